@@ -20,6 +20,7 @@
  *
  */
 
+#include "common/config-manager.h"
 #include "common/debug.h"
 #include "common/file.h"
 #include "common/mutex.h"
@@ -28,6 +29,7 @@
 #include "common/util.h"
 
 #include "audio/audiostream.h"
+#include "audio/decodeahead.h"
 #include "audio/decoders/flac.h"
 #include "audio/decoders/mp3.h"
 #include "audio/decoders/quicktime.h"
@@ -80,8 +82,16 @@ SeekableAudioStream *SeekableAudioStream::openStreamFile(const Common::String &b
 
 	delete fileHandle;
 
-	if (stream == NULL)
+	if (stream == NULL) {
 		debug(1, "SeekableAudioStream::openStreamFile: Could not open compressed AudioFile %s", basename.c_str());
+		return NULL;
+	}
+
+	// Decode the stream ahead of playback, if requested. This moves most
+	// of the decoding out of the mixer callback.
+	const int decodeAhead = ConfMan.getInt("decode_ahead");
+	if (decodeAhead > 0)
+		stream = new DecodeAheadAudioStream(stream, decodeAhead, DisposeAfterUse::YES);
 
 	return stream;
 }
@@ -0,0 +1,276 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ */
+
+#include "common/algorithm.h"
+#include "common/array.h"
+#include "common/list.h"
+#include "common/singleton.h"
+#include "common/system.h"
+#include "common/timer.h"
+#include "common/util.h"
+
+#include "audio/decodeahead.h"
+
+namespace Audio {
+
+/**
+ * Calls DecodeAheadAudioStream::decodeAhead() on all existing decode ahead
+ * streams from a timer callback.
+ *
+ * The timer stays installed as long as the manager exists. Streams are
+ * usually destroyed by the mixer callback, which holds the mixer mutex,
+ * while music timer callbacks wait for that mutex with the timer manager
+ * locked. Removing the timer from removeStream() would thus deadlock.
+ */
+class DecodeAheadManager : public Common::Singleton<DecodeAheadManager> {
+public:
+	void addStream(DecodeAheadAudioStream *stream);
+	void removeStream(DecodeAheadAudioStream *stream);
+
+private:
+	friend class Common::Singleton<SingletonBaseType>;
+	DecodeAheadManager();
+	~DecodeAheadManager();
+
+	static void timerProc(void *refCon);
+
+	/**
+	 * Protects the stream list and _decodingStream. Only held for short
+	 * periods of time, not while decoding.
+	 */
+	Common::Mutex _mutex;
+	Common::List<DecodeAheadAudioStream *> _streams;
+
+	/**
+	 * Held by the timer callback while decoding a stream, which is
+	 * _decodingStream. This keeps removeStream() from returning while the
+	 * stream being removed is still decoding.
+	 */
+	Common::Mutex _decodeMutex;
+	DecodeAheadAudioStream *_decodingStream;
+};
+
+} // End of namespace Audio
+
+namespace Common {
+DECLARE_SINGLETON(Audio::DecodeAheadManager);
+}
+
+namespace Audio {
+
+DecodeAheadManager::DecodeAheadManager() : _decodingStream(0) {
+	// SDL timers have a resolution of 10ms, so there is no point in
+	// calling the timer more often.
+	g_system->getTimerManager()->installTimerProc(&timerProc, 10000, this, "DecodeAheadManager");
+}
+
+DecodeAheadManager::~DecodeAheadManager() {
+	g_system->getTimerManager()->removeTimerProc(&timerProc);
+}
+
+void DecodeAheadManager::addStream(DecodeAheadAudioStream *stream) {
+	Common::StackLock lock(_mutex);
+	_streams.push_back(stream);
+}
+
+void DecodeAheadManager::removeStream(DecodeAheadAudioStream *stream) {
+	Common::StackLock lock(_mutex);
+	_streams.remove(stream);
+
+	if (stream == _decodingStream) {
+		// The stream is being decoded right now. Since it is no longer in
+		// the list, the timer callback won't pick it up again, so we only
+		// have to wait for the current pass. The callback needs _mutex for
+		// that, so release it meanwhile.
+		_mutex.unlock();
+		_decodeMutex.lock();
+		_decodeMutex.unlock();
+		_mutex.lock();
+	}
+}
+
+void DecodeAheadManager::timerProc(void *refCon) {
+	DecodeAheadManager *manager = (DecodeAheadManager *)refCon;
+	Common::Array<DecodeAheadAudioStream *> streams;
+
+	{
+		Common::StackLock lock(manager->_mutex);
+		if (manager->_streams.empty())
+			return;
+
+		for (Common::List<DecodeAheadAudioStream *>::iterator i = manager->_streams.begin(); i != manager->_streams.end(); ++i)
+			streams.push_back(*i);
+	}
+
+	// Only hold the list mutex while picking the next stream, so that
+	// streams can be added and removed while others are decoding.
+	for (uint i = 0; i < streams.size(); i++) {
+		Common::StackLock decodeLock(manager->_decodeMutex);
+
+		{
+			Common::StackLock lock(manager->_mutex);
+			// Skip streams which have been removed in the meantime
+			if (Common::find(manager->_streams.begin(), manager->_streams.end(), streams[i]) == manager->_streams.end())
+				continue;
+			manager->_decodingStream = streams[i];
+		}
+
+		streams[i]->decodeAhead();
+
+		Common::StackLock lock(manager->_mutex);
+		manager->_decodingStream = 0;
+	}
+}
+
+#pragma mark -
+
+DecodeAheadAudioStream::DecodeAheadAudioStream(SeekableAudioStream *stream, uint32 msecs, DisposeAfterUse::Flag disposeAfterUse)
+    : _parent(stream, disposeAfterUse), _stereo(stream->isStereo()), _rate(stream->getRate()), _length(stream->getLength()),
+      _readPos(0), _fill(0), _parentEnded(false), _underruns(0) {
+
+	// Keep the buffer size (and a quarter of it, see decodeAhead()) a
+	// multiple of two, so that the samples of stereo streams are never
+	// split at the end of the buffer.
+	_bufferSize = MAX<uint32>(msecs * _rate / 1000 * (_stereo ? 2 : 1), 1024) & ~7;
+	_buffer = new int16[_bufferSize];
+
+	decode(_bufferSize);
+	DecodeAheadManager::instance().addStream(this);
+}
+
+DecodeAheadAudioStream::~DecodeAheadAudioStream() {
+	// This waits for the timer callback, in case it is decoding this
+	// stream right now
+	DecodeAheadManager::instance().removeStream(this);
+	delete[] _buffer;
+}
+
+void DecodeAheadAudioStream::decodeAhead() {
+	// Don't hold up other timer callbacks (like music players) for too
+	// long, even if the buffer is empty, e.g. right after seeking.
+	decode(_bufferSize / 4);
+}
+
+void DecodeAheadAudioStream::decode(uint32 maxSamples) {
+	Common::StackLock decodeLock(_decodeMutex);
+
+	while (maxSamples > 0) {
+		uint32 writePos, space;
+
+		{
+			Common::StackLock lock(_bufferMutex);
+			if (_parentEnded)
+				return;
+
+			writePos = (_readPos + _fill) % _bufferSize;
+			space = MIN(MIN(_bufferSize - _fill, _bufferSize - writePos), maxSamples);
+		}
+
+		if (space == 0)
+			return;
+
+		// Only the mixer reads from the buffer, and only from the filled
+		// part of it, so we can decode into the free part without holding
+		// the buffer mutex.
+		const int samples = _parent->readBuffer(_buffer + writePos, space);
+
+		Common::StackLock lock(_bufferMutex);
+		if (samples > 0)
+			_fill += samples;
+		if (_parent->endOfData())
+			_parentEnded = true;
+		if (samples < (int)space)
+			return;
+
+		maxSamples -= space;
+	}
+}
+
+int DecodeAheadAudioStream::readFromBuffer(int16 *buffer, int numSamples) {
+	Common::StackLock lock(_bufferMutex);
+
+	int samples = 0;
+	while (samples < numSamples && _fill > 0) {
+		const uint32 count = MIN<uint32>(MIN(_fill, _bufferSize - _readPos), numSamples - samples);
+		memcpy(buffer + samples, _buffer + _readPos, count * sizeof(int16));
+
+		samples += count;
+		_readPos = (_readPos + count) % _bufferSize;
+		_fill -= count;
+	}
+
+	return samples;
+}
+
+int DecodeAheadAudioStream::readBuffer(int16 *buffer, const int numSamples) {
+	int samples = readFromBuffer(buffer, numSamples);
+
+	if (samples < numSamples && !endOfData()) {
+		// The buffer ran empty. Wait for the timer callback in case it is
+		// decoding right now, and decode the rest ourselves if necessary.
+		Common::StackLock decodeLock(_decodeMutex);
+
+		samples += readFromBuffer(buffer + samples, numSamples - samples);
+
+		if (samples < numSamples && !_parentEnded) {
+			_underruns++;
+
+			const int decoded = _parent->readBuffer(buffer + samples, numSamples - samples);
+			if (decoded > 0)
+				samples += decoded;
+
+			Common::StackLock lock(_bufferMutex);
+			if (_parent->endOfData())
+				_parentEnded = true;
+		}
+	}
+
+	return samples;
+}
+
+bool DecodeAheadAudioStream::endOfData() const {
+	Common::StackLock lock(_bufferMutex);
+	return _fill == 0 && _parentEnded;
+}
+
+bool DecodeAheadAudioStream::seek(const Timestamp &where) {
+	bool result;
+
+	{
+		Common::StackLock decodeLock(_decodeMutex);
+
+		{
+			Common::StackLock lock(_bufferMutex);
+			_readPos = _fill = 0;
+		}
+
+		result = _parent->seek(where);
+
+		Common::StackLock lock(_bufferMutex);
+		_parentEnded = _parent->endOfData();
+	}
+
+	decode(_bufferSize);
+	return result;
+}
+
+} // End of namespace Audio
@@ -0,0 +1,118 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ */
+
+#ifndef AUDIO_DECODEAHEAD_H
+#define AUDIO_DECODEAHEAD_H
+
+#include "common/mutex.h"
+#include "common/ptr.h"
+#include "common/scummsys.h"
+
+#include "audio/audiostream.h"
+#include "audio/timestamp.h"
+
+namespace Audio {
+
+/**
+ * A wrapper stream, which decodes the wrapped stream ahead of playback.
+ *
+ * Decoding compressed audio can take a while for some frames, and when this
+ * happens in the mixer callback, it may cause the audio output to skip. This
+ * stream decodes the wrapped stream from a timer callback instead, keeping a
+ * buffer of decoded samples, which the mixer reads from.
+ *
+ * Should the buffer run empty anyway (an underrun), the samples are decoded
+ * right away, as if the stream was not wrapped.
+ */
+class DecodeAheadAudioStream : public SeekableAudioStream {
+public:
+	/**
+	 * Creates a decode ahead stream, and fills its buffer.
+	 *
+	 * @param stream Stream to decode ahead
+	 * @param msecs How far ahead of playback to decode, in milliseconds
+	 * @param disposeAfterUse Destroy the stream when the DecodeAheadAudioStream is destroyed.
+	 */
+	DecodeAheadAudioStream(SeekableAudioStream *stream, uint32 msecs, DisposeAfterUse::Flag disposeAfterUse = DisposeAfterUse::YES);
+	~DecodeAheadAudioStream();
+
+	int readBuffer(int16 *buffer, const int numSamples);
+	bool endOfData() const;
+
+	bool isStereo() const { return _stereo; }
+	int getRate() const { return _rate; }
+
+	/**
+	 * Seeks the wrapped stream. The buffered samples are dropped.
+	 */
+	bool seek(const Timestamp &where);
+	Timestamp getLength() const { return _length; }
+
+	/**
+	 * Returns how often the buffer ran empty, so that samples had to be
+	 * decoded during playback.
+	 */
+	uint32 getUnderrunCount() const { return _underruns; }
+
+	/**
+	 * Decodes the wrapped stream to refill the buffer. This is called
+	 * regularly from a timer callback.
+	 */
+	void decodeAhead();
+
+private:
+	Common::DisposablePtr<SeekableAudioStream> _parent;
+
+	const bool _stereo;
+	const int _rate;
+	const Timestamp _length;
+
+	/**
+	 * Held while decoding from the wrapped stream. Since the samples are
+	 * added to the buffer while holding it, too, this keeps the samples in
+	 * order when the mixer has to decode samples itself.
+	 */
+	Common::Mutex _decodeMutex;
+
+	/** Protects the buffer positions. Only held for short periods of time. */
+	Common::Mutex _bufferMutex;
+
+	/** Ring buffer of decoded samples */
+	int16 *_buffer;
+	uint32 _bufferSize;
+	uint32 _readPos;
+	uint32 _fill;
+
+	/** Whether all samples have been decoded from the wrapped stream */
+	bool _parentEnded;
+
+	uint32 _underruns;
+
+	/** Decodes up to maxSamples samples into the buffer. */
+	void decode(uint32 maxSamples);
+
+	int readFromBuffer(int16 *buffer, int numSamples);
+};
+
+} // End of namespace Audio
+
+#endif
@@ -44,7 +44,8 @@ _centerPitchWheelOnUnload(false),
 _sendSustainOffOnNotesOff(false),
 _numTracks(0),
 _activeTrack(255),
-_abortParse(0) {
+_abortParse(0),
+_indexSeeks(false) {
 	memset(_activeNotes, 0, sizeof(_activeNotes));
 	_nextEvent.start = NULL;
 	_nextEvent.delta = 0;
@@ -318,6 +319,8 @@ bool MidiParser::setTrack(int track) {
 
 	resetTracking();
 	memset(_activeNotes, 0, sizeof(_activeNotes));
+	if (track != _activeTrack)
+		_seekPoints.clear();
 	_activeTrack = track;
 	_position._playPos = _tracks[track];
 	parseNextEvent(_nextEvent);
@@ -365,6 +368,27 @@ void MidiParser::hangAllActiveNotes() {
 	}
 }
 
+int MidiParser::findSeekPoint(uint32 tick) const {
+	// Find the last seek point whose next event is before the tick. The
+	// event ticks never decrease, so a binary search will do.
+	int first = 0;
+	int last = _seekPoints.size() - 1;
+	int found = -1;
+
+	while (first <= last) {
+		const int middle = (first + last) / 2;
+		const SeekPoint &point = _seekPoints[middle];
+		if (point.position._lastEventTick + point.nextEvent.delta < tick) {
+			found = middle;
+			first = middle + 1;
+		} else {
+			last = middle - 1;
+		}
+	}
+
+	return found;
+}
+
 bool MidiParser::jumpToTick(uint32 tick, bool fireEvents, bool stopNotes, bool dontSendNoteOn) {
 	if (_activeTrack >= _numTracks)
 		return false;
@@ -375,9 +399,51 @@ bool MidiParser::jumpToTick(uint32 tick, bool fireEvents, bool stopNotes, bool d
 	resetTracking();
 	_position._playPos = _tracks[_activeTrack];
 	parseNextEvent(_nextEvent);
+
+	// Keep track of what is needed to add seek points while parsing
+	const uint32 initialPsecPerTick = _psecPerTick;
+	uint32 eventCount = 0;
+	uint32 initialTicks = 0;
+	uint32 trackTempo = 0;
+	bool trackTempoSet = false;
+
+	// Skip the events before the last seek point in front of the tick. This
+	// is only possible if the skipped events need not be sent.
+	if (tick > 0 && _indexSeeks && !fireEvents) {
+		const int index = findSeekPoint(tick);
+		if (index >= 0) {
+			const SeekPoint &point = _seekPoints[index];
+
+			_position = point.position;
+			_position._lastEventTime += point.initialTicks * _psecPerTick;
+			_position._playTime = _position._lastEventTime;
+			_nextEvent = point.nextEvent;
+			if (point.tempoSet)
+				setTempo(point.tempo);
+
+			eventCount = (index + 1) * kSeekPointInterval;
+			initialTicks = point.initialTicks;
+			trackTempo = point.tempo;
+			trackTempoSet = point.tempoSet;
+		}
+	}
+
 	if (tick > 0) {
 		while (true) {
 			EventInfo &info = _nextEvent;
+
+			if (_indexSeeks && eventCount == (_seekPoints.size() + 1) * kSeekPointInterval) {
+				SeekPoint point;
+				point.position = _position;
+				point.nextEvent = info;
+				point.initialTicks = trackTempoSet ? initialTicks : _position._lastEventTick;
+				point.position._lastEventTime -= point.initialTicks * initialPsecPerTick;
+				point.position._playTime = point.position._lastEventTime;
+				point.tempo = trackTempo;
+				point.tempoSet = trackTempoSet;
+				_seekPoints.push_back(point);
+			}
+
 			if (_position._lastEventTick + info.delta >= tick) {
 				_position._playTime += (tick - _position._lastEventTick) * _psecPerTick;
 				_position._playTick = tick;
@@ -395,8 +461,13 @@ bool MidiParser::jumpToTick(uint32 tick, bool fireEvents, bool stopNotes, bool d
 					_nextEvent = currentEvent;
 					return false;
 				} else {
-					if (info.ext.type == 0x51 && info.length >= 3) // Tempo
+					if (info.ext.type == 0x51 && info.length >= 3) { // Tempo
 						setTempo(info.ext.data[0] << 16 | info.ext.data[1] << 8 | info.ext.data[2]);
+						if (!trackTempoSet)
+							initialTicks = _position._lastEventTick;
+						trackTempo = _tempo;
+						trackTempoSet = true;
+					}
 					if (fireEvents)
 						_driver->metaEvent(info.ext.type, info.ext.data, (uint16) info.length);
 				}
@@ -420,6 +491,7 @@ bool MidiParser::jumpToTick(uint32 tick, bool fireEvents, bool stopNotes, bool d
 			}
 
 			parseNextEvent(_nextEvent);
+			eventCount++;
 		}
 	}
 
@@ -449,6 +521,7 @@ void MidiParser::unloadMusic() {
 	_numTracks = 0;
 	_activeTrack = 255;
 	_abortParse = true;
+	_seekPoints.clear();
 
 	if (_centerPitchWheelOnUnload) {
 		// Center the pitch wheels in preparation for the next piece of
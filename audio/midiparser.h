@@ -26,6 +26,7 @@
 #define AUDIO_MIDIPARSER_H
 
 #include "common/scummsys.h"
+#include "common/array.h"
 #include "common/endian.h"
 
 class MidiDriver_BASE;
@@ -109,6 +110,20 @@ struct EventInfo {
 	byte command() { return event >> 4; }   ///< Separates the command code from the event.
 };
 
+/**
+ * The state of the parser at an event of the active track, which
+ * jumpToTick() can continue from instead of parsing the track from the
+ * start. The times are stored relative to the tempo in effect before the
+ * track sets one, since jumpToTick() starts with whatever tempo is current.
+ */
+struct SeekPoint {
+	Tracker position;     ///< The position, with the ticks played at the initial tempo not counted in the times
+	EventInfo nextEvent;  ///< The next event to process
+	uint32 initialTicks;  ///< The number of ticks played at the initial tempo
+	uint32 tempo;         ///< The tempo set by the track, if tempoSet is true
+	bool tempoSet;        ///< Whether the track has set a tempo so far
+};
+
 /**
  * Provides expiration tracking for hanging notes.
  * Hanging notes are used when a MIDI format does not include explicit Note Off
@@ -288,6 +303,14 @@ protected:
 	                        ///< simulated events in certain formats.
 	bool   _abortParse;    ///< If a jump or other operation interrupts parsing, flag to abort.
 
+	bool   _indexSeeks;    ///< Remember seek points in the active track, to speed up jumpToTick().
+	                        ///< Only for formats which keep all of their parsing state in _position.
+	Common::Array<SeekPoint> _seekPoints; ///< Seek points of the active track, one every kSeekPointInterval events
+
+	enum {
+		kSeekPointInterval = 64 ///< The number of events between two seek points
+	};
+
 protected:
 	static uint32 readVLQ(byte * &data);
 	virtual void resetTracking();
@@ -297,6 +320,7 @@ protected:
 	void activeNote(byte channel, byte note, bool active);
 	void hangingNote(byte channel, byte note, uint32 ticksLeft, bool recycle = true);
 	void hangAllActiveNotes();
+	int findSeekPoint(uint32 tick) const;
 
 	virtual void sendToDriver(uint32 b);
 	void sendToDriver(byte status, byte firstOp, byte secondOp) {
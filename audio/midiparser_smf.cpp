@@ -37,7 +37,7 @@ protected:
 	void parseNextEvent(EventInfo &info);
 
 public:
-	MidiParser_SMF() : _buffer(0), _malformedPitchBends(false) {}
+	MidiParser_SMF() : _buffer(0), _malformedPitchBends(false) { _indexSeeks = true; }
 	~MidiParser_SMF();
 
 	bool loadMusic(byte *data, uint32 size);
@@ -56,6 +56,8 @@ void MidiParser_SMF::property(int prop, int value) {
 	switch (prop) {
 	case mpMalformedPitchBends:
 		_malformedPitchBends = (value > 0);
+		// The seek points depend on how the events were parsed
+		_seekPoints.clear();
 	default:
 		MidiParser::property(prop, value);
 	}
@@ -20,7 +20,9 @@
  *
  */
 
+#include "common/config-manager.h"
 #include "common/util.h"
+#include "common/profiler.h"
 #include "common/system.h"
 #include "common/textconsole.h"
 
@@ -42,19 +44,38 @@ namespace Audio {
  */
 class Channel {
 public:
-	Channel(Mixer *mixer, Mixer::SoundType type, AudioStream *stream, DisposeAfterUse::Flag autofreeStream, bool reverseStereo, int id, bool permanent);
+	Channel(Mixer *mixer, Mixer::SoundType type, AudioStream *stream, DisposeAfterUse::Flag autofreeStream, bool reverseStereo, int id, bool permanent, bool highQuality);
 	~Channel();
 
 	/**
-	 * Mixes the channel's samples into the given buffer.
+	 * Prepares mixing the next buffer, by updating the timing information
+	 * used by getElapsedTime() and taking a copy of the channel volumes.
+	 * This must be called with the mixer mutex held, while mix() itself
+	 * does not need it.
 	 *
-	 * @param data buffer where to mix the data
+	 * @return true if there is data to be mixed
+	 */
+	bool prepareMix();
+
+	/**
+	 * Mixes the channel's samples into the given mixing bus, using the
+	 * volumes copied by prepareMix().
+	 *
+	 * @param data mixing bus where to mix the data
 	 * @param len  number of sample *pairs*. So a value of
 	 *             10 means that the buffer contains twice 10 sample, each
 	 *             16 bits, for a total of 40 bytes.
 	 * @return number of sample pairs processed (which can still be silence!)
 	 */
-	int mix(int16 *data, uint len);
+	int mix(st_bus_t *data, uint len);
+
+	/**
+	 * Accounts for the samples processed by mix(). This must be called with
+	 * the mixer mutex held.
+	 *
+	 * @param samples number of sample pairs returned by mix()
+	 */
+	void finishMix(int samples) { _samplesDecoded += samples; }
 
 	/**
 	 * Queries whether the channel is still playing or not.
@@ -155,6 +176,9 @@ private:
 	void updateChannelVolumes();
 	st_volume_t _volL, _volR;
 
+	/** The volumes used by mix(), copied from _volL and _volR by prepareMix() */
+	st_volume_t _mixVolL, _mixVolR;
+
 	Mixer *_mixer;
 
 	uint32 _samplesConsumed;
@@ -173,10 +197,13 @@ private:
 
 
 MixerImpl::MixerImpl(OSystem *system, uint sampleRate)
-	: _syst(system), _mutex(), _sampleRate(sampleRate), _mixerReady(false), _handleSeed(0), _soundTypeSettings() {
+	: _syst(system), _mutex(), _mixMutex(), _mixingChannel(0), _sampleRate(sampleRate), _mixerReady(false), _handleSeed(0),
+	  _soundTypeSettings(), _mixBuffer(0), _mixBufferSize(0), _ditherSeed(0) {
 
 	assert(sampleRate > 0);
 
+	_highQualityResampling = (ConfMan.get("resampler") == "sinc");
+
 	for (int i = 0; i != NUM_CHANNELS; i++)
 		_channels[i] = 0;
 }
@@ -184,6 +211,8 @@ MixerImpl::MixerImpl(OSystem *system, uint sampleRate)
 MixerImpl::~MixerImpl() {
 	for (int i = 0; i != NUM_CHANNELS; i++)
 		delete _channels[i];
+
+	free(_mixBuffer);
 }
 
 void MixerImpl::setReady(bool ready) {
@@ -258,16 +287,16 @@ void MixerImpl::playStream(
 #endif
 
 	// Create the channel
-	Channel *chan = new Channel(this, type, stream, autofreeStream, reverseStereo, id, permanent);
+	Channel *chan = new Channel(this, type, stream, autofreeStream, reverseStereo, id, permanent, _highQualityResampling);
 	chan->setVolume(volume);
 	chan->setBalance(balance);
 	insertChannel(handle, chan);
 }
 
 int MixerImpl::mixCallback(byte *samples, uint len) {
-	assert(samples);
+	PROFILE_ZONE_TRACK("MixerImpl::mixCallback", kTrackAudio);
 
-	Common::StackLock lock(_mutex);
+	assert(samples);
 
 	int16 *buf = (int16 *)samples;
 	// we store stereo, 16-bit samples
@@ -277,61 +306,166 @@ int MixerImpl::mixCallback(byte *samples, uint len) {
 	// Since the mixer callback has been called, the mixer must be ready...
 	_mixerReady = true;
 
-	//  zero the buf
-	memset(buf, 0, 2 * len * sizeof(int16));
+	// Grow the mixing bus, if necessary, and zero it
+	if (2 * len > _mixBufferSize) {
+		free(_mixBuffer);
+		_mixBufferSize = 2 * len;
+		_mixBuffer = (st_bus_t *)malloc(_mixBufferSize * sizeof(st_bus_t));
+		if (!_mixBuffer)
+			error("MixerImpl::mixCallback: Cannot allocate memory for the mixing bus");
+	}
+
+	memset(_mixBuffer, 0, 2 * len * sizeof(st_bus_t));
 
 	// mix all channels
+	//
+	// The mixer mutex is only held while looking up each channel, not while
+	// mixing it, so that the engine does not have to wait for the whole
+	// buffer to be mixed whenever it calls into the mixer. _mixMutex is held
+	// instead, which keeps deleteChannels() from deleting the channel being
+	// mixed.
 	int res = 0, tmp;
-	for (int i = 0; i != NUM_CHANNELS; i++)
-		if (_channels[i]) {
-			if (_channels[i]->isFinished()) {
-				delete _channels[i];
+	for (int i = 0; i != NUM_CHANNELS; i++) {
+		Common::StackLock mixLock(_mixMutex);
+		Channel *chan;
+		bool finished;
+
+		{
+			Common::StackLock lock(_mutex);
+
+			chan = _channels[i];
+			if (!chan)
+				continue;
+
+			finished = chan->isFinished();
+			if (finished)
 				_channels[i] = 0;
-			} else if (!_channels[i]->isPaused()) {
-				tmp = _channels[i]->mix(buf, len);
+			else if (chan->isPaused() || !chan->prepareMix())
+				continue;
+			else
+				_mixingChannel = chan;
+		}
 
-				if (tmp > res)
-					res = tmp;
-			}
+		// Finished channels are deleted without holding _mutex, since the
+		// stream's destructor may call back into the mixer.
+		if (finished) {
+			delete chan;
+			continue;
 		}
 
+		tmp = chan->mix(_mixBuffer, len);
+
+		if (tmp > res)
+			res = tmp;
+
+		Common::StackLock lock(_mutex);
+		chan->finishMix(tmp);
+		_mixingChannel = 0;
+	}
+
+	// Convert the mixing bus to the output format. Rather than rounding
+	// the samples, we add a random fraction before dropping the extra bits
+	// (i.e. rectangular dither). This avoids the distortion caused by
+	// quantizing quiet sounds, while samples without a fractional part,
+	// like those of channels playing at full volume, are left untouched.
+	for (uint i = 0; i < 2 * len; i++) {
+		_ditherSeed = _ditherSeed * 1664525 + 1013904223;
+		int val = (_mixBuffer[i] + (int)(_ditherSeed >> (32 - ST_BUS_FRAC_BITS))) >> ST_BUS_FRAC_BITS;
+
+		if (val > ST_SAMPLE_MAX)
+			val = ST_SAMPLE_MAX;
+		else if (val < ST_SAMPLE_MIN)
+			val = ST_SAMPLE_MIN;
+
+#ifdef OUTPUT_UNSIGNED_AUDIO
+		buf[i] = ((int16)val) ^ 0x8000;
+#else
+		buf[i] = val;
+#endif
+	}
+
 	return res;
 }
 
+Channel *MixerImpl::detachChannel(int index) {
+	Channel *chan = _channels[index];
+	_channels[index] = 0;
+	return chan;
+}
+
+void MixerImpl::deleteChannels(Channel *const *chans, int count) {
+	bool mixing = false;
+
+	{
+		Common::StackLock lock(_mutex);
+		for (int i = 0; i < count; i++) {
+			if (chans[i] == _mixingChannel)
+				mixing = true;
+		}
+	}
+
+	if (mixing) {
+		// A channel is being mixed right now. Since it is no longer in the
+		// channel table, the mixer callback won't pick it up again, so we
+		// only have to wait for it to finish the current buffer.
+		Common::StackLock mixLock(_mixMutex);
+	}
+
+	for (int i = 0; i < count; i++)
+		delete chans[i];
+}
+
 void MixerImpl::stopAll() {
-	Common::StackLock lock(_mutex);
-	for (int i = 0; i != NUM_CHANNELS; i++) {
-		if (_channels[i] != 0 && !_channels[i]->isPermanent()) {
-			delete _channels[i];
-			_channels[i] = 0;
+	Channel *chans[NUM_CHANNELS];
+	int count = 0;
+
+	{
+		Common::StackLock lock(_mutex);
+		for (int i = 0; i != NUM_CHANNELS; i++) {
+			if (_channels[i] != 0 && !_channels[i]->isPermanent())
+				chans[count++] = detachChannel(i);
 		}
 	}
+
+	deleteChannels(chans, count);
 }
 
 void MixerImpl::stopID(int id) {
-	Common::StackLock lock(_mutex);
-	for (int i = 0; i != NUM_CHANNELS; i++) {
-		if (_channels[i] != 0 && _channels[i]->getId() == id) {
-			delete _channels[i];
-			_channels[i] = 0;
+	Channel *chans[NUM_CHANNELS];
+	int count = 0;
+
+	{
+		Common::StackLock lock(_mutex);
+		for (int i = 0; i != NUM_CHANNELS; i++) {
+			if (_channels[i] != 0 && _channels[i]->getId() == id)
+				chans[count++] = detachChannel(i);
 		}
 	}
+
+	deleteChannels(chans, count);
 }
 
 void MixerImpl::stopHandle(SoundHandle handle) {
-	Common::StackLock lock(_mutex);
+	Channel *chan;
 
-	// Simply ignore stop requests for handles of sounds that already terminated
-	const int index = handle._val % NUM_CHANNELS;
-	if (!_channels[index] || _channels[index]->getHandle()._val != handle._val)
-		return;
+	{
+		Common::StackLock lock(_mutex);
 
-	delete _channels[index];
-	_channels[index] = 0;
+		// Simply ignore stop requests for handles of sounds that already terminated
+		const int index = handle._val % NUM_CHANNELS;
+		if (!_channels[index] || _channels[index]->getHandle()._val != handle._val)
+			return;
+
+		chan = detachChannel(index);
+	}
+
+	deleteChannels(&chan, 1);
 }
 
 void MixerImpl::muteSoundType(SoundType type, bool mute) {
 	assert(0 <= type && type < ARRAYSIZE(_soundTypeSettings));
+
+	Common::StackLock lock(_mutex);
 	_soundTypeSettings[type].mute = mute;
 
 	for (int i = 0; i != NUM_CHANNELS; ++i) {
@@ -488,7 +622,7 @@ int MixerImpl::getVolumeForSoundType(SoundType type) const {
 #pragma mark -
 
 Channel::Channel(Mixer *mixer, Mixer::SoundType type, AudioStream *stream,
-                 DisposeAfterUse::Flag autofreeStream, bool reverseStereo, int id, bool permanent)
+                 DisposeAfterUse::Flag autofreeStream, bool reverseStereo, int id, bool permanent, bool highQuality)
     : _type(type), _mixer(mixer), _id(id), _permanent(permanent), _volume(Mixer::kMaxChannelVolume),
       _balance(0), _pauseLevel(0), _samplesConsumed(0), _samplesDecoded(0), _mixerTimeStamp(0),
       _pauseStartTime(0), _pauseTime(0), _converter(0),
@@ -497,7 +631,7 @@ Channel::Channel(Mixer *mixer, Mixer::SoundType type, AudioStream *stream,
 	assert(stream);
 
 	// Get a rate converter instance
-	_converter = makeRateConverter(_stream->getRate(), mixer->getOutputRate(), _stream->isStereo(), reverseStereo);
+	_converter = makeRateConverter(_stream->getRate(), mixer->getOutputRate(), _stream->isStereo(), reverseStereo, highQuality);
 }
 
 Channel::~Channel() {
@@ -595,23 +729,26 @@ Timestamp Channel::getElapsedTime() {
 	return ts;
 }
 
-int Channel::mix(int16 *data, uint len) {
+bool Channel::prepareMix() {
 	assert(_stream);
 
-	int res = 0;
-
 	if (_stream->endOfData()) {
 		// TODO: call drain method
-	} else {
-		assert(_converter);
-		_samplesConsumed = _samplesDecoded;
-		_mixerTimeStamp = g_system->getMillis();
-		_pauseTime = 0;
-		res = _converter->flow(*_stream, data, len, _volL, _volR);
-		_samplesDecoded += res;
+		return false;
 	}
 
-	return res;
+	_samplesConsumed = _samplesDecoded;
+	_mixerTimeStamp = g_system->getMillis();
+	_pauseTime = 0;
+	_mixVolL = _volL;
+	_mixVolR = _volR;
+	return true;
+}
+
+int Channel::mix(st_bus_t *data, uint len) {
+	assert(_converter);
+
+	return _converter->flow(*_stream, data, len, _mixVolL, _mixVolR);
 }
 
 } // End of namespace Audio
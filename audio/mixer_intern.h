@@ -26,6 +26,7 @@
 #include "common/scummsys.h"
 #include "common/mutex.h"
 #include "audio/mixer.h"
+#include "audio/rate.h"
 
 namespace Audio {
 
@@ -55,10 +56,24 @@ private:
 	};
 
 	OSystem *_syst;
+
+	/**
+	 * Protects the channel table and the channels' state. The mixer callback
+	 * only holds it briefly, and not while mixing a channel.
+	 */
 	Common::Mutex _mutex;
 
+	/** Held by the mixer callback while it mixes a channel. */
+	Common::Mutex _mixMutex;
+
+	/** The channel currently being mixed by the mixer callback, if any. */
+	Channel *_mixingChannel;
+
 	const uint _sampleRate;
 	bool _mixerReady;
+
+	/** Whether to use the windowed sinc rate converter, see makeRateConverter() */
+	bool _highQualityResampling;
 	uint32 _handleSeed;
 
 	struct SoundTypeSettings {
@@ -71,6 +86,13 @@ private:
 	SoundTypeSettings _soundTypeSettings[4];
 	Channel *_channels[NUM_CHANNELS];
 
+	/** The mixing bus all channels are mixed into, see st_bus_t. */
+	st_bus_t *_mixBuffer;
+	uint _mixBufferSize;
+
+	/** State of the random number generator used for dithering. */
+	uint32 _ditherSeed;
+
 
 public:
 
@@ -122,6 +144,20 @@ public:
 protected:
 	void insertChannel(SoundHandle *handle, Channel *chan);
 
+	/**
+	 * Remove a channel from the channel table. Must be called with _mutex
+	 * held. The channel must then be passed to deleteChannels().
+	 */
+	Channel *detachChannel(int index);
+
+	/**
+	 * Delete channels removed by detachChannel(). Must be called without
+	 * holding _mutex. If the mixer callback is currently mixing one of the
+	 * channels, this waits for it to finish, so the caller can rely on the
+	 * streams not being accessed anymore afterwards.
+	 */
+	void deleteChannels(Channel *const *chans, int count);
+
 public:
 	/**
 	 * The mixer callback function, to be called at regular intervals by
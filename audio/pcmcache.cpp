@@ -0,0 +1,162 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ */
+
+#include "common/debug.h"
+#include "common/util.h"
+
+#include "audio/audiostream.h"
+#include "audio/pcmcache.h"
+
+namespace Audio {
+
+/**
+ * A stream playing the samples of a PCMCache entry.
+ */
+class PCMCacheStream : public SeekableAudioStream {
+public:
+	PCMCacheStream(PCMCache *cache, PCMCache::Entry *entry) : _cache(cache), _entry(entry), _pos(0) {}
+	~PCMCacheStream() { _cache->releaseEntry(_entry); }
+
+	int readBuffer(int16 *buffer, const int numSamples) {
+		const int samples = MIN<uint32>(numSamples, _entry->numSamples - _pos);
+		memcpy(buffer, _entry->samples + _pos, samples * sizeof(int16));
+		_pos += samples;
+		return samples;
+	}
+
+	bool isStereo() const { return _entry->stereo; }
+	int getRate() const { return _entry->rate; }
+	bool endOfData() const { return _pos >= _entry->numSamples; }
+
+	bool seek(const Timestamp &where) {
+		const uint32 pos = convertTimeToStreamPos(where, getRate(), isStereo()).totalNumberOfFrames();
+		if (pos > _entry->numSamples)
+			return false;
+
+		_pos = pos;
+		return true;
+	}
+
+	Timestamp getLength() const {
+		return Timestamp(0, _entry->numSamples / (isStereo() ? 2 : 1), getRate());
+	}
+
+private:
+	PCMCache *_cache;
+	PCMCache::Entry *_entry;
+	uint32 _pos;
+};
+
+PCMCache::PCMCache(uint32 maxSize) : _maxSize(maxSize), _size(0), _hits(0), _misses(0) {
+}
+
+PCMCache::~PCMCache() {
+	debug(1, "PCMCache: %d hits, %d misses", _hits, _misses);
+	clear();
+}
+
+RewindableAudioStream *PCMCache::getStream(const PCMCacheKey &key) {
+	Common::StackLock lock(_mutex);
+
+	EntryMap::iterator i = _map.find(key);
+	if (i == _map.end()) {
+		_misses++;
+		return 0;
+	}
+
+	_hits++;
+
+	// Move the sound to the front of the list, since it has been used
+	Entry *entry = *i->_value;
+	_entries.erase(i->_value);
+	_entries.push_front(entry);
+	i->_value = _entries.begin();
+
+	entry->refCount++;
+	return new PCMCacheStream(this, entry);
+}
+
+RewindableAudioStream *PCMCache::addStream(const PCMCacheKey &key, SeekableAudioStream *stream) {
+	if (!stream)
+		return 0;
+
+	const uint32 numSamples = convertTimeToStreamPos(stream->getLength(), stream->getRate(), stream->isStereo()).totalNumberOfFrames();
+	if (numSamples == 0 || numSamples * sizeof(int16) > _maxSize / 4)
+		return stream;
+
+	Entry *entry = new Entry(key);
+	entry->samples = new int16[numSamples];
+	entry->numSamples = MAX(stream->readBuffer(entry->samples, numSamples), 0);
+	entry->rate = stream->getRate();
+	entry->stereo = stream->isStereo();
+	delete stream;
+
+	Common::StackLock lock(_mutex);
+
+	// Replace the sound, in case it has been added before
+	EntryMap::iterator i = _map.find(key);
+	if (i != _map.end())
+		removeEntry(i->_value);
+
+	_entries.push_front(entry);
+	_map[key] = _entries.begin();
+	_size += entry->numSamples * sizeof(int16);
+
+	// Discard the least recently used sounds, until the cache fits again
+	while (_size > _maxSize)
+		removeEntry(--_entries.end());
+
+	entry->refCount++;
+	return new PCMCacheStream(this, entry);
+}
+
+void PCMCache::clear() {
+	Common::StackLock lock(_mutex);
+
+	while (!_entries.empty())
+		removeEntry(_entries.begin());
+}
+
+void PCMCache::removeEntry(EntryList::iterator i) {
+	Entry *entry = *i;
+
+	_map.erase(entry->key);
+	_entries.erase(i);
+	_size -= entry->numSamples * sizeof(int16);
+
+	// Streams still playing the sound keep the samples alive
+	unrefEntry(entry);
+}
+
+void PCMCache::releaseEntry(Entry *entry) {
+	Common::StackLock lock(_mutex);
+	unrefEntry(entry);
+}
+
+void PCMCache::unrefEntry(Entry *entry) {
+	if (--entry->refCount == 0) {
+		delete[] entry->samples;
+		delete entry;
+	}
+}
+
+} // End of namespace Audio
@@ -0,0 +1,159 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ */
+
+#ifndef AUDIO_PCMCACHE_H
+#define AUDIO_PCMCACHE_H
+
+#include "common/hash-str.h"
+#include "common/hashmap.h"
+#include "common/list.h"
+#include "common/mutex.h"
+#include "common/str.h"
+
+namespace Audio {
+
+class RewindableAudioStream;
+class SeekableAudioStream;
+
+/**
+ * Identifies a sound in a PCMCache.
+ */
+struct PCMCacheKey {
+	Common::String archive;	///< The name of the file containing the sound
+	uint32 id;				///< The resource id of the sound
+	uint32 offset;			///< The offset of the sound in the file
+
+	PCMCacheKey(const Common::String &a, uint32 i, uint32 o) : archive(a), id(i), offset(o) {}
+
+	bool operator==(const PCMCacheKey &key) const {
+		return id == key.id && offset == key.offset && archive == key.archive;
+	}
+};
+
+struct PCMCacheKey_Hash {
+	uint operator()(const PCMCacheKey &key) const {
+		return Common::hashit(key.archive.c_str()) ^ (key.id * 2654435761U) ^ key.offset;
+	}
+};
+
+/**
+ * A cache of decoded sounds, meant for short sound effects which are played
+ * over and over again. Instead of creating a new decoder for every playback,
+ * engines can look up a sound in the cache, and only decode it on a miss:
+ *
+ *   Audio::PCMCacheKey key(filename, resourceId, offset);
+ *   Audio::RewindableAudioStream *stream = cache.getStream(key);
+ *   if (!stream)
+ *       stream = cache.addStream(key, Audio::makeVOCStream(...));
+ *
+ * The cache holds the decoded samples of up to a given size, and discards the
+ * least recently used sounds when it is full. The streams handed out by the
+ * cache share the samples of the cached sound. Once a sound is discarded, its
+ * samples are freed when the last of these streams is destroyed. The cache
+ * must not be destroyed before all of its streams.
+ */
+class PCMCache {
+public:
+	/**
+	 * @param maxSize	The maximum size of all cached samples, in bytes
+	 */
+	PCMCache(uint32 maxSize);
+	~PCMCache();
+
+	/**
+	 * Create a stream playing a cached sound.
+	 *
+	 * @param key	the sound to look up
+	 * @return a new stream, or 0 if the sound is not in the cache
+	 */
+	RewindableAudioStream *getStream(const PCMCacheKey &key);
+
+	/**
+	 * Decode a sound into the cache, and create a stream playing it. The
+	 * given stream is deleted. Sounds larger than a quarter of the cache
+	 * size are not cached. In that case, the given stream is returned.
+	 *
+	 * @param key		the sound to add
+	 * @param stream	the stream to decode
+	 * @return a new stream playing the sound
+	 */
+	RewindableAudioStream *addStream(const PCMCacheKey &key, SeekableAudioStream *stream);
+
+	/** Discard all cached sounds. */
+	void clear();
+
+	/** Returns how often getStream() found a sound in the cache. */
+	uint32 getHits() const { return _hits; }
+
+	/** Returns how often getStream() did not find a sound in the cache. */
+	uint32 getMisses() const { return _misses; }
+
+	/** Returns the size of all cached samples, in bytes. */
+	uint32 getSize() const { return _size; }
+
+private:
+	friend class PCMCacheStream;
+
+	struct Entry {
+		PCMCacheKey key;
+		int16 *samples;
+		uint32 numSamples;
+		int rate;
+		bool stereo;
+
+		/** The number of streams using the samples, plus one while cached */
+		int refCount;
+
+		Entry(const PCMCacheKey &k) : key(k), samples(0), numSamples(0), rate(0), stereo(false), refCount(1) {}
+	};
+
+	typedef Common::List<Entry *> EntryList;
+	typedef Common::HashMap<PCMCacheKey, EntryList::iterator, PCMCacheKey_Hash> EntryMap;
+
+	/** The cached sounds, the most recently used one first */
+	EntryList _entries;
+	EntryMap _map;
+
+	const uint32 _maxSize;
+	uint32 _size;
+
+	uint32 _hits;
+	uint32 _misses;
+
+	/**
+	 * Protects the reference counts, since the streams are usually destroyed
+	 * by the mixer.
+	 */
+	Common::Mutex _mutex;
+
+	void removeEntry(EntryList::iterator i);
+
+	/** Called by PCMCacheStream when it is destroyed. */
+	void releaseEntry(Entry *entry);
+
+	/** Drop a reference to the entry. Must be called with _mutex held. */
+	void unrefEntry(Entry *entry);
+};
+
+} // End of namespace Audio
+
+#endif
@@ -30,8 +30,9 @@
 
 #include "audio/audiostream.h"
 #include "audio/rate.h"
-#include "audio/mixer.h"
+#include "common/algorithm.h"
 #include "common/frac.h"
+#include "common/math.h"
 #include "common/textconsole.h"
 #include "common/util.h"
 
@@ -69,8 +70,8 @@ protected:
 
 public:
 	SimpleRateConverter(st_rate_t inrate, st_rate_t outrate);
-	int flow(AudioStream &input, st_sample_t *obuf, st_size_t osamp, st_volume_t vol_l, st_volume_t vol_r);
-	int drain(st_sample_t *obuf, st_size_t osamp, st_volume_t vol) {
+	int flow(AudioStream &input, st_bus_t *obuf, st_size_t osamp, st_volume_t vol_l, st_volume_t vol_r);
+	int drain(st_bus_t *obuf, st_size_t osamp, st_volume_t vol) {
 		return ST_SUCCESS;
 	}
 };
@@ -102,8 +103,8 @@ SimpleRateConverter<stereo, reverseStereo>::SimpleRateConverter(st_rate_t inrate
  * Return number of sample pairs processed.
  */
 template<bool stereo, bool reverseStereo>
-int SimpleRateConverter<stereo, reverseStereo>::flow(AudioStream &input, st_sample_t *obuf, st_size_t osamp, st_volume_t vol_l, st_volume_t vol_r) {
-	st_sample_t *ostart, *oend;
+int SimpleRateConverter<stereo, reverseStereo>::flow(AudioStream &input, st_bus_t *obuf, st_size_t osamp, st_volume_t vol_l, st_volume_t vol_r) {
+	st_bus_t *ostart, *oend;
 
 	ostart = obuf;
 	oend = obuf + osamp * 2;
@@ -134,10 +135,10 @@ int SimpleRateConverter<stereo, reverseStereo>::flow(AudioStream &input, st_samp
 		opos += opos_inc;
 
 		// output left channel
-		clampedAdd(obuf[reverseStereo    ], (out0 * (int)vol_l) / Audio::Mixer::kMaxMixerVolume);
+		obuf[reverseStereo    ] += out0 * (int)vol_l;
 
 		// output right channel
-		clampedAdd(obuf[reverseStereo ^ 1], (out1 * (int)vol_r) / Audio::Mixer::kMaxMixerVolume);
+		obuf[reverseStereo ^ 1] += out1 * (int)vol_r;
 
 		obuf += 2;
 	}
@@ -175,8 +176,8 @@ protected:
 
 public:
 	LinearRateConverter(st_rate_t inrate, st_rate_t outrate);
-	int flow(AudioStream &input, st_sample_t *obuf, st_size_t osamp, st_volume_t vol_l, st_volume_t vol_r);
-	int drain(st_sample_t *obuf, st_size_t osamp, st_volume_t vol) {
+	int flow(AudioStream &input, st_bus_t *obuf, st_size_t osamp, st_volume_t vol_l, st_volume_t vol_r);
+	int drain(st_bus_t *obuf, st_size_t osamp, st_volume_t vol) {
 		return ST_SUCCESS;
 	}
 };
@@ -211,8 +212,8 @@ LinearRateConverter<stereo, reverseStereo>::LinearRateConverter(st_rate_t inrate
  * Return number of sample pairs processed.
  */
 template<bool stereo, bool reverseStereo>
-int LinearRateConverter<stereo, reverseStereo>::flow(AudioStream &input, st_sample_t *obuf, st_size_t osamp, st_volume_t vol_l, st_volume_t vol_r) {
-	st_sample_t *ostart, *oend;
+int LinearRateConverter<stereo, reverseStereo>::flow(AudioStream &input, st_bus_t *obuf, st_size_t osamp, st_volume_t vol_l, st_volume_t vol_r) {
+	st_bus_t *ostart, *oend;
 
 	ostart = obuf;
 	oend = obuf + osamp * 2;
@@ -249,10 +250,10 @@ int LinearRateConverter<stereo, reverseStereo>::flow(AudioStream &input, st_samp
 						  out0);
 
 			// output left channel
-			clampedAdd(obuf[reverseStereo    ], (out0 * (int)vol_l) / Audio::Mixer::kMaxMixerVolume);
+			obuf[reverseStereo    ] += out0 * (int)vol_l;
 
 			// output right channel
-			clampedAdd(obuf[reverseStereo ^ 1], (out1 * (int)vol_r) / Audio::Mixer::kMaxMixerVolume);
+			obuf[reverseStereo ^ 1] += out1 * (int)vol_r;
 
 			obuf += 2;
 
@@ -280,14 +281,9 @@ public:
 		free(_buffer);
 	}
 
-	virtual int flow(AudioStream &input, st_sample_t *obuf, st_size_t osamp, st_volume_t vol_l, st_volume_t vol_r) {
+	virtual int flow(AudioStream &input, st_bus_t *obuf, st_size_t osamp, st_volume_t vol_l, st_volume_t vol_r) {
 		assert(input.isStereo() == stereo);
 
-		st_sample_t *ptr;
-		st_size_t len;
-
-		st_sample_t *ostart = obuf;
-
 		if (stereo)
 			osamp *= 2;
 
@@ -302,38 +298,278 @@ public:
 			error("[CopyRateConverter::flow] Cannot allocate memory for temp buffer");
 
 		// Read up to 'osamp' samples into our temporary buffer
-		len = input.readBuffer(_buffer, osamp);
+		const int len = input.readBuffer(_buffer, osamp);
+		const int pairs = stereo ? len / 2 : len;
 
-		// Mix the data into the output buffer
-		ptr = _buffer;
-		for (; len > 0; len -= (stereo ? 2 : 1)) {
-			st_sample_t out0, out1;
-			out0 = *ptr++;
-			out1 = (stereo ? *ptr++ : out0);
+		// Mix the data into the output buffer. The iterations don't depend
+		// on each other, so the compiler is free to vectorize this loop.
+		const int volL = vol_l;
+		const int volR = vol_r;
+		for (int i = 0; i < pairs; i++) {
+			const int out0 = _buffer[stereo ? 2 * i : i];
+			const int out1 = (stereo ? _buffer[2 * i + 1] : out0);
 
 			// output left channel
-			clampedAdd(obuf[reverseStereo    ], (out0 * (int)vol_l) / Audio::Mixer::kMaxMixerVolume);
+			obuf[2 * i + reverseStereo    ] += out0 * volL;
 
 			// output right channel
-			clampedAdd(obuf[reverseStereo ^ 1], (out1 * (int)vol_r) / Audio::Mixer::kMaxMixerVolume);
-
-			obuf += 2;
+			obuf[2 * i + (reverseStereo ^ 1)] += out1 * volR;
 		}
-		return (obuf - ostart) / 2;
+		return pairs;
 	}
 
-	virtual int drain(st_sample_t *obuf, st_size_t osamp, st_volume_t vol) {
+	virtual int drain(st_bus_t *obuf, st_size_t osamp, st_volume_t vol) {
 		return ST_SUCCESS;
 	}
 };
 
 
+#pragma mark -
+
+
+/**
+ * The number of filter taps the SincRateConverter uses when upsampling.
+ * When downsampling, the filter gets wider by the rate ratio, but never
+ * exceeds SINC_MAX_TAPS. This bounds the work per output sample.
+ */
+#define SINC_TAPS 32
+#define SINC_MAX_TAPS 64
+
+/**
+ * The maximum number of filter phases of the SincRateConverter. If the rate
+ * ratio requires more phases, the closest phase is used.
+ */
+#define SINC_MAX_PHASES 1024
+
+/**
+ * The cutoff frequency of the SincRateConverter's filter, relative to the
+ * lower one of the input and the output rate. It is slightly below the
+ * Nyquist frequency, so that the filter's transition band is mostly below it.
+ */
+#define SINC_CUTOFF 0.45
+
+/** The beta parameter of the Kaiser window, giving about 60 dB attenuation. */
+#define SINC_KAISER_BETA 6.0
+
+/** The number of fractional bits of the filter coefficients. */
+#define SINC_COEF_BITS 14
+
+/**
+ * Audio rate converter using a windowed sinc filter (polyphase resampling).
+ *
+ * Unlike LinearRateConverter, which only softens the images of the input
+ * spectrum (audible as aliasing, especially with 11 kHz and 22 kHz samples),
+ * this suppresses them. The filter coefficients for all phases needed for
+ * the rate ratio are computed once, when the converter is created. This is
+ * the only place where floating point arithmetic is used.
+ *
+ * Limited to sampling frequency <= 65535 Hz.
+ */
+template<bool stereo, bool reverseStereo>
+class SincRateConverter : public RateConverter {
+protected:
+	st_sample_t inBuf[INTERMEDIATE_BUFFER_SIZE];
+	const st_sample_t *inPtr;
+	int inLen;
+
+	/** The input position increment per output sample is inc / den */
+	uint32 inc, den;
+
+	/** position of the output stream between two input samples, in units of 1 / den */
+	uint32 pos;
+
+	/** number of filter taps */
+	int taps;
+
+	/** number of filter phases */
+	uint32 phases;
+
+	/** filter coefficients, taps per phase */
+	int16 *bank;
+
+	/**
+	 * The last input samples (left/right channel). Every sample is stored
+	 * twice, at histPos and at histPos + taps, so that the last taps
+	 * samples can always be accessed without wrapping around.
+	 */
+	st_sample_t *history[2];
+	int histPos;
+
+	static double besselI0(double x);
+
+	void pushSample(int channel, st_sample_t sample) {
+		history[channel][histPos] = history[channel][histPos + taps] = sample;
+	}
+
+	static int applyFilter(const st_sample_t *samples, const int16 *coefs, int taps) {
+		// Kept simple so that the compiler can vectorize it
+		int32 acc = 0;
+		for (int i = 0; i < taps; i++)
+			acc += samples[i] * coefs[i];
+		return acc >> SINC_COEF_BITS;
+	}
+
+public:
+	SincRateConverter(st_rate_t inrate, st_rate_t outrate);
+	~SincRateConverter();
+	int flow(AudioStream &input, st_bus_t *obuf, st_size_t osamp, st_volume_t vol_l, st_volume_t vol_r);
+	int drain(st_bus_t *obuf, st_size_t osamp, st_volume_t vol) {
+		return ST_SUCCESS;
+	}
+};
+
+/*
+ * Modified Bessel function of the first kind, used by the Kaiser window.
+ */
+template<bool stereo, bool reverseStereo>
+double SincRateConverter<stereo, reverseStereo>::besselI0(double x) {
+	double sum = 1.0, term = 1.0;
+	for (int k = 1; k < 32 && term > sum * 1e-12; k++) {
+		term *= (x / (2 * k)) * (x / (2 * k));
+		sum += term;
+	}
+	return sum;
+}
+
+/*
+ * Prepare processing.
+ */
+template<bool stereo, bool reverseStereo>
+SincRateConverter<stereo, reverseStereo>::SincRateConverter(st_rate_t inrate, st_rate_t outrate) {
+	if (inrate >= 65536 || outrate >= 65536) {
+		error("rate effect can only handle rates < 65536");
+	}
+
+	const st_rate_t divisor = Common::gcd(inrate, outrate);
+	inc = inrate / divisor;
+	den = outrate / divisor;
+	pos = den;
+
+	// When downsampling, the cutoff frequency has to be lowered to the
+	// output's Nyquist frequency, which makes the filter wider.
+	const double scale = (outrate < inrate) ? (double)outrate / inrate : 1.0;
+	taps = MIN<int>(((int)ceil(SINC_TAPS / scale) + 1) & ~1, SINC_MAX_TAPS);
+	phases = MIN<uint32>(den, SINC_MAX_PHASES);
+
+	bank = new int16[phases * taps];
+
+	const double cutoff = SINC_CUTOFF * scale;
+	const double window = besselI0(SINC_KAISER_BETA);
+
+	double *coefs = new double[taps];
+
+	for (uint32 phase = 0; phase < phases; phase++) {
+		const double frac = (double)phase / phases;
+		double sum = 0.0;
+
+		// Tap i is applied to the input sample at distance x from the
+		// position of the output sample
+		for (int i = 0; i < taps; i++) {
+			const double x = i + 1 - taps / 2 - frac;
+			const double t = x / (taps / 2);
+			const double sinc = (x == 0.0) ? 1.0 : sin(2 * M_PI * cutoff * x) / (2 * M_PI * cutoff * x);
+			const double kaiser = (t * t < 1.0) ? besselI0(SINC_KAISER_BETA * sqrt(1.0 - t * t)) / window : 0.0;
+
+			coefs[i] = sinc * kaiser;
+			sum += coefs[i];
+		}
+
+		// Normalize every phase, so they all have exactly the same DC gain
+		int16 *phaseCoefs = bank + phase * taps;
+		int total = 0, center = taps / 2 - 1;
+		for (int i = 0; i < taps; i++) {
+			phaseCoefs[i] = (int16)floor(coefs[i] / sum * (1 << SINC_COEF_BITS) + 0.5);
+			total += phaseCoefs[i];
+			if (coefs[i] > coefs[center])
+				center = i;
+		}
+		phaseCoefs[center] += (1 << SINC_COEF_BITS) - total;
+	}
+
+	delete[] coefs;
+
+	history[0] = new st_sample_t[2 * taps];
+	history[1] = stereo ? new st_sample_t[2 * taps] : 0;
+	memset(history[0], 0, 2 * taps * sizeof(st_sample_t));
+	if (stereo)
+		memset(history[1], 0, 2 * taps * sizeof(st_sample_t));
+	histPos = 0;
+
+	inLen = 0;
+}
+
+template<bool stereo, bool reverseStereo>
+SincRateConverter<stereo, reverseStereo>::~SincRateConverter() {
+	delete[] bank;
+	delete[] history[0];
+	delete[] history[1];
+}
+
+/*
+ * Processed signed long samples from ibuf to obuf.
+ * Return number of sample pairs processed.
+ */
+template<bool stereo, bool reverseStereo>
+int SincRateConverter<stereo, reverseStereo>::flow(AudioStream &input, st_bus_t *obuf, st_size_t osamp, st_volume_t vol_l, st_volume_t vol_r) {
+	st_bus_t *ostart, *oend;
+
+	ostart = obuf;
+	oend = obuf + osamp * 2;
+
+	while (obuf < oend) {
+
+		// read enough input samples so that pos < den
+		while (pos >= den) {
+			// Check if we have to refill the buffer
+			if (inLen == 0) {
+				inPtr = inBuf;
+				inLen = input.readBuffer(inBuf, ARRAYSIZE(inBuf));
+				if (inLen <= 0)
+					return (obuf - ostart) / 2;
+			}
+			inLen -= (stereo ? 2 : 1);
+			if (++histPos == taps)
+				histPos = 0;
+			pushSample(0, *inPtr++);
+			if (stereo)
+				pushSample(1, *inPtr++);
+			pos -= den;
+		}
+
+		// Loop as long as the outpos trails behind, and as long as there is
+		// still space in the output buffer.
+		while (pos < den && obuf < oend) {
+			const uint32 phase = (phases == den) ? pos : pos * phases / den;
+			const int16 *coefs = bank + phase * taps;
+
+			int out0, out1;
+			out0 = applyFilter(history[0] + histPos + 1, coefs, taps);
+			out1 = (stereo ? applyFilter(history[1] + histPos + 1, coefs, taps) : out0);
+
+			// output left channel
+			obuf[reverseStereo    ] += out0 * (int)vol_l;
+
+			// output right channel
+			obuf[reverseStereo ^ 1] += out1 * (int)vol_r;
+
+			obuf += 2;
+
+			// Increment output position
+			pos += inc;
+		}
+	}
+	return (obuf - ostart) / 2;
+}
+
+
 #pragma mark -
 
 template<bool stereo, bool reverseStereo>
-RateConverter *makeRateConverter(st_rate_t inrate, st_rate_t outrate) {
+RateConverter *makeRateConverter(st_rate_t inrate, st_rate_t outrate, bool highQuality) {
 	if (inrate != outrate) {
-		if ((inrate % outrate) == 0) {
+		if (highQuality) {
+			return new SincRateConverter<stereo, reverseStereo>(inrate, outrate);
+		} else if ((inrate % outrate) == 0) {
 			return new SimpleRateConverter<stereo, reverseStereo>(inrate, outrate);
 		} else {
 			return new LinearRateConverter<stereo, reverseStereo>(inrate, outrate);
@@ -346,14 +582,14 @@ RateConverter *makeRateConverter(st_rate_t inrate, st_rate_t outrate) {
 /**
  * Create and return a RateConverter object for the specified input and output rates.
  */
-RateConverter *makeRateConverter(st_rate_t inrate, st_rate_t outrate, bool stereo, bool reverseStereo) {
+RateConverter *makeRateConverter(st_rate_t inrate, st_rate_t outrate, bool stereo, bool reverseStereo, bool highQuality) {
 	if (stereo) {
 		if (reverseStereo)
-			return makeRateConverter<true, true>(inrate, outrate);
+			return makeRateConverter<true, true>(inrate, outrate, highQuality);
 		else
-			return makeRateConverter<true, false>(inrate, outrate);
+			return makeRateConverter<true, false>(inrate, outrate, highQuality);
 	} else
-		return makeRateConverter<false, false>(inrate, outrate);
+		return makeRateConverter<false, false>(inrate, outrate, highQuality);
 }
 
 } // End of namespace Audio
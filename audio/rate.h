@@ -34,12 +34,26 @@ typedef uint16 st_volume_t;
 typedef uint32 st_size_t;
 typedef uint32 st_rate_t;
 
+/**
+ * The sample type of the mixing bus the rate converters add their output
+ * to. Instead of dividing the samples by the volume (which ranges from 0 to
+ * Mixer::kMaxMixerVolume), the bus keeps them multiplied by it, i.e. with
+ * ST_BUS_FRAC_BITS extra bits of precision. This way, mixing neither loses
+ * precision nor saturates, no matter how many channels overlap, and the
+ * result only needs to be clamped once in the end.
+ */
+typedef int32 st_bus_t;
+
 /* Minimum and maximum values a sample can hold. */
 enum {
 	ST_SAMPLE_MAX = 0x7fffL,
 	ST_SAMPLE_MIN = (-ST_SAMPLE_MAX - 1L)
 };
 
+enum {
+	ST_BUS_FRAC_BITS = 8
+};
+
 enum {
 	ST_EOF = -1,
 	ST_SUCCESS = 0
@@ -65,20 +79,49 @@ static inline void clampedAdd(int16& a, int b) {
 #endif
 }
 
+/**
+ * Convert samples of a mixing bus back to st_sample_t, rounding and
+ * clamping them.
+ *
+ * @param dst	the buffer to write the samples to
+ * @param src	the mixing bus
+ * @param len	the number of samples (not sample pairs) to convert
+ */
+static inline void convertBusToSamples(st_sample_t *dst, const st_bus_t *src, st_size_t len) {
+	for (st_size_t i = 0; i < len; i++) {
+		const st_bus_t val = (src[i] + (1 << (ST_BUS_FRAC_BITS - 1))) >> ST_BUS_FRAC_BITS;
+		dst[i] = (val > ST_SAMPLE_MAX) ? ST_SAMPLE_MAX : ((val < ST_SAMPLE_MIN) ? ST_SAMPLE_MIN : val);
+	}
+}
+
 class RateConverter {
 public:
 	RateConverter() {}
 	virtual ~RateConverter() {}
 
 	/**
+	 * Read samples from the input stream, convert them to the output rate,
+	 * and add them to the mixing bus, scaled by the given volumes.
+	 *
 	 * @return Number of sample pairs written into the buffer.
 	 */
-	virtual int flow(AudioStream &input, st_sample_t *obuf, st_size_t osamp, st_volume_t vol_l, st_volume_t vol_r) = 0;
+	virtual int flow(AudioStream &input, st_bus_t *obuf, st_size_t osamp, st_volume_t vol_l, st_volume_t vol_r) = 0;
 
-	virtual int drain(st_sample_t *obuf, st_size_t osamp, st_volume_t vol) = 0;
+	virtual int drain(st_bus_t *obuf, st_size_t osamp, st_volume_t vol) = 0;
 };
 
-RateConverter *makeRateConverter(st_rate_t inrate, st_rate_t outrate, bool stereo, bool reverseStereo = false);
+/**
+ * Create a rate converter for the given input and output rates.
+ *
+ * @param inrate		the sample rate of the input stream
+ * @param outrate		the sample rate to convert to
+ * @param stereo		whether the input stream is stereo
+ * @param reverseStereo	whether to swap the left and right channels
+ * @param highQuality	whether to use a windowed sinc filter instead of
+ *						linear interpolation when the rates differ. This
+ *						sounds a lot cleaner, but is also a lot slower.
+ */
+RateConverter *makeRateConverter(st_rate_t inrate, st_rate_t outrate, bool stereo, bool reverseStereo = false, bool highQuality = false);
 
 } // End of namespace Audio
 
@@ -68,6 +68,19 @@ namespace Audio {
  */
 #define INTERMEDIATE_BUFFER_SIZE 512
 
+/**
+ * The assembler routines mix into a buffer of st_sample_t. To use them with
+ * the mixing bus, we let them write into a zeroed scratch buffer of this
+ * size, which is then added to the bus. With only one channel in the scratch
+ * buffer, the clamping done by the assembler routines has no effect.
+ */
+#define SCRATCH_BUFFER_SIZE 512
+
+static void addScratchToBus(st_bus_t *obuf, const st_sample_t *scratch, int len) {
+	for (int i = 0; i < len; i++)
+		obuf[i] += scratch[i] * (1 << ST_BUS_FRAC_BITS);
+}
+
 
 /**
  * Audio rate converter based on simple resampling. Used when no
@@ -95,8 +108,8 @@ protected:
 	SimpleRateDetails  sr;
 public:
 	SimpleRateConverter(st_rate_t inrate, st_rate_t outrate);
-	int flow(AudioStream &input, st_sample_t *obuf, st_size_t osamp, st_volume_t vol_l, st_volume_t vol_r);
-	int drain(st_sample_t *obuf, st_size_t osamp, st_volume_t vol) {
+	int flow(AudioStream &input, st_bus_t *obuf, st_size_t osamp, st_volume_t vol_l, st_volume_t vol_r);
+	int drain(st_bus_t *obuf, st_size_t osamp, st_volume_t vol) {
 		return (ST_SUCCESS);
 	}
 };
@@ -169,31 +182,49 @@ extern "C" int SimpleRate_readFudge(Audio::AudioStream &input, int16 *a, int b)
 }
 
 template<bool stereo, bool reverseStereo>
-int SimpleRateConverter<stereo, reverseStereo>::flow(AudioStream &input, st_sample_t *obuf, st_size_t osamp, st_volume_t vol_l, st_volume_t vol_r) {
+int SimpleRateConverter<stereo, reverseStereo>::flow(AudioStream &input, st_bus_t *obuf, st_size_t osamp, st_volume_t vol_l, st_volume_t vol_r) {
 
 #ifdef DEBUG_RATECONV
 	debug("Simple st=%d rev=%d", stereo, reverseStereo);
 #endif
-	st_sample_t *ostart = obuf;
-
-	if (!stereo) {
-		obuf = ARM_SimpleRate_M(input,
-								&SimpleRate_readFudge,
-								&sr,
-								obuf, osamp, vol_l, vol_r);
-	} else if (reverseStereo) {
-		obuf = ARM_SimpleRate_R(input,
-								&SimpleRate_readFudge,
-								&sr,
-								obuf, osamp, vol_l, vol_r);
-	} else {
-		obuf = ARM_SimpleRate_S(input,
-								&SimpleRate_readFudge,
-								&sr,
-								obuf, osamp, vol_l, vol_r);
+
+	st_sample_t scratch[SCRATCH_BUFFER_SIZE];
+	int written = 0;
+
+	while (osamp > 0) {
+		const st_size_t chunk = MIN<st_size_t>(osamp, ARRAYSIZE(scratch) / 2);
+		st_sample_t *end;
+
+		memset(scratch, 0, sizeof(scratch));
+
+		if (!stereo) {
+			end = ARM_SimpleRate_M(input,
+									&SimpleRate_readFudge,
+									&sr,
+									scratch, chunk, vol_l, vol_r);
+		} else if (reverseStereo) {
+			end = ARM_SimpleRate_R(input,
+									&SimpleRate_readFudge,
+									&sr,
+									scratch, chunk, vol_l, vol_r);
+		} else {
+			end = ARM_SimpleRate_S(input,
+									&SimpleRate_readFudge,
+									&sr,
+									scratch, chunk, vol_l, vol_r);
+		}
+
+		const int len = end - scratch;
+		addScratchToBus(obuf + written, scratch, len);
+		written += len;
+		osamp -= chunk;
+
+		// Stop if the input stream ran dry
+		if (len < (int)chunk * 2)
+			break;
 	}
 
-	return (obuf - ostart) / 2;
+	return written / 2;
 }
 
 /**
@@ -269,8 +300,8 @@ protected:
 
 public:
 	LinearRateConverter(st_rate_t inrate, st_rate_t outrate);
-	int flow(AudioStream &input, st_sample_t *obuf, st_size_t osamp, st_volume_t vol_l, st_volume_t vol_r);
-	int drain(st_sample_t *obuf, st_size_t osamp, st_volume_t vol) {
+	int flow(AudioStream &input, st_bus_t *obuf, st_size_t osamp, st_volume_t vol_l, st_volume_t vol_r);
+	int drain(st_bus_t *obuf, st_size_t osamp, st_volume_t vol) {
 		return (ST_SUCCESS);
 	}
 };
@@ -309,36 +340,54 @@ LinearRateConverter<stereo, reverseStereo>::LinearRateConverter(st_rate_t inrate
  * Return number of sample pairs processed.
  */
 template<bool stereo, bool reverseStereo>
-int LinearRateConverter<stereo, reverseStereo>::flow(AudioStream &input, st_sample_t *obuf, st_size_t osamp, st_volume_t vol_l, st_volume_t vol_r) {
+int LinearRateConverter<stereo, reverseStereo>::flow(AudioStream &input, st_bus_t *obuf, st_size_t osamp, st_volume_t vol_l, st_volume_t vol_r) {
 
 #ifdef DEBUG_RATECONV
 	debug("Linear st=%d rev=%d", stereo, reverseStereo);
 #endif
-	st_sample_t *ostart = obuf;
-
 	if (vol_l > 0xff)
 		vol_l = 0xff;
 
 	if (vol_r > 0xff)
 		vol_r = 0xff;
 
-	if (!stereo) {
-		obuf = ARM_LinearRate_M(input,
-								&SimpleRate_readFudge,
-								&lr,
-								obuf, osamp, vol_l, vol_r);
-	} else if (reverseStereo) {
-		obuf = ARM_LinearRate_R(input,
-								&SimpleRate_readFudge,
-								&lr,
-								obuf, osamp, vol_l, vol_r);
-	} else {
-		obuf = ARM_LinearRate_S(input,
-								&SimpleRate_readFudge,
-								&lr,
-								obuf, osamp, vol_l, vol_r);
+	st_sample_t scratch[SCRATCH_BUFFER_SIZE];
+	int written = 0;
+
+	while (osamp > 0) {
+		const st_size_t chunk = MIN<st_size_t>(osamp, ARRAYSIZE(scratch) / 2);
+		st_sample_t *end;
+
+		memset(scratch, 0, sizeof(scratch));
+
+		if (!stereo) {
+			end = ARM_LinearRate_M(input,
+									&SimpleRate_readFudge,
+									&lr,
+									scratch, chunk, vol_l, vol_r);
+		} else if (reverseStereo) {
+			end = ARM_LinearRate_R(input,
+									&SimpleRate_readFudge,
+									&lr,
+									scratch, chunk, vol_l, vol_r);
+		} else {
+			end = ARM_LinearRate_S(input,
+									&SimpleRate_readFudge,
+									&lr,
+									scratch, chunk, vol_l, vol_r);
+		}
+
+		const int len = end - scratch;
+		addScratchToBus(obuf + written, scratch, len);
+		written += len;
+		osamp -= chunk;
+
+		// Stop if the input stream ran dry
+		if (len < (int)chunk * 2)
+			break;
 	}
-	return (obuf - ostart) / 2;
+
+	return written / 2;
 }
 
 
@@ -389,14 +438,13 @@ public:
 		free(_buffer);
 	}
 
-	virtual int flow(AudioStream &input, st_sample_t *obuf, st_size_t osamp, st_volume_t vol_l, st_volume_t vol_r) {
+	virtual int flow(AudioStream &input, st_bus_t *obuf, st_size_t osamp, st_volume_t vol_l, st_volume_t vol_r) {
 		assert(input.isStereo() == stereo);
 
 #ifdef DEBUG_RATECONV
 		debug("Copy st=%d rev=%d", stereo, reverseStereo);
 #endif
 		st_size_t len;
-		st_sample_t *ostart = obuf;
 
 		if (stereo)
 			osamp *= 2;
@@ -414,17 +462,31 @@ public:
 			return 0;
 
 		// Mix the data into the output buffer
-		if (stereo && reverseStereo)
-			obuf = ARM_CopyRate_R(len, obuf, vol_l, vol_r, _buffer);
-		else if (stereo)
-			obuf = ARM_CopyRate_S(len, obuf, vol_l, vol_r, _buffer);
-		else
-			obuf = ARM_CopyRate_M(len, obuf, vol_l, vol_r, _buffer);
-
-		return (obuf - ostart) / 2;
+		st_sample_t scratch[SCRATCH_BUFFER_SIZE];
+		const st_size_t chunkSize = stereo ? ARRAYSIZE(scratch) : ARRAYSIZE(scratch) / 2;
+		int written = 0;
+
+		for (st_size_t pos = 0; pos < len; pos += chunkSize) {
+			const st_size_t chunk = MIN<st_size_t>(len - pos, chunkSize);
+			st_sample_t *end;
+
+			memset(scratch, 0, sizeof(scratch));
+
+			if (stereo && reverseStereo)
+				end = ARM_CopyRate_R(chunk, scratch, vol_l, vol_r, _buffer + pos);
+			else if (stereo)
+				end = ARM_CopyRate_S(chunk, scratch, vol_l, vol_r, _buffer + pos);
+			else
+				end = ARM_CopyRate_M(chunk, scratch, vol_l, vol_r, _buffer + pos);
+
+			addScratchToBus(obuf + written, scratch, end - scratch);
+			written += end - scratch;
+		}
+
+		return written / 2;
 	}
 
-	virtual int drain(st_sample_t *obuf, st_size_t osamp, st_volume_t vol) {
+	virtual int drain(st_bus_t *obuf, st_size_t osamp, st_volume_t vol) {
 		return (ST_SUCCESS);
 	}
 };
@@ -435,8 +497,10 @@ public:
 
 /**
  * Create and return a RateConverter object for the specified input and output rates.
+ * There is no assembler version of the high quality converter, so the
+ * highQuality parameter is ignored.
  */
-RateConverter *makeRateConverter(st_rate_t inrate, st_rate_t outrate, bool stereo, bool reverseStereo) {
+RateConverter *makeRateConverter(st_rate_t inrate, st_rate_t outrate, bool stereo, bool reverseStereo, bool highQuality) {
 	if (inrate != outrate) {
 		if ((inrate % outrate) == 0) {
 			if (stereo) {
@@ -35,7 +35,10 @@
 #include "common/error.h"
 #include "common/events.h"
 #include "common/file.h"
+#include "common/mutex.h"
+#include "common/queue.h"
 #include "common/system.h"
+#include "common/timer.h"
 #include "common/util.h"
 #include "common/archive.h"
 #include "common/textconsole.h"
@@ -60,6 +63,58 @@ private:
 
 	int _outputRate;
 
+	/**
+	 * A MIDI message or SysEx waiting to be played. The synth is only
+	 * accessed while rendering, so messages may be sent from any thread.
+	 */
+	struct MidiEvent {
+		uint32 msg;
+		byte *sysex;	///< Copy of the SysEx data, or 0 for a regular message
+		uint16 length;
+	};
+
+	/**
+	 * The queue is drained whenever samples are rendered. If nothing is
+	 * rendered for a while, e.g. because the mixer is paused, further events
+	 * are dropped once this many are waiting.
+	 */
+	enum {
+		kMaxQueuedEvents = 4096
+	};
+
+	Common::Mutex _eventMutex;
+	Common::Queue<MidiEvent> _events;
+	uint _queuedEvents;
+	bool _eventsDropped;
+
+	void queueEvent(uint32 msg, const byte *sysex, uint16 length);
+	void playEvents();
+	void clearEvents();
+
+	/**
+	 * Held while rendering. The player callbacks run while rendering,
+	 * too, so they are called in order, at the right sample position.
+	 */
+	Common::Mutex _renderMutex;
+
+	/** Protects the render buffer positions. Only held for short periods of time. */
+	Common::Mutex _bufferMutex;
+
+	/** Ring buffer of samples rendered ahead of playback, or 0 if disabled */
+	int16 *_renderBuffer;
+	uint32 _renderBufferSize;
+	uint32 _renderReadPos;
+	uint32 _renderFill;
+
+	uint32 _underruns;
+
+	static void renderAheadProc(void *refCon);
+
+	/** Renders up to maxSamples samples into the render buffer. */
+	void renderAhead(uint32 maxSamples);
+
+	int readFromRenderBuffer(int16 *data, int numSamples);
+
 protected:
 	void generateSamples(int16 *buf, int len);
 
@@ -80,6 +135,7 @@ public:
 	MidiChannel *getPercussionChannel();
 
 	// AudioStream API
+	int readBuffer(int16 *data, const int numSamples);
 	bool isStereo() const { return true; }
 	int getRate() const { return _outputRate; }
 };
@@ -249,9 +305,18 @@ MidiDriver_MT32::MidiDriver_MT32(Audio::Mixer *mixer) : MidiDriver_Emulated(mixe
 	// rely on Mixer to convert.
 	_outputRate = 32000; //_mixer->getOutputRate();
 	_initializing = false;
+
+	_renderBuffer = 0;
+	_renderBufferSize = 0;
+	_renderReadPos = 0;
+	_renderFill = 0;
+	_underruns = 0;
+	_queuedEvents = 0;
+	_eventsDropped = false;
 }
 
 MidiDriver_MT32::~MidiDriver_MT32() {
+	clearEvents();
 	delete _synth;
 }
 
@@ -307,13 +372,34 @@ int MidiDriver_MT32::open() {
 
 	g_system->updateScreen();
 
+	// Rendering the MT-32 takes a lot of time, especially with many
+	// partials playing. To avoid skipping audio, it can be rendered from a
+	// timer callback into a buffer, which the mixer reads from. The music
+	// is then heard up to renderAheadMsecs later than without the buffer,
+	// and the player callback runs that much ahead of the audible music.
+	// This is why it is disabled by default.
+	const int renderAheadMsecs = ConfMan.getInt("mt32_render_ahead");
+	if (renderAheadMsecs > 0) {
+		// Keep a quarter of the buffer size (see renderAheadProc()) a
+		// multiple of two, so that stereo samples are never split.
+		_renderBufferSize = MAX<uint32>(renderAheadMsecs * getRate() / 1000 * 2, 1024) & ~7;
+		_renderBuffer = new int16[_renderBufferSize];
+		_renderReadPos = 0;
+		_renderFill = 0;
+		_underruns = 0;
+
+		// SDL timers have a resolution of 10ms, so there is no point in
+		// calling the timer more often.
+		g_system->getTimerManager()->installTimerProc(&renderAheadProc, 10000, this, "MT32RenderAhead");
+	}
+
 	_mixer->playStream(Audio::Mixer::kSFXSoundType, &_mixerSoundHandle, this, -1, Audio::Mixer::kMaxChannelVolume, 0, DisposeAfterUse::NO, true);
 
 	return 0;
 }
 
 void MidiDriver_MT32::send(uint32 b) {
-	_synth->playMsg(b);
+	queueEvent(b, 0, 0);
 }
 
 void MidiDriver_MT32::setPitchBendRange(byte channel, uint range) {
@@ -334,11 +420,65 @@ void MidiDriver_MT32::setPitchBendRange(byte channel, uint range) {
 }
 
 void MidiDriver_MT32::sysEx(const byte *msg, uint16 length) {
-	if (msg[0] == 0xf0) {
-		_synth->playSysex(msg, length);
-	} else {
-		_synth->playSysexWithoutFraming(msg, length);
+	queueEvent(0, msg, length);
+}
+
+void MidiDriver_MT32::queueEvent(uint32 msg, const byte *sysex, uint16 length) {
+	Common::StackLock lock(_eventMutex);
+
+	if (_queuedEvents >= kMaxQueuedEvents) {
+		if (!_eventsDropped)
+			warning("MT32emu: Too many MIDI events waiting to be played, dropping events");
+		_eventsDropped = true;
+		return;
+	}
+
+	MidiEvent event;
+	event.msg = msg;
+	event.sysex = 0;
+	event.length = length;
+
+	if (sysex) {
+		event.sysex = new byte[length];
+		memcpy(event.sysex, sysex, length);
 	}
+
+	_events.push(event);
+	_queuedEvents++;
+}
+
+void MidiDriver_MT32::playEvents() {
+	while (true) {
+		MidiEvent event;
+
+		{
+			Common::StackLock lock(_eventMutex);
+			if (_events.empty()) {
+				_eventsDropped = false;
+				return;
+			}
+			event = _events.pop();
+			_queuedEvents--;
+		}
+
+		if (!event.sysex) {
+			_synth->playMsg(event.msg);
+		} else if (event.sysex[0] == 0xf0) {
+			_synth->playSysex(event.sysex, event.length);
+		} else {
+			_synth->playSysexWithoutFraming(event.sysex, event.length);
+		}
+
+		delete[] event.sysex;
+	}
+}
+
+void MidiDriver_MT32::clearEvents() {
+	Common::StackLock lock(_eventMutex);
+	while (!_events.empty())
+		delete[] _events.pop().sysex;
+	_queuedEvents = 0;
+	_eventsDropped = false;
 }
 
 void MidiDriver_MT32::close() {
@@ -346,163 +486,134 @@ void MidiDriver_MT32::close() {
 		return;
 	_isOpen = false;
 
+	// Stop rendering ahead. This waits for the timer callback, in case it
+	// is rendering right now.
+	if (_renderBuffer) {
+		g_system->getTimerManager()->removeTimerProc(&renderAheadProc);
+		if (_underruns)
+			debug(1, "MT32emu: The render buffer ran empty %d times", _underruns);
+	}
+
 	// Detach the player callback handler
 	setTimerCallback(NULL, NULL);
 	// Detach the mixer callback handler
 	_mixer->stopHandle(_mixerSoundHandle);
 
+	delete[] _renderBuffer;
+	_renderBuffer = 0;
+
+	clearEvents();
+
 	_synth->close();
 	delete _synth;
 	_synth = NULL;
 }
 
 void MidiDriver_MT32::generateSamples(int16 *data, int len) {
+	playEvents();
 	_synth->render(data, len);
 }
 
-uint32 MidiDriver_MT32::property(int prop, uint32 param) {
-	switch (prop) {
-	case PROP_CHANNEL_MASK:
-		_channelMask = param & 0xFFFF;
-		return 1;
-	}
+void MidiDriver_MT32::renderAheadProc(void *refCon) {
+	MidiDriver_MT32 *driver = (MidiDriver_MT32 *)refCon;
 
-	return 0;
+	// Don't hold up other timer callbacks for too long, even if the
+	// buffer is empty, e.g. right after starting.
+	driver->renderAhead(driver->_renderBufferSize / 4);
 }
 
-MidiChannel *MidiDriver_MT32::allocateChannel() {
-	MidiChannel_MT32 *chan;
-	uint i;
+void MidiDriver_MT32::renderAhead(uint32 maxSamples) {
+	Common::StackLock renderLock(_renderMutex);
 
-	for (i = 0; i < ARRAYSIZE(_midiChannels); ++i) {
-		if (i == 9 || !(_channelMask & (1 << i)))
-			continue;
-		chan = &_midiChannels[i];
-		if (chan->allocate()) {
-			return chan;
+	while (maxSamples > 0) {
+		uint32 writePos, space;
+
+		{
+			Common::StackLock lock(_bufferMutex);
+			writePos = (_renderReadPos + _renderFill) % _renderBufferSize;
+			space = MIN(MIN(_renderBufferSize - _renderFill, _renderBufferSize - writePos), maxSamples);
 		}
-	}
-	return NULL;
-}
 
-MidiChannel *MidiDriver_MT32::getPercussionChannel() {
-	return &_midiChannels[9];
-}
+		if (space == 0)
+			return;
 
-// This code should be used when calling the timer callback from the mixer thread is undesirable.
-// Note that it results in less accurate timing.
-#if 0
-class MidiEvent_MT32 {
-public:
-	MidiEvent_MT32 *_next;
-	uint32 _msg; // 0xFFFFFFFF indicates a sysex message
-	byte *_data;
-	uint32 _len;
-
-	MidiEvent_MT32(uint32 msg, byte *data, uint32 len) {
-		_msg = msg;
-		if (len > 0) {
-			_data = new byte[len];
-			memcpy(_data, data, len);
-		}
-		_len = len;
-		_next = NULL;
-	}
+		// Only the mixer reads from the buffer, and only from the filled
+		// part of it, so we can render into the free part without holding
+		// the buffer mutex.
+		MidiDriver_Emulated::readBuffer(_renderBuffer + writePos, space);
 
-	MidiEvent_MT32() {
-		if (_len > 0)
-			delete _data;
+		Common::StackLock lock(_bufferMutex);
+		_renderFill += space;
+		maxSamples -= space;
 	}
-};
+}
 
-class MidiDriver_ThreadedMT32 : public MidiDriver_MT32 {
-private:
-	OSystem::Mutex _eventMutex;
-	MidiEvent_MT32 *_events;
-	TimerManager::TimerProc _timer_proc;
+int MidiDriver_MT32::readFromRenderBuffer(int16 *data, int numSamples) {
+	Common::StackLock lock(_bufferMutex);
 
-	void pushMidiEvent(MidiEvent_MT32 *event);
-	MidiEvent_MT32 *popMidiEvent();
+	int samples = 0;
+	while (samples < numSamples && _renderFill > 0) {
+		const uint32 count = MIN<uint32>(MIN(_renderFill, _renderBufferSize - _renderReadPos), numSamples - samples);
+		memcpy(data + samples, _renderBuffer + _renderReadPos, count * sizeof(int16));
 
-protected:
-	void send(uint32 b);
-	void sysEx(const byte *msg, uint16 length);
+		samples += count;
+		_renderReadPos = (_renderReadPos + count) % _renderBufferSize;
+		_renderFill -= count;
+	}
 
-public:
-	MidiDriver_ThreadedMT32(Audio::Mixer *mixer);
+	return samples;
+}
 
-	void onTimer();
-	void close();
-	void setTimerCallback(void *timer_param, TimerManager::TimerProc timer_proc);
-};
+int MidiDriver_MT32::readBuffer(int16 *data, const int numSamples) {
+	if (!_renderBuffer)
+		return MidiDriver_Emulated::readBuffer(data, numSamples);
 
+	int samples = readFromRenderBuffer(data, numSamples);
 
-MidiDriver_ThreadedMT32::MidiDriver_ThreadedMT32(Audio::Mixer *mixer) : MidiDriver_MT32(mixer) {
-	_events = NULL;
-	_timer_proc = NULL;
-}
+	if (samples < numSamples) {
+		// The buffer ran empty. Wait for the timer callback in case it is
+		// rendering right now, and render the rest ourselves if necessary.
+		Common::StackLock renderLock(_renderMutex);
 
-void MidiDriver_ThreadedMT32::close() {
-	MidiDriver_MT32::close();
-	while ((popMidiEvent() != NULL)) {
-		// Just eat any leftover events
-	}
-}
+		samples += readFromRenderBuffer(data + samples, numSamples - samples);
 
-void MidiDriver_ThreadedMT32::setTimerCallback(void *timer_param, TimerManager::TimerProc timer_proc) {
-	if (!_timer_proc || !timer_proc) {
-		if (_timer_proc)
-			_vm->_timer->removeTimerProc(_timer_proc);
-		_timer_proc = timer_proc;
-		if (timer_proc)
-			_vm->_timer->installTimerProc(timer_proc, getBaseTempo(), timer_param, "MT32tempo");
+		if (samples < numSamples) {
+			_underruns++;
+			MidiDriver_Emulated::readBuffer(data + samples, numSamples - samples);
+		}
 	}
-}
 
-void MidiDriver_ThreadedMT32::pushMidiEvent(MidiEvent_MT32 *event) {
-	Common::StackLock lock(_eventMutex);
-	if (_events == NULL) {
-		_events = event;
-	} else {
-		MidiEvent_MT32 *last = _events;
-		while (last->_next != NULL)
-			last = last->_next;
-		last->_next = event;
-	}
+	return numSamples;
 }
 
-MidiEvent_MT32 *MidiDriver_ThreadedMT32::popMidiEvent() {
-	Common::StackLock lock(_eventMutex);
-	MidiEvent_MT32 *event;
-	event = _events;
-	if (event != NULL)
-		_events = event->_next;
-	return event;
-}
+uint32 MidiDriver_MT32::property(int prop, uint32 param) {
+	switch (prop) {
+	case PROP_CHANNEL_MASK:
+		_channelMask = param & 0xFFFF;
+		return 1;
+	}
 
-void MidiDriver_ThreadedMT32::send(uint32 b) {
-	MidiEvent_MT32 *event = new MidiEvent_MT32(b, NULL, 0);
-	pushMidiEvent(event);
+	return 0;
 }
 
-void MidiDriver_ThreadedMT32::sysEx(const byte *msg, uint16 length) {
-	MidiEvent_MT32 *event = new MidiEvent_MT32(0xFFFFFFFF, msg, length);
-	pushMidiEvent(event);
-}
+MidiChannel *MidiDriver_MT32::allocateChannel() {
+	MidiChannel_MT32 *chan;
+	uint i;
 
-void MidiDriver_ThreadedMT32::onTimer() {
-	MidiEvent_MT32 *event;
-	while ((event = popMidiEvent()) != NULL) {
-		if (event->_msg == 0xFFFFFFFF) {
-			MidiDriver_MT32::sysEx(event->_data, event->_len);
-		} else {
-			MidiDriver_MT32::send(event->_msg);
+	for (i = 0; i < ARRAYSIZE(_midiChannels); ++i) {
+		if (i == 9 || !(_channelMask & (1 << i)))
+			continue;
+		chan = &_midiChannels[i];
+		if (chan->allocate()) {
+			return chan;
 		}
-		delete event;
 	}
+	return NULL;
 }
-#endif
 
+MidiChannel *MidiDriver_MT32::getPercussionChannel() {
+	return &_midiChannels[9];
+}
 
 // Plugin interface
 
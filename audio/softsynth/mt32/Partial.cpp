@@ -265,8 +265,14 @@ unsigned long Partial::generateSamples(float *partialBuf, unsigned long length)
 			}
 
 			float newPCMPosition = pcmPosition + positionDelta;
-			if (pcmWave->loop) {
-				newPCMPosition = fmod(newPCMPosition, (float)pcmWave->len);
+			if (pcmWave->loop && newPCMPosition >= len) {
+				// The subtraction is exact as long as the position is below twice
+				// the length, giving the same result as fmod() without its cost
+				if (newPCMPosition < 2.0f * len) {
+					newPCMPosition -= len;
+				} else {
+					newPCMPosition = fmod(newPCMPosition, (float)len);
+				}
 			}
 			pcmPosition = newPCMPosition;
 		} else {
@@ -567,16 +573,13 @@ bool Partial::produceOutput(float *leftBuf, float *rightBuf, unsigned long lengt
 		}
 	}
 
+	// Mix straight into the output buffers. The samples after numGenerated are
+	// left alone, which is the same as adding silence.
+	const float leftVol = stereoVolume.leftVol;
+	const float rightVol = stereoVolume.rightVol;
 	for (unsigned int i = 0; i < numGenerated; i++) {
-		*leftBuf++ = partialBuf[i] * stereoVolume.leftVol;
-	}
-	for (unsigned int i = 0; i < numGenerated; i++) {
-		*rightBuf++ = partialBuf[i] * stereoVolume.rightVol;
-	}
-	while (numGenerated < length) {
-		*leftBuf++ = 0.0f;
-		*rightBuf++ = 0.0f;
-		numGenerated++;
+		leftBuf[i] += partialBuf[i] * leftVol;
+		rightBuf[i] += partialBuf[i] * rightVol;
 	}
 	return true;
 }
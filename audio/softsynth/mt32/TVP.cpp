@@ -286,7 +286,10 @@ Bit16u TVP::nextPitch() {
 		timeElapsed = timeElapsed & 0x00FFFFFF;
 		process();
 	}
-	counter = (counter + 1) % maxCounter;
+	// Avoid a division per sample, counter is always below maxCounter
+	if (++counter == maxCounter) {
+		counter = 0;
+	}
 	return pitch;
 }
 
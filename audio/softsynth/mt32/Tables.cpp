@@ -24,11 +24,6 @@
 
 namespace MT32Emu {
 
-const Tables &Tables::getInstance() {
-	static const Tables instance;
-	return instance;
-}
-
 Tables::Tables() {
 	int lf;
 	for (lf = 0; lf <= 100; lf++) {
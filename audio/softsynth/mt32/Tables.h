@@ -33,7 +33,11 @@ private:
 	Tables(Tables &);
 
 public:
-	static const Tables &getInstance();
+	// Inline, since this is called for every sample by EXP2I()
+	static const Tables &getInstance() {
+		static const Tables instance;
+		return instance;
+	}
 
 	// Constant LUTs
 
@@ -376,7 +376,7 @@ INLINE Bit32s Operator::RateForward( Bit32u add ) {
 }
 
 template< Operator::State yes>
-Bits Operator::TemplateVolume(  ) {
+FORCEINLINE Bits Operator::TemplateVolume(  ) {
 	Bit32s vol = volume;
 	Bit32s change;
 	switch ( yes ) {
@@ -426,16 +426,27 @@ Bits Operator::TemplateVolume(  ) {
 	return vol;
 }
 
-static const VolumeHandler VolumeHandlerTable[5] = {
-	&Operator::TemplateVolume< Operator::OFF >,
-	&Operator::TemplateVolume< Operator::RELEASE >,
-	&Operator::TemplateVolume< Operator::SUSTAIN >,
-	&Operator::TemplateVolume< Operator::DECAY >,
-	&Operator::TemplateVolume< Operator::ATTACK >
-};
-
-INLINE Bitu Operator::ForwardVolume() {
-	return currentLevel + (this->*volHandler)();
+//Dispatch on the state here instead of calling through a handler, so the envelope code gets inlined
+FORCEINLINE Bitu Operator::ForwardVolume() {
+	Bits vol;
+	switch ( state ) {
+	case OFF:
+		vol = TemplateVolume< OFF >();
+		break;
+	case RELEASE:
+		vol = TemplateVolume< RELEASE >();
+		break;
+	case SUSTAIN:
+		vol = TemplateVolume< SUSTAIN >();
+		break;
+	case DECAY:
+		vol = TemplateVolume< DECAY >();
+		break;
+	default:
+		vol = TemplateVolume< ATTACK >();
+		break;
+	}
+	return currentLevel + vol;
 }
 
 
@@ -518,7 +529,6 @@ void Operator::WriteE0( const Chip* chip, Bit8u val ) {
 
 INLINE void Operator::SetState( Bit8u s ) {
 	state = s;
-	volHandler = VolumeHandlerTable[ s ];
 }
 
 INLINE bool Operator::Silent() const {
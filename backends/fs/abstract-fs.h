@@ -158,6 +158,20 @@ public:
 	 */
 	virtual bool isWritable() const = 0;
 
+	/**
+	 * Retrieves the size of the file referred by this path and the time of
+	 * its last modification, without opening the file.
+	 *
+	 * @note By default, this method returns false, for backends which can't
+	 *       provide this information.
+	 *
+	 * @param size Set to the size of the file, in bytes.
+	 * @param modificationTime Set to the modification time, in seconds since some backend specific epoch.
+	 *
+	 * @return true if the information is available, false otherwise.
+	 */
+	virtual bool getFileStat(int32 &size, uint32 &modificationTime) const { return false; }
+
 
 	/**
 	 * Creates a SeekableReadStream instance corresponding to the file
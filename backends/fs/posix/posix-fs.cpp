@@ -30,6 +30,7 @@
 #define FORBIDDEN_SYMBOL_EXCEPTION_exit		//Needed for IRIX's unistd.h
 
 #include "backends/fs/posix/posix-fs.h"
+#include "backends/fs/posix/posix-mmapstream.h"
 #include "backends/fs/stdiostream.h"
 #include "common/algorithm.h"
 
@@ -43,7 +44,6 @@
 #include <os2.h>
 #endif
 
-
 void POSIXFilesystemNode::setFlags() {
 	struct stat st;
 
@@ -242,8 +242,25 @@ AbstractFSNode *POSIXFilesystemNode::getParent() const {
 	return makeNode(Common::String(start, end));
 }
 
+bool POSIXFilesystemNode::getFileStat(int32 &size, uint32 &modificationTime) const {
+	struct stat st;
+
+	if (stat(_path.c_str(), &st) != 0 || !S_ISREG(st.st_mode))
+		return false;
+
+	size = (int32)st.st_size;
+	modificationTime = (uint32)st.st_mtime;
+	return true;
+}
+
 Common::SeekableReadStream *POSIXFilesystemNode::createReadStream() {
+#if defined(POSIX)
+	// Reading goes through stdio, the file is only memory mapped if the
+	// caller asks for getMemoryData()
+	return POSIXMmapStream::makeFromPath(getPath());
+#else
 	return StdioStream::makeFromPath(getPath(), false);
+#endif
 }
 
 Common::WriteStream *POSIXFilesystemNode::createWriteStream() {
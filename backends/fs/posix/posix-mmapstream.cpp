@@ -0,0 +1,72 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ */
+
+#if defined(POSIX)
+
+// Disable symbol overrides so that we can use FILE, fopen etc.
+#define FORBIDDEN_SYMBOL_ALLOW_ALL
+
+#include "backends/fs/posix/posix-mmapstream.h"
+
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <stdio.h>
+
+POSIXMmapStream::POSIXMmapStream(void *handle)
+	: StdioStream(handle), _mapping(0), _mappingSize(0), _mappingTried(false) {
+}
+
+POSIXMmapStream::~POSIXMmapStream() {
+	if (_mapping)
+		munmap(_mapping, _mappingSize);
+}
+
+POSIXMmapStream *POSIXMmapStream::makeFromPath(const Common::String &path) {
+	FILE *handle = fopen(path.c_str(), "rb");
+
+	if (handle)
+		return new POSIXMmapStream(handle);
+	return 0;
+}
+
+const byte *POSIXMmapStream::getMemoryData() const {
+	if (_mappingTried)
+		return (const byte *)_mapping;
+
+	_mappingTried = true;
+
+	const int fd = fileno((FILE *)_handle);
+
+	struct stat st;
+	if (fstat(fd, &st) != 0 || !S_ISREG(st.st_mode) || st.st_size == 0 || st.st_size > 0x7FFFFFFF)
+		return 0;
+
+	void *mapping = mmap(0, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+	if (mapping == MAP_FAILED)
+		return 0;
+
+	_mapping = mapping;
+	_mappingSize = st.st_size;
+	return (const byte *)_mapping;
+}
+
+#endif
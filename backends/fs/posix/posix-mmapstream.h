@@ -0,0 +1,63 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ */
+
+#ifndef BACKENDS_FS_POSIX_MMAPSTREAM_H
+#define BACKENDS_FS_POSIX_MMAPSTREAM_H
+
+#include "backends/fs/stdiostream.h"
+
+/**
+ * A stdio read stream which maps the file into memory when getMemoryData()
+ * is called. Reading always goes through stdio, so the file is only mapped
+ * for callers which ask for direct access. Truncating a mapped file makes
+ * accesses beyond its new end fail with SIGBUS, so only game data, which
+ * is not modified while running, should be accessed that way.
+ */
+class POSIXMmapStream : public StdioStream {
+protected:
+	/** Start of the mapping, or 0 if the file is not mapped. */
+	mutable void *_mapping;
+
+	/** Size of the mapping. */
+	mutable uint32 _mappingSize;
+
+	/** Whether mapping the file has been attempted already. */
+	mutable bool _mappingTried;
+
+public:
+	/**
+	 * Given a path, opens the file at that path for reading and wraps the
+	 * result in a POSIXMmapStream instance.
+	 */
+	static POSIXMmapStream *makeFromPath(const Common::String &path);
+
+	POSIXMmapStream(void *handle);
+	virtual ~POSIXMmapStream();
+
+	/**
+	 * Maps the file into memory on the first call. Returns 0 if the file is
+	 * not a regular file, is empty, or can't be mapped for any reason.
+	 */
+	virtual const byte *getMemoryData() const;
+};
+
+#endif
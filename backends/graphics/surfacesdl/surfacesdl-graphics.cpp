@@ -29,6 +29,7 @@
 #include "backends/platform/sdl/sdl.h"
 #include "common/config-manager.h"
 #include "common/mutex.h"
+#include "common/profiler.h"
 #include "common/textconsole.h"
 #include "common/translation.h"
 #include "common/util.h"
@@ -135,6 +136,10 @@ SurfaceSdlGraphicsManager::SurfaceSdlGraphicsManager(SdlEventSource *sdlEventSou
 	_paletteDirtyStart(0), _paletteDirtyEnd(0),
 	_screenIsLocked(false),
 	_graphicsMutex(0),
+	_numScalerThreads(0), _scalerThreadsShouldQuit(false),
+	_scalerStartSem(0), _scalerDoneSem(0), _scalerBandMutex(0),
+	_bandScalerProc(0), _bandSrcPitch(0), _bandDstPitch(0),
+	_numScalerBands(0), _nextScalerBand(0),
 #ifdef USE_SDL_DEBUG_FOCUSRECT
 	_enableFocusRectDebugCode(false), _enableFocusRect(false), _focusRect(),
 #endif
@@ -188,6 +193,8 @@ SurfaceSdlGraphicsManager::SurfaceSdlGraphicsManager(SdlEventSource *sdlEventSou
 #else
 	_videoMode.fullscreen = true;
 #endif
+
+	initScalerThreads();
 }
 
 SurfaceSdlGraphicsManager::~SurfaceSdlGraphicsManager() {
@@ -202,6 +209,7 @@ SurfaceSdlGraphicsManager::~SurfaceSdlGraphicsManager() {
 	if (_mouseOrigSurface)
 		SDL_FreeSurface(_mouseOrigSurface);
 	_mouseOrigSurface = 0;
+	deinitScalerThreads();
 	g_system->deleteMutex(_graphicsMutex);
 
 	free(_currentPalette);
@@ -954,6 +962,8 @@ void SurfaceSdlGraphicsManager::updateScreen() {
 }
 
 void SurfaceSdlGraphicsManager::internUpdateScreen() {
+	PROFILE_ZONE("SurfaceSdlGraphicsManager::internUpdateScreen");
+
 	SDL_Surface *srcSurf, *origSurf;
 	int height, width;
 	ScalerProc *scalerProc;
@@ -1083,8 +1093,8 @@ void SurfaceSdlGraphicsManager::internUpdateScreen() {
 					dst_y = real2Aspect(dst_y);
 
 				assert(scalerProc != NULL);
-				scalerProc((byte *)srcSurf->pixels + (r->x * 2 + 2) + (r->y + 1) * srcPitch, srcPitch,
-					(byte *)_hwscreen->pixels + rx1 * 2 + dst_y * dstPitch, dstPitch, r->w, dst_h);
+				scaleRect(scalerProc, (byte *)srcSurf->pixels + (r->x * 2 + 2) + (r->y + 1) * srcPitch, srcPitch,
+					(byte *)_hwscreen->pixels + rx1 * 2 + dst_y * dstPitch, dstPitch, r->w, dst_h, scale1);
 			}
 
 			r->x = rx1;
@@ -1196,6 +1206,118 @@ void SurfaceSdlGraphicsManager::internUpdateScreen() {
 	_mouseNeedsRedraw = false;
 }
 
+void SurfaceSdlGraphicsManager::initScalerThreads() {
+	int numThreads = 1;
+	if (ConfMan.hasKey("scaler_threads"))
+		numThreads = CLIP(ConfMan.getInt("scaler_threads"), 1, kMaxScalerThreads + 1);
+	if (numThreads == 1)
+		return;
+
+	_scalerThreadsShouldQuit = false;
+	_scalerStartSem = SDL_CreateSemaphore(0);
+	_scalerDoneSem = SDL_CreateSemaphore(0);
+	_scalerBandMutex = SDL_CreateMutex();
+	if (!_scalerStartSem || !_scalerDoneSem || !_scalerBandMutex) {
+		warning("Could not create the scaler threads: %s", SDL_GetError());
+		deinitScalerThreads();
+		return;
+	}
+
+	// Platforms without threads fail to create the first one, and scale
+	// on the thread updating the screen only
+	while (_numScalerThreads < numThreads - 1) {
+		SDL_Thread *thread = SDL_CreateThread(scalerThreadEntry, this);
+		if (!thread)
+			break;
+		_scalerThreads[_numScalerThreads++] = thread;
+	}
+}
+
+void SurfaceSdlGraphicsManager::deinitScalerThreads() {
+	// Wake up all threads, and wait for them to finish
+	_scalerThreadsShouldQuit = true;
+	for (int i = 0; i < _numScalerThreads; i++)
+		SDL_SemPost(_scalerStartSem);
+	for (int i = 0; i < _numScalerThreads; i++)
+		SDL_WaitThread(_scalerThreads[i], NULL);
+	_numScalerThreads = 0;
+
+	if (_scalerStartSem)
+		SDL_DestroySemaphore(_scalerStartSem);
+	if (_scalerDoneSem)
+		SDL_DestroySemaphore(_scalerDoneSem);
+	if (_scalerBandMutex)
+		SDL_DestroyMutex(_scalerBandMutex);
+	_scalerStartSem = _scalerDoneSem = 0;
+	_scalerBandMutex = 0;
+}
+
+void SurfaceSdlGraphicsManager::scaleRect(ScalerProc *scalerProc, const byte *src, uint32 srcPitch,
+		byte *dst, uint32 dstPitch, int width, int height, int scaleFactor) {
+	int numThreads = _numScalerThreads + 1;
+#if defined(USE_NASM) && defined(USE_HQ_SCALERS)
+	// The assembly versions of the HQ scalers keep their state in globals
+	if (scalerProc == HQ2x || scalerProc == HQ3x)
+		numThreads = 1;
+#endif
+
+	if (numThreads == 1) {
+		scalerProc(src, srcPitch, dst, dstPitch, width, height);
+		return;
+	}
+
+	SDL_LockMutex(_scalerBandMutex);
+	_numScalerBands = splitScalerBands(src, srcPitch, dst, dstPitch, width, height, scaleFactor, numThreads, _scalerBands);
+	_nextScalerBand = 0;
+	_bandScalerProc = scalerProc;
+	_bandSrcPitch = srcPitch;
+	_bandDstPitch = dstPitch;
+	const bool split = (_numScalerBands > 1);
+	SDL_UnlockMutex(_scalerBandMutex);
+
+	if (!split) {
+		scalerProc(src, srcPitch, dst, dstPitch, width, height);
+		return;
+	}
+
+	// Each thread signals when it found no bands left; it will not look at
+	// them again before it is woken up for the next rect.
+	for (int i = 0; i < _numScalerThreads; i++)
+		SDL_SemPost(_scalerStartSem);
+	scaleBands();
+	for (int i = 0; i < _numScalerThreads; i++)
+		SDL_SemWait(_scalerDoneSem);
+}
+
+void SurfaceSdlGraphicsManager::scaleBands() {
+	while (true) {
+		SDL_LockMutex(_scalerBandMutex);
+		if (_nextScalerBand == _numScalerBands) {
+			SDL_UnlockMutex(_scalerBandMutex);
+			return;
+		}
+		const ScalerBand band = _scalerBands[_nextScalerBand++];
+		SDL_UnlockMutex(_scalerBandMutex);
+
+		_bandScalerProc(band.src, _bandSrcPitch, band.dst, _bandDstPitch, band.width, band.height);
+	}
+}
+
+int SDLCALL SurfaceSdlGraphicsManager::scalerThreadEntry(void *arg) {
+	SurfaceSdlGraphicsManager *graphicsManager = (SurfaceSdlGraphicsManager *)arg;
+	assert(graphicsManager);
+
+	while (true) {
+		SDL_SemWait(graphicsManager->_scalerStartSem);
+		if (graphicsManager->_scalerThreadsShouldQuit)
+			break;
+
+		graphicsManager->scaleBands();
+		SDL_SemPost(graphicsManager->_scalerDoneSem);
+	}
+	return 0;
+}
+
 bool SurfaceSdlGraphicsManager::saveScreenshot(const char *filename) {
 	assert(_hwscreen != NULL);
 
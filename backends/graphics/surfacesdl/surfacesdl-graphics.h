@@ -306,6 +306,24 @@ protected:
 	 */
 	OSystem::MutexRef _graphicsMutex;
 
+	enum {
+		kMaxScalerThreads = 16
+	};
+
+	// Scaler threads
+	SDL_Thread *_scalerThreads[kMaxScalerThreads];
+	int _numScalerThreads;
+	bool _scalerThreadsShouldQuit;
+	SDL_sem *_scalerStartSem;
+	SDL_sem *_scalerDoneSem;
+	SDL_mutex *_scalerBandMutex;
+
+	// The bands being scaled, protected by _scalerBandMutex
+	ScalerProc *_bandScalerProc;
+	uint32 _bandSrcPitch, _bandDstPitch;
+	ScalerBand _scalerBands[(kMaxScalerThreads + 1) * 2];
+	int _numScalerBands, _nextScalerBand;
+
 #ifdef USE_SDL_DEBUG_FOCUSRECT
 	bool _enableFocusRectDebugCode;
 	bool _enableFocusRect;
@@ -320,6 +338,35 @@ protected:
 
 	virtual void internUpdateScreen();
 
+	/**
+	 * Start the scaler threads, as many as set by scaler_threads besides
+	 * the thread updating the screen.
+	 */
+	void initScalerThreads();
+
+	/**
+	 * Stop the scaler threads.
+	 */
+	void deinitScalerThreads();
+
+	/**
+	 * Scale a rect with the given scaler. Big enough rects are split into
+	 * bands by splitScalerBands(), which are scaled by the scaler threads
+	 * and the calling thread.
+	 */
+	void scaleRect(ScalerProc *scalerProc, const byte *src, uint32 srcPitch,
+		byte *dst, uint32 dstPitch, int width, int height, int scaleFactor);
+
+	/**
+	 * Scale the bands left, until there are none.
+	 */
+	void scaleBands();
+
+	/**
+	 * Entry point of the scaler threads
+	 */
+	static int SDLCALL scalerThreadEntry(void *arg);
+
 	virtual bool loadGFXMode();
 	virtual void unloadGFXMode();
 	virtual bool hotswapGFXMode();
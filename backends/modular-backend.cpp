@@ -28,6 +28,8 @@
 #include "backends/mutex/mutex.h"
 
 #include "audio/mixer.h"
+#include "common/EventRecorder.h"
+#include "common/profiler.h"
 #include "graphics/pixelformat.h"
 
 ModularBackend::ModularBackend()
@@ -141,7 +143,11 @@ void ModularBackend::fillScreen(uint32 col) {
 }
 
 void ModularBackend::updateScreen() {
+	PROFILE_FRAME();
+
 	_graphicsManager->updateScreen();
+
+	g_eventRec.processScreenUpdate();
 }
 
 void ModularBackend::setShakePos(int shakeOffset) {
@@ -20,15 +20,33 @@
  *
  */
 
+#define FORBIDDEN_SYMBOL_EXCEPTION_FILE
+#define FORBIDDEN_SYMBOL_EXCEPTION_fputs
+#define FORBIDDEN_SYMBOL_EXCEPTION_fflush
+#define FORBIDDEN_SYMBOL_EXCEPTION_stdout
+#define FORBIDDEN_SYMBOL_EXCEPTION_stderr
+
+#if defined(POSIX)
+#define FORBIDDEN_SYMBOL_EXCEPTION_time_h
+#endif
+
 #include "backends/modular-backend.h"
 #include "base/main.h"
 
 #if defined(USE_NULL_DRIVER)
+#include "backends/graphics/null/null-graphics.h"
+#include "backends/mutex/null/null-mutex.h"
 #include "backends/saves/default/default-saves.h"
 #include "backends/timer/default/default-timer.h"
 #include "audio/mixer_intern.h"
+#include "common/EventRecorder.h"
 #include "common/scummsys.h"
 
+#if defined(POSIX)
+#include <sys/resource.h>
+#include <sys/time.h>
+#endif
+
 /*
  * Include header files needed for the getFilesystemFactory() method.
  */
@@ -40,7 +58,10 @@
 	#include "backends/fs/windows/windows-fs-factory.h"
 #endif
 
-class OSystem_NULL : public ModularBackend {
+class OSystem_NULL : public ModularBackend, Common::EventSource {
+protected:
+	virtual Common::EventSource *getDefaultEventSource() { return this; }
+
 public:
 	OSystem_NULL();
 	virtual ~OSystem_NULL();
@@ -50,10 +71,18 @@ public:
 	virtual bool pollEvent(Common::Event &event);
 
 	virtual uint32 getMillis();
+	virtual uint32 getMicros();
 	virtual void delayMillis(uint msecs);
 	virtual void getTimeAndDate(TimeDate &t) const {}
 
 	virtual void logMessage(LogMessageType::Type type, const char *message);
+
+	virtual uint32 getPeakMemoryUsage() const;
+
+private:
+#if defined(POSIX)
+	timeval _startTime;
+#endif
 };
 
 OSystem_NULL::OSystem_NULL() {
@@ -66,6 +95,10 @@ OSystem_NULL::OSystem_NULL() {
 	#else
 		#error Unknown and unsupported FS backend
 	#endif
+
+	#if defined(POSIX)
+		gettimeofday(&_startTime, 0);
+	#endif
 }
 
 OSystem_NULL::~OSystem_NULL() {
@@ -74,7 +107,6 @@ OSystem_NULL::~OSystem_NULL() {
 void OSystem_NULL::initBackend() {
 	_mutexManager = new NullMutexManager();
 	_timerManager = new DefaultTimerManager();
-	_eventManager = new DefaultEventManager(this);
 	_savefileManager = new DefaultSaveFileManager();
 	_graphicsManager = new NullGraphicsManager();
 	_mixer = new Audio::MixerImpl(this, 22050);
@@ -93,7 +125,32 @@ bool OSystem_NULL::pollEvent(Common::Event &event) {
 }
 
 uint32 OSystem_NULL::getMillis() {
+	uint32 millis = 0;
+
+#if defined(POSIX)
+	timeval curTime;
+	gettimeofday(&curTime, 0);
+
+	millis = (uint32)(((curTime.tv_sec - _startTime.tv_sec) * 1000) +
+			((curTime.tv_usec - _startTime.tv_usec) / 1000));
+#endif
+
+	// This allows playing back recordings with the event recorder, e.g.
+	// in its benchmark mode.
+	g_eventRec.processMillis(millis);
+	return millis;
+}
+
+uint32 OSystem_NULL::getMicros() {
+#if defined(POSIX)
+	timeval curTime;
+	gettimeofday(&curTime, 0);
+
+	return (uint32)((curTime.tv_sec - _startTime.tv_sec) * 1000000 +
+			(curTime.tv_usec - _startTime.tv_usec));
+#else
 	return 0;
+#endif
 }
 
 void OSystem_NULL::delayMillis(uint msecs) {
@@ -111,6 +168,22 @@ void OSystem_NULL::logMessage(LogMessageType::Type type, const char *message) {
 	fflush(output);
 }
 
+uint32 OSystem_NULL::getPeakMemoryUsage() const {
+#if defined(POSIX)
+	struct rusage usage;
+	if (getrusage(RUSAGE_SELF, &usage) == 0) {
+#ifdef MACOSX
+		// Mac OS X reports the maximum resident set size in bytes
+		return usage.ru_maxrss / 1024;
+#else
+		return usage.ru_maxrss;
+#endif
+	}
+#endif
+
+	return 0;
+}
+
 OSystem *OSystem_NULL_create() {
 	return new OSystem_NULL();
 }
@@ -36,14 +36,20 @@
 #include "backends/taskbar/unity/unity-taskbar.h"
 
 #include <errno.h>
+#include <sys/resource.h>
 #include <sys/stat.h>
+#include <sys/time.h>
 #include <sys/wait.h>
 #include <unistd.h>
 
+// The time the backend was created at, used by getMicros()
+static timeval s_startTime;
+
 
 OSystem_POSIX::OSystem_POSIX(Common::String baseConfigName)
 	:
 	_baseConfigName(baseConfigName) {
+	gettimeofday(&s_startTime, 0);
 }
 
 void OSystem_POSIX::init() {
@@ -210,5 +216,26 @@ bool OSystem_POSIX::displayLogFile() {
 	return WIFEXITED(status) && WEXITSTATUS(status) == 0;
 }
 
+uint32 OSystem_POSIX::getMicros() {
+	timeval curTime;
+	gettimeofday(&curTime, 0);
+
+	return (uint32)((curTime.tv_sec - s_startTime.tv_sec) * 1000000 +
+			(curTime.tv_usec - s_startTime.tv_usec));
+}
+
+uint32 OSystem_POSIX::getPeakMemoryUsage() const {
+	struct rusage usage;
+	if (getrusage(RUSAGE_SELF, &usage) != 0)
+		return 0;
+
+#ifdef MACOSX
+	// Mac OS X reports the maximum resident set size in bytes
+	return usage.ru_maxrss / 1024;
+#else
+	return usage.ru_maxrss;
+#endif
+}
+
 
 #endif
@@ -35,6 +35,10 @@ public:
 
 	virtual bool displayLogFile();
 
+	virtual uint32 getMicros();
+
+	virtual uint32 getPeakMemoryUsage() const;
+
 	virtual void init();
 	virtual void initBackend();
 
@@ -472,6 +472,12 @@ uint32 OSystem_SDL::getMillis() {
 	return millis;
 }
 
+uint32 OSystem_SDL::getMicros() {
+	// Don't use getMillis(), the event recorder must not see these calls.
+	// Ports which have a finer timer should override this.
+	return SDL_GetTicks() * 1000;
+}
+
 void OSystem_SDL::delayMillis(uint msecs) {
 	if (!g_eventRec.processDelayMillis(msecs))
 		SDL_Delay(msecs);
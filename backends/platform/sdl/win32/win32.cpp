@@ -46,7 +46,12 @@
 
 #define DEFAULT_CONFIG_FILE "scummvm.ini"
 
+// The performance counter at the time the backend was initialized, used by getMicros()
+static LARGE_INTEGER s_startCounter;
+
 void OSystem_Win32::init() {
+	QueryPerformanceCounter(&s_startCounter);
+
 	// Initialize File System Factory
 	_fsFactory = new WindowsFilesystemFactory();
 
@@ -91,6 +96,16 @@ bool OSystem_Win32::hasFeature(Feature f) {
 	return OSystem_SDL::hasFeature(f);
 }
 
+uint32 OSystem_Win32::getMicros() {
+	LARGE_INTEGER frequency, counter;
+	if (!QueryPerformanceFrequency(&frequency) || !QueryPerformanceCounter(&counter))
+		return OSystem_SDL::getMicros();
+
+	// Split the conversion, so that it doesn't overflow
+	const LONGLONG ticks = counter.QuadPart - s_startCounter.QuadPart;
+	return (uint32)((ticks / frequency.QuadPart) * 1000000 + (ticks % frequency.QuadPart) * 1000000 / frequency.QuadPart);
+}
+
 bool OSystem_Win32::displayLogFile() {
 	if (_logFilePath.empty())
 		return false;
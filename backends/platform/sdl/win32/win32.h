@@ -34,6 +34,8 @@ public:
 
 	virtual bool hasFeature(Feature f);
 
+	virtual uint32 getMicros();
+
 	virtual bool displayLogFile();
 
 protected:
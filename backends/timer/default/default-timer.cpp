@@ -22,6 +22,7 @@
 #include "common/scummsys.h"
 #include "backends/timer/default/default-timer.h"
 #include "common/util.h"
+#include "common/profiler.h"
 #include "common/system.h"
 
 struct TimerSlot {
@@ -78,6 +79,8 @@ DefaultTimerManager::~DefaultTimerManager() {
 }
 
 void DefaultTimerManager::handler() {
+	PROFILE_ZONE_TRACK("DefaultTimerManager::handler", kTrackTimer);
+
 	Common::StackLock lock(_mutex);
 
 	const uint32 curTime = g_system->getMillis();
@@ -183,10 +183,14 @@ void registerDefaults() {
 	ConfMan.registerDefault("speech_mute", false);
 	ConfMan.registerDefault("mute", false);
 
+	ConfMan.registerDefault("decode_ahead", 0);
+	ConfMan.registerDefault("resampler", "linear");
+
 	ConfMan.registerDefault("multi_midi", false);
 	ConfMan.registerDefault("native_mt32", false);
 	ConfMan.registerDefault("enable_gs", false);
 	ConfMan.registerDefault("midi_gain", 100);
+	ConfMan.registerDefault("mt32_render_ahead", 0);
 
 	ConfMan.registerDefault("music_driver", "auto");
 	ConfMan.registerDefault("mt32_device", "null");
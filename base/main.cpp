@@ -31,6 +31,7 @@
 // FIXME: Avoid using printf
 #define FORBIDDEN_SYMBOL_EXCEPTION_printf
 
+#include "engines/detectionCache.h"
 #include "engines/engine.h"
 #include "engines/metaengine.h"
 #include "base/commandLine.h"
@@ -44,6 +45,7 @@
 #include "common/events.h"
 #include "common/EventRecorder.h"
 #include "common/fs.h"
+#include "common/profiler.h"
 #include "common/system.h"
 #include "common/textconsole.h"
 #include "common/tokenizer.h"
@@ -387,6 +389,12 @@ extern "C" int scummvm_main(int argc, const char * const argv[]) {
 		return res.getCode();
 	}
 
+#ifdef USE_PROFILER
+	// Create the profiler before the backend starts running the audio and
+	// timer threads, which may record into it right away
+	Common::Profiler::instance();
+#endif
+
 	// Init the backend. Must take place after all config data (including
 	// the command line params) was read.
 	system.initBackend();
@@ -496,8 +504,15 @@ extern "C" int scummvm_main(int argc, const char * const argv[]) {
 		setupGraphics(system);
 		launcherDialog();
 	}
+#ifdef USE_PROFILER
+	// The profiler is not destroyed, since the audio and timer threads
+	// may still be running
+	ProfilerMan.dump("scummvm-profile.json");
+#endif
+
 	PluginManager::instance().unloadAllPlugins();
 	PluginManager::destroy();
+	DetectionCache::destroy();
 	GUI::GuiManager::destroy();
 	Common::ConfigManager::destroy();
 	Common::DebugManager::destroy();
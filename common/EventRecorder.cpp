@@ -22,6 +22,7 @@
 
 #include "common/EventRecorder.h"
 
+#include "common/algorithm.h"
 #include "common/bufferedstream.h"
 #include "common/config-manager.h"
 #include "common/random.h"
@@ -130,6 +131,12 @@ EventRecorder::EventRecorder() {
 	_lastEventMillis = 0;
 
 	_recordMode = kPassthrough;
+
+	_benchmark = false;
+	_benchmarkFinished = false;
+	_benchmarkQuitSent = false;
+	_benchmarkStartMillis = 0;
+	_lastFrameMillis = 0;
 }
 
 EventRecorder::~EventRecorder() {
@@ -149,6 +156,10 @@ void EventRecorder::init() {
 		if (recordModeString.compareToIgnoreCase("playback") == 0) {
 			_recordMode = kRecorderPlayback;
 			debug(3, "EventRecorder: playback");
+		} else if (recordModeString.compareToIgnoreCase("benchmark") == 0) {
+			_recordMode = kRecorderPlayback;
+			_benchmark = true;
+			debug(3, "EventRecorder: benchmark");
 		} else {
 			_recordMode = kPassthrough;
 			debug(3, "EventRecorder: passthrough");
@@ -224,6 +235,13 @@ void EventRecorder::init() {
 		}
 
 		_hasPlaybackEvent = false;
+	} else {
+		_benchmark = false;
+	}
+
+	if (_benchmark) {
+		_benchmarkStartMillis = getRealMillis();
+		_lastFrameMillis = _benchmarkStartMillis;
 	}
 
 	g_system->getEventManager()->getEventDispatcher()->registerSource(this, false);
@@ -233,6 +251,11 @@ void EventRecorder::init() {
 void EventRecorder::deinit() {
 	debug(3, "EventRecorder: deinit");
 
+	if (_benchmark) {
+		printBenchmarkReport();
+		_benchmark = false;
+	}
+
 	g_system->getEventManager()->getEventDispatcher()->unregisterSource(this);
 	g_system->getEventManager()->getEventDispatcher()->unregisterObserver(this);
 
@@ -325,7 +348,9 @@ void EventRecorder::processMillis(uint32 &millis) {
 		if (_recordTimeCount > _playbackTimeCount) {
 			d = readTime(_playbackTimeFile);
 
-			while ((_lastMillis + d > millis) && (_lastMillis + d - millis > 50)) {
+			// A benchmark runs as fast as possible, without waiting for the
+			// real time to catch up with the recorded one
+			while (!_benchmark && (_lastMillis + d > millis) && (_lastMillis + d - millis > 50)) {
 				_recordMode = kPassthrough;
 				g_system->delayMillis(50);
 				millis = g_system->getMillis();
@@ -334,6 +359,10 @@ void EventRecorder::processMillis(uint32 &millis) {
 
 			millis = _lastMillis + d;
 			_playbackTimeCount++;
+		} else if (_benchmark) {
+			// The recording is over. Stop the time until the engine has quit.
+			millis = _lastMillis;
+			_benchmarkFinished = true;
 		}
 	}
 
@@ -342,6 +371,11 @@ void EventRecorder::processMillis(uint32 &millis) {
 }
 
 bool EventRecorder::processDelayMillis(uint &msecs) {
+	if (_recordMode == kRecorderPlayback && _benchmark) {
+		// Never wait in a benchmark, the time is taken from the recording
+		return true;
+	}
+
 	if (_recordMode == kRecorderPlayback) {
 		_recordMode = kPassthrough;
 
@@ -358,6 +392,50 @@ bool EventRecorder::processDelayMillis(uint &msecs) {
 	return false;
 }
 
+void EventRecorder::processScreenUpdate() {
+	if (_recordMode != kRecorderPlayback || !_benchmark)
+		return;
+
+	uint32 millis = getRealMillis();
+	_frameTimes.push_back(millis - _lastFrameMillis);
+	_lastFrameMillis = millis;
+}
+
+uint32 EventRecorder::getRealMillis() {
+	StackLock lock(_timeMutex);
+
+	RecordMode recordMode = _recordMode;
+	_recordMode = kPassthrough;
+	uint32 millis = g_system->getMillis();
+	_recordMode = recordMode;
+
+	return millis;
+}
+
+void EventRecorder::printBenchmarkReport() {
+	const uint32 totalMillis = getRealMillis() - _benchmarkStartMillis;
+	const uint frames = _frameTimes.size();
+
+	String report = String::format("Benchmark: %d frames in %d ms, %.2f fps\n", frames, totalMillis,
+	                               totalMillis ? frames * 1000.0 / totalMillis : 0.0);
+
+	if (frames) {
+		sort(_frameTimes.begin(), _frameTimes.end());
+
+		report += String::format("Frame times: median %d ms, 90th percentile %d ms, 99th percentile %d ms, maximum %d ms\n",
+		                         _frameTimes[frames / 2], _frameTimes[frames * 90 / 100],
+		                         _frameTimes[frames * 99 / 100], _frameTimes[frames - 1]);
+	}
+
+	const uint32 peakMemory = g_system->getPeakMemoryUsage();
+	if (peakMemory)
+		report += String::format("Peak memory usage: %d KB\n", peakMemory);
+
+	g_system->logMessage(LogMessageType::kInfo, report.c_str());
+
+	_frameTimes.clear();
+}
+
 bool EventRecorder::notifyEvent(const Event &ev) {
 	if (_recordMode != kRecorderRecord)
 		return false;
@@ -392,6 +470,13 @@ bool EventRecorder::pollEvent(Event &ev) {
 	StackLock lock(_recorderMutex);
 	++_eventCount;
 
+	if (_benchmarkFinished && !_benchmarkQuitSent) {
+		// Quit the engine at the end of a benchmark
+		ev.type = EVENT_QUIT;
+		_benchmarkQuitSent = true;
+		return true;
+	}
+
 	if (!_hasPlaybackEvent) {
 		if (_recordCount > _playbackCount) {
 			readRecord(_playbackFile, const_cast<uint32&>(_playbackDiff), _playbackEvent, millis);
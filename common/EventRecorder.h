@@ -59,12 +59,24 @@ public:
 	/** TODO: Add documentation, this is only used by the backend */
 	bool processDelayMillis(uint &msecs);
 
+	/**
+	 * Notify the recorder that the screen has been updated. In benchmark
+	 * mode, this is used to measure the frame times. Only used by the backend.
+	 */
+	void processScreenUpdate();
+
 private:
 	bool notifyEvent(const Event &ev);
 	bool notifyPoll();
 	bool pollEvent(Event &ev);
 	bool allowMapping() const { return false; }
 
+	/** Get the time from the backend, bypassing the playback. */
+	uint32 getRealMillis();
+
+	/** Print the frame rate, frame times and memory usage of a benchmark run. */
+	void printBenchmarkReport();
+
 	class RandomSourceRecord {
 	public:
 		String name;
@@ -100,6 +112,18 @@ private:
 		kRecorderPlayback = 2
 	};
 	volatile RecordMode _recordMode;
+
+	/**
+	 * Whether the playback is a benchmark, i.e. the recorded time is used
+	 * without waiting for the real time to catch up, and the engine is
+	 * quit at the end of the recording.
+	 */
+	bool _benchmark;
+	bool _benchmarkFinished;
+	bool _benchmarkQuitSent;
+	uint32 _benchmarkStartMillis;
+	uint32 _lastFrameMillis;
+	Array<uint32> _frameTimes;
 	String _recordFileName;
 	String _recordTempFileName;
 	String _recordTimeFileName;
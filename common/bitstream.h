@@ -26,6 +26,7 @@
 #define COMMON_BITSTREAM_H
 
 #include "common/scummsys.h"
+#include "common/util.h"
 #include "common/textconsole.h"
 #include "common/stream.h"
 
@@ -67,6 +68,9 @@ public:
 	/** Add a bit to the value x, making it an n+1-bit value. */
 	virtual void addBit(uint32 &x, uint32 n) = 0;
 
+	/** Are the bits handed out in the order of MSB to LSB? */
+	virtual bool isMSBFirst() const = 0;
+
 protected:
 	BitStream() {
 	}
@@ -191,17 +195,33 @@ public:
 		if (n > 32)
 			error("BitStreamImpl::getBits(): Too many bits requested to be read");
 
-		// Read the number of bits
-		uint32 v = 0;
-
-		if (isMSB2LSB) {
-			while (n-- > 0)
-				v = (v << 1) | getBit();
-		} else {
-			for (uint32 i = 0; i < n; i++)
-				v = (v >> 1) | (((uint32) getBit()) << 31);
-
-			v >>= (32 - n);
+		// Read the number of bits, taking as many as possible out of the current value at once
+		uint32 v   = 0;
+		uint8  got = 0;
+
+		while (n > 0) {
+			// Check if we need the next value
+			if (_inValue == 0)
+				readValue();
+
+			uint8 take = MIN<uint8>(n, valueBits - _inValue);
+
+			if (take == 32) {
+				v = _value;
+				_value = 0;
+			} else if (isMSB2LSB) {
+				v = (v << take) | (_value >> (32 - take));
+				_value <<= take;
+			} else {
+				v |= (_value & ((((uint32) 1) << take) - 1)) << got;
+				_value >>= take;
+			}
+
+			// Increase the position within the current value
+			_inValue = (_inValue + take) % valueBits;
+
+			got += take;
+			n   -= take;
 		}
 
 		return v;
@@ -228,15 +248,54 @@ public:
 	 * The bit order is the same as in getBits().
 	 */
 	uint32 peekBits(uint8 n) {
-		uint32 value   = _value;
-		uint8  inValue = _inValue;
-		uint32 curPos  = _stream->pos();
+		if (n == 0)
+			return 0;
 
-		uint32 v = getBits(n);
+		if (n > 32)
+			error("BitStreamImpl::peekBits(): Too many bits requested to be read");
 
-		_stream->seek(curPos);
-		_inValue = inValue;
-		_value   = value;
+		// Start with the bits left in the current value
+		uint8  got = (_inValue == 0) ? 0 : valueBits - _inValue;
+		uint32 v   = 0;
+
+		if (got >= n) {
+			if (isMSB2LSB)
+				return _value >> (32 - n);
+
+			return _value & ((((uint32) 1) << n) - 1);
+		}
+
+		if (got > 0)
+			v = isMSB2LSB ? (_value >> (32 - got)) : _value;
+
+		// Add the bits of the following values, and go back in the stream
+		// afterwards. Only whole values are read, so the stream position
+		// stays aligned to them.
+		int32 readBytes = 0;
+
+		while (got < n) {
+			if ((size() - _stream->pos() * 8) < valueBits)
+				error("BitStreamImpl::peekBits(): End of bit stream reached");
+
+			uint32 next = readData();
+			readBytes += valueBits / 8;
+
+			uint8 take = MIN<uint8>(n - got, valueBits);
+
+			if (take == 32)
+				v = next;
+			else if (isMSB2LSB)
+				v = (v << take) | ((next << (32 - valueBits)) >> (32 - take));
+			else
+				v |= (next & ((((uint32) 1) << take) - 1)) << got;
+
+			got += take;
+		}
+
+		if (_stream->err())
+			error("BitStreamImpl::peekBits(): Read error");
+
+		_stream->seek(-readBytes, SEEK_CUR);
 
 		return v;
 	}
@@ -262,6 +321,11 @@ public:
 			x = (x & ~(1 << n)) | (getBit() << n);
 	}
 
+	/** Are the bits handed out in the order of MSB to LSB? */
+	bool isMSBFirst() const {
+		return isMSB2LSB;
+	}
+
 	/** Rewind the bit stream back to the start. */
 	void rewind() {
 		_stream->seek(0);
@@ -272,8 +336,12 @@ public:
 
 	/** Skip the specified amount of bits. */
 	void skip(uint32 n) {
-		while (n-- > 0)
-			getBit();
+		while (n > 32) {
+			getBits(32);
+			n -= 32;
+		}
+
+		getBits(n);
 	}
 
 	/** Return the stream position in bits. */
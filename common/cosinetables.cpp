@@ -27,14 +27,25 @@
 
 namespace Common {
 
+// The tables are shared by all instances with the same precision. They are
+// only created by the decoders setting up their transforms, on the main
+// thread, so no locking is needed.
+static float *s_tables[17];
+static int s_refCounts[17];
+
 CosineTable::CosineTable(int bitPrecision) {
 	assert((bitPrecision >= 4) && (bitPrecision <= 16));
 
 	_bitPrecision = bitPrecision;
 
+	if (s_refCounts[_bitPrecision]++) {
+		_table = s_tables[_bitPrecision];
+		return;
+	}
+
 	int m = 1 << _bitPrecision;
 	double freq = 2 * M_PI / m;
-	_table = new float[m];
+	_table = s_tables[_bitPrecision] = new float[m];
 
 	// Table contains cos(2*pi*x/n) for 0<=x<=n/4,
 	// followed by its reverse
@@ -46,7 +57,10 @@ CosineTable::CosineTable(int bitPrecision) {
 }
 
 CosineTable::~CosineTable() {
-	delete[] _table;
+	if (!--s_refCounts[_bitPrecision]) {
+		delete[] s_tables[_bitPrecision];
+		s_tables[_bitPrecision] = 0;
+	}
 }
 
 } // End of namespace Common
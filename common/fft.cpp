@@ -26,6 +26,12 @@
 // Copyright (c) 2002 Fabrice Bellard
 // Partly based on libdjbfft by D. J. Bernstein
 
+// The SSE header has to come before the ScummVM ones, which forbid some of
+// the symbols in the system headers it includes
+#ifdef __SSE__
+#include <xmmintrin.h>
+#endif
+
 #include "common/cosinetables.h"
 #include "common/fft.h"
 #include "common/util.h"
@@ -56,6 +62,9 @@ FFT::FFT(int bits, int inverse) : _bits(bits), _inverse(inverse) {
 }
 
 FFT::~FFT() {
+	for (int i = 0; i < ARRAYSIZE(_cosTables); i++)
+		delete _cosTables[i];
+
 	delete[] _revTab;
 	delete[] _expTab;
 	delete[] _tmpBuf;
@@ -165,11 +174,70 @@ static void name(Complex *z, const float *wre, unsigned int n) { \
 	} while(--n);\
 }
 
+#ifndef __SSE__
+
 PASS(pass)
 #undef BUTTERFLIES
 #define BUTTERFLIES BUTTERFLIES_BIG
 PASS(pass_big)
 
+#else
+
+/*
+ * The same as the plain C pass, but doing both transforms of an iteration
+ * at once. The arithmetic is that of TRANSFORM, in the same order, so the
+ * results only differ in the sign of zeros.
+ */
+static void pass_sse(Complex *z, const float *wre, unsigned int n) {
+	float t1, t2, t3, t4, t5, t6;
+	int o1 = 2 * n;
+	int o2 = 4 * n;
+	int o3 = 6 * n;
+	const float *wim = wre + o1;
+	n--;
+
+	TRANSFORM_ZERO(z[0], z[o1], z[o2], z[o3]);
+	TRANSFORM(z[1], z[o1 + 1], z[o2 + 1], z[o3 + 1], wre[1], wim[-1]);
+
+	const __m128 negOdd  = _mm_set_ps(-0.0f, 0.0f, -0.0f, 0.0f);
+	const __m128 negEven = _mm_set_ps(0.0f, -0.0f, 0.0f, -0.0f);
+
+	do {
+		z += 2;
+		wre += 2;
+		wim -= 2;
+
+		// wr = { wre[0], wre[0], wre[1], wre[1] }, wi = { wim[0], wim[0], wim[-1], wim[-1] }
+		__m128 wr = _mm_loadl_pi(_mm_setzero_ps(), (const __m64 *)wre);
+		wr = _mm_unpacklo_ps(wr, wr);
+		__m128 wi = _mm_loadl_pi(_mm_setzero_ps(), (const __m64 *)(wim - 1));
+		wi = _mm_shuffle_ps(wi, wi, _MM_SHUFFLE(0, 0, 1, 1));
+
+		__m128 a0 = _mm_loadu_ps(&z[0].re);
+		__m128 a1 = _mm_loadu_ps(&z[o1].re);
+		__m128 a2 = _mm_loadu_ps(&z[o2].re);
+		__m128 a3 = _mm_loadu_ps(&z[o3].re);
+
+		// (t1, t2) = a2 * conj(w), (t5, t6) = a3 * w
+		__m128 t12 = _mm_mul_ps(_mm_shuffle_ps(a2, a2, _MM_SHUFFLE(2, 3, 0, 1)), wi);
+		t12 = _mm_add_ps(_mm_mul_ps(a2, wr), _mm_xor_ps(t12, negOdd));
+		__m128 t56 = _mm_mul_ps(_mm_shuffle_ps(a3, a3, _MM_SHUFFLE(2, 3, 0, 1)), wi);
+		t56 = _mm_add_ps(_mm_mul_ps(a3, wr), _mm_xor_ps(t56, negEven));
+
+		// BUTTERFLIES, with sum = (t5, t6) and diff = (t4, t3) after the additions
+		__m128 sum = _mm_add_ps(t56, t12);
+		__m128 diff = _mm_sub_ps(t12, t56);
+		diff = _mm_xor_ps(_mm_shuffle_ps(diff, diff, _MM_SHUFFLE(2, 3, 0, 1)), negOdd);
+
+		_mm_storeu_ps(&z[o2].re, _mm_sub_ps(a0, sum));
+		_mm_storeu_ps(&z[0].re, _mm_add_ps(a0, sum));
+		_mm_storeu_ps(&z[o3].re, _mm_sub_ps(a1, diff));
+		_mm_storeu_ps(&z[o1].re, _mm_add_ps(a1, diff));
+	} while (--n);
+}
+
+#endif // __SSE__
+
 void FFT::fft4(Complex *z) {
 	float t1, t2, t3, t4, t5, t6, t7, t8;
 
@@ -234,10 +302,14 @@ void FFT::fft(int n, int logn, Complex *z) {
 		fft((n / 4), logn - 2, z + (n / 4) * 2);
 		fft((n / 4), logn - 2, z + (n / 4) * 3);
 		assert(_cosTables[logn - 4]);
+#ifdef __SSE__
+		pass_sse(z, _cosTables[logn - 4]->getTable(), (n / 4) / 2);
+#else
 		if (n > 1024)
 			pass_big(z, _cosTables[logn - 4]->getTable(), (n / 4) / 2);
 		else
 			pass(z, _cosTables[logn - 4]->getTable(), (n / 4) / 2);
+#endif
 	}
 }
 
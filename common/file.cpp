@@ -141,6 +141,11 @@ uint32 File::read(void *ptr, uint32 len) {
 	return _handle->read(ptr, len);
 }
 
+const byte *File::getMemoryData() const {
+	assert(_handle);
+	return _handle->getMemoryData();
+}
+
 
 DumpFile::DumpFile() : _handle(0) {
 }
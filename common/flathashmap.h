@@ -0,0 +1,598 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ */
+
+// The open addressing scheme in this file is modelled after the "Swiss
+// tables" of the Abseil library, using a portable SWAR implementation of
+// the control byte group matching.
+
+#ifndef COMMON_FLATHASHMAP_H
+#define COMMON_FLATHASHMAP_H
+
+#include "common/endian.h"
+#include "common/func.h"
+
+namespace Common {
+
+/**
+ * FlatHashMap<Key,Val> maps objects of type Key to objects of type Val,
+ * just like HashMap, and offers the same interface. Keys and values are
+ * stored directly in the table instead of in separately allocated nodes,
+ * and for every slot a control byte holds 7 bits of the hash of its key.
+ * Lookups scan the control bytes of a group of slots at once and only
+ * compare keys whose hash bits match, which makes them considerably more
+ * cache friendly than those of HashMap.
+ *
+ * The drawback is that iterators and references to values are invalidated
+ * whenever a new key is added, since the table may then be rehashed and
+ * all entries moved. Also, Key and Val are copied on rehashing, so keys or
+ * values which are expensive to copy are better kept in a HashMap.
+ */
+template<class Key, class Val, class HashFunc = Hash<Key>, class EqualFunc = EqualTo<Key> >
+class FlatHashMap {
+public:
+	typedef uint size_type;
+
+	struct Node {
+		const Key _key;
+		Val _value;
+		explicit Node(const Key &key) : _key(key), _value() {}
+		Node(const Node &node) : _key(node._key), _value(node._value) {}
+	};
+
+private:
+
+	typedef FlatHashMap<Key, Val, HashFunc, EqualFunc> FHM_t;
+
+	enum {
+		FLATHASHMAP_GROUP_SIZE = 8,
+		FLATHASHMAP_MIN_CAPACITY = 16,
+
+		// The quotient of the next two constants controls how much the
+		// internal storage of the hashmap may fill up (including deleted
+		// entries) before being rehashed.
+		FLATHASHMAP_LOADFACTOR_NUMERATOR = 7,
+		FLATHASHMAP_LOADFACTOR_DENOMINATOR = 8
+	};
+
+	enum {
+		// Control bytes of slots in use hold the low 7 bits of the hash
+		kCtrlEmpty = 0x80,
+		kCtrlDeleted = 0xFE
+	};
+
+	byte *_ctrl;		///< Control byte of each slot.
+	Node *_slots;		///< Storage of the entries, only valid for used slots.
+	size_type _mask;	///< Capacity of the FlatHashMap minus one; must be a power of two minus one
+	size_type _size;
+	size_type _deleted;	///< Number of slots marked as deleted
+
+	HashFunc _hash;
+	EqualFunc _equal;
+
+	/** Default value, returned by the const getVal. */
+	const Val _defaultVal;
+
+	/**
+	 * Scramble the hash value, since the hash functions of integral
+	 * types are the identity. This is the finalizer of MurmurHash3.
+	 */
+	static uint mixHash(uint hash) {
+		hash ^= hash >> 16;
+		hash *= 0x85EBCA6B;
+		hash ^= hash >> 13;
+		hash *= 0xC2B2AE35;
+		hash ^= hash >> 16;
+		return hash;
+	}
+
+	/**
+	 * The following functions take four control bytes (read as a
+	 * little endian word) and return a word, which has the high bit
+	 * of every byte set whose control byte matches. matchByte() may
+	 * report false positives, which is fine, since the keys of
+	 * candidate slots are compared anyway.
+	 */
+	static uint32 matchByte(uint32 ctrl, byte value) {
+		const uint32 x = ctrl ^ (0x01010101 * value);
+		return (x - 0x01010101) & ~x & 0x80808080;
+	}
+
+	static uint32 matchEmpty(uint32 ctrl) {
+		// Only kCtrlEmpty has the high bit set and the second lowest bit cleared
+		return ctrl & ~(ctrl << 6) & 0x80808080;
+	}
+
+	static uint32 matchEmptyOrDeleted(uint32 ctrl) {
+		return ctrl & 0x80808080;
+	}
+
+	/** Return the index of the first byte matched in a word returned by the match functions. */
+	static uint firstMatch(uint32 match) {
+#if GCC_ATLEAST(3, 4)
+		return __builtin_ctz(match) >> 3;
+#else
+		// Count the bytes below the lowest match, each of which has its
+		// high bit set after subtracting one
+		const uint32 below = ((match & (~match + 1)) - 1) >> 7 & 0x01010101;
+		return (below * 0x01010101) >> 24;
+#endif
+	}
+
+	size_type groupMask() const {
+		return (_mask + 1) / FLATHASHMAP_GROUP_SIZE - 1;
+	}
+
+	bool groupHasEmpty(size_type group) const {
+		const byte *ctrl = _ctrl + group * FLATHASHMAP_GROUP_SIZE;
+		return matchEmpty(READ_LE_UINT32(ctrl)) || matchEmpty(READ_LE_UINT32(ctrl + 4));
+	}
+
+	void allocStorage(size_type capacity);
+	void freeStorage();
+	void assign(const FHM_t &map);
+	size_type lookup(const Key &key) const;
+	size_type findFreeSlot(uint hash) const;
+	size_type lookupAndCreateIfMissing(const Key &key);
+	void eraseSlot(size_type idx);
+	void rehash(size_type newCapacity);
+
+	template<class T> friend class IteratorImpl;
+
+	/**
+	 * Simple FlatHashMap iterator implementation.
+	 */
+	template<class NodeType>
+	class IteratorImpl {
+		friend class FlatHashMap;
+		template<class T> friend class IteratorImpl;
+	protected:
+		typedef const FlatHashMap hashmap_t;
+
+		size_type _idx;
+		hashmap_t *_hashmap;
+
+	protected:
+		IteratorImpl(size_type idx, hashmap_t *hashmap) : _idx(idx), _hashmap(hashmap) {}
+
+		NodeType *deref() const {
+			assert(_hashmap != 0);
+			assert(_idx <= _hashmap->_mask);
+			assert(!(_hashmap->_ctrl[_idx] & 0x80));
+			return &_hashmap->_slots[_idx];
+		}
+
+	public:
+		IteratorImpl() : _idx(0), _hashmap(0) {}
+		template<class T>
+		IteratorImpl(const IteratorImpl<T> &c) : _idx(c._idx), _hashmap(c._hashmap) {}
+
+		NodeType &operator*() const { return *deref(); }
+		NodeType *operator->() const { return deref(); }
+
+		bool operator==(const IteratorImpl &iter) const { return _idx == iter._idx && _hashmap == iter._hashmap; }
+		bool operator!=(const IteratorImpl &iter) const { return !(*this == iter); }
+
+		IteratorImpl &operator++() {
+			assert(_hashmap);
+			do {
+				_idx++;
+			} while (_idx <= _hashmap->_mask && (_hashmap->_ctrl[_idx] & 0x80));
+			if (_idx > _hashmap->_mask)
+				_idx = (size_type)-1;
+
+			return *this;
+		}
+
+		IteratorImpl operator++(int) {
+			IteratorImpl old = *this;
+			operator ++();
+			return old;
+		}
+	};
+
+public:
+	typedef IteratorImpl<Node> iterator;
+	typedef IteratorImpl<const Node> const_iterator;
+
+	FlatHashMap();
+	FlatHashMap(const FHM_t &map);
+	~FlatHashMap();
+
+	FHM_t &operator=(const FHM_t &map) {
+		if (this == &map)
+			return *this;
+
+		// Remove the previous content and ...
+		freeStorage();
+		// ... copy the new stuff.
+		assign(map);
+		return *this;
+	}
+
+	bool contains(const Key &key) const;
+
+	Val &operator[](const Key &key);
+	const Val &operator[](const Key &key) const;
+
+	Val &getVal(const Key &key);
+	const Val &getVal(const Key &key) const;
+	const Val &getVal(const Key &key, const Val &defaultVal) const;
+	void setVal(const Key &key, const Val &val);
+
+	void clear(bool shrinkArray = 0);
+
+	void erase(iterator entry);
+	void erase(const Key &key);
+
+	size_type size() const { return _size; }
+
+	iterator	begin() {
+		// Find and return the first non-empty entry
+		for (size_type ctr = 0; ctr <= _mask; ++ctr) {
+			if (!(_ctrl[ctr] & 0x80))
+				return iterator(ctr, this);
+		}
+		return end();
+	}
+	iterator	end() {
+		return iterator((size_type)-1, this);
+	}
+
+	const_iterator	begin() const {
+		// Find and return the first non-empty entry
+		for (size_type ctr = 0; ctr <= _mask; ++ctr) {
+			if (!(_ctrl[ctr] & 0x80))
+				return const_iterator(ctr, this);
+		}
+		return end();
+	}
+	const_iterator	end() const {
+		return const_iterator((size_type)-1, this);
+	}
+
+	iterator	find(const Key &key) {
+		size_type ctr = lookup(key);
+		if (ctr <= _mask)
+			return iterator(ctr, this);
+		return end();
+	}
+
+	const_iterator	find(const Key &key) const {
+		size_type ctr = lookup(key);
+		if (ctr <= _mask)
+			return const_iterator(ctr, this);
+		return end();
+	}
+
+	bool empty() const {
+		return (_size == 0);
+	}
+};
+
+//-------------------------------------------------------
+// FlatHashMap functions
+
+/**
+ * Base constructor, creates an empty hashmap.
+ */
+template<class Key, class Val, class HashFunc, class EqualFunc>
+FlatHashMap<Key, Val, HashFunc, EqualFunc>::FlatHashMap() : _defaultVal() {
+	allocStorage(FLATHASHMAP_MIN_CAPACITY);
+}
+
+/**
+ * Copy constructor, creates a full copy of the given hashmap.
+ */
+template<class Key, class Val, class HashFunc, class EqualFunc>
+FlatHashMap<Key, Val, HashFunc, EqualFunc>::FlatHashMap(const FHM_t &map) : _defaultVal() {
+	assign(map);
+}
+
+/**
+ * Destructor, frees all used memory.
+ */
+template<class Key, class Val, class HashFunc, class EqualFunc>
+FlatHashMap<Key, Val, HashFunc, EqualFunc>::~FlatHashMap() {
+	freeStorage();
+}
+
+/**
+ * Internal method for allocating empty storage of the given capacity.
+ *
+ * @note We do *not* deallocate the previous storage here -- the caller is
+ *       responsible for doing that!
+ */
+template<class Key, class Val, class HashFunc, class EqualFunc>
+void FlatHashMap<Key, Val, HashFunc, EqualFunc>::allocStorage(size_type capacity) {
+	_mask = capacity - 1;
+	_size = 0;
+	_deleted = 0;
+
+	_ctrl = new byte[capacity];
+	assert(_ctrl != NULL);
+	memset(_ctrl, kCtrlEmpty, capacity);
+
+	_slots = (Node *)malloc(capacity * sizeof(Node));
+	assert(_slots != NULL);
+}
+
+/**
+ * Internal method for destroying all entries and freeing the storage.
+ */
+template<class Key, class Val, class HashFunc, class EqualFunc>
+void FlatHashMap<Key, Val, HashFunc, EqualFunc>::freeStorage() {
+	for (size_type ctr = 0; ctr <= _mask; ++ctr) {
+		if (!(_ctrl[ctr] & 0x80))
+			_slots[ctr].~Node();
+	}
+
+	delete[] _ctrl;
+	free(_slots);
+}
+
+/**
+ * Internal method for assigning the content of another FlatHashMap
+ * to this one.
+ *
+ * @note We do *not* deallocate the previous storage here -- the caller is
+ *       responsible for doing that!
+ */
+template<class Key, class Val, class HashFunc, class EqualFunc>
+void FlatHashMap<Key, Val, HashFunc, EqualFunc>::assign(const FHM_t &map) {
+	allocStorage(map._mask + 1);
+
+	// Both maps use the same hash function, so the entries can simply
+	// be cloned into the same slots.
+	memcpy(_ctrl, map._ctrl, _mask + 1);
+	for (size_type ctr = 0; ctr <= _mask; ++ctr) {
+		if (!(_ctrl[ctr] & 0x80))
+			new ((void *)&_slots[ctr]) Node(map._slots[ctr]);
+	}
+
+	_size = map._size;
+	_deleted = map._deleted;
+}
+
+template<class Key, class Val, class HashFunc, class EqualFunc>
+void FlatHashMap<Key, Val, HashFunc, EqualFunc>::clear(bool shrinkArray) {
+	if (shrinkArray && _mask >= FLATHASHMAP_MIN_CAPACITY) {
+		freeStorage();
+		allocStorage(FLATHASHMAP_MIN_CAPACITY);
+		return;
+	}
+
+	for (size_type ctr = 0; ctr <= _mask; ++ctr) {
+		if (!(_ctrl[ctr] & 0x80))
+			_slots[ctr].~Node();
+	}
+	memset(_ctrl, kCtrlEmpty, _mask + 1);
+
+	_size = 0;
+	_deleted = 0;
+}
+
+template<class Key, class Val, class HashFunc, class EqualFunc>
+void FlatHashMap<Key, Val, HashFunc, EqualFunc>::rehash(size_type newCapacity) {
+	assert(newCapacity >= FLATHASHMAP_MIN_CAPACITY);
+
+#ifndef NDEBUG
+	const size_type old_size = _size;
+#endif
+	const size_type old_mask = _mask;
+	byte *old_ctrl = _ctrl;
+	Node *old_slots = _slots;
+
+	allocStorage(newCapacity);
+
+	// Move all the old elements. Since we know that no key exists twice
+	// in the old table, we don't have to compare any keys.
+	for (size_type ctr = 0; ctr <= old_mask; ++ctr) {
+		if (old_ctrl[ctr] & 0x80)
+			continue;
+
+		const uint hash = mixHash(_hash(old_slots[ctr]._key));
+		const size_type idx = findFreeSlot(hash);
+
+		new ((void *)&_slots[idx]) Node(old_slots[ctr]);
+		old_slots[ctr].~Node();
+		_ctrl[idx] = hash & 0x7F;
+		_size++;
+	}
+
+	// Perform a sanity check: Old number of elements should match the new one!
+	// This check will fail if some previous operation corrupted this hashmap.
+	assert(_size == old_size);
+
+	delete[] old_ctrl;
+	free(old_slots);
+}
+
+/**
+ * Look up the slot holding the given key.
+ *
+ * @return the index of the slot, or _mask + 1 if the key is not present
+ */
+template<class Key, class Val, class HashFunc, class EqualFunc>
+typename FlatHashMap<Key, Val, HashFunc, EqualFunc>::size_type FlatHashMap<Key, Val, HashFunc, EqualFunc>::lookup(const Key &key) const {
+	const uint hash = mixHash(_hash(key));
+	const byte h2 = hash & 0x7F;
+	const size_type mask = groupMask();
+	size_type group = (hash >> 7) & mask;
+
+	// Probe the groups in triangular order, which visits all of them
+	// since their number is a power of two.
+	for (size_type step = 1; ; step++) {
+		const size_type base = group * FLATHASHMAP_GROUP_SIZE;
+		const uint32 ctrlLow = READ_LE_UINT32(_ctrl + base);
+		const uint32 ctrlHigh = READ_LE_UINT32(_ctrl + base + 4);
+
+		for (uint32 match = matchByte(ctrlLow, h2); match; match &= match - 1) {
+			const size_type idx = base + firstMatch(match);
+			if (_ctrl[idx] == h2 && _equal(_slots[idx]._key, key))
+				return idx;
+		}
+
+		for (uint32 match = matchByte(ctrlHigh, h2); match; match &= match - 1) {
+			const size_type idx = base + 4 + firstMatch(match);
+			if (_ctrl[idx] == h2 && _equal(_slots[idx]._key, key))
+				return idx;
+		}
+
+		// A key is never stored past a group with empty slots
+		if (matchEmpty(ctrlLow) || matchEmpty(ctrlHigh))
+			return _mask + 1;
+
+		group = (group + step) & mask;
+	}
+}
+
+/**
+ * Find the first empty or deleted slot on the probe sequence of the given
+ * (mixed) hash value.
+ */
+template<class Key, class Val, class HashFunc, class EqualFunc>
+typename FlatHashMap<Key, Val, HashFunc, EqualFunc>::size_type FlatHashMap<Key, Val, HashFunc, EqualFunc>::findFreeSlot(uint hash) const {
+	const size_type mask = groupMask();
+	size_type group = (hash >> 7) & mask;
+
+	for (size_type step = 1; ; step++) {
+		const size_type base = group * FLATHASHMAP_GROUP_SIZE;
+
+		for (uint half = 0; half < FLATHASHMAP_GROUP_SIZE; half += 4) {
+			const uint32 match = matchEmptyOrDeleted(READ_LE_UINT32(_ctrl + base + half));
+			if (match)
+				return base + half + firstMatch(match);
+		}
+
+		group = (group + step) & mask;
+	}
+}
+
+template<class Key, class Val, class HashFunc, class EqualFunc>
+typename FlatHashMap<Key, Val, HashFunc, EqualFunc>::size_type FlatHashMap<Key, Val, HashFunc, EqualFunc>::lookupAndCreateIfMissing(const Key &key) {
+	size_type ctr = lookup(key);
+	if (ctr <= _mask)
+		return ctr;
+
+	// Keep the load factor below a certain threshold. Deleted slots are
+	// also counted. If they make up a large part of it, rehashing to the
+	// same capacity is enough to get rid of them.
+	size_type capacity = _mask + 1;
+	if ((_size + _deleted + 1) * FLATHASHMAP_LOADFACTOR_DENOMINATOR > capacity * FLATHASHMAP_LOADFACTOR_NUMERATOR) {
+		if ((_size + 1) * FLATHASHMAP_LOADFACTOR_DENOMINATOR * 2 > capacity * FLATHASHMAP_LOADFACTOR_NUMERATOR)
+			capacity *= 2;
+		rehash(capacity);
+	}
+
+	const uint hash = mixHash(_hash(key));
+	ctr = findFreeSlot(hash);
+
+	if (_ctrl[ctr] == kCtrlDeleted)
+		_deleted--;
+	new ((void *)&_slots[ctr]) Node(key);
+	_ctrl[ctr] = hash & 0x7F;
+	_size++;
+
+	return ctr;
+}
+
+template<class Key, class Val, class HashFunc, class EqualFunc>
+void FlatHashMap<Key, Val, HashFunc, EqualFunc>::eraseSlot(size_type idx) {
+	_slots[idx].~Node();
+	_size--;
+
+	// If the group still has empty slots, no key was ever stored past it
+	// and the slot can be marked empty. Otherwise, lookups must continue
+	// searching past it.
+	if (groupHasEmpty(idx / FLATHASHMAP_GROUP_SIZE)) {
+		_ctrl[idx] = kCtrlEmpty;
+	} else {
+		_ctrl[idx] = kCtrlDeleted;
+		_deleted++;
+	}
+}
+
+
+template<class Key, class Val, class HashFunc, class EqualFunc>
+bool FlatHashMap<Key, Val, HashFunc, EqualFunc>::contains(const Key &key) const {
+	return lookup(key) <= _mask;
+}
+
+template<class Key, class Val, class HashFunc, class EqualFunc>
+Val &FlatHashMap<Key, Val, HashFunc, EqualFunc>::operator[](const Key &key) {
+	return getVal(key);
+}
+
+template<class Key, class Val, class HashFunc, class EqualFunc>
+const Val &FlatHashMap<Key, Val, HashFunc, EqualFunc>::operator[](const Key &key) const {
+	return getVal(key);
+}
+
+template<class Key, class Val, class HashFunc, class EqualFunc>
+Val &FlatHashMap<Key, Val, HashFunc, EqualFunc>::getVal(const Key &key) {
+	size_type ctr = lookupAndCreateIfMissing(key);
+	return _slots[ctr]._value;
+}
+
+template<class Key, class Val, class HashFunc, class EqualFunc>
+const Val &FlatHashMap<Key, Val, HashFunc, EqualFunc>::getVal(const Key &key) const {
+	return getVal(key, _defaultVal);
+}
+
+template<class Key, class Val, class HashFunc, class EqualFunc>
+const Val &FlatHashMap<Key, Val, HashFunc, EqualFunc>::getVal(const Key &key, const Val &defaultVal) const {
+	size_type ctr = lookup(key);
+	if (ctr <= _mask)
+		return _slots[ctr]._value;
+	else
+		return defaultVal;
+}
+
+template<class Key, class Val, class HashFunc, class EqualFunc>
+void FlatHashMap<Key, Val, HashFunc, EqualFunc>::setVal(const Key &key, const Val &val) {
+	size_type ctr = lookupAndCreateIfMissing(key);
+	_slots[ctr]._value = val;
+}
+
+template<class Key, class Val, class HashFunc, class EqualFunc>
+void FlatHashMap<Key, Val, HashFunc, EqualFunc>::erase(iterator entry) {
+	// Check whether we have a valid iterator
+	assert(entry._hashmap == this);
+	const size_type ctr = entry._idx;
+	assert(ctr <= _mask);
+	assert(!(_ctrl[ctr] & 0x80));
+
+	eraseSlot(ctr);
+}
+
+template<class Key, class Val, class HashFunc, class EqualFunc>
+void FlatHashMap<Key, Val, HashFunc, EqualFunc>::erase(const Key &key) {
+	size_type ctr = lookup(key);
+	if (ctr > _mask)
+		return;
+
+	eraseSlot(ctr);
+}
+
+}	// End of namespace Common
+
+#endif
@@ -124,6 +124,10 @@ bool FSNode::isWritable() const {
 	return _realNode && _realNode->isWritable();
 }
 
+bool FSNode::getFileStat(int32 &size, uint32 &modificationTime) const {
+	return _realNode && _realNode->getFileStat(size, modificationTime);
+}
+
 SeekableReadStream *FSNode::createReadStream() const {
 	if (_realNode == 0)
 		return 0;
@@ -205,6 +205,18 @@ public:
 	 */
 	bool isWritable() const;
 
+	/**
+	 * Retrieves the size of the file referred by this node and the time of
+	 * its last modification, without opening the file. Not all backends
+	 * can provide this information.
+	 *
+	 * @param size Set to the size of the file, in bytes.
+	 * @param modificationTime Set to the modification time, in seconds since some backend specific epoch.
+	 *
+	 * @return true if the information is available, false otherwise.
+	 */
+	bool getFileStat(int32 &size, uint32 &modificationTime) const;
+
 	/**
 	 * Creates a SeekableReadStream instance corresponding to the file
 	 * referred by this node. This assumes that the node actually refers
@@ -29,6 +29,16 @@
 
 namespace Common {
 
+/** Maximum number of bits indexing a lookup table or subtable. */
+enum {
+	kHuffmanTableBits = 9
+};
+
+/** Return a mask of the lowest n bits. */
+static inline uint32 lowMask(uint32 n) {
+	return (n >= 32) ? 0xFFFFFFFF : ((((uint32) 1) << n) - 1);
+}
+
 Huffman::Symbol::Symbol(uint32 c, uint32 s) : code(c), symbol(s) {
 }
 
@@ -47,6 +57,7 @@ Huffman::Huffman(uint8 maxLength, uint32 codeCount, const uint32 *codes, const u
 
 	_codes.resize(maxLength);
 	_symbols.resize(codeCount);
+	_lengths.resize(codeCount);
 
 	for (uint32 i = 0; i < codeCount; i++) {
 		// The symbol. If none were specified, just assume it's identical to the code index
@@ -57,7 +68,14 @@ Huffman::Huffman(uint8 maxLength, uint32 codeCount, const uint32 *codes, const u
 
 		// And put the pointer to the symbol/code struct into the symbol list.
 		_symbols[i] = &_codes[lengths[i] - 1].back();
+
+		_lengths[i] = lengths[i];
 	}
+
+	_tableBits = MIN<uint8>(maxLength, kHuffmanTableBits);
+
+	buildTable(_tables[0], false);
+	buildTable(_tables[1], true);
 }
 
 Huffman::~Huffman() {
@@ -66,9 +84,109 @@ Huffman::~Huffman() {
 void Huffman::setSymbols(const uint32 *symbols) {
 	for (uint32 i = 0; i < _symbols.size(); i++)
 		_symbols[i]->symbol = symbols ? *symbols++ : i;
+
+	buildTable(_tables[0], false);
+	buildTable(_tables[1], true);
+}
+
+void Huffman::buildTable(Table &table, bool msbFirst) {
+	const uint32 n = _tableBits;
+
+	table.clear();
+	table.resize(1 << n);
+
+	// The longest code sharing each first-level index, for codes not fitting into the table
+	Array<uint8> subLength;
+	subLength.resize(1 << n);
+
+	for (uint32 i = 0; i < _symbols.size(); i++) {
+		const uint32 code   = _symbols[i]->code;
+		const uint32 length = _lengths[i];
+
+		if (length <= n) {
+			// Fill every index starting with this code
+			for (uint32 j = 0; j < ((uint32) 1 << (n - length)); j++) {
+				TableEntry &entry = table[msbFirst ? ((code << (n - length)) | j) : (code | (j << length))];
+
+				entry.value  = _symbols[i]->symbol;
+				entry.length = length;
+			}
+		} else {
+			const uint32 prefix = msbFirst ? (code >> (length - n)) : (code & lowMask(n));
+
+			subLength[prefix] = MAX<uint8>(subLength[prefix], length);
+		}
+	}
+
+	// Allocate the second-level subtables
+	for (uint32 i = 0; i < subLength.size(); i++) {
+		if (subLength[i] == 0)
+			continue;
+
+		table[i].value   = table.size();
+		table[i].subBits = MIN<uint32>(subLength[i] - n, kHuffmanTableBits);
+
+		table.resize(table.size() + (1 << table[i].subBits));
+	}
+
+	// And fill them. Codes too long even for the subtables aren't entered and
+	// are left to getSymbolSlow() to find.
+	for (uint32 i = 0; i < _symbols.size(); i++) {
+		const uint32 code   = _symbols[i]->code;
+		const uint32 length = _lengths[i];
+
+		if (length <= n)
+			continue;
+
+		const uint32 prefix = msbFirst ? (code >> (length - n)) : (code & lowMask(n));
+		const uint32 offset = table[prefix].value;
+		const uint32 s      = table[prefix].subBits;
+		const uint32 rest   = length - n;
+
+		if (rest > s)
+			continue;
+
+		const uint32 restCode = msbFirst ? (code & lowMask(rest)) : (code >> n);
+
+		for (uint32 j = 0; j < ((uint32) 1 << (s - rest)); j++) {
+			TableEntry &entry = table[offset + (msbFirst ? ((restCode << (s - rest)) | j) : (restCode | (j << rest)))];
+
+			entry.value  = _symbols[i]->symbol;
+			entry.length = length;
+		}
+	}
 }
 
 uint32 Huffman::getSymbol(BitStream &bits) const {
+	const Table &table = _tables[bits.isMSBFirst() ? 1 : 0];
+	const uint32 bitsLeft = bits.size() - bits.pos();
+
+	// Near the end of the stream, we can't peek a full table index
+	if (bitsLeft < _tableBits)
+		return getSymbolSlow(bits);
+
+	const TableEntry *entry = &table[bits.peekBits(_tableBits)];
+
+	if (entry->subBits != 0) {
+		const uint32 totalBits = _tableBits + entry->subBits;
+
+		if (bitsLeft < totalBits)
+			return getSymbolSlow(bits);
+
+		const uint32 index = bits.peekBits(totalBits);
+		const uint32 subIndex = bits.isMSBFirst() ? (index & lowMask(entry->subBits)) : (index >> _tableBits);
+
+		entry = &table[entry->value + subIndex];
+	}
+
+	if (entry->length == 0)
+		return getSymbolSlow(bits);
+
+	bits.skip(entry->length);
+	return entry->value;
+}
+
+uint32 Huffman::getSymbolSlow(BitStream &bits) const {
 	uint32 code = 0;
 
 	for (uint32 i = 0; i < _codes.size(); i++) {
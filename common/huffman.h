@@ -70,11 +70,43 @@ private:
 	typedef Array<CodeList> CodeLists;
 	typedef Array<Symbol *> SymbolList;
 
+	/**
+	 * An entry in the lookup tables.
+	 *
+	 * An entry either directly resolves to a symbol, or, for codes that are
+	 * longer than the bits used to index the table, points to a second-level
+	 * subtable indexed by the bits following the first-level ones.
+	 */
+	struct TableEntry {
+		uint32 value;  ///< The symbol, or the offset of the subtable.
+		uint8 length;  ///< The length of the code, 0 if it's not in the table.
+		uint8 subBits; ///< The number of bits indexing the subtable, 0 if there's none.
+
+		TableEntry() : value(0), length(0), subBits(0) {}
+	};
+
+	typedef Array<TableEntry> Table;
+
 	/** Lists of codes and their symbols, sorted by code length. */
 	CodeLists _codes;
 
 	/** Sorted list of pointers to the symbols. */
 	SymbolList _symbols;
+
+	/** Lengths of the codes, in the order they were given. */
+	Array<uint8> _lengths;
+
+	/** Number of bits indexing the first-level tables. */
+	uint8 _tableBits;
+
+	/** Lookup tables, for streams read LSB to MSB [0] and MSB to LSB [1]. */
+	Table _tables[2];
+
+	/** Build the lookup table for the specified bit order. */
+	void buildTable(Table &table, bool msbFirst);
+
+	/** Find the next symbol by reading the code bit by bit. */
+	uint32 getSymbolSlow(BitStream &bits) const;
 };
 
 } // End of namespace Common
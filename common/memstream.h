@@ -70,6 +70,8 @@ public:
 	int32 size() const { return _size; }
 
 	bool seek(int32 offs, int whence = SEEK_SET);
+
+	const byte *getMemoryData() const { return _ptrOrig; }
 };
 
 
@@ -0,0 +1,137 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ */
+
+#include "common/profiler.h"
+
+#ifdef USE_PROFILER
+
+#include "common/debug.h"
+#include "common/file.h"
+#include "common/textconsole.h"
+
+namespace Common {
+
+DECLARE_SINGLETON(Profiler);
+
+static const char *const s_trackNames[] = {
+	"Main",
+	"Audio",
+	"Timer"
+};
+
+Profiler::Profiler() {
+	for (int i = 0; i < kTrackCount; i++) {
+		_tracks[i].events = new Event[kEventsPerTrack];
+		_tracks[i].count = 0;
+	}
+}
+
+Profiler::~Profiler() {
+	for (int i = 0; i < kTrackCount; i++)
+		delete[] _tracks[i].events;
+}
+
+void Profiler::addZone(const char *name, uint32 startTime, Track track) {
+	addEvent(track, kEventZone, name, startTime, g_system->getMicros() - startTime);
+}
+
+void Profiler::addCounter(const char *name, int32 value, Track track) {
+	addEvent(track, kEventCounter, name, g_system->getMicros(), value);
+}
+
+void Profiler::addFrame() {
+	addEvent(kTrackMain, kEventFrame, "Frame", g_system->getMicros(), 0);
+}
+
+/** Quote a string for use in JSON. */
+static String quoteString(const char *str) {
+	String quoted = "\"";
+	for (; *str; str++) {
+		if (*str == '"' || *str == '\\')
+			quoted += '\\';
+		quoted += *str;
+	}
+	quoted += '"';
+	return quoted;
+}
+
+bool Profiler::dump(const String &filename) const {
+	DumpFile file;
+	if (!file.open(filename)) {
+		warning("Profiler: Could not open '%s' for writing", filename.c_str());
+		return false;
+	}
+
+	file.writeString("{\"traceEvents\":[\n");
+
+	for (int i = 0; i < kTrackCount; i++) {
+		file.writeString(String::format("{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%d,\"args\":{\"name\":\"%s\"}}",
+		                                i, s_trackNames[i]));
+		if (i != kTrackCount - 1)
+			file.writeString(",\n");
+	}
+
+	for (int i = 0; i < kTrackCount; i++) {
+		// Take a snapshot of the event count. If the track is written to
+		// meanwhile, the oldest events dumped may be overwritten, which
+		// is acceptable for this purpose.
+		const uint32 count = _tracks[i].count;
+		const uint32 first = count > (uint32)kEventsPerTrack ? count - kEventsPerTrack : 0;
+
+		for (uint32 j = first; j != count; j++) {
+			const Event &event = _tracks[i].events[j % kEventsPerTrack];
+			String line;
+
+			switch (event.type) {
+			case kEventZone:
+				line = String::format(",\n{\"name\":%s,\"ph\":\"X\",\"ts\":%u,\"dur\":%d,\"pid\":1,\"tid\":%d}",
+				                      quoteString(event.name).c_str(), event.time, event.value, i);
+				break;
+			case kEventCounter:
+				line = String::format(",\n{\"name\":%s,\"ph\":\"C\",\"ts\":%u,\"pid\":1,\"tid\":%d,\"args\":{\"value\":%d}}",
+				                      quoteString(event.name).c_str(), event.time, i, event.value);
+				break;
+			case kEventFrame:
+				line = String::format(",\n{\"name\":%s,\"ph\":\"i\",\"s\":\"g\",\"ts\":%u,\"pid\":1,\"tid\":%d}",
+				                      quoteString(event.name).c_str(), event.time, i);
+				break;
+			}
+
+			file.writeString(line);
+		}
+	}
+
+	file.writeString("\n]}\n");
+	file.finalize();
+
+	if (file.err()) {
+		warning("Profiler: Could not write '%s'", filename.c_str());
+		return false;
+	}
+
+	debug(1, "Profiler: Wrote trace to '%s'", filename.c_str());
+	return true;
+}
+
+} // End of namespace Common
+
+#endif // USE_PROFILER
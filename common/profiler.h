@@ -0,0 +1,164 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ */
+
+#ifndef COMMON_PROFILER_H
+#define COMMON_PROFILER_H
+
+#include "common/scummsys.h"
+
+/**
+ * @file
+ * Macros for marking up code for the profiler. Unless ScummVM is configured
+ * with --enable-profiler, they expand to nothing.
+ *
+ * PROFILE_ZONE(name) measures the time until the end of the enclosing scope.
+ * PROFILE_ZONE_TRACK(name, track) does the same for code running outside
+ * of the main thread, see Common::Profiler::Track.
+ * PROFILE_COUNTER(name, value) records the value of a counter.
+ * PROFILE_FRAME() marks the start of a new frame.
+ *
+ * The names must be string literals, since only the pointers are stored.
+ */
+
+#ifdef USE_PROFILER
+
+#include "common/singleton.h"
+#include "common/str.h"
+#include "common/system.h"
+
+namespace Common {
+
+/**
+ * The profiler records zones (named spans of time), counters and frame
+ * markers into fixed size ring buffers, so only the most recent events are
+ * kept. The events can be written to a file in the Chrome trace event
+ * format, which can be viewed with chrome://tracing.
+ *
+ * There is one ring buffer per track. Since ScummVM has no notion of
+ * threads, code running outside of the main thread must record into its own
+ * track, and each track must only be written to from a single thread. This
+ * way, no locking is necessary.
+ */
+class Profiler : public Singleton<Profiler> {
+public:
+	enum Track {
+		kTrackMain = 0,		///< The main thread, running the engine and the GUI
+		kTrackAudio = 1,	///< The audio callback
+		kTrackTimer = 2,	///< The timer callbacks
+
+		kTrackCount
+	};
+
+	/** Record a zone which started at the given time, and ends now. */
+	void addZone(const char *name, uint32 startTime, Track track);
+
+	/** Record the value of a counter. */
+	void addCounter(const char *name, int32 value, Track track = kTrackMain);
+
+	/** Record the start of a new frame. */
+	void addFrame();
+
+	/**
+	 * Write all recorded events to a file in the Chrome trace event format.
+	 *
+	 * @param filename	the name of the file to write
+	 * @return true if the file was written successfully
+	 */
+	bool dump(const String &filename) const;
+
+private:
+	friend class Singleton<SingletonBaseType>;
+	Profiler();
+	~Profiler();
+
+	enum {
+		kEventsPerTrack = 65536
+	};
+
+	enum EventType {
+		kEventZone,
+		kEventCounter,
+		kEventFrame
+	};
+
+	struct Event {
+		const char *name;
+		uint32 time;	///< Time of the event in microseconds
+		int32 value;	///< Duration for zones, value for counters
+		EventType type;
+	};
+
+	struct TrackBuffer {
+		Event *events;
+		volatile uint32 count;	///< Total number of events recorded
+	};
+
+	TrackBuffer _tracks[kTrackCount];
+
+	void addEvent(Track track, EventType type, const char *name, uint32 time, int32 value) {
+		TrackBuffer &buffer = _tracks[track];
+		Event &event = buffer.events[buffer.count % kEventsPerTrack];
+		event.name = name;
+		event.time = time;
+		event.value = value;
+		event.type = type;
+		buffer.count++;
+	}
+};
+
+/**
+ * Helper class recording a zone spanning its lifetime.
+ */
+class ProfilerZone {
+public:
+	ProfilerZone(const char *name, Profiler::Track track) : _name(name), _track(track), _startTime(g_system->getMicros()) {}
+	~ProfilerZone() { Profiler::instance().addZone(_name, _startTime, _track); }
+
+private:
+	const char *_name;
+	Profiler::Track _track;
+	uint32 _startTime;
+};
+
+} // End of namespace Common
+
+/** Shortcut for accessing the profiler. */
+#define ProfilerMan		Common::Profiler::instance()
+
+#define PROFILE_ZONE_NAME2(line)	profilerZone ## line
+#define PROFILE_ZONE_NAME(line)		PROFILE_ZONE_NAME2(line)
+
+#define PROFILE_ZONE(name)					Common::ProfilerZone PROFILE_ZONE_NAME(__LINE__)(name, Common::Profiler::kTrackMain)
+#define PROFILE_ZONE_TRACK(name, track)		Common::ProfilerZone PROFILE_ZONE_NAME(__LINE__)(name, Common::Profiler::track)
+#define PROFILE_COUNTER(name, value)		ProfilerMan.addCounter(name, value)
+#define PROFILE_FRAME()						ProfilerMan.addFrame()
+
+#else
+
+#define PROFILE_ZONE(name)					do {} while (0)
+#define PROFILE_ZONE_TRACK(name, track)		do {} while (0)
+#define PROFILE_COUNTER(name, value)		do {} while (0)
+#define PROFILE_FRAME()						do {} while (0)
+
+#endif // USE_PROFILER
+
+#endif
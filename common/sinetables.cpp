@@ -27,14 +27,23 @@
 
 namespace Common {
 
+// Shared by all sine tables of the same precision, like the cosine tables
+static float *s_tables[17];
+static int s_refCounts[17];
+
 SineTable::SineTable(int bitPrecision) {
 	assert((bitPrecision >= 4) && (bitPrecision <= 16));
 
 	_bitPrecision = bitPrecision;
 
+	if (s_refCounts[_bitPrecision]++) {
+		_table = s_tables[_bitPrecision];
+		return;
+	}
+
 	int m = 1 << _bitPrecision;
 	double freq = 2 * M_PI / m;
-	_table = new float[m];
+	_table = s_tables[_bitPrecision] = new float[m];
 
 	// Table contains sin(2*pi*x/n) for 0<=x<=n/4,
 	// followed by its reverse
@@ -46,7 +55,10 @@ SineTable::SineTable(int bitPrecision) {
 }
 
 SineTable::~SineTable() {
-	delete[] _table;
+	if (!--s_refCounts[_bitPrecision]) {
+		delete[] s_tables[_bitPrecision];
+		s_tables[_bitPrecision] = 0;
+	}
 }
 
 } // End of namespace Common
@@ -28,7 +28,8 @@ namespace Common {
 class SineTable {
 public:
 	/**
-	 * Construct a sine table with the specified bit precision
+	 * Construct a sine table with the specified bit precision. The values
+	 * are shared with all other tables of the same precision.
 	 *
 	 * @param bitPrecision Precision of the table, which must be in range [4, 16]
 	 */
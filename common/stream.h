@@ -371,6 +371,20 @@ public:
 	 */
 	virtual bool skip(uint32 offset) { return seek(offset, SEEK_CUR); }
 
+	/**
+	 * Returns a pointer to the whole contents of the stream, if they are
+	 * directly accessible in memory, e.g. because the stream wraps a memory
+	 * block or a memory mapped file. Client code like archive loaders can
+	 * use this to avoid copying data out of the stream.
+	 *
+	 * The pointer stays valid for as long as the stream exists. Streams for
+	 * files may memory map the file for this, so only call it on files which
+	 * are not modified meanwhile, like game data, but not savegames.
+	 *
+	 * @return a pointer to the data, or 0 if it's not available in memory
+	 */
+	virtual const byte *getMemoryData() const { return 0; }
+
 	/**
 	 * Reads at most one less than the number of characters specified
 	 * by bufSize from the and stores them in the string buf. Reading
@@ -893,6 +893,18 @@ public:
 	/** Get the number of milliseconds since the program was started. */
 	virtual uint32 getMillis() = 0;
 
+	/**
+	 * Get the number of microseconds since the program was started, for
+	 * measuring short time spans, e.g. by the profiler. The value wraps
+	 * around after about 71 minutes. Unlike getMillis(), this is not
+	 * affected by the event recorder.
+	 *
+	 * The default implementation is based on getMillis(). Backends whose
+	 * getMillis() goes through the event recorder, or which have a finer
+	 * timer, should override it.
+	 */
+	virtual uint32 getMicros() { return getMillis() * 1000; }
+
 	/** Delay/sleep for the specified amount of milliseconds. */
 	virtual void delayMillis(uint msecs) = 0;
 
@@ -1215,6 +1227,16 @@ public:
 	 */
 	virtual Common::String getSystemLanguage() const;
 
+	/**
+	 * Returns the peak amount of memory used by ScummVM so far, in KB.
+	 * This is used by the benchmark mode of the event recorder.
+	 *
+	 * The default implementation returns 0, meaning that it is unknown.
+	 *
+	 * @return peak memory usage in KB
+	 */
+	virtual uint32 getPeakMemoryUsage() const { return 0; }
+
 	//@}
 };
 
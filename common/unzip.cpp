@@ -105,6 +105,10 @@ typedef struct {
 #include "common/fs.h"
 #include "common/unzip.h"
 #include "common/memstream.h"
+#include "common/mutex.h"
+#include "common/ptr.h"
+#include "common/substream.h"
+#include "common/zlib.h"
 
 #include "common/hashmap.h"
 #include "common/hash-str.h"
@@ -379,6 +383,10 @@ typedef Common::HashMap<Common::String, cached_file_in_zip, Common::IgnoreCase_H
 */
 typedef struct {
 	Common::SeekableReadStream *_stream;				/* io structore of the zipfile */
+	Common::SharedPtr<Common::SeekableReadStream> _streamRef;	/* owner of _stream, shared with
+													the streams of the members */
+	Common::SharedPtr<Common::Mutex> _streamMutex;	/* serializes access to _stream, which
+													the members may read from other threads */
 	unz_global_info gi;				/* public global information */
 	uLong byte_before_the_zipfile;	/* byte before the zipfile, (>0 for sfx)*/
 	uLong num_file;					/* number of the current file in the zipfile*/
@@ -541,6 +549,8 @@ unzFile unzOpen(Common::SeekableReadStream *stream) {
 	int err=UNZ_OK;
 
 	us->_stream = stream;
+	us->_streamRef = Common::SharedPtr<Common::SeekableReadStream>(stream);
+	us->_streamMutex = Common::SharedPtr<Common::Mutex>(new Common::Mutex());
 
 	central_pos = unzlocal_SearchCentralDir(*us->_stream);
 	if (central_pos==0)
@@ -592,7 +602,6 @@ unzFile unzOpen(Common::SeekableReadStream *stream) {
 		err=UNZ_BADZIPFILE;
 
 	if (err != UNZ_OK) {
-		delete us->_stream;
 		delete us;
 		return NULL;
 	}
@@ -641,7 +650,7 @@ int unzClose(unzFile file) {
 	if (s->pfile_in_zip_read != NULL)
 		unzCloseCurrentFile(file);
 
-	delete s->_stream;
+	// The stream itself is deleted once no member streams refer to it anymore
 	delete s;
 	return UNZ_OK;
 }
@@ -1122,6 +1131,33 @@ int unzOpenCurrentFile (unzFile file) {
 }
 
 
+/*
+  Get the position of the data of the current file in the stream of the
+  zipfile, after checking its local header.
+  return UNZ_OK if there is no problem.
+*/
+static int unzGetCurrentFileDataPos(unzFile file, uLong *pPos) {
+	uInt iSizeVar;
+	uLong offset_local_extrafield;
+	uInt  size_local_extrafield;
+	unz_s* s;
+
+	if (file==NULL)
+		return UNZ_PARAMERROR;
+	s=(unz_s*)file;
+	if (!s->current_file_ok)
+		return UNZ_PARAMERROR;
+
+	if (unzlocal_CheckCurrentFileCoherencyHeader(s,&iSizeVar,
+				&offset_local_extrafield,&size_local_extrafield)!=UNZ_OK)
+		return UNZ_BADZIPFILE;
+
+	*pPos = s->cur_file_info_internal.offset_curfile + SIZEZIPLOCALHEADER + iSizeVar +
+		s->byte_before_the_zipfile;
+	return UNZ_OK;
+}
+
+
 /*
   Read bytes from the current file.
   buf contain buffer where data must be copied
@@ -1482,36 +1518,126 @@ const ArchiveMemberPtr ZipArchive::getMember(const String &name) const {
 	return ArchiveMemberPtr(new GenericArchiveMember(name, this));
 }
 
+/**
+ * A substream of the archive stream, which keeps the archive stream alive
+ * for as long as it's used, even after the ZipArchive has been deleted.
+ *
+ * Like SafeSeekableSubReadStream, it repositions the archive stream before
+ * each read, so several members can be read at once. Engines read members
+ * from the mixer thread as well (e.g. speech streamed from a ZIP archive),
+ * so this is done under a mutex shared by all members of the archive.
+ */
+class ZipMemberSubReadStream : public SeekableSubReadStream {
+	SharedPtr<SeekableReadStream> _archiveStream;
+	SharedPtr<Mutex> _archiveMutex;
+
+public:
+	ZipMemberSubReadStream(const SharedPtr<SeekableReadStream> &archiveStream, const SharedPtr<Mutex> &archiveMutex, uint32 begin, uint32 end)
+		: SeekableSubReadStream(archiveStream.get(), begin, end), _archiveStream(archiveStream), _archiveMutex(archiveMutex) {
+	}
+
+	virtual bool seek(int32 offset, int whence = SEEK_SET) {
+		StackLock lock(*_archiveMutex);
+		return SeekableSubReadStream::seek(offset, whence);
+	}
+
+	virtual uint32 read(void *dataPtr, uint32 dataSize) {
+		StackLock lock(*_archiveMutex);
+
+		// Make sure the archive stream is at the right position
+		SeekableSubReadStream::seek(0, SEEK_CUR);
+		return SeekableSubReadStream::read(dataPtr, dataSize);
+	}
+};
+
+#ifdef USE_ZLIB
+/**
+ * Verifies the CRC of a member, once all of its data has been read. The
+ * data is checked in the order it is read, so parts read again after
+ * seeking back are not checked twice, and parts skipped by seeking forward
+ * leave the CRC unchecked.
+ */
+class ZipMemberCRCReadStream : public SeekableReadStream {
+	ScopedPtr<SeekableReadStream> _member;
+	String _name;
+	uLong _crc;
+	uLong _expectedCRC;
+	uint32 _checkedSize;
+	bool _crcError;
+
+public:
+	ZipMemberCRCReadStream(SeekableReadStream *member, const String &name, uLong expectedCRC)
+		: _member(member), _name(name), _crc(crc32(0, Z_NULL, 0)), _expectedCRC(expectedCRC),
+		  _checkedSize(0), _crcError(false) {
+	}
+
+	virtual bool eos() const { return _member->eos(); }
+	virtual bool err() const { return _crcError || _member->err(); }
+	virtual void clearErr() { _member->clearErr(); }
+
+	virtual int32 pos() const { return _member->pos(); }
+	virtual int32 size() const { return _member->size(); }
+	virtual bool seek(int32 offset, int whence = SEEK_SET) { return _member->seek(offset, whence); }
+
+	virtual uint32 read(void *dataPtr, uint32 dataSize) {
+		const uint32 start = _member->pos();
+		const uint32 actual = _member->read(dataPtr, dataSize);
+
+		// Add the data following what has been checked so far
+		if (start <= _checkedSize && _checkedSize < start + actual) {
+			const uint32 skip = _checkedSize - start;
+			_crc = crc32(_crc, (const byte *)dataPtr + skip, actual - skip);
+			_checkedSize = start + actual;
+
+			if (_checkedSize == (uint32)size() && _crc != _expectedCRC) {
+				warning("ZipArchive: CRC mismatch in '%s'", _name.c_str());
+				_crcError = true;
+			}
+		}
+
+		return actual;
+	}
+};
+#endif
+
 SeekableReadStream *ZipArchive::createReadStreamForMember(const String &name) const {
+	const unz_s *const archive = (const unz_s *)_zipFile;
+
+	// Reading the headers moves the archive stream, which member streams
+	// may be using at the same time
+	StackLock lock(*archive->_streamMutex);
+
 	if (unzLocateFile(_zipFile, name.c_str(), 2) != UNZ_OK)
 		return 0;
 
 	unz_file_info fileInfo;
-	if (unzOpenCurrentFile(_zipFile) != UNZ_OK)
-		return 0;
-
 	if (unzGetCurrentFileInfo(_zipFile, &fileInfo, NULL, 0, NULL, 0, NULL, 0) != UNZ_OK)
 		return 0;
 
-	byte *buffer = (byte *)malloc(fileInfo.uncompressed_size);
-	assert(buffer);
-
-	if (unzReadCurrentFile(_zipFile, buffer, fileInfo.uncompressed_size) != (int)fileInfo.uncompressed_size) {
-		free(buffer);
+	uLong dataPos;
+	if (unzGetCurrentFileDataPos(_zipFile, &dataPos) != UNZ_OK)
 		return 0;
-	}
 
-	if (unzCloseCurrentFile(_zipFile) != UNZ_OK) {
-		free(buffer);
-		return 0;
-	}
+	// Instead of extracting the member into memory, we hand out a view of
+	// its data inside the archive. Stored members are returned directly,
+	// deflated ones are decompressed on the fly, as far as they are read.
+	SeekableReadStream *data = new ZipMemberSubReadStream(archive->_streamRef, archive->_streamMutex,
+		dataPos, dataPos + fileInfo.compressed_size);
 
-	return new MemoryReadStream(buffer, fileInfo.uncompressed_size, DisposeAfterUse::YES);
+#ifdef USE_ZLIB
+	if (fileInfo.compression_method != 0)
+		data = wrapDeflateReadStream(data, fileInfo.uncompressed_size);
 
-	// FIXME: instead of reading all into a memory stream, we could
-	// instead create a new ZipStream class. But then we have to be
-	// careful to handle the case where the client code opens multiple
-	// files in the archive and tries to use them independently.
+	return new ZipMemberCRCReadStream(data, name, fileInfo.crc);
+#else
+	if (fileInfo.compression_method == 0)
+		return data;
+
+	// Cannot decompress the file without zlib. Without it, the CRC of
+	// stored members isn't verified either, since crc32() is not defined.
+	delete data;
+	return 0;
+#endif
 }
 
 Archive *makeZipArchive(const String &name) {
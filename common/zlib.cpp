@@ -24,6 +24,7 @@
 #define FORBIDDEN_SYMBOL_ALLOW_ALL
 
 #include "common/zlib.h"
+#include "common/array.h"
 #include "common/ptr.h"
 #include "common/util.h"
 #include "common/stream.h"
@@ -142,12 +143,33 @@ bool inflateZlibInstallShield(byte *dst, uint dstLen, const byte *src, uint srcL
 /**
  * A simple wrapper class which can be used to wrap around an arbitrary
  * other SeekableReadStream and will then provide on-the-fly decompression support.
- * Assumes the compressed data to be in gzip format.
+ * Assumes the compressed data to be in gzip or zlib format, or to be raw
+ * deflate data without any header if rawDeflate is set.
  */
 class GZipReadStream : public SeekableReadStream {
 protected:
 	enum {
-		BUFSIZE = 16384		// 1 << MAX_WBITS
+		BUFSIZE = 16384,		// 1 << MAX_WBITS
+
+		/**
+		 * Initial distance between two seek points in the decompressed data.
+		 * This is doubled whenever the seek points would exceed the
+		 * memory limit below.
+		 */
+		kSeekPointInterval = 64 * 1024,
+
+		/** Approximate size of one seek point: the inflate state plus its 32KB window. */
+		kSeekPointSize = 40 * 1024
+	};
+
+	/**
+	 * A point we can resume decompression from, without having to
+	 * decompress all data before it again.
+	 */
+	struct SeekPoint {
+		uint32 pos;       ///< Position in the decompressed data.
+		uint32 inputPos;  ///< Position in the wrapped stream.
+		z_stream state;   ///< Copy of the inflate state, including the window.
 	};
 
 	byte	_buf[BUFSIZE];
@@ -159,36 +181,110 @@ protected:
 	uint32 _origSize;
 	bool _eos;
 
+	Array<SeekPoint *> _seekPoints; ///< Seek points, sorted by position.
+	uint32 _seekMemoryLimit;        ///< Maximum amount of memory to spend on seek points.
+	uint32 _seekPointInterval;
+	uint32 _nextSeekPoint;
+
+	/** Remember the current decompression state as a seek point. */
+	void addSeekPoint() {
+		if (_seekMemoryLimit < kSeekPointSize)
+			return;
+
+		if (!_seekPoints.empty() && _seekPoints.back()->pos >= _pos)
+			return;
+
+		if ((_seekPoints.size() + 1) * kSeekPointSize > _seekMemoryLimit) {
+			// Thin out the seek points, keeping the ones on the new interval
+			_seekPointInterval *= 2;
+
+			uint32 kept = 0;
+			for (uint32 i = 0; i < _seekPoints.size(); i++) {
+				if (_seekPoints[i]->pos % _seekPointInterval == 0) {
+					_seekPoints[kept++] = _seekPoints[i];
+				} else {
+					inflateEnd(&_seekPoints[i]->state);
+					delete _seekPoints[i];
+				}
+			}
+			_seekPoints.resize(kept);
+
+			if (_pos % _seekPointInterval != 0)
+				return;
+		}
+
+		SeekPoint *point = new SeekPoint();
+		if (inflateCopy(&point->state, &_stream) != Z_OK) {
+			delete point;
+			return;
+		}
+
+		point->pos = _pos;
+		// Input that was read into the buffer but not inflated yet has to be read again
+		point->inputPos = _wrapped->pos() - _stream.avail_in;
+
+		_seekPoints.push_back(point);
+	}
+
+	/** Find the last seek point at or before this position, or 0 if there is none. */
+	SeekPoint *findSeekPoint(uint32 pos) const {
+		SeekPoint *point = 0;
+
+		for (uint32 i = 0; i < _seekPoints.size() && _seekPoints[i]->pos <= pos; i++)
+			point = _seekPoints[i];
+
+		return point;
+	}
+
+	void updateNextSeekPoint() {
+		_nextSeekPoint = (_pos / _seekPointInterval + 1) * _seekPointInterval;
+	}
+
 public:
 
-	GZipReadStream(SeekableReadStream *w, uint32 knownSize = 0) : _wrapped(w), _stream() {
+	GZipReadStream(SeekableReadStream *w, uint32 knownSize = 0, bool rawDeflate = false,
+			uint32 seekMemoryLimit = kDefaultSeekMemoryLimit)
+		: _wrapped(w), _stream(), _seekMemoryLimit(seekMemoryLimit) {
 		assert(w != 0);
 
-		// Verify file header is correct
-		w->seek(0, SEEK_SET);
-		uint16 header = w->readUint16BE();
-		assert(header == 0x1F8B ||
-		       ((header & 0x0F00) == 0x0800 && header % 31 == 0));
-
-		if (header == 0x1F8B) {
-			// Retrieve the original file size
-			w->seek(-4, SEEK_END);
-			_origSize = w->readUint32LE();
-		} else {
-			// Original size not available in zlib format
-			// use an otherwise known size if supplied.
+		if (rawDeflate) {
+			// There's no header at all, so the size has to be supplied
 			_origSize = knownSize;
+		} else {
+			// Verify file header is correct
+			w->seek(0, SEEK_SET);
+			uint16 header = w->readUint16BE();
+			assert(header == 0x1F8B ||
+			       ((header & 0x0F00) == 0x0800 && header % 31 == 0));
+
+			if (header == 0x1F8B) {
+				// Retrieve the original file size
+				w->seek(-4, SEEK_END);
+				_origSize = w->readUint32LE();
+			} else {
+				// Original size not available in zlib format
+				// use an otherwise known size if supplied.
+				_origSize = knownSize;
+			}
 		}
 		_pos = 0;
 		w->seek(0, SEEK_SET);
 		_eos = false;
 
-		// Adding 32 to windowBits indicates to zlib that it is supposed to
-		// automatically detect whether gzip or zlib headers are used for
-		// the compressed file. This feature was added in zlib 1.2.0.4,
-		// released 10 August 2003.
-		// Note: This is *crucial* for savegame compatibility, do *not* remove!
-		_zlibErr = inflateInit2(&_stream, MAX_WBITS + 32);
+		_seekPointInterval = kSeekPointInterval;
+		updateNextSeekPoint();
+
+		if (rawDeflate) {
+			// Negative MAX_WBITS tells zlib there's no header
+			_zlibErr = inflateInit2(&_stream, -MAX_WBITS);
+		} else {
+			// Adding 32 to windowBits indicates to zlib that it is supposed to
+			// automatically detect whether gzip or zlib headers are used for
+			// the compressed file. This feature was added in zlib 1.2.0.4,
+			// released 10 August 2003.
+			// Note: This is *crucial* for savegame compatibility, do *not* remove!
+			_zlibErr = inflateInit2(&_stream, MAX_WBITS + 32);
+		}
 		if (_zlibErr != Z_OK)
 			return;
 
@@ -198,6 +294,11 @@ public:
 	}
 
 	~GZipReadStream() {
+		for (uint32 i = 0; i < _seekPoints.size(); i++) {
+			inflateEnd(&_seekPoints[i]->state);
+			delete _seekPoints[i];
+		}
+
 		inflateEnd(&_stream);
 	}
 
@@ -208,26 +309,39 @@ public:
 	}
 
 	uint32 read(void *dataPtr, uint32 dataSize) {
+		uint32 remaining = dataSize;
 		_stream.next_out = (byte *)dataPtr;
-		_stream.avail_out = dataSize;
-
-		// Keep going while we get no error
-		while (_zlibErr == Z_OK && _stream.avail_out) {
-			if (_stream.avail_in == 0 && !_wrapped->eos()) {
-				// If we are out of input data: Read more data, if available.
-				_stream.next_in = _buf;
-				_stream.avail_in = _wrapped->read(_buf, BUFSIZE);
+
+		while (_zlibErr == Z_OK && remaining) {
+			// Stop at the next seek point, so that we can record it
+			uint32 chunk = MIN(remaining, _nextSeekPoint - _pos);
+			_stream.avail_out = chunk;
+
+			// Keep going while we get no error
+			while (_zlibErr == Z_OK && _stream.avail_out) {
+				if (_stream.avail_in == 0 && !_wrapped->eos()) {
+					// If we are out of input data: Read more data, if available.
+					_stream.next_in = _buf;
+					_stream.avail_in = _wrapped->read(_buf, BUFSIZE);
+				}
+				_zlibErr = inflate(&_stream, Z_NO_FLUSH);
 			}
-			_zlibErr = inflate(&_stream, Z_NO_FLUSH);
-		}
 
-		// Update the position counter
-		_pos += dataSize - _stream.avail_out;
+			// Update the position counter
+			_pos += chunk - _stream.avail_out;
+			remaining -= chunk - _stream.avail_out;
+
+			if (_pos == _nextSeekPoint) {
+				if (_zlibErr == Z_OK)
+					addSeekPoint();
+				updateNextSeekPoint();
+			}
+		}
 
-		if (_zlibErr == Z_STREAM_END && _stream.avail_out > 0)
+		if (_zlibErr == Z_STREAM_END && remaining > 0)
 			_eos = true;
 
-		return dataSize - _stream.avail_out;
+		return dataSize - remaining;
 	}
 
 	bool eos() const {
@@ -252,10 +366,24 @@ public:
 
 		assert(newPos >= 0);
 
-		if ((uint32)newPos < _pos) {
-			// To search backward, we have to restart the whole decompression
-			// from the start of the file. A rather wasteful operation, best
-			// to avoid it. :/
+		// Resume from the closest seek point, if it's closer than the current position
+		SeekPoint *point = findSeekPoint(newPos);
+
+		if (point && (point->pos > _pos || (uint32)newPos < _pos)) {
+			inflateEnd(&_stream);
+			_zlibErr = inflateCopy(&_stream, &point->state);
+			if (_zlibErr != Z_OK)
+				return false;	// FIXME: STREAM REWRITE
+
+			_pos = point->pos;
+			_wrapped->seek(point->inputPos, SEEK_SET);
+			_stream.next_in = _buf;
+			_stream.avail_in = 0;
+			updateNextSeekPoint();
+		} else if ((uint32)newPos < _pos) {
+			// To search backward without a seek point, we have to restart the
+			// whole decompression from the start of the file. A rather
+			// wasteful operation, best to avoid it. :/
 #if DEBUG
 			warning("Backward seeking in GZipReadStream detected");
 #endif
@@ -266,6 +394,7 @@ public:
 				return false;	// FIXME: STREAM REWRITE
 			_stream.next_in = _buf;
 			_stream.avail_in = 0;
+			updateNextSeekPoint();
 		}
 
 		offset = newPos - _pos;
@@ -389,9 +518,16 @@ public:
 	}
 };
 
+SeekableReadStream *wrapDeflateReadStream(SeekableReadStream *toBeWrapped, uint32 knownSize, uint32 seekMemoryLimit) {
+	if (!toBeWrapped)
+		return 0;
+
+	return new GZipReadStream(toBeWrapped, knownSize, true, seekMemoryLimit);
+}
+
 #endif	// USE_ZLIB
 
-SeekableReadStream *wrapCompressedReadStream(SeekableReadStream *toBeWrapped, uint32 knownSize) {
+SeekableReadStream *wrapCompressedReadStream(SeekableReadStream *toBeWrapped, uint32 knownSize, uint32 seekMemoryLimit) {
 #if defined(USE_ZLIB)
 	if (toBeWrapped) {
 		uint16 header = toBeWrapped->readUint16BE();
@@ -400,7 +536,7 @@ SeekableReadStream *wrapCompressedReadStream(SeekableReadStream *toBeWrapped, ui
 				      header % 31 == 0));
 		toBeWrapped->seek(-2, SEEK_CUR);
 		if (isCompressed)
-			return new GZipReadStream(toBeWrapped, knownSize);
+			return new GZipReadStream(toBeWrapped, knownSize, false, seekMemoryLimit);
 	}
 #endif
 	return toBeWrapped;
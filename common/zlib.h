@@ -30,6 +30,11 @@ namespace Common {
 class SeekableReadStream;
 class WriteStream;
 
+enum {
+	/** Default amount of memory a decompressing stream spends on seek points. */
+	kDefaultSeekMemoryLimit = 1024 * 1024
+};
+
 #if defined(USE_ZLIB)
 
 /**
@@ -96,6 +101,25 @@ bool inflateZlibHeaderless(byte *dst, uint dstLen, const byte *src, uint srcLen,
  */
 bool inflateZlibInstallShield(byte *dst, uint dstLen, const byte *src, uint srcLen);
 
+/**
+ * Take an arbitrary SeekableReadStream containing raw deflate data, i.e.
+ * without a zlib or gzip header, and wrap it in a custom stream which
+ * provides transparent on-the-fly decompression. Data is only decompressed
+ * as far as it is read from the returned stream.
+ *
+ * Since raw deflate data doesn't carry its length, the decompressed size has
+ * to be supplied as knownSize.
+ *
+ * It is safe to call this with a NULL parameter (in this case, NULL is
+ * returned).
+ *
+ * @param toBeWrapped	the stream to be wrapped, which is deleted together with the returned stream
+ * @param knownSize		the length of the decompressed data
+ * @param seekMemoryLimit	the memory to spend at most on seek points, see wrapCompressedReadStream()
+ */
+SeekableReadStream *wrapDeflateReadStream(SeekableReadStream *toBeWrapped, uint32 knownSize,
+	uint32 seekMemoryLimit = kDefaultSeekMemoryLimit);
+
 #endif
 
 /**
@@ -110,13 +134,20 @@ bool inflateZlibInstallShield(byte *dst, uint dstLen, const byte *src, uint srcL
  * the decompressed length at wrap-time, then it can be supplied as knownSize
  * here. knownSize will be ignored if the GZip-stream DOES include a length.
  *
+ * To make seeking backwards cheaper, the decompression state is remembered
+ * every so often while reading. Each of these seek points takes about 40KB.
+ * The points are thinned out to stay below seekMemoryLimit; with a limit
+ * of 0, backward seeks always decompress from the start again.
+ *
  * It is safe to call this with a NULL parameter (in this case, NULL is
  * returned).
  *
  * @param toBeWrapped	the stream to be wrapped (if it is in gzip-format)
  * @param knownSize		a supplied length of the compressed data (if not available directly)
+ * @param seekMemoryLimit	the memory to spend at most on seek points
  */
-SeekableReadStream *wrapCompressedReadStream(SeekableReadStream *toBeWrapped, uint32 knownSize = 0);
+SeekableReadStream *wrapCompressedReadStream(SeekableReadStream *toBeWrapped, uint32 knownSize = 0,
+	uint32 seekMemoryLimit = kDefaultSeekMemoryLimit);
 
 /**
  * Take an arbitrary WriteStream and wrap it in a custom stream which provides
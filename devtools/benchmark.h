@@ -0,0 +1,191 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ */
+
+/*
+ * Helpers shared by the devtools/ *_benchmark tools.
+ *
+ * Each benchmark runs several passes over the same work and reports the
+ * fastest one, which is the least disturbed by other processes, along with
+ * a checksum of the output, so that optimizations can be checked to give
+ * the same results.
+ *
+ * Everything is inline, since the tools are single source files and a
+ * devtools library would be linked into ScummVM itself by rules.mk.
+ * Include this after defining FORBIDDEN_SYMBOL_ALLOW_ALL.
+ */
+
+#ifndef DEVTOOLS_BENCHMARK_H
+#define DEVTOOLS_BENCHMARK_H
+
+#include <stdio.h>
+#include <sys/time.h>
+
+#include "common/scummsys.h"
+#include "common/system.h"
+#include "common/util.h"
+
+#include "graphics/surface.h"
+
+namespace Benchmark {
+
+/** Return the number of microseconds since the first call. */
+inline uint32 getMicros() {
+	static timeval startTime;
+	static bool started = false;
+
+	if (!started) {
+		gettimeofday(&startTime, 0);
+		started = true;
+	}
+
+	timeval curTime;
+	gettimeofday(&curTime, 0);
+	return (uint32)((curTime.tv_sec - startTime.tv_sec) * 1000000 + (curTime.tv_usec - startTime.tv_usec));
+}
+
+/**
+ * Keeps the time of the fastest of several passes. The time of a pass is
+ * the sum of all intervals timed with start() and stop(), so that setting
+ * up and checking the output can be left out.
+ */
+class PassTimer {
+public:
+	PassTimer() : _bestTime(0), _time(0), _start(0), _passes(0) {}
+
+	void start() { _start = getMicros(); }
+
+	/** Stop timing, and return the time since start() in microseconds. */
+	uint32 stop() {
+		const uint32 time = getMicros() - _start;
+		_time += time;
+		return time;
+	}
+
+	/** End the current pass. Returns true if it was the fastest so far. */
+	bool endPass() {
+		const bool fastest = (_passes == 0 || _time < _bestTime);
+		if (fastest)
+			_bestTime = _time;
+
+		_time = 0;
+		_passes++;
+		return fastest;
+	}
+
+	/** The time of the fastest pass in microseconds, at least 1. */
+	uint32 getBestTime() const { return MAX<uint32>(_bestTime, 1); }
+
+	double getBestSeconds() const { return getBestTime() / 1000000.0; }
+
+private:
+	uint32 _bestTime;
+	uint32 _time;
+	uint32 _start;
+	int _passes;
+};
+
+inline uint32 updateChecksum(uint32 checksum, uint32 value) {
+	return checksum * 31 + value;
+}
+
+inline uint32 updateChecksum(uint32 checksum, const byte *data, uint32 size) {
+	for (uint32 i = 0; i < size; i++)
+		checksum = checksum * 31 + data[i];
+
+	return checksum;
+}
+
+inline uint32 updateChecksum(uint32 checksum, const int16 *samples, uint32 count) {
+	for (uint32 i = 0; i < count; i++)
+		checksum = checksum * 31 + (uint16)samples[i];
+
+	return checksum;
+}
+
+/** Checksum the pixels of a surface, leaving out the padding at the end of the rows. */
+inline uint32 updateChecksum(uint32 checksum, const Graphics::Surface &surface) {
+	for (int y = 0; y < surface.h; y++)
+		checksum = updateChecksum(checksum, (const byte *)surface.getBasePtr(0, y), surface.w * surface.format.bytesPerPixel);
+
+	return checksum;
+}
+
+/**
+ * Just enough of a backend for code which creates mutexes and asks for the
+ * time. Everything else does nothing, and there is no mixer.
+ */
+class BenchmarkSystem : public OSystem {
+public:
+	uint32 getMicros() { return Benchmark::getMicros(); }
+	uint32 getMillis() { return Benchmark::getMicros() / 1000; }
+	void delayMillis(uint msecs) {}
+	void getTimeAndDate(TimeDate &t) const {}
+
+	MutexRef createMutex() { return 0; }
+	void lockMutex(MutexRef mutex) {}
+	void unlockMutex(MutexRef mutex) {}
+	void deleteMutex(MutexRef mutex) {}
+
+	Audio::Mixer *getMixer() { return 0; }
+
+	void logMessage(LogMessageType::Type type, const char *message) { fputs(message, stderr); }
+	void displayMessageOnOSD(const char *msg) {}
+	void quit() {}
+
+	const GraphicsMode *getSupportedGraphicsModes() const {
+		static const GraphicsMode noGraphicsModes[] = { { 0, 0, 0 } };
+		return noGraphicsModes;
+	}
+
+	int getDefaultGraphicsMode() const { return 0; }
+	bool setGraphicsMode(int mode) { return false; }
+	int getGraphicsMode() const { return 0; }
+#ifdef USE_RGB_COLOR
+	Graphics::PixelFormat getScreenFormat() const { return Graphics::PixelFormat::createFormatCLUT8(); }
+	Common::List<Graphics::PixelFormat> getSupportedFormats() const { return Common::List<Graphics::PixelFormat>(); }
+#endif
+	void initSize(uint width, uint height, const Graphics::PixelFormat *format) {}
+	int16 getHeight() { return 0; }
+	int16 getWidth() { return 0; }
+	PaletteManager *getPaletteManager() { return 0; }
+	void copyRectToScreen(const void *buf, int pitch, int x, int y, int w, int h) {}
+	Graphics::Surface *lockScreen() { return 0; }
+	void unlockScreen() {}
+	void fillScreen(uint32 col) {}
+	void updateScreen() {}
+	void setShakePos(int shakeOffset) {}
+	void showOverlay() {}
+	void hideOverlay() {}
+	Graphics::PixelFormat getOverlayFormat() const { return Graphics::PixelFormat(); }
+	void clearOverlay() {}
+	void grabOverlay(void *buf, int pitch) {}
+	void copyRectToOverlay(const void *buf, int pitch, int x, int y, int w, int h) {}
+	int16 getOverlayHeight() { return 0; }
+	int16 getOverlayWidth() { return 0; }
+	bool showMouse(bool visible) { return false; }
+	void warpMouse(int x, int y) {}
+	void setMouseCursor(const void *buf, uint w, uint h, int hotspotX, int hotspotY, uint32 keycolor, bool dontScale, const Graphics::PixelFormat *format) {}
+};
+
+} // End of namespace Benchmark
+
+#endif
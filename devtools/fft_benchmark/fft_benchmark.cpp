@@ -0,0 +1,183 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ */
+
+/*
+ * This is a benchmark for the FFT, RDFT and DCT in common/. For every
+ * transform size from 256 to 4096 points, it reports how many transforms
+ * per second are done by the complex FFT, and by the real transforms and
+ * the DCT the way the Bink and QDM2 audio decoders use them.
+ *
+ * Each transform is repeated on its own output, which is scaled back to
+ * keep it in range, and the checksum is that of the final data.
+ */
+
+// Disable symbol overrides so that we can use system headers.
+#define FORBIDDEN_SYMBOL_ALLOW_ALL
+
+// HACK to allow building with the SDL backend on MinGW
+// see bug #1800764 "TOOLS: MinGW tools building broken"
+#ifdef main
+#undef main
+#endif // main
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "common/scummsys.h"
+#include "common/dct.h"
+#include "common/fft.h"
+#include "common/rdft.h"
+#include "common/util.h"
+
+#include "devtools/benchmark.h"
+
+enum TransformKind {
+	kTransformFFT,
+	kTransformRDFT,		///< DFT_C2R, as used by Bink audio
+	kTransformIRDFT,	///< IDFT_C2R, as used by QDM2
+	kTransformDCT,		///< DCT_III, as used by Bink audio
+
+	kTransformCount
+};
+
+static const char *const s_transformNames[kTransformCount] = {
+	"FFT",
+	"RDFT",
+	"IRDFT",
+	"DCT"
+};
+
+/**
+ * Run the transform the given number of times, timed with the timer.
+ * The data holds 1 << bits complex values, or 1 << bits real ones (plus two
+ * for the DCT).
+ */
+static void runTransform(TransformKind kind, int bits, float *data, int count, Benchmark::PassTimer &timer) {
+	const int n = 1 << bits;
+	const int values = (kind == kTransformFFT) ? 2 * n : n;
+
+	Common::FFT *fft = 0;
+	Common::RDFT *rdft = 0;
+	Common::DCT *dct = 0;
+
+	switch (kind) {
+	case kTransformFFT:
+		fft = new Common::FFT(bits, 0);
+		break;
+	case kTransformRDFT:
+		rdft = new Common::RDFT(bits, Common::RDFT::DFT_C2R);
+		break;
+	case kTransformIRDFT:
+		rdft = new Common::RDFT(bits, Common::RDFT::IDFT_C2R);
+		break;
+	case kTransformDCT:
+		dct = new Common::DCT(bits, Common::DCT::DCT_III);
+		break;
+	default:
+		break;
+	}
+
+	timer.start();
+
+	for (int i = 0; i < count; i++) {
+		if (fft) {
+			fft->permute((Common::Complex *)data);
+			fft->calc((Common::Complex *)data);
+		} else if (rdft) {
+			rdft->calc(data);
+		} else {
+			dct->calc(data);
+		}
+
+		// Scale the data back to a maximum of one
+		float max = 0.0f;
+		for (int j = 0; j < values; j++)
+			max = MAX(max, (float)fabs(data[j]));
+		if (max > 0.0f) {
+			const float scale = 1.0f / max;
+			for (int j = 0; j < values; j++)
+				data[j] *= scale;
+		}
+	}
+
+	timer.stop();
+
+	delete fft;
+	delete rdft;
+	delete dct;
+}
+
+int main(int argc, char *argv[]) {
+	int repeat = 5;
+	int count = 0;
+
+	for (int i = 1; i < argc; i++) {
+		if (!strcmp(argv[i], "--repeat") && i + 1 < argc) {
+			repeat = atoi(argv[++i]);
+		} else if (!strcmp(argv[i], "--count") && i + 1 < argc) {
+			count = atoi(argv[++i]);
+		} else {
+			printf("Usage: %s [--repeat <passes>] [--count <transforms per pass>]\n", argv[0]);
+			return 1;
+		}
+	}
+
+	if (repeat <= 0 || count < 0) {
+		fprintf(stderr, "Invalid arguments\n");
+		return 1;
+	}
+
+	float *data = new float[2 * 4096 + 2];
+
+	printf("%-6s %6s %14s %10s\n", "", "Points", "Transforms/s", "Checksum");
+
+	for (int kind = 0; kind < kTransformCount; kind++) {
+		for (int bits = 8; bits <= 12; bits++) {
+			// Do about the same amount of work for each size
+			const int transforms = count ? count : (40 << 12) >> (bits - 8);
+			Benchmark::PassTimer timer;
+			uint32 checksum = 0;
+
+			for (int pass = 0; pass < repeat; pass++) {
+				for (int i = 0; i < 2 * 4096 + 2; i++)
+					data[i] = (float)sin(i * 0.1) + (float)(i % 5) * 0.25f;
+
+				runTransform((TransformKind)kind, bits, data, transforms, timer);
+				timer.endPass();
+
+				checksum = 0;
+				for (int i = 0; i < ((kind == kTransformFFT) ? 2 : 1) << bits; i++) {
+					uint32 value;
+					memcpy(&value, &data[i], sizeof(value));
+					checksum = Benchmark::updateChecksum(checksum, value);
+				}
+			}
+
+			printf("%-6s %6d %14.0f %08x\n", s_transformNames[kind], 1 << bits, transforms / timer.getBestSeconds(), checksum);
+		}
+	}
+
+	delete[] data;
+	return 0;
+}
@@ -0,0 +1,13 @@
+MODULE := devtools/fft_benchmark
+
+MODULE_OBJS := \
+	fft_benchmark.o
+
+# Set the name of the executable
+TOOL_EXECUTABLE := fft_benchmark
+
+# The transforms are taken from the common module
+TOOL_DEPS := common/libcommon.a
+
+# Include common rules
+include $(srcdir)/rules.mk
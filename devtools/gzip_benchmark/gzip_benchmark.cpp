@@ -0,0 +1,179 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ */
+
+/*
+ * This is a benchmark for seeking in gzip compressed streams, as returned by
+ * wrapCompressedReadStream(). It compresses a few MB of text like data, and
+ * reports how many random seeks per second, each followed by a small read,
+ * the decompressing stream does with a few different limits on the memory
+ * spent on seek points. Reading the whole stream sequentially is timed as
+ * well. The checksum of the data read is the same for all limits.
+ */
+
+// Disable symbol overrides so that we can use system headers.
+#define FORBIDDEN_SYMBOL_ALLOW_ALL
+
+// HACK to allow building with the SDL backend on MinGW
+// see bug #1800764 "TOOLS: MinGW tools building broken"
+#ifdef main
+#undef main
+#endif // main
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "common/scummsys.h"
+#include "common/memstream.h"
+#include "common/util.h"
+#include "common/zlib.h"
+
+#include "devtools/benchmark.h"
+
+static uint32 s_seed = 1;
+
+static uint32 getRandom() {
+	s_seed = s_seed * 1103515245 + 12345;
+	return s_seed >> 8;
+}
+
+/** Compress data made of random words, which compresses about as well as text. */
+static byte *createCompressedData(uint32 size, uint32 &compressedSize) {
+	static const char *const words[] = {
+		"the ", "room ", "door ", "is ", "locked ", "you ", "can't ", "open ", "it ",
+		"look ", "at ", "key ", "with ", "pick ", "up ", "a ", "strange ", "object ",
+		"talk ", "to ", "guard ", "\n"
+	};
+
+	Common::MemoryWriteStreamDynamic *compressed = new Common::MemoryWriteStreamDynamic(DisposeAfterUse::YES);
+	Common::WriteStream *stream = Common::wrapCompressedWriteStream(compressed);
+
+	for (uint32 written = 0; written < size; ) {
+		const char *word = words[getRandom() % ARRAYSIZE(words)];
+		const uint32 length = MIN<uint32>(strlen(word), size - written);
+		stream->write(word, length);
+		written += length;
+	}
+
+	stream->finalize();
+
+	// Deleting the wrapper deletes the wrapped stream, so copy the data first
+	compressedSize = compressed->size();
+	byte *data = new byte[compressedSize];
+	memcpy(data, compressed->getData(), compressedSize);
+	delete stream;
+	return data;
+}
+
+/**
+ * Seek to random positions and read a bit at each of them, or read the whole
+ * stream if count is 0. Returns the checksum of the data read.
+ */
+static uint32 runSeeks(const byte *compressed, uint32 compressedSize, uint32 seekMemoryLimit,
+		uint32 count, Benchmark::PassTimer &timer) {
+	Common::SeekableReadStream *stream = Common::wrapCompressedReadStream(
+		new Common::MemoryReadStream(compressed, compressedSize), 0, seekMemoryLimit);
+
+	byte buffer[4096];
+	const uint32 size = stream->size();
+	uint32 checksum = 0;
+
+	// Always seek to the same positions
+	s_seed = 1;
+
+	timer.start();
+
+	if (count == 0) {
+		while (!stream->eos()) {
+			const uint32 length = stream->read(buffer, sizeof(buffer));
+			checksum = Benchmark::updateChecksum(checksum, buffer, length);
+		}
+	}
+
+	for (uint32 i = 0; i < count; i++) {
+		stream->seek(getRandom() % (size - sizeof(buffer)), SEEK_SET);
+		stream->read(buffer, sizeof(buffer));
+		checksum = Benchmark::updateChecksum(checksum, READ_UINT32(buffer));
+	}
+
+	timer.stop();
+
+	delete stream;
+	return checksum;
+}
+
+int main(int argc, char *argv[]) {
+#ifdef USE_ZLIB
+	int repeat = 3;
+	uint32 count = 200;
+
+	for (int i = 1; i < argc; i++) {
+		if (!strcmp(argv[i], "--repeat") && i + 1 < argc) {
+			repeat = atoi(argv[++i]);
+		} else if (!strcmp(argv[i], "--count") && i + 1 < argc) {
+			count = atoi(argv[++i]);
+		} else {
+			printf("Usage: %s [--repeat <passes>] [--count <seeks per pass>]\n", argv[0]);
+			return 1;
+		}
+	}
+
+	if (repeat <= 0 || count == 0) {
+		fprintf(stderr, "Invalid arguments\n");
+		return 1;
+	}
+
+	const uint32 size = 4 * 1024 * 1024;
+	uint32 compressedSize;
+	byte *compressed = createCompressedData(size, compressedSize);
+	printf("%u bytes compressed to %u bytes\n\n", size, compressedSize);
+
+	printf("%-12s %12s %10s\n", "Seek memory", "Seeks/s", "Checksum");
+
+	static const uint32 limits[] = { 0, 256 * 1024, Common::kDefaultSeekMemoryLimit, 4 * 1024 * 1024 };
+
+	for (uint32 i = 0; i <= ARRAYSIZE(limits); i++) {
+		// The last pass reads the stream sequentially
+		const bool sequential = (i == ARRAYSIZE(limits));
+		const uint32 limit = sequential ? (uint32)Common::kDefaultSeekMemoryLimit : limits[i];
+		Benchmark::PassTimer timer;
+		uint32 checksum = 0;
+
+		for (int pass = 0; pass < repeat; pass++) {
+			checksum = runSeeks(compressed, compressedSize, limit, sequential ? 0 : count, timer);
+			timer.endPass();
+		}
+
+		const double seconds = timer.getBestSeconds();
+		if (sequential)
+			printf("%-12s %9.1f MB/s %08x\n", "sequential", size / seconds / (1024 * 1024), checksum);
+		else
+			printf("%9uKB %12.1f %08x\n", limit / 1024, count / seconds, checksum);
+	}
+
+	delete[] compressed;
+	return 0;
+#else
+	fprintf(stderr, "This benchmark needs zlib support\n");
+	return 1;
+#endif
+}
@@ -0,0 +1,17 @@
+MODULE := devtools/gzip_benchmark
+
+MODULE_OBJS := \
+	gzip_benchmark.o
+
+# Set the name of the executable
+TOOL_EXECUTABLE := gzip_benchmark
+
+# The compressed streams are taken from the common module
+TOOL_DEPS := common/libcommon.a
+
+ifdef USE_ZLIB
+TOOL_LIBS := -lz
+endif
+
+# Include common rules
+include $(srcdir)/rules.mk
@@ -0,0 +1,195 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ */
+
+/*
+ * This is a benchmark comparing FlatHashMap with HashMap. For maps with
+ * integer keys of a few sizes, and for case insensitive String keys as
+ * used for file names, it reports how many million operations per second
+ * each map does when inserting all keys, looking up present and missing
+ * keys, iterating over the map and erasing half of the keys. Each operation
+ * is timed on its own, and the checksum of the values seen is the same for
+ * both maps.
+ */
+
+// Disable symbol overrides so that we can use system headers.
+#define FORBIDDEN_SYMBOL_ALLOW_ALL
+
+// HACK to allow building with the SDL backend on MinGW
+// see bug #1800764 "TOOLS: MinGW tools building broken"
+#ifdef main
+#undef main
+#endif // main
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "common/scummsys.h"
+#include "common/flathashmap.h"
+#include "common/hash-str.h"
+#include "common/hashmap.h"
+#include "common/str.h"
+
+#include "devtools/benchmark.h"
+
+enum Operation {
+	kOperationInsert,
+	kOperationLookup,
+	kOperationMiss,
+	kOperationIterate,
+	kOperationErase,
+
+	kOperationCount
+};
+
+static const char *const s_operationNames[kOperationCount] = {
+	"insert",
+	"lookup",
+	"miss",
+	"iterate",
+	"erase"
+};
+
+/**
+ * Run all operations on a map, on fresh maps several times, so that the
+ * times of small maps can be measured. The keys to look up as missing
+ * follow the present ones in the key array. Returns the checksum.
+ */
+template<class Map, class Key>
+static uint32 runOperations(const Key *keys, uint count, uint rounds, Benchmark::PassTimer *timers) {
+	uint32 checksum = 0;
+
+	for (uint round = 0; round < rounds; round++) {
+		Map map;
+
+		timers[kOperationInsert].start();
+		for (uint i = 0; i < count; i++)
+			map[keys[i]] = i;
+		timers[kOperationInsert].stop();
+
+		timers[kOperationLookup].start();
+		for (uint i = 0; i < count; i++)
+			checksum += map.getVal(keys[i]);
+		timers[kOperationLookup].stop();
+
+		timers[kOperationMiss].start();
+		for (uint i = count; i < 2 * count; i++)
+			checksum += map.contains(keys[i]);
+		timers[kOperationMiss].stop();
+
+		timers[kOperationIterate].start();
+		for (typename Map::const_iterator i = map.begin(); i != map.end(); ++i)
+			checksum += i->_value;
+		timers[kOperationIterate].stop();
+
+		timers[kOperationErase].start();
+		for (uint i = 0; i < count; i += 2)
+			map.erase(keys[i]);
+		timers[kOperationErase].stop();
+
+		checksum += map.size();
+	}
+
+	return checksum;
+}
+
+/**
+ * Run the operations on the map several times, and print the fastest time
+ * of each operation in million operations per second.
+ */
+template<class Map, class Key>
+static void benchmark(const char *name, const Key *keys, uint count, int repeat) {
+	// Do at least a million operations of each kind per pass
+	const uint rounds = MAX<uint>(1, 1000000 / count);
+
+	Benchmark::PassTimer timers[kOperationCount];
+	uint32 checksum = 0;
+	for (int pass = 0; pass < repeat; pass++) {
+		checksum = runOperations<Map, Key>(keys, count, rounds, timers);
+
+		for (int op = 0; op < kOperationCount; op++)
+			timers[op].endPass();
+	}
+
+	printf("%-22s %8u", name, count);
+	for (int op = 0; op < kOperationCount; op++) {
+		// Only half of the keys are erased
+		const double ops = (double)rounds * ((op == kOperationErase) ? (count + 1) / 2 : count);
+		printf(" %8.2f", ops / timers[op].getBestSeconds() / 1000000.0);
+	}
+	printf(" %08x\n", checksum);
+}
+
+int main(int argc, char *argv[]) {
+	int repeat = 5;
+	uint stringCount = 50000;
+
+	for (int i = 1; i < argc; i++) {
+		if (!strcmp(argv[i], "--repeat") && i + 1 < argc) {
+			repeat = atoi(argv[++i]);
+		} else if (!strcmp(argv[i], "--strings") && i + 1 < argc) {
+			stringCount = atoi(argv[++i]);
+		} else {
+			printf("Usage: %s [--repeat <passes>] [--strings <string keys>]\n", argv[0]);
+			return 1;
+		}
+	}
+
+	if (repeat <= 0 || stringCount == 0) {
+		fprintf(stderr, "Invalid arguments\n");
+		return 1;
+	}
+
+	printf("%-22s %8s", "Mops/s", "Keys");
+	for (int op = 0; op < kOperationCount; op++)
+		printf(" %8s", s_operationNames[op]);
+	printf(" %8s\n", "Checksum");
+
+	// Integer keys, scattered over the whole range, since HashMap does not
+	// scramble the hash values and would find consecutive keys in order
+	static const uint sizes[] = { 1000, 200000, 2000000 };
+	uint *intKeys = new uint[2 * sizes[ARRAYSIZE(sizes) - 1]];
+	for (uint i = 0; i < ARRAYSIZE(sizes); i++) {
+		// Multiplying by an odd number gives a unique key for each index
+		for (uint j = 0; j < 2 * sizes[i]; j++)
+			intKeys[j] = (j + 1) * 0x9E3779B1;
+
+		// Fewer passes for the big maps, which take long to set up
+		const int passes = (sizes[i] > 200000) ? MAX(1, repeat / 3) : repeat;
+		benchmark<Common::HashMap<uint, uint>, uint>("HashMap<uint>", intKeys, sizes[i], passes);
+		benchmark<Common::FlatHashMap<uint, uint>, uint>("FlatHashMap<uint>", intKeys, sizes[i], passes);
+	}
+	delete[] intKeys;
+
+	// File name like String keys, compared ignoring case
+	Common::String *stringKeys = new Common::String[2 * stringCount];
+	for (uint i = 0; i < 2 * stringCount; i++)
+		stringKeys[i] = Common::String::format("%s/Data%u.%s", (i & 1) ? "sounds" : "GRAPHICS", i, (i % 3) ? "dat" : "BIN");
+
+	typedef Common::HashMap<Common::String, uint, Common::IgnoreCase_Hash, Common::IgnoreCase_EqualTo> StringHashMap;
+	typedef Common::FlatHashMap<Common::String, uint, Common::IgnoreCase_Hash, Common::IgnoreCase_EqualTo> StringFlatHashMap;
+	benchmark<StringHashMap, Common::String>("HashMap<String>", stringKeys, stringCount, repeat);
+	benchmark<StringFlatHashMap, Common::String>("FlatHashMap<String>", stringKeys, stringCount, repeat);
+	delete[] stringKeys;
+
+	return 0;
+}
@@ -0,0 +1,13 @@
+MODULE := devtools/hashmap_benchmark
+
+MODULE_OBJS := \
+	hashmap_benchmark.o
+
+# Set the name of the executable
+TOOL_EXECUTABLE := hashmap_benchmark
+
+# The maps are taken from the common module
+TOOL_DEPS := common/libcommon.a
+
+# Include common rules
+include $(srcdir)/rules.mk
@@ -0,0 +1,202 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ */
+
+/*
+ * This is a benchmark for the Huffman decoder and the bit streams in
+ * common/. It encodes a million symbols with some of the SVQ1 codebooks,
+ * each symbol as likely as its code length implies, and reports how many
+ * symbols per second Huffman::getSymbol() decodes from a BitStream32BEMSB,
+ * the way the SVQ1 decoder reads them. Reading fields of 1 to 16 bits with
+ * BitStream::getBits() is timed as well. The checksum is that of the decoded
+ * values, and each decoded symbol is also compared with the encoded one.
+ */
+
+// Disable symbol overrides so that we can use system headers.
+#define FORBIDDEN_SYMBOL_ALLOW_ALL
+
+// HACK to allow building with the SDL backend on MinGW
+// see bug #1800764 "TOOLS: MinGW tools building broken"
+#ifdef main
+#undef main
+#endif // main
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "common/scummsys.h"
+#include "common/bitstream.h"
+#include "common/huffman.h"
+#include "common/memstream.h"
+#include "video/codecs/svq1_vlc.h"
+
+#include "devtools/benchmark.h"
+
+struct Codebook {
+	const char *name;
+	uint32 codeCount;
+	const uint32 *codes;
+	const byte *lengths;
+};
+
+static const Codebook s_codebooks[] = {
+	{ "SVQ1 block type", 4, Video::s_svq1BlockTypeCodes, Video::s_svq1BlockTypeLengths },
+	{ "SVQ1 intra stage", 8, Video::s_svq1IntraMultistageCodes[0], Video::s_svq1IntraMultistageLengths[0] },
+	{ "SVQ1 inter stage", 8, Video::s_svq1InterMultistageCodes[0], Video::s_svq1InterMultistageLengths[0] },
+	{ "SVQ1 motion", 33, Video::s_svq1MotionComponentCodes, Video::s_svq1MotionComponentLengths },
+	{ "SVQ1 intra mean", 256, Video::s_svq1IntraMeanCodes, Video::s_svq1IntraMeanLengths },
+	{ "SVQ1 inter mean", 512, Video::s_svq1InterMeanCodes, Video::s_svq1InterMeanLengths }
+};
+
+/** Writes bits MSB first, which a BitStream32BEMSB reads back in order. */
+class BitWriter {
+public:
+	BitWriter(byte *data) : _data(data), _bitPos(0) {}
+
+	void put(uint32 value, int length) {
+		for (int i = length - 1; i >= 0; i--) {
+			if ((value >> i) & 1)
+				_data[_bitPos / 8] |= 0x80 >> (_bitPos % 8);
+			_bitPos++;
+		}
+	}
+
+private:
+	byte *_data;
+	uint32 _bitPos;
+};
+
+static uint32 s_seed = 1;
+
+static uint32 getRandom() {
+	s_seed = s_seed * 1103515245 + 12345;
+	return s_seed >> 8;
+}
+
+/**
+ * Encode the symbols with the codebook, picking each code with the
+ * probability of 2^-length. Returns the symbols in the order encoded.
+ */
+static void encodeSymbols(const Codebook &codebook, uint32 count, byte *data, uint32 *symbols) {
+	// The cumulative probabilities of the codes, in units of 2^-24
+	uint32 *cumulative = new uint32[codebook.codeCount];
+	uint32 total = 0;
+	for (uint32 i = 0; i < codebook.codeCount; i++) {
+		total += (1 << 24) >> MIN<int>(codebook.lengths[i], 24);
+		cumulative[i] = total;
+	}
+
+	BitWriter writer(data);
+	for (uint32 i = 0; i < count; i++) {
+		const uint32 value = getRandom() % total;
+		uint32 code = 0;
+		while (cumulative[code] <= value)
+			code++;
+
+		writer.put(codebook.codes[code], codebook.lengths[code]);
+		symbols[i] = code;
+	}
+
+	delete[] cumulative;
+}
+
+int main(int argc, char *argv[]) {
+	int repeat = 5;
+	uint32 count = 1000000;
+
+	for (int i = 1; i < argc; i++) {
+		if (!strcmp(argv[i], "--repeat") && i + 1 < argc) {
+			repeat = atoi(argv[++i]);
+		} else if (!strcmp(argv[i], "--count") && i + 1 < argc) {
+			count = atoi(argv[++i]);
+		} else {
+			printf("Usage: %s [--repeat <passes>] [--count <symbols per pass>]\n", argv[0]);
+			return 1;
+		}
+	}
+
+	if (repeat <= 0 || count == 0) {
+		fprintf(stderr, "Invalid arguments\n");
+		return 1;
+	}
+
+	// Codes are at most 32 bits long, plus padding to read ahead from
+	const uint32 dataSize = count * 4 + 64;
+	byte *data = new byte[dataSize];
+	uint32 *symbols = new uint32[count];
+
+	printf("%-16s %10s %10s\n", "", "Msymbols/s", "Checksum");
+
+	for (uint i = 0; i < ARRAYSIZE(s_codebooks); i++) {
+		const Codebook &codebook = s_codebooks[i];
+
+		memset(data, 0, dataSize);
+		encodeSymbols(codebook, count, data, symbols);
+
+		Common::Huffman huffman(0, codebook.codeCount, codebook.codes, codebook.lengths);
+		Benchmark::PassTimer timer;
+		uint32 checksum = 0;
+		bool mismatch = false;
+
+		for (int pass = 0; pass < repeat; pass++) {
+			Common::MemoryReadStream stream(data, dataSize);
+			Common::BitStream32BEMSB bits(stream);
+
+			checksum = 0;
+			timer.start();
+			for (uint32 j = 0; j < count; j++) {
+				const uint32 symbol = huffman.getSymbol(bits);
+				mismatch |= (symbol != symbols[j]);
+				checksum = Benchmark::updateChecksum(checksum, symbol);
+			}
+			timer.stop();
+			timer.endPass();
+		}
+
+		printf("%-16s %10.2f %08x%s\n", codebook.name, count / timer.getBestSeconds() / 1000000.0, checksum,
+			mismatch ? " (decoded symbols differ from the encoded ones)" : "");
+	}
+
+	// Plain bit fields, with the lengths cycling through 1 to 16 bits
+	for (uint32 i = 0; i < dataSize; i++)
+		data[i] = getRandom();
+
+	Benchmark::PassTimer timer;
+	uint32 checksum = 0;
+	for (int pass = 0; pass < repeat; pass++) {
+		Common::MemoryReadStream stream(data, dataSize);
+		Common::BitStream32BEMSB bits(stream);
+
+		checksum = 0;
+		timer.start();
+		for (uint32 j = 0; j < count; j++)
+			checksum = Benchmark::updateChecksum(checksum, bits.getBits((j & 15) + 1));
+		timer.stop();
+		timer.endPass();
+	}
+
+	printf("%-16s %10.2f %08x\n", "getBits(1-16)", count / timer.getBestSeconds() / 1000000.0, checksum);
+
+	delete[] data;
+	delete[] symbols;
+	return 0;
+}
@@ -0,0 +1,13 @@
+MODULE := devtools/huffman_benchmark
+
+MODULE_OBJS := \
+	huffman_benchmark.o
+
+# Set the name of the executable
+TOOL_EXECUTABLE := huffman_benchmark
+
+# The Huffman decoder and bit streams are taken from the common module
+TOOL_DEPS := common/libcommon.a
+
+# Include common rules
+include $(srcdir)/rules.mk
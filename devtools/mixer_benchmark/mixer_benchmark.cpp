@@ -0,0 +1,162 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ */
+
+/*
+ * This is a benchmark for the audio mixer. It plays 8 or 16 (all mixer
+ * channels) endless streams at once, a third each of them stereo at the
+ * output rate, mono at 22050 Hz and mono at 11025 Hz, at varying volumes and
+ * balances. It reports how long the mixer callback takes to fill a buffer of
+ * 1024 sample pairs, at output rates of 44100 and 48000 Hz, and a checksum
+ * of the mixed output.
+ */
+
+// Disable symbol overrides so that we can use system headers.
+#define FORBIDDEN_SYMBOL_ALLOW_ALL
+
+// HACK to allow building with the SDL backend on MinGW
+// see bug #1800764 "TOOLS: MinGW tools building broken"
+#ifdef main
+#undef main
+#endif // main
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "common/scummsys.h"
+#include "common/util.h"
+
+#include "audio/audiostream.h"
+#include "audio/mixer_intern.h"
+
+#include "devtools/benchmark.h"
+
+/**
+ * An endless stream of sawtooth waves, with a different period on each
+ * channel.
+ */
+class SawtoothStream : public Audio::AudioStream {
+public:
+	SawtoothStream(int rate, bool stereo, int period) : _rate(rate), _stereo(stereo), _period(period), _phase(0) {}
+
+	int readBuffer(int16 *buffer, const int numSamples) {
+		for (int i = 0; i < numSamples; i++) {
+			const int period = (_stereo && (i & 1)) ? _period + 7 : _period;
+			buffer[i] = (int16)((_phase % period) * 50000 / period - 25000);
+			if (!_stereo || (i & 1))
+				_phase++;
+		}
+		return numSamples;
+	}
+
+	bool isStereo() const { return _stereo; }
+	int getRate() const { return _rate; }
+	bool endOfData() const { return false; }
+
+private:
+	int _rate;
+	bool _stereo;
+	int _period;
+	int _phase;
+};
+
+int main(int argc, char *argv[]) {
+	int repeat = 5;
+	int count = 500;
+
+	for (int i = 1; i < argc; i++) {
+		if (!strcmp(argv[i], "--repeat") && i + 1 < argc) {
+			repeat = atoi(argv[++i]);
+		} else if (!strcmp(argv[i], "--count") && i + 1 < argc) {
+			count = atoi(argv[++i]);
+		} else {
+			printf("Usage: %s [--repeat <passes>] [--count <buffers per pass>]\n", argv[0]);
+			return 1;
+		}
+	}
+
+	if (repeat <= 0 || count <= 0) {
+		fprintf(stderr, "Invalid arguments\n");
+		return 1;
+	}
+
+	Benchmark::BenchmarkSystem *system = new Benchmark::BenchmarkSystem();
+	g_system = system;
+
+	const uint bufferSamples = 1024;
+	int16 *buffer = new int16[bufferSamples * 2];
+
+	printf("%6s %8s %12s %10s\n", "Rate", "Channels", "us/buffer", "Checksum");
+
+	static const int rates[] = { 44100, 48000 };
+	static const int channelCounts[] = { 8, 16 };
+
+	for (uint r = 0; r < ARRAYSIZE(rates); r++) {
+		for (uint c = 0; c < ARRAYSIZE(channelCounts); c++) {
+			Benchmark::PassTimer timer;
+			uint32 checksum = 0;
+
+			for (int pass = 0; pass < repeat; pass++) {
+				Audio::MixerImpl *mixer = new Audio::MixerImpl(system, rates[r]);
+				mixer->setReady(true);
+
+				for (int i = 0; i < channelCounts[c]; i++) {
+					Audio::AudioStream *stream;
+					switch (i % 3) {
+					case 0:
+						stream = new SawtoothStream(rates[r], true, 50 + i * 3);
+						break;
+					case 1:
+						stream = new SawtoothStream(22050, false, 40 + i * 5);
+						break;
+					default:
+						stream = new SawtoothStream(11025, false, 30 + i * 7);
+						break;
+					}
+
+					Audio::SoundHandle handle;
+					mixer->playStream(Audio::Mixer::kPlainSoundType, &handle, stream, -1,
+						(byte)(64 + (i * 37) % 192), (int8)((i * 29) % 255 - 127), DisposeAfterUse::YES, false, false);
+				}
+
+				checksum = 0;
+				for (int i = 0; i < count; i++) {
+					// Only time the mixer, not the checksum
+					timer.start();
+					mixer->mixCallback((byte *)buffer, bufferSamples * 4);
+					timer.stop();
+
+					checksum = Benchmark::updateChecksum(checksum, buffer, bufferSamples * 2);
+				}
+
+				timer.endPass();
+				delete mixer;
+			}
+
+			printf("%6d %8d %12.1f %08x\n", rates[r], channelCounts[c], (double)timer.getBestTime() / count, checksum);
+		}
+	}
+
+	delete[] buffer;
+	delete system;
+	return 0;
+}
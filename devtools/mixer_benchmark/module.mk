@@ -0,0 +1,15 @@
+MODULE := devtools/mixer_benchmark
+
+MODULE_OBJS := \
+	mixer_benchmark.o
+
+# Set the name of the executable
+TOOL_EXECUTABLE := mixer_benchmark
+
+# The mixer is taken from the audio module
+TOOL_DEPS := \
+	audio/libaudio.a \
+	common/libcommon.a
+
+# Include common rules
+include $(srcdir)/rules.mk
@@ -0,0 +1,28 @@
+MODULE := devtools/mt32_benchmark
+
+MODULE_OBJS := \
+	mt32_benchmark.o
+
+# Set the name of the executable
+TOOL_EXECUTABLE := mt32_benchmark
+
+# The emulator is taken from the audio module
+TOOL_DEPS := \
+	audio/softsynth/mt32/AReverbModel.o \
+	audio/softsynth/mt32/DelayReverb.o \
+	audio/softsynth/mt32/FreeverbModel.o \
+	audio/softsynth/mt32/LA32Ramp.o \
+	audio/softsynth/mt32/Part.o \
+	audio/softsynth/mt32/Partial.o \
+	audio/softsynth/mt32/PartialManager.o \
+	audio/softsynth/mt32/Poly.o \
+	audio/softsynth/mt32/Synth.o \
+	audio/softsynth/mt32/TVA.o \
+	audio/softsynth/mt32/TVF.o \
+	audio/softsynth/mt32/TVP.o \
+	audio/softsynth/mt32/Tables.o \
+	audio/softsynth/mt32/freeverb.o \
+	common/libcommon.a
+
+# Include common rules
+include $(srcdir)/rules.mk
@@ -0,0 +1,402 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ */
+
+/*
+ * This is a benchmark for the MT-32 emulator. It renders a standard MIDI
+ * file, or a synthetic song playing on all parts, and reports the real time
+ * factor. The MT-32 (or CM-32L) ROMs are required, and are looked for in the
+ * directory given with --rom-path. Any change to the emulator's output shows
+ * in the checksum, even one below the audible level.
+ */
+
+// Disable symbol overrides so that we can use system headers.
+#define FORBIDDEN_SYMBOL_ALLOW_ALL
+
+// HACK to allow building with the SDL backend on MinGW
+// see bug #1800764 "TOOLS: MinGW tools building broken"
+#ifdef main
+#undef main
+#endif // main
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "common/scummsys.h"
+#include "common/array.h"
+#include "common/file.h"
+#include "common/memstream.h"
+#include "common/str.h"
+
+#include "audio/softsynth/mt32/mt32emu.h"
+
+#include "devtools/benchmark.h"
+
+/** A MIDI event, taking place at the given sample position. */
+struct MidiEvent {
+	uint32 sample;
+	uint32 msg;
+	Common::Array<byte> sysex;	///< SysEx data including the framing, or empty for a regular message
+};
+
+typedef Common::Array<MidiEvent> EventList;
+
+static Common::String s_romPath = ".";
+
+static Common::File *openROM(void *userData, const char *filename) {
+	const Common::String path = s_romPath + "/" + filename;
+	FILE *file = fopen(path.c_str(), "rb");
+	if (!file)
+		return 0;
+
+	fseek(file, 0, SEEK_END);
+	const long size = ftell(file);
+	fseek(file, 0, SEEK_SET);
+
+	byte *data = (byte *)malloc(size);
+	if (fread(data, 1, size, file) != (size_t)size) {
+		free(data);
+		fclose(file);
+		return 0;
+	}
+	fclose(file);
+
+	Common::File *romFile = new Common::File();
+	romFile->open(new Common::MemoryReadStream(data, size, DisposeAfterUse::YES), filename);
+	return romFile;
+}
+
+static void printDebug(void *userData, const char *fmt, va_list list) {
+	// Only print the errors preventing the synth from being opened
+	if (!strncmp(fmt, "Init Error", 10) || !strncmp(fmt, "Control ROM error", 17)) {
+		vfprintf(stderr, fmt, list);
+		fprintf(stderr, "\n");
+	}
+}
+
+static uint32 readVLQ(const byte *&pos, const byte *end) {
+	uint32 value = 0;
+	while (pos < end) {
+		const byte b = *pos++;
+		value = (value << 7) | (b & 0x7F);
+		if (!(b & 0x80))
+			break;
+	}
+	return value;
+}
+
+/** A MIDI event in a track, or a tempo change if tempo is non-zero. */
+struct TrackEvent {
+	uint32 tick;
+	uint32 tempo;
+	MidiEvent event;
+};
+
+static bool parseTrack(const byte *pos, const byte *end, Common::Array<TrackEvent> &events) {
+	static const byte eventLengths[8] = { 2, 2, 2, 2, 1, 1, 2, 0 };
+	uint32 tick = 0;
+	byte status = 0;
+
+	while (pos < end) {
+		tick += readVLQ(pos, end);
+		if (pos >= end)
+			return false;
+
+		TrackEvent event;
+		event.tick = tick;
+		event.tempo = 0;
+		event.event.msg = 0;
+
+		if (*pos == 0xFF) {
+			// Meta event, only the tempo is of interest
+			if (pos + 2 > end)
+				return false;
+			const byte type = pos[1];
+			pos += 2;
+			const uint32 length = readVLQ(pos, end);
+			if (pos + length > end)
+				return false;
+			if (type == 0x51 && length == 3) {
+				event.tempo = (pos[0] << 16) | (pos[1] << 8) | pos[2];
+				events.push_back(event);
+			} else if (type == 0x2F) {
+				return true;
+			}
+			pos += length;
+		} else if (*pos == 0xF0 || *pos == 0xF7) {
+			const byte type = *pos++;
+			const uint32 length = readVLQ(pos, end);
+			if (pos + length > end)
+				return false;
+			if (type == 0xF0)
+				event.event.sysex.push_back(0xF0);
+			for (uint32 i = 0; i < length; i++)
+				event.event.sysex.push_back(pos[i]);
+			events.push_back(event);
+			pos += length;
+		} else {
+			// Running status
+			if (*pos & 0x80)
+				status = *pos++;
+			if (!(status & 0x80))
+				return false;
+
+			const byte length = eventLengths[(status >> 4) & 7];
+			if (pos + length > end)
+				return false;
+			event.event.msg = status | (pos[0] << 8) | (length > 1 ? pos[1] << 16 : 0);
+			events.push_back(event);
+			pos += length;
+		}
+	}
+
+	return true;
+}
+
+static bool loadMidiFile(const char *filename, uint32 rate, EventList &result, uint32 &length) {
+	FILE *file = fopen(filename, "rb");
+	if (!file) {
+		fprintf(stderr, "Could not open '%s'\n", filename);
+		return false;
+	}
+
+	fseek(file, 0, SEEK_END);
+	const long size = ftell(file);
+	fseek(file, 0, SEEK_SET);
+
+	byte *data = new byte[size];
+	const bool read = fread(data, 1, size, file) == (size_t)size;
+	fclose(file);
+
+	if (!read || size < 14 || memcmp(data, "MThd", 4) || (data[12] & 0x80)) {
+		fprintf(stderr, "'%s' is not a standard MIDI file with a metrical time division\n", filename);
+		delete[] data;
+		return false;
+	}
+
+	const uint32 ticksPerBeat = (data[12] << 8) | data[13];
+	const byte *pos = data + 8 + ((data[4] << 24) | (data[5] << 16) | (data[6] << 8) | data[7]);
+	const byte *end = data + size;
+
+	// Merge the events of all tracks, keeping their order within the tracks
+	Common::Array<TrackEvent> events;
+	while (pos + 8 <= end) {
+		const uint32 chunkLength = (pos[4] << 24) | (pos[5] << 16) | (pos[6] << 8) | pos[7];
+		const byte *chunkEnd = MIN(pos + 8 + chunkLength, end);
+
+		if (!memcmp(pos, "MTrk", 4)) {
+			Common::Array<TrackEvent> track;
+			if (!parseTrack(pos + 8, chunkEnd, track)) {
+				fprintf(stderr, "'%s' contains an invalid track\n", filename);
+				delete[] data;
+				return false;
+			}
+
+			Common::Array<TrackEvent> merged;
+			uint32 i = 0, j = 0;
+			while (i < events.size() || j < track.size()) {
+				if (j == track.size() || (i < events.size() && events[i].tick <= track[j].tick))
+					merged.push_back(events[i++]);
+				else
+					merged.push_back(track[j++]);
+			}
+			events = merged;
+		}
+
+		pos = chunkEnd;
+	}
+
+	delete[] data;
+
+	// Convert the ticks to sample positions
+	uint32 tempo = 500000;
+	uint32 lastTick = 0;
+	double time = 0.0;
+
+	for (uint32 i = 0; i < events.size(); i++) {
+		time += (double)(events[i].tick - lastTick) * tempo / ticksPerBeat / 1000000.0;
+		lastTick = events[i].tick;
+
+		if (events[i].tempo) {
+			tempo = events[i].tempo;
+		} else {
+			result.push_back(events[i].event);
+			result.back().sample = (uint32)(time * rate);
+		}
+	}
+
+	// Leave some time for the last notes to decay
+	length = (uint32)((time + 2.0) * rate);
+	return true;
+}
+
+static void addMessage(EventList &events, uint32 sample, uint32 msg) {
+	MidiEvent event;
+	event.sample = sample;
+	event.msg = msg;
+	events.push_back(event);
+}
+
+/**
+ * Create a song playing chords on all melodic parts, with a different
+ * program on each, and a drum pattern on the rhythm part.
+ */
+static void createSong(uint32 rate, uint32 seconds, EventList &events, uint32 &length) {
+	static const byte chords[4][3] = { { 48, 52, 55 }, { 45, 48, 52 }, { 41, 45, 48 }, { 43, 47, 50 } };
+	static const byte drums[4] = { 36, 42, 38, 42 };
+
+	const uint32 beat = rate / 2;
+	byte playing[8];
+
+	for (int part = 0; part < 8; part++) {
+		addMessage(events, 0, 0xC1 + part + ((part * 17 % 128) << 8));
+		playing[part] = 0;
+	}
+
+	for (uint32 i = 0; i * beat < seconds * rate; i++) {
+		const uint32 sample = i * beat;
+		const byte *chord = chords[(i / 4) % 4];
+
+		// The lower parts change the chord every bar, the upper ones play a
+		// melody on every beat
+		for (int part = 0; part < 8; part++) {
+			if (part < 4 && i % 4 != 0)
+				continue;
+
+			const byte channel = 1 + part;
+			const byte note = (part < 4) ? chord[part % 3] + 12 * (part / 3) : chord[(i + part) % 3] + 24;
+
+			if (playing[part])
+				addMessage(events, sample, 0x80 | channel | (playing[part] << 8));
+			addMessage(events, sample, 0x90 | channel | (note << 8) | (100 << 16));
+			playing[part] = note;
+		}
+
+		addMessage(events, sample, 0x99 | (drums[i % 4] << 8) | (110 << 16));
+		addMessage(events, sample + beat / 2, 0x89 | (drums[i % 4] << 8));
+	}
+
+	for (int part = 0; part < 8; part++)
+		addMessage(events, seconds * rate, 0x81 + part + (playing[part] << 8));
+
+	length = (seconds + 2) * rate;
+}
+
+int main(int argc, char *argv[]) {
+	uint32 rate = 32000;
+	uint32 blockSize = 1024;
+	int repeat = 3;
+	const char *filename = 0;
+
+	for (int i = 1; i < argc; i++) {
+		if (!strcmp(argv[i], "--rom-path") && i + 1 < argc) {
+			s_romPath = argv[++i];
+		} else if (!strcmp(argv[i], "--rate") && i + 1 < argc) {
+			rate = atoi(argv[++i]);
+		} else if (!strcmp(argv[i], "--block") && i + 1 < argc) {
+			blockSize = atoi(argv[++i]);
+		} else if (!strcmp(argv[i], "--repeat") && i + 1 < argc) {
+			repeat = atoi(argv[++i]);
+		} else if (argv[i][0] != '-' && !filename) {
+			filename = argv[i];
+		} else {
+			printf("Usage: %s [--rom-path <path>] [--rate <rate>] [--block <samples>] [--repeat <count>] [<file.mid>]\n", argv[0]);
+			return 1;
+		}
+	}
+
+	if (rate == 0 || blockSize == 0 || repeat <= 0) {
+		fprintf(stderr, "Invalid arguments\n");
+		return 1;
+	}
+
+	EventList events;
+	uint32 length;
+
+	if (filename) {
+		if (!loadMidiFile(filename, rate, events, length))
+			return 1;
+	} else {
+		createSong(rate, 60, events, length);
+	}
+
+	int16 *buffer = new int16[blockSize * 2];
+	uint32 checksum = 0;
+	Benchmark::PassTimer timer;
+
+	for (int pass = 0; pass < repeat; pass++) {
+		MT32Emu::SynthProperties prop;
+		memset(&prop, 0, sizeof(prop));
+		prop.sampleRate = rate;
+		prop.useReverb = true;
+		prop.printDebug = printDebug;
+		prop.openFile = openROM;
+
+		MT32Emu::Synth *synth = new MT32Emu::Synth();
+		if (!synth->open(prop)) {
+			fprintf(stderr, "Could not open the emulator, are the ROMs in '%s'?\n", s_romPath.c_str());
+			delete synth;
+			return 1;
+		}
+
+		uint32 rendered = 0;
+		uint32 next = 0;
+		checksum = 0;
+
+		timer.start();
+
+		while (rendered < length) {
+			while (next < events.size() && events[next].sample <= rendered) {
+				if (events[next].sysex.empty())
+					synth->playMsg(events[next].msg);
+				else
+					synth->playSysex(events[next].sysex.begin(), events[next].sysex.size());
+				next++;
+			}
+
+			// Render up to the next event, so that it is played at the right sample
+			uint32 samples = MIN(blockSize, length - rendered);
+			if (next < events.size())
+				samples = MIN(samples, events[next].sample - rendered);
+
+			synth->render(buffer, samples);
+			checksum = Benchmark::updateChecksum(checksum, buffer, samples * 2);
+
+			rendered += samples;
+		}
+
+		timer.stop();
+		timer.endPass();
+
+		synth->close();
+		delete synth;
+	}
+
+	const double seconds = timer.getBestSeconds();
+
+	printf("%u events, %.1f s of audio\n", events.size(), (double)length / rate);
+	printf("Rendered in %.3f s: %.1fx real time\n", seconds, (double)length / rate / seconds);
+	printf("Checksum: %08x\n", checksum);
+
+	delete[] buffer;
+	return 0;
+}
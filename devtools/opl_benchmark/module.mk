@@ -0,0 +1,13 @@
+MODULE := devtools/opl_benchmark
+
+MODULE_OBJS := \
+	opl_benchmark.o
+
+# Set the name of the executable
+TOOL_EXECUTABLE := opl_benchmark
+
+# The emulator is taken from the audio module
+TOOL_DEPS := audio/softsynth/opl/dbopl.o
+
+# Include common rules
+include $(srcdir)/rules.mk
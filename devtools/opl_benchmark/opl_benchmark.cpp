@@ -0,0 +1,300 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ */
+
+/*
+ * This is a benchmark for the DOSBox OPL emulator. It replays a register log
+ * captured with DOSBox (a .dro file, version 2) and reports how many samples
+ * per second the emulator generates. Without a file, a synthetic log playing
+ * notes on all melodic channels is used.
+ *
+ * The samples are generated in small blocks, the way the AdLib players of the
+ * engines request them from their timer callbacks.
+ */
+
+// Disable symbol overrides so that we can use system headers.
+#define FORBIDDEN_SYMBOL_ALLOW_ALL
+
+// HACK to allow building with the SDL backend on MinGW
+// see bug #1800764 "TOOLS: MinGW tools building broken"
+#ifdef main
+#undef main
+#endif // main
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "common/scummsys.h"
+#include "audio/softsynth/opl/dbopl.h"
+
+#include "devtools/benchmark.h"
+
+using namespace OPL::DOSBox;
+
+enum {
+	kHardwareOpl2 = 0,
+	kHardwareDualOpl2 = 1,
+	kHardwareOpl3 = 2
+};
+
+/** A register write, taking place at the given time in milliseconds. */
+struct RegisterWrite {
+	uint32 time;
+	uint16 reg;
+	uint8 value;
+};
+
+struct RegisterLog {
+	RegisterWrite *writes;
+	uint32 count;
+	uint32 length;	///< Length of the log in milliseconds
+	int hardware;
+};
+
+static uint16 readUint16LE(const uint8 *data) {
+	return data[0] | (data[1] << 8);
+}
+
+static uint32 readUint32LE(const uint8 *data) {
+	return data[0] | (data[1] << 8) | (data[2] << 16) | ((uint32)data[3] << 24);
+}
+
+static bool loadDRO(const char *filename, RegisterLog &log) {
+	FILE *file = fopen(filename, "rb");
+	if (!file) {
+		fprintf(stderr, "Could not open '%s'\n", filename);
+		return false;
+	}
+
+	fseek(file, 0, SEEK_END);
+	long size = ftell(file);
+	fseek(file, 0, SEEK_SET);
+
+	uint8 *data = new uint8[size];
+	if (fread(data, 1, size, file) != (size_t)size)
+		size = 0;
+	fclose(file);
+
+	if (size < 26 || memcmp(data, "DBRAWOPL", 8) || readUint16LE(data + 8) != 2 || data[21] != 0 || data[22] != 0) {
+		fprintf(stderr, "'%s' is not an uncompressed version 2 DRO file\n", filename);
+		delete[] data;
+		return false;
+	}
+
+	const uint32 pairs = readUint32LE(data + 12);
+	const uint8 shortDelayCode = data[23];
+	const uint8 longDelayCode = data[24];
+	const uint8 codemapLength = data[25];
+	const uint8 *codemap = data + 26;
+	const uint8 *pos = codemap + codemapLength;
+	const uint8 *end = data + size;
+
+	log.writes = new RegisterWrite[pairs];
+	log.count = 0;
+	log.length = 0;
+	log.hardware = data[20];
+
+	for (uint32 i = 0; i < pairs && pos + 2 <= end; i++, pos += 2) {
+		if (pos[0] == shortDelayCode) {
+			log.length += pos[1] + 1;
+		} else if (pos[0] == longDelayCode) {
+			log.length += (pos[1] + 1) << 8;
+		} else if ((pos[0] & 0x7F) < codemapLength) {
+			RegisterWrite &write = log.writes[log.count++];
+			write.time = log.length;
+			write.reg = codemap[pos[0] & 0x7F] | ((pos[0] & 0x80) << 1);
+			write.value = pos[1];
+		}
+	}
+
+	delete[] data;
+	return true;
+}
+
+static void addWrite(RegisterLog &log, uint32 time, uint16 reg, uint8 value) {
+	RegisterWrite &write = log.writes[log.count++];
+	write.time = time;
+	write.reg = reg;
+	write.value = value;
+}
+
+/**
+ * Create a log playing a simple tune on all melodic channels. The
+ * instruments cover both synthesis modes, tremolo, vibrato and feedback.
+ */
+static void createLog(RegisterLog &log, bool opl3, uint32 length) {
+	static const uint8 operatorOffsets[9] = { 0x00, 0x01, 0x02, 0x08, 0x09, 0x0A, 0x10, 0x11, 0x12 };
+	static const uint16 noteFrequencies[12] = { 0x157, 0x16B, 0x181, 0x198, 0x1B0, 0x1CA, 0x1E5, 0x202, 0x220, 0x241, 0x263, 0x287 };
+
+	const int channels = opl3 ? 18 : 9;
+	const uint32 noteLength = 125;
+
+	log.writes = new RegisterWrite[256 + (length / noteLength + 1) * channels * 3];
+	log.count = 0;
+	log.length = length;
+	log.hardware = opl3 ? kHardwareOpl3 : kHardwareOpl2;
+
+	addWrite(log, 0, 0x01, 0x20);
+	if (opl3)
+		addWrite(log, 0, 0x105, 0x01);
+	addWrite(log, 0, 0xBD, 0xC0);
+
+	for (int i = 0; i < channels; i++) {
+		const uint16 bank = (i / 9) << 8;
+		const uint16 op = bank | operatorOffsets[i % 9];
+		const uint16 chan = bank | (i % 9);
+
+		addWrite(log, 0, 0x20 + op, 0x01 | ((i & 1) ? 0x80 : 0x20) | ((i & 2) ? 0x40 : 0));
+		addWrite(log, 0, 0x23 + op, 0x01 | ((i & 4) ? 0x20 : 0));
+		addWrite(log, 0, 0x40 + op, 0x10 + i);
+		addWrite(log, 0, 0x43 + op, 0x00);
+		addWrite(log, 0, 0x60 + op, 0xF2 - (i & 3) * 0x10);
+		addWrite(log, 0, 0x63 + op, 0xF4);
+		addWrite(log, 0, 0x80 + op, 0x55);
+		addWrite(log, 0, 0x83 + op, 0x37);
+		addWrite(log, 0, 0xE0 + op, i & 3);
+		addWrite(log, 0, 0xE3 + op, 0x00);
+		addWrite(log, 0, 0xC0 + chan, 0x30 | ((i & 7) << 1) | ((i % 3) == 0 ? 1 : 0));
+	}
+
+	uint32 seed = 1;
+	for (uint32 time = 0; time < length; time += noteLength) {
+		for (int i = 0; i < channels; i++) {
+			const uint16 chan = ((i / 9) << 8) | (i % 9);
+
+			seed = seed * 1103515245 + 12345;
+			// Let some channels rest, so the silent channel check gets exercised
+			if ((seed >> 16) % 4 == 0)
+				continue;
+
+			const uint16 frequency = noteFrequencies[(seed >> 18) % 12];
+			const uint8 octave = 2 + (seed >> 22) % 4;
+
+			addWrite(log, time, 0xB0 + chan, 0x00);
+			addWrite(log, time, 0xA0 + chan, frequency & 0xFF);
+			addWrite(log, time, 0xB0 + chan, 0x20 | (octave << 2) | (frequency >> 8));
+		}
+	}
+}
+
+int main(int argc, char *argv[]) {
+	RegisterLog log;
+	uint32 rate = 44100;
+	uint32 blockSize = 128;
+	int repeat = 10;
+	const char *filename = 0;
+	bool opl3 = false;
+
+	for (int i = 1; i < argc; i++) {
+		if (!strcmp(argv[i], "--rate") && i + 1 < argc) {
+			rate = atoi(argv[++i]);
+		} else if (!strcmp(argv[i], "--block") && i + 1 < argc) {
+			blockSize = atoi(argv[++i]);
+		} else if (!strcmp(argv[i], "--repeat") && i + 1 < argc) {
+			repeat = atoi(argv[++i]);
+		} else if (!strcmp(argv[i], "--opl3")) {
+			opl3 = true;
+		} else if (argv[i][0] != '-' && !filename) {
+			filename = argv[i];
+		} else {
+			printf("Usage: %s [--rate <rate>] [--block <samples>] [--repeat <count>] [--opl3] [<file.dro>]\n", argv[0]);
+			return 1;
+		}
+	}
+
+	if (rate == 0 || blockSize == 0 || repeat <= 0) {
+		fprintf(stderr, "Invalid arguments\n");
+		return 1;
+	}
+
+	if (filename) {
+		if (!loadDRO(filename, log))
+			return 1;
+	} else {
+		createLog(log, opl3, 60 * 1000);
+	}
+
+	const bool stereo = log.hardware != kHardwareOpl2;
+	const uint32 channels = stereo ? 2 : 1;
+	const uint32 totalSamples = (uint32)((double)log.length * rate / 1000);
+
+	int32 *tempBuffer = new int32[blockSize * 2];
+	int16 *buffer = new int16[blockSize * 2];
+
+	DBOPL::InitTables();
+
+	uint32 checksum = 0;
+	Benchmark::PassTimer timer;
+
+	for (int pass = 0; pass < repeat; pass++) {
+		DBOPL::Chip *chip = new DBOPL::Chip();
+		chip->Setup(rate);
+		if (stereo)
+			chip->WriteReg(0x105, 1);
+
+		uint32 written = 0;
+		uint32 next = 0;
+		checksum = 0;
+
+		timer.start();
+
+		while (written < totalSamples) {
+			const uint32 now = (uint32)((double)written * 1000 / rate);
+			while (next < log.count && log.writes[next].time <= now) {
+				chip->WriteReg(log.writes[next].reg, log.writes[next].value);
+				next++;
+			}
+
+			const uint32 samples = blockSize < totalSamples - written ? blockSize : totalSamples - written;
+			if (stereo)
+				chip->GenerateBlock3(samples, tempBuffer);
+			else
+				chip->GenerateBlock2(samples, tempBuffer);
+
+			// Convert the samples like OPL::readBuffer does
+			for (uint32 i = 0; i < samples * channels; i++)
+				buffer[i] = tempBuffer[i];
+
+			checksum = Benchmark::updateChecksum(checksum, buffer, samples * channels);
+
+			written += samples;
+		}
+
+		timer.stop();
+		timer.endPass();
+		delete chip;
+	}
+
+	const double seconds = timer.getBestSeconds();
+	const double samples = totalSamples;
+
+	printf("%u register writes, %u ms, %s\n", log.count, log.length, stereo ? "stereo" : "mono");
+	printf("%.0f samples in %.3f s: %.0f samples/s (%.1fx real time)\n",
+	       samples, seconds, samples / seconds, samples / seconds / rate);
+	printf("Checksum: %08x\n", checksum);
+
+	delete[] buffer;
+	delete[] tempBuffer;
+	delete[] log.writes;
+
+	return 0;
+}
@@ -0,0 +1,209 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ */
+
+/*
+ * This is a benchmark for the scalers in graphics/. It scales a 320x200
+ * screen of blocky, pixel art like graphics with each scaler, in the 16
+ * bit 565 and the 32 bit 8888 formats, and reports the frames scaled per
+ * second, and a checksum of the scaled frame. Some of the scalers only
+ * support 16 bit pixels.
+ */
+
+// Disable symbol overrides so that we can use system headers.
+#define FORBIDDEN_SYMBOL_ALLOW_ALL
+
+// HACK to allow building with the SDL backend on MinGW
+// see bug #1800764 "TOOLS: MinGW tools building broken"
+#ifdef main
+#undef main
+#endif // main
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "common/scummsys.h"
+#include "common/util.h"
+
+#include "graphics/colormasks.h"
+#include "graphics/scaler.h"
+
+#include "devtools/benchmark.h"
+
+#ifndef USE_SCALERS
+#error The scaler benchmark needs the scalers to be enabled
+#endif
+
+struct Scaler {
+	const char *name;
+	ScalerProc *proc;
+	/** The scale factor, in halves */
+	int factor2;
+	bool only16Bit;
+};
+
+static const Scaler s_scalers[] = {
+	{ "Normal1x",   Normal1x,   2, false },
+	{ "Normal1o5x", Normal1o5x, 3, true },
+	{ "Normal2x",   Normal2x,   4, false },
+	{ "Normal3x",   Normal3x,   6, false },
+	{ "2xSaI",      _2xSaI,     4, true },
+	{ "Super2xSaI", Super2xSaI, 4, true },
+	{ "SuperEagle", SuperEagle, 4, true },
+	{ "AdvMame2x",  AdvMame2x,  4, false },
+	{ "AdvMame3x",  AdvMame3x,  6, false },
+#ifdef USE_HQ_SCALERS
+	{ "HQ2x",       HQ2x,       4, false },
+	{ "HQ3x",       HQ3x,       6, false },
+#endif
+	{ "TV2x",       TV2x,       4, false },
+	{ "DotMatrix",  DotMatrix,  4, false }
+};
+
+struct Format {
+	int bitFormat;
+	Graphics::PixelFormat format;
+};
+
+enum {
+	kWidth = 320,
+	kHeight = 200,
+
+	// The scalers read a few pixels around the area they scale
+	kBorder = 4
+};
+
+/**
+ * Fill the screen with blocks of a few colors and sizes, and some
+ * gradients, which gives the scalers edges to find in all directions.
+ */
+static void fillScreen(byte *screen, int pitch, const Graphics::PixelFormat &format) {
+	static const byte palette[][3] = {
+		{   0,   0,   0 }, { 255, 255, 255 }, { 200,  40,  40 }, {  40, 200,  40 },
+		{  40,  40, 200 }, { 220, 220,  60 }, {  60, 220, 220 }, { 220,  60, 220 },
+		{ 120,  80,  40 }, {  90,  90,  90 }, { 170, 170, 170 }, { 250, 150,  80 },
+		{  20,  80,  20 }, {  80,  20,  80 }, { 130, 160, 250 }, { 250, 200, 200 }
+	};
+
+	uint32 seed = 1;
+	for (int y = 0; y < kHeight + 2 * kBorder; y++) {
+		byte *row = screen + y * pitch;
+		for (int x = 0; x < kWidth + 2 * kBorder; x++) {
+			// Blocks of 1 to 4 pixels, depending on the area of the screen
+			const int size = 1 + (x / 80 + y / 50) % 4;
+			seed = ((x / size) * 7919 + (y / size) * 104729) * 1103515245 + 12345;
+
+			byte r, g, b;
+			if (((seed >> 20) & 7) == 0) {
+				r = x * 255 / (kWidth + 2 * kBorder);
+				g = y * 255 / (kHeight + 2 * kBorder);
+				b = 128;
+			} else {
+				const byte *color = palette[(seed >> 16) & 15];
+				r = color[0];
+				g = color[1];
+				b = color[2];
+			}
+
+			const uint32 color = format.RGBToColor(r, g, b);
+			if (format.bytesPerPixel == 2)
+				((uint16 *)row)[x] = color;
+			else
+				((uint32 *)row)[x] = color;
+		}
+	}
+}
+
+/** Scale the screen the given number of times, timed with the timer. */
+static void runScaler(const Scaler &scaler, const byte *src, int srcPitch, byte *dst, int dstPitch, int count, Benchmark::PassTimer &timer) {
+	timer.start();
+
+	for (int i = 0; i < count; i++)
+		scaler.proc(src, srcPitch, dst, dstPitch, kWidth, kHeight);
+
+	timer.stop();
+}
+
+int main(int argc, char *argv[]) {
+	int repeat = 5;
+	int count = 200;
+
+	for (int i = 1; i < argc; i++) {
+		if (!strcmp(argv[i], "--repeat") && i + 1 < argc) {
+			repeat = atoi(argv[++i]);
+		} else if (!strcmp(argv[i], "--count") && i + 1 < argc) {
+			count = atoi(argv[++i]);
+		} else {
+			printf("Usage: %s [--repeat <passes>] [--count <frames per pass>]\n", argv[0]);
+			return 1;
+		}
+	}
+
+	if (repeat <= 0 || count <= 0) {
+		fprintf(stderr, "Invalid arguments\n");
+		return 1;
+	}
+
+	const Format formats[] = {
+		{  565, Graphics::createPixelFormat<565>() },
+		{ 8888, Graphics::createPixelFormat<8888>() }
+	};
+
+	printf("%-10s %4s %10s %10s\n", "", "Bits", "Frames/s", "Checksum");
+
+	for (int format = 0; format < ARRAYSIZE(formats); format++) {
+		const Graphics::PixelFormat &pixelFormat = formats[format].format;
+		InitScalers(formats[format].bitFormat);
+
+		const int srcPitch = (kWidth + 2 * kBorder) * pixelFormat.bytesPerPixel;
+		byte *screen = new byte[srcPitch * (kHeight + 2 * kBorder)];
+		fillScreen(screen, srcPitch, pixelFormat);
+		const byte *src = screen + kBorder * srcPitch + kBorder * pixelFormat.bytesPerPixel;
+
+		for (int i = 0; i < ARRAYSIZE(s_scalers); i++) {
+			const Scaler &scaler = s_scalers[i];
+			if (scaler.only16Bit && pixelFormat.bytesPerPixel != 2)
+				continue;
+
+			const int dstWidth = kWidth * scaler.factor2 / 2;
+			const int dstHeight = kHeight * scaler.factor2 / 2;
+			const int dstPitch = dstWidth * pixelFormat.bytesPerPixel;
+			byte *dst = new byte[dstPitch * dstHeight];
+
+			Benchmark::PassTimer timer;
+			for (int pass = 0; pass < repeat; pass++) {
+				runScaler(scaler, src, srcPitch, dst, dstPitch, count, timer);
+				timer.endPass();
+			}
+
+			const uint32 checksum = Benchmark::updateChecksum(0, dst, dstPitch * dstHeight);
+			printf("%-10s %4d %10.1f %08x\n", scaler.name, pixelFormat.bytesPerPixel * 8, count / timer.getBestSeconds(), checksum);
+
+			delete[] dst;
+		}
+
+		delete[] screen;
+		DestroyScalers();
+	}
+
+	return 0;
+}
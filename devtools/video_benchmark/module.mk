@@ -0,0 +1,22 @@
+MODULE := devtools/video_benchmark
+
+MODULE_OBJS := \
+	video_benchmark.o
+
+# Set the name of the executable
+TOOL_EXECUTABLE := video_benchmark
+
+# The decoders are taken from the video module
+TOOL_DEPS := \
+	video/libvideo.a \
+	audio/libaudio.a \
+	graphics/libgraphics.a \
+	common/libcommon.a
+
+# QuickTime audio tracks may be compressed with zlib
+ifdef USE_ZLIB
+TOOL_LIBS := -lz
+endif
+
+# Include common rules
+include $(srcdir)/rules.mk
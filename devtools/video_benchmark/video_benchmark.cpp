@@ -0,0 +1,190 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ */
+
+/*
+ * This is a benchmark for the video decoders. It decodes all frames of a
+ * Smacker or Bink file as fast as possible, and reports the number of frames
+ * decoded per second, and the average and slowest frame decode times.
+ *
+ * The file is read into memory first, so that only the decoding is measured.
+ * The times are those of the fastest pass, and a checksum of all decoded
+ * frames is printed with them.
+ */
+
+// Disable symbol overrides so that we can use system headers.
+#define FORBIDDEN_SYMBOL_ALLOW_ALL
+
+// HACK to allow building with the SDL backend on MinGW
+// see bug #1800764 "TOOLS: MinGW tools building broken"
+#ifdef main
+#undef main
+#endif // main
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "common/scummsys.h"
+#include "common/memstream.h"
+#include "common/str.h"
+
+#include "audio/mixer_intern.h"
+
+#include "graphics/surface.h"
+
+#include "video/bink_decoder.h"
+#include "video/smk_decoder.h"
+
+#include "devtools/benchmark.h"
+
+/**
+ * The video decoders set up their audio tracks with the mixer, so the
+ * benchmark backend needs one.
+ */
+class VideoBenchmarkSystem : public Benchmark::BenchmarkSystem {
+public:
+	VideoBenchmarkSystem() : _mixer(0) {}
+
+	~VideoBenchmarkSystem() {
+		delete _mixer;
+	}
+
+	void initBackend() {
+		// The other managers aren't needed, so don't call OSystem::initBackend()
+		_mixer = new Audio::MixerImpl(this, 22050);
+	}
+
+	Audio::Mixer *getMixer() { return _mixer; }
+
+private:
+	Audio::MixerImpl *_mixer;
+};
+
+static Video::VideoDecoder *createDecoder(const char *filename) {
+	Common::String name(filename);
+	name.toLowercase();
+
+	if (name.hasSuffix(".smk"))
+		return new Video::SmackerDecoder();
+
+#ifdef USE_BINK
+	if (name.hasSuffix(".bik"))
+		return new Video::BinkDecoder();
+#endif
+
+	return 0;
+}
+
+int main(int argc, char *argv[]) {
+	int repeat = 3;
+	const char *filename = 0;
+
+	for (int i = 1; i < argc; i++) {
+		if (!strcmp(argv[i], "--repeat") && i + 1 < argc) {
+			repeat = atoi(argv[++i]);
+		} else if (argv[i][0] != '-' && !filename) {
+			filename = argv[i];
+		} else {
+			filename = 0;
+			break;
+		}
+	}
+
+	if (!filename) {
+		printf("Usage: %s [--repeat <passes>] <file.smk|file.bik>\n", argv[0]);
+		return 1;
+	}
+
+	if (repeat <= 0) {
+		fprintf(stderr, "Invalid arguments\n");
+		return 1;
+	}
+
+	FILE *file = fopen(filename, "rb");
+	if (!file) {
+		fprintf(stderr, "Could not open '%s'\n", filename);
+		return 1;
+	}
+
+	fseek(file, 0, SEEK_END);
+	const long size = ftell(file);
+	fseek(file, 0, SEEK_SET);
+
+	byte *data = (byte *)malloc(size);
+	if (fread(data, 1, size, file) != (size_t)size) {
+		fprintf(stderr, "Could not read '%s'\n", filename);
+		fclose(file);
+		return 1;
+	}
+
+	fclose(file);
+
+	VideoBenchmarkSystem *system = new VideoBenchmarkSystem();
+	g_system = system;
+	system->initBackend();
+
+	Benchmark::PassTimer timer;
+	uint32 slowestFrame = 0, frames = 0, checksum = 0;
+
+	for (int pass = 0; pass < repeat; pass++) {
+		Video::VideoDecoder *decoder = createDecoder(filename);
+		if (!decoder) {
+			fprintf(stderr, "Unknown video format\n");
+			return 1;
+		}
+
+		if (!decoder->loadStream(new Common::MemoryReadStream(data, size))) {
+			fprintf(stderr, "Could not load '%s'\n", filename);
+			return 1;
+		}
+
+		if (pass == 0)
+			printf("%dx%d, %d frames\n", decoder->getWidth(), decoder->getHeight(), decoder->getFrameCount());
+
+		uint32 slowest = 0;
+		frames = 0;
+		checksum = 0;
+
+		while (frames < decoder->getFrameCount()) {
+			timer.start();
+			const Graphics::Surface *frame = decoder->decodeNextFrame();
+			slowest = MAX(slowest, timer.stop());
+			frames++;
+
+			if (frame)
+				checksum = Benchmark::updateChecksum(checksum, *frame);
+		}
+
+		delete decoder;
+
+		if (timer.endPass())
+			slowestFrame = slowest;
+	}
+
+	printf("%.1f frames/s, %.2f ms per frame on average, %.2f ms for the slowest frame\n",
+	       frames / timer.getBestSeconds(), timer.getBestTime() / 1000.0 / MAX<uint32>(frames, 1), slowestFrame / 1000.0);
+	printf("Checksum: %08x\n", checksum);
+
+	delete system;
+	free(data);
+	return 0;
+}
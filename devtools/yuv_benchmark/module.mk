@@ -0,0 +1,13 @@
+MODULE := devtools/yuv_benchmark
+
+MODULE_OBJS := \
+	yuv_benchmark.o
+
+# Set the name of the executable
+TOOL_EXECUTABLE := yuv_benchmark
+
+# The conversion is taken from the graphics module
+TOOL_DEPS := graphics/libgraphics.a common/libcommon.a
+
+# Include common rules
+include $(srcdir)/rules.mk
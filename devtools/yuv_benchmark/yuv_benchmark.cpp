@@ -0,0 +1,188 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ */
+
+/*
+ * This is a benchmark for the YUV to RGB conversion in graphics/. It
+ * converts 640x480 and 1280x720 frames from YUV444, YUV420 and YUV410 to
+ * 16 and 32 bit surfaces, and reports the frames converted per second.
+ * The luminance scale is the one the decoders use: ITU for YUV420 (Bink
+ * and Theora), full for YUV444 (JPEG) and YUV410 (SVQ1). The checksum is
+ * that of the converted frame.
+ */
+
+// Disable symbol overrides so that we can use system headers.
+#define FORBIDDEN_SYMBOL_ALLOW_ALL
+
+// HACK to allow building with the SDL backend on MinGW
+// see bug #1800764 "TOOLS: MinGW tools building broken"
+#ifdef main
+#undef main
+#endif // main
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "common/scummsys.h"
+#include "common/util.h"
+
+#include "graphics/surface.h"
+#include "graphics/yuv_to_rgb.h"
+
+#include "devtools/benchmark.h"
+
+enum Subsampling {
+	kSubsampling444,
+	kSubsampling420,
+	kSubsampling410,
+
+	kSubsamplingCount
+};
+
+static const char *const s_subsamplingNames[kSubsamplingCount] = {
+	"YUV444",
+	"YUV420",
+	"YUV410"
+};
+
+struct FrameSize {
+	int width, height;
+};
+
+static const FrameSize s_frameSizes[] = {
+	{  640, 480 },
+	{ 1280, 720 }
+};
+
+/**
+ * Fill a plane with a gradient and some noise, which gives a spread of
+ * values similar to that of video frames.
+ */
+static void fillPlane(byte *plane, int width, int height, int pitch, uint32 seed) {
+	for (int y = 0; y < height; y++) {
+		for (int x = 0; x < pitch; x++) {
+			seed = seed * 1103515245 + 12345;
+			plane[y * pitch + x] = (byte)((x * 255 / width + y * 255 / height) / 2 + ((seed >> 16) & 31) - 16);
+		}
+	}
+}
+
+/** Convert the frame the given number of times, timed with the timer. */
+static void runConversion(Subsampling subsampling, Graphics::Surface &dst, const byte *y, const byte *u, const byte *v, int uvPitch, int count, Benchmark::PassTimer &timer) {
+	timer.start();
+
+	for (int i = 0; i < count; i++) {
+		switch (subsampling) {
+		case kSubsampling444:
+			YUVToRGBMan.convert444(&dst, Graphics::YUVToRGBManager::kScaleFull, y, u, v, dst.w, dst.h, dst.w, uvPitch);
+			break;
+		case kSubsampling420:
+			YUVToRGBMan.convert420(&dst, Graphics::YUVToRGBManager::kScaleITU, y, u, v, dst.w, dst.h, dst.w, uvPitch);
+			break;
+		case kSubsampling410:
+			YUVToRGBMan.convert410(&dst, Graphics::YUVToRGBManager::kScaleFull, y, u, v, dst.w, dst.h, dst.w, uvPitch);
+			break;
+		default:
+			break;
+		}
+	}
+
+	timer.stop();
+}
+
+int main(int argc, char *argv[]) {
+	int repeat = 5;
+	int count = 0;
+
+	for (int i = 1; i < argc; i++) {
+		if (!strcmp(argv[i], "--repeat") && i + 1 < argc) {
+			repeat = atoi(argv[++i]);
+		} else if (!strcmp(argv[i], "--count") && i + 1 < argc) {
+			count = atoi(argv[++i]);
+		} else {
+			printf("Usage: %s [--repeat <passes>] [--count <frames per pass>]\n", argv[0]);
+			return 1;
+		}
+	}
+
+	if (repeat <= 0 || count < 0) {
+		fprintf(stderr, "Invalid arguments\n");
+		return 1;
+	}
+
+	const Graphics::PixelFormat formats[] = {
+		Graphics::PixelFormat(2, 5, 6, 5, 0, 11, 5, 0, 0),
+		Graphics::PixelFormat(4, 8, 8, 8, 8, 24, 16, 8, 0)
+	};
+
+	printf("%-6s %9s %4s %10s %10s\n", "", "Size", "Bits", "Frames/s", "Checksum");
+
+	for (int subsampling = 0; subsampling < kSubsamplingCount; subsampling++) {
+		for (int size = 0; size < ARRAYSIZE(s_frameSizes); size++) {
+			const int width = s_frameSizes[size].width;
+			const int height = s_frameSizes[size].height;
+
+			// The chroma planes of YUV410 need an extra row and column
+			int uvWidth = width, uvHeight = height;
+			if (subsampling == kSubsampling420) {
+				uvWidth = width / 2;
+				uvHeight = height / 2;
+			} else if (subsampling == kSubsampling410) {
+				uvWidth = width / 4 + 1;
+				uvHeight = height / 4 + 1;
+			}
+
+			byte *y = new byte[width * height];
+			byte *u = new byte[uvWidth * uvHeight];
+			byte *v = new byte[uvWidth * uvHeight];
+			fillPlane(y, width, height, width, 1);
+			fillPlane(u, uvWidth, uvHeight, uvWidth, 2);
+			fillPlane(v, uvWidth, uvHeight, uvWidth, 3);
+
+			for (int format = 0; format < ARRAYSIZE(formats); format++) {
+				Graphics::Surface dst;
+				dst.create(width, height, formats[format]);
+
+				// Do about the same amount of work for each size
+				const int frames = count ? count : 200 * 640 * 480 / (width * height);
+				Benchmark::PassTimer timer;
+
+				for (int pass = 0; pass < repeat; pass++) {
+					runConversion((Subsampling)subsampling, dst, y, u, v, uvWidth, frames, timer);
+					timer.endPass();
+				}
+
+				const uint32 checksum = Benchmark::updateChecksum(0, dst);
+				printf("%-6s %4dx%-4d %4d %10.1f %08x\n", s_subsamplingNames[subsampling], width, height,
+				       formats[format].bytesPerPixel * 8, frames / timer.getBestSeconds(), checksum);
+
+				dst.free();
+			}
+
+			delete[] y;
+			delete[] u;
+			delete[] v;
+		}
+	}
+
+	return 0;
+}
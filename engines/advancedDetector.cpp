@@ -26,13 +26,50 @@
 #include "common/macresman.h"
 #include "common/md5.h"
 #include "common/config-manager.h"
+#include "common/hash-str.h"
 #include "common/system.h"
 #include "common/textconsole.h"
 #include "common/translation.h"
 
 #include "engines/advancedDetector.h"
+#include "engines/detectionCache.h"
 #include "engines/obsolete.h"
 
+/** Add a string, which may be NULL, to a hash. */
+static uint addToHash(uint hash, const char *str) {
+	return hash * 31 + (str ? Common::hashit(str) : 0);
+}
+
+/**
+ * Compute a hash of the detection tables of an engine, so that cached
+ * detection results are dropped when they change, even between builds
+ * of the same version.
+ */
+static uint hashDetectionTables(const byte *descPtr, uint descItemSize, const PlainGameDescriptor *gameids) {
+	uint hash = 0;
+
+	for (; ((const ADGameDescription *)descPtr)->gameid != 0; descPtr += descItemSize) {
+		const ADGameDescription *g = (const ADGameDescription *)descPtr;
+
+		hash = addToHash(hash, g->gameid);
+		hash = addToHash(hash, g->extra);
+		for (const ADGameFileDescription *fileDesc = g->filesDescriptions; fileDesc->fileName; fileDesc++) {
+			hash = addToHash(hash, fileDesc->fileName);
+			hash = addToHash(hash, fileDesc->md5);
+			hash = hash * 31 + fileDesc->fileSize;
+		}
+		hash = ((hash * 31 + g->language) * 31 + g->platform) * 31 + g->flags;
+		hash = addToHash(hash, g->guioptions);
+	}
+
+	for (; gameids->gameid; gameids++) {
+		hash = addToHash(hash, gameids->gameid);
+		hash = addToHash(hash, gameids->description);
+	}
+
+	return hash;
+}
+
 static GameDescriptor toGameDescriptor(const ADGameDescription &g, const PlainGameDescriptor *sg) {
 	const char *title = 0;
 	const char *extra;
@@ -142,6 +179,22 @@ GameList AdvancedMetaEngine::detectGames(const Common::FSList &fslist) const {
 	// Compose a hashmap of all files in fslist.
 	composeFileHashMap(allFiles, fslist, (_maxScanDepth == 0 ? 1 : _maxScanDepth));
 
+	// Reuse the results of an earlier run, if none of the files changed since
+	Common::FSNode parent = fslist.begin()->getParent();
+	Common::FSList scannedFiles;
+	for (FileMap::const_iterator file = allFiles.begin(); file != allFiles.end(); ++file)
+		scannedFiles.push_back(file->_value);
+
+	Common::String signature;
+	bool cacheable = DetectionCacheMan.getSignature(parent, scannedFiles, signature);
+	signature += Common::String::format(":%x:%d:%d:%x", hashDetectionTables(_gameDescriptors, _descItemSize, _gameids),
+		_md5Bytes, _maxScanDepth, _flags);
+
+	if (cacheable && DetectionCacheMan.getGames(getName(), parent, signature, detectedGames)) {
+		debug(3, "Using cached detection results for '%s'", parent.getPath().c_str());
+		return detectedGames;
+	}
+
 	// Run the detector on this
 	matches = detectGame(fslist.begin()->getParent(), allFiles, Common::UNK_LANG, Common::kPlatformUnknown, "");
 
@@ -163,6 +216,9 @@ GameList AdvancedMetaEngine::detectGames(const Common::FSList &fslist) const {
 		}
 	}
 
+	if (cacheable)
+		DetectionCacheMan.setGames(getName(), parent, signature, detectedGames);
+
 	return detectedGames;
 }
 
@@ -325,6 +381,9 @@ void AdvancedMetaEngine::reportUnknown(const Common::FSNode &path, const ADFileP
 	report += "\n";
 
 	g_system->logMessage(LogMessageType::kInfo, report.c_str());
+
+	// Report the game again when the directory is scanned the next time
+	DetectionCacheMan.skipGames(getName(), path);
 }
 
 void AdvancedMetaEngine::composeFileHashMap(FileMap &allFiles, const Common::FSList &fslist, int depth) const {
@@ -385,6 +444,9 @@ bool AdvancedMetaEngine::getFileProperties(const Common::FSNode &parent, const F
 	if (!allFiles.contains(fname))
 		return false;
 
+	if (DetectionCacheMan.getFileMD5(allFiles[fname], _md5Bytes, fileProps.size, fileProps.md5))
+		return true;
+
 	Common::File testFile;
 
 	if (!testFile.open(allFiles[fname]))
@@ -392,6 +454,8 @@ bool AdvancedMetaEngine::getFileProperties(const Common::FSNode &parent, const F
 
 	fileProps.size = (int32)testFile.size();
 	fileProps.md5 = Common::computeStreamMD5AsString(testFile, _md5Bytes);
+
+	DetectionCacheMan.setFileMD5(allFiles[fname], _md5Bytes, fileProps.size, fileProps.md5);
 	return true;
 }
 
@@ -20,6 +20,8 @@
  *
  */
 
+#include "common/profiler.h"
+
 #include "agi/agi.h"
 #include "agi/sprite.h"
 #include "agi/graphics.h"
@@ -188,6 +190,8 @@ void AgiEngine::oldInputMode() {
 
 // If main_cycle returns false, don't process more events!
 int AgiEngine::mainCycle() {
+	PROFILE_ZONE("AgiEngine::mainCycle");
+
 	unsigned int key, kascii;
 	VtEntry *v = &_game.viewTable[0];
 
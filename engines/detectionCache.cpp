@@ -0,0 +1,344 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ */
+
+#include "common/debug.h"
+#include "common/algorithm.h"
+#include "common/md5.h"
+#include "common/memstream.h"
+#include "common/savefile.h"
+#include "common/system.h"
+#include "common/textconsole.h"
+
+#include "base/version.h"
+
+#include "engines/detectionCache.h"
+
+namespace Common {
+DECLARE_SINGLETON(DetectionCache);
+}
+
+static const char *kDetectionCacheFile = "detection.cache";
+
+/**
+ * The first line of the cache file. Bump the format number whenever the
+ * format changes.
+ */
+static Common::String getCacheHeader() {
+	return Common::String::format("# ScummVM detection cache 2 %s", gScummVMVersion);
+}
+
+/** Split a line of the cache file into its tab separated fields. */
+static void splitFields(const Common::String &line, Common::Array<Common::String> &fields) {
+	const char *start = line.c_str();
+	const char *tab;
+
+	fields.clear();
+	while ((tab = strchr(start, '\t')) != 0) {
+		fields.push_back(Common::String(start, tab));
+		start = tab + 1;
+	}
+	fields.push_back(Common::String(start));
+}
+
+/** Check whether a string can be stored as a field in the cache file. */
+static bool isValidField(const Common::String &str) {
+	return !strchr(str.c_str(), '\t') && !strchr(str.c_str(), '\n') && !strchr(str.c_str(), '\r');
+}
+
+DetectionCache::DetectionCache() : _today(0), _loaded(false), _dirty(false),
+	_fileHits(0), _fileMisses(0), _directoryHits(0), _directoryMisses(0) {
+}
+
+DetectionCache::~DetectionCache() {
+	flush();
+}
+
+bool DetectionCache::getFileMD5(const Common::FSNode &node, uint md5Bytes, int32 &size, Common::String &md5) {
+	int32 fileSize;
+	uint32 modificationTime;
+
+	if (!getFileStat(node, fileSize, modificationTime))
+		return false;
+
+	load();
+
+	FileMap::iterator entry = _files.find(Common::String::format("%s\t%d", node.getPath().c_str(), md5Bytes));
+	if (entry == _files.end() || entry->_value.size != fileSize || entry->_value.modificationTime != modificationTime) {
+		_fileMisses++;
+		return false;
+	}
+
+	_fileHits++;
+	touch(entry->_value.lastUsed);
+	size = entry->_value.size;
+	md5 = entry->_value.md5;
+	return true;
+}
+
+void DetectionCache::setFileMD5(const Common::FSNode &node, uint md5Bytes, int32 size, const Common::String &md5) {
+	FileEntry entry;
+
+	if (!getFileStat(node, entry.size, entry.modificationTime) || entry.size != size)
+		return;
+
+	if (!isValidField(node.getPath()))
+		return;
+
+	load();
+
+	entry.md5 = md5;
+	entry.lastUsed = _today;
+	_files[Common::String::format("%s\t%d", node.getPath().c_str(), md5Bytes)] = entry;
+	_dirty = true;
+}
+
+bool DetectionCache::getSignature(const Common::FSNode &directory, const Common::FSList &files, Common::String &signature) {
+	Common::Array<Common::String> names;
+
+	if (directory.getPath() != _statDirectory) {
+		_statDirectory = directory.getPath();
+		_fileStats.clear();
+	}
+
+	for (Common::FSList::const_iterator file = files.begin(); file != files.end(); ++file) {
+		if (file->isDirectory()) {
+			names.push_back(file->getPath() + "/");
+			continue;
+		}
+
+		int32 size;
+		uint32 modificationTime;
+		if (!getFileStat(*file, size, modificationTime))
+			return false;
+
+		names.push_back(Common::String::format("%s\t%d\t%u", file->getPath().c_str(), size, modificationTime));
+	}
+
+	// The order of the listing is not guaranteed
+	Common::sort(names.begin(), names.end());
+
+	Common::String all;
+	for (uint i = 0; i < names.size(); i++) {
+		all += names[i];
+		all += '\n';
+	}
+
+	Common::MemoryReadStream stream((const byte *)all.c_str(), all.size());
+	signature = Common::computeStreamMD5AsString(stream);
+	return true;
+}
+
+bool DetectionCache::getGames(const Common::String &engine, const Common::FSNode &directory, const Common::String &signature, GameList &games) {
+	load();
+
+	DirectoryMap::iterator entry = _directories.find(engine + '\t' + directory.getPath());
+	if (entry == _directories.end() || entry->_value.signature != signature) {
+		_directoryMisses++;
+		return false;
+	}
+
+	_directoryHits++;
+	touch(entry->_value.lastUsed);
+	games = entry->_value.games;
+	return true;
+}
+
+void DetectionCache::setGames(const Common::String &engine, const Common::FSNode &directory, const Common::String &signature, const GameList &games) {
+	if (!isValidField(engine) || !isValidField(directory.getPath()))
+		return;
+
+	const Common::String key = engine + '\t' + directory.getPath();
+	if (_skippedGames.contains(key)) {
+		_skippedGames.erase(key);
+		return;
+	}
+
+	for (uint i = 0; i < games.size(); i++) {
+		for (GameDescriptor::const_iterator j = games[i].begin(); j != games[i].end(); ++j) {
+			if (!isValidField(j->_key) || !isValidField(j->_value) || strchr(j->_key.c_str(), '='))
+				return;
+		}
+	}
+
+	load();
+
+	DirectoryEntry &entry = _directories[key];
+	entry.signature = signature;
+	entry.games = games;
+	entry.lastUsed = _today;
+	_dirty = true;
+}
+
+void DetectionCache::skipGames(const Common::String &engine, const Common::FSNode &directory) {
+	const Common::String key = engine + '\t' + directory.getPath();
+	_skippedGames[key] = true;
+
+	// Drop an earlier result, too
+	load();
+	if (_directories.contains(key)) {
+		_directories.erase(key);
+		_dirty = true;
+	}
+}
+
+bool DetectionCache::getFileStat(const Common::FSNode &node, int32 &size, uint32 &modificationTime) {
+	FileStatMap::const_iterator cached = _fileStats.find(node.getPath());
+
+	FileStat stat;
+	if (cached != _fileStats.end()) {
+		stat = cached->_value;
+	} else {
+		stat.valid = node.getFileStat(stat.size, stat.modificationTime);
+		_fileStats[node.getPath()] = stat;
+	}
+
+	size = stat.size;
+	modificationTime = stat.modificationTime;
+	return stat.valid;
+}
+
+void DetectionCache::touch(uint32 &lastUsed) {
+	if (lastUsed != _today) {
+		lastUsed = _today;
+		_dirty = true;
+	}
+}
+
+uint32 DetectionCache::getDay() {
+	// Some backends don't fill in the date
+	TimeDate date = TimeDate();
+	g_system->getTimeAndDate(date);
+
+	// Pretend all months have 31 days, which is good enough for aging entries
+	return ((date.tm_year * 12) + date.tm_mon) * 31 + date.tm_mday;
+}
+
+void DetectionCache::load() {
+	if (_loaded)
+		return;
+	_loaded = true;
+	_today = getDay();
+
+	// Some command line commands detect games before the backend is set up
+	if (!g_system->getSavefileManager())
+		return;
+
+	Common::InSaveFile *in = g_system->getSavefileManager()->openForLoading(kDetectionCacheFile);
+	if (!in)
+		return;
+
+	// Detection entries change between versions, so don't use caches of other versions
+	if (in->readLine() != getCacheHeader()) {
+		delete in;
+		return;
+	}
+
+	Common::Array<Common::String> fields;
+	DirectoryEntry *directory = 0;
+
+	while (!in->eos() && !in->err()) {
+		Common::String line = in->readLine();
+		splitFields(line, fields);
+
+		if (fields[0] == "F" && fields.size() == 7) {
+			// F <path> <md5 bytes> <size> <modification time> <md5> <last used>
+			FileEntry &entry = _files[fields[1] + '\t' + fields[2]];
+			entry.size = atoi(fields[3].c_str());
+			entry.modificationTime = strtoul(fields[4].c_str(), 0, 10);
+			entry.md5 = fields[5];
+			entry.lastUsed = strtoul(fields[6].c_str(), 0, 10);
+		} else if (fields[0] == "D" && fields.size() == 5) {
+			// D <engine> <path> <signature> <last used>, followed by its games
+			directory = &_directories[fields[1] + '\t' + fields[2]];
+			directory->signature = fields[3];
+			directory->lastUsed = strtoul(fields[4].c_str(), 0, 10);
+			directory->games.clear();
+		} else if (fields[0] == "G" && directory) {
+			// G <key>=<value> ...
+			GameDescriptor game;
+			for (uint i = 1; i < fields.size(); i++) {
+				const char *separator = strchr(fields[i].c_str(), '=');
+				if (separator)
+					game[Common::String(fields[i].c_str(), separator)] = separator + 1;
+			}
+			directory->games.push_back(game);
+		}
+	}
+
+	delete in;
+
+	debug(3, "Loaded detection cache with %d files and %d directories", _files.size(), _directories.size());
+}
+
+void DetectionCache::flush() {
+	debug(3, "Detection cache: %d file hits, %d file misses, %d directory hits, %d directory misses",
+		_fileHits, _fileMisses, _directoryHits, _directoryMisses);
+
+	// Files may change before the next scan
+	_statDirectory.clear();
+	_fileStats.clear();
+
+	if (!_dirty || !g_system->getSavefileManager())
+		return;
+
+	Common::OutSaveFile *out = g_system->getSavefileManager()->openForSaving(kDetectionCacheFile, false);
+	if (!out) {
+		warning("Could not write the detection cache");
+		return;
+	}
+
+	out->writeString(getCacheHeader() + "\n");
+
+	// Drop the entries of files and directories which are gone, or weren't
+	// scanned for a long time. Entries written by a clock set to the future
+	// are dropped as well.
+	for (FileMap::const_iterator i = _files.begin(); i != _files.end(); ++i) {
+		if (_today - i->_value.lastUsed > kMaxEntryAge)
+			continue;
+
+		out->writeString(Common::String::format("F\t%s\t%d\t%u\t%s\t%u\n", i->_key.c_str(),
+			i->_value.size, i->_value.modificationTime, i->_value.md5.c_str(), i->_value.lastUsed));
+	}
+
+	for (DirectoryMap::const_iterator i = _directories.begin(); i != _directories.end(); ++i) {
+		if (_today - i->_value.lastUsed > kMaxEntryAge)
+			continue;
+
+		out->writeString(Common::String::format("D\t%s\t%s\t%u\n", i->_key.c_str(),
+			i->_value.signature.c_str(), i->_value.lastUsed));
+
+		for (uint j = 0; j < i->_value.games.size(); j++) {
+			Common::String line = "G";
+			for (GameDescriptor::const_iterator k = i->_value.games[j].begin(); k != i->_value.games[j].end(); ++k)
+				line += Common::String::format("\t%s=%s", k->_key.c_str(), k->_value.c_str());
+			out->writeString(line + "\n");
+		}
+	}
+
+	out->finalize();
+	if (out->err())
+		warning("Could not write the detection cache");
+	else
+		_dirty = false;
+
+	delete out;
+}
@@ -0,0 +1,162 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ */
+
+#ifndef ENGINES_DETECTIONCACHE_H
+#define ENGINES_DETECTIONCACHE_H
+
+#include "common/fs.h"
+#include "common/hashmap.h"
+#include "common/hash-str.h"
+#include "common/singleton.h"
+#include "common/str.h"
+
+#include "engines/game.h"
+
+/**
+ * A persistent cache for the results of the advanced detector.
+ *
+ * It stores the MD5 sums of the detection files, and the games detected in
+ * whole directories. Entries are only used as long as the files involved
+ * have the same size and modification time, so a re-scan of an unchanged
+ * directory doesn't need to read any file at all.
+ *
+ * Only files for which the backend can tell the size and modification time
+ * without opening them are cached. Entries which haven't been used for
+ * kMaxEntryAge days are dropped when the cache is written.
+ */
+class DetectionCache : public Common::Singleton<DetectionCache> {
+public:
+	/**
+	 * Look up the MD5 of the first md5Bytes bytes of a file.
+	 *
+	 * @return true if there is an entry, and the file hasn't changed since.
+	 */
+	bool getFileMD5(const Common::FSNode &node, uint md5Bytes, int32 &size, Common::String &md5);
+
+	/** Remember the MD5 of the first md5Bytes bytes of a file. */
+	void setFileMD5(const Common::FSNode &node, uint md5Bytes, int32 size, const Common::String &md5);
+
+	/**
+	 * Compute a signature of a set of files in a directory, changing
+	 * whenever a file is added, removed or modified.
+	 *
+	 * All engines compute a signature of the files they scan, so the size
+	 * and modification time of each file is only queried once, and kept
+	 * until another directory is scanned or the cache is flushed.
+	 *
+	 * @return false if the files can't be checked for changes without
+	 *         opening them, in which case they can't be cached.
+	 */
+	bool getSignature(const Common::FSNode &directory, const Common::FSList &files, Common::String &signature);
+
+	/**
+	 * Look up the games an engine detected in a directory.
+	 *
+	 * @return true if there is an entry with the same signature.
+	 */
+	bool getGames(const Common::String &engine, const Common::FSNode &directory, const Common::String &signature, GameList &games);
+
+	/** Remember the games an engine detected in a directory. */
+	void setGames(const Common::String &engine, const Common::FSNode &directory, const Common::String &signature, const GameList &games);
+
+	/**
+	 * Don't remember the games an engine is detecting in a directory right
+	 * now. This is used when an unknown game variant was reported, so that
+	 * it's reported again when the directory is scanned the next time.
+	 */
+	void skipGames(const Common::String &engine, const Common::FSNode &directory);
+
+	/**
+	 * Write the cache to disk, if it was changed. This also happens when
+	 * the cache is destroyed.
+	 */
+	void flush();
+
+private:
+	friend class Common::Singleton<SingletonBaseType>;
+	DetectionCache();
+	~DetectionCache();
+
+	enum {
+		/** Number of days after which an unused entry is dropped. */
+		kMaxEntryAge = 90
+	};
+
+	struct FileEntry {
+		int32 size;
+		uint32 modificationTime;
+		Common::String md5;
+		uint32 lastUsed;	///< Day the entry was last used, see getDay().
+	};
+
+	struct DirectoryEntry {
+		Common::String signature;
+		GameList games;
+		uint32 lastUsed;
+	};
+
+	struct FileStat {
+		bool valid;
+		int32 size;
+		uint32 modificationTime;
+	};
+
+	typedef Common::HashMap<Common::String, FileEntry> FileMap;
+	typedef Common::HashMap<Common::String, DirectoryEntry> DirectoryMap;
+	typedef Common::HashMap<Common::String, FileStat> FileStatMap;
+	typedef Common::HashMap<Common::String, bool> SkipMap;
+
+	FileMap _files;
+	DirectoryMap _directories;
+
+	/** The files of the directory being scanned, see getSignature(). */
+	Common::String _statDirectory;
+	FileStatMap _fileStats;
+
+	/** The engines and directories passed to skipGames(). */
+	SkipMap _skippedGames;
+
+	uint32 _today;
+
+	bool _loaded;
+	bool _dirty;
+
+	uint _fileHits, _fileMisses;
+	uint _directoryHits, _directoryMisses;
+
+	/** Read the cache from disk, if it wasn't already. */
+	void load();
+
+	/** Get the size and modification time of a file, at most once per scan. */
+	bool getFileStat(const Common::FSNode &node, int32 &size, uint32 &modificationTime);
+
+	/** Mark an entry as used today. */
+	void touch(uint32 &lastUsed);
+
+	/** Get a number which increases by at least one each day. */
+	static uint32 getDay();
+};
+
+/** Shortcut for accessing the detection cache. */
+#define DetectionCacheMan DetectionCache::instance()
+
+#endif
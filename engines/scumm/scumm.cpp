@@ -24,6 +24,7 @@
 #include "common/debug-channels.h"
 #include "common/md5.h"
 #include "common/events.h"
+#include "common/profiler.h"
 #include "common/system.h"
 #include "common/translation.h"
 
@@ -2058,6 +2059,8 @@ void ScummEngine_v0::scummLoop(int delta) {
 }
 
 void ScummEngine::scummLoop(int delta) {
+	PROFILE_ZONE("ScummEngine::scummLoop");
+
 	if (_game.version >= 3) {
 		VAR(VAR_TMR_1) += delta;
 		VAR(VAR_TMR_2) += delta;
@@ -2367,6 +2370,8 @@ void ScummEngine_v8::scummLoop_handleSaveLoad() {
 #endif
 
 void ScummEngine::scummLoop_handleDrawing() {
+	PROFILE_ZONE("ScummEngine::scummLoop_handleDrawing");
+
 	if (camera._cur != camera._last || _bgNeedsRedraw || _fullRedraw) {
 		redrawBGAreas();
 	}
@@ -239,10 +239,23 @@ Music::~Music() {
 
 void Music::mixer(int16 *buf, uint32 len) {
 	Common::StackLock lock(_mutex);
-	memset(buf, 0, 2 * len * sizeof(int16));
-	for (int i = 0; i < ARRAYSIZE(_handles); i++)
-		if (_handles[i].streaming() && _converter[i])
-			_converter[i]->flow(_handles[i], buf, len, _volumeL, _volumeR);
+
+	// The rate converters mix into a bus with extra precision, so mix the
+	// music in chunks, converting each back to 16-bit samples.
+	Audio::st_bus_t bus[1024];
+
+	while (len > 0) {
+		const uint32 chunk = MIN<uint32>(len, ARRAYSIZE(bus) / 2);
+
+		memset(bus, 0, 2 * chunk * sizeof(Audio::st_bus_t));
+		for (int i = 0; i < ARRAYSIZE(_handles); i++)
+			if (_handles[i].streaming() && _converter[i])
+				_converter[i]->flow(_handles[i], bus, chunk, _volumeL, _volumeR);
+
+		Audio::convertBusToSamples(buf, bus, 2 * chunk);
+		buf += 2 * chunk;
+		len -= chunk;
+	}
 }
 
 void Music::setVolume(uint8 volL, uint8 volR) {
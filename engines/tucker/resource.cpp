@@ -229,6 +229,7 @@ void CompressedSound::openFile() {
 
 void CompressedSound::closeFile() {
 	_fCompressedSound.close();
+	_fxCache.clear();
 }
 
 Audio::RewindableAudioStream *CompressedSound::load(CompressedSoundType type, int num) {
@@ -266,10 +267,21 @@ Audio::RewindableAudioStream *CompressedSound::load(CompressedSoundType type, in
 		int soundOffset = _fCompressedSound.readUint32LE();
 		int soundSize = _fCompressedSound.readUint32LE();
 		if (soundSize != 0) {
-			_fCompressedSound.seek(dirOffset + dirSize * 8 + soundOffset);
+			const int pos = dirOffset + dirSize * 8 + soundOffset;
+			const Audio::PCMCacheKey key(compressedSoundFilesTable[_compressedSoundType].filename, num, pos);
+			if (type == kSoundTypeFx) {
+				Audio::RewindableAudioStream *cached = _fxCache.getStream(key);
+				if (cached) {
+					return cached;
+				}
+			}
+			_fCompressedSound.seek(pos);
 			Common::SeekableReadStream *tmp = _fCompressedSound.readStream(soundSize);
 			if (tmp) {
 				stream = (compressedSoundFilesTable[_compressedSoundType].makeStream)(tmp, DisposeAfterUse::YES);
+				if (stream && type == kSoundTypeFx) {
+					return _fxCache.addStream(key, stream);
+				}
 			}
 		}
 	}
@@ -68,6 +68,8 @@ Common::Error TuckerEngine::run() {
 	if ((_gameFlags & kGameFlagIntroOnly) == 0 && !shouldQuit()) {
 		mainLoop();
 	}
+	// The sound effects may still play samples from the cache of _compressedSound
+	_mixer->stopAll();
 	_compressedSound.closeFile();
 	return Common::kNoError;
 }
@@ -33,6 +33,7 @@
 #include "video/flic_decoder.h"
 
 #include "audio/mixer.h"
+#include "audio/pcmcache.h"
 
 #include "engines/engine.h"
 
@@ -232,7 +233,7 @@ enum CompressedSoundType {
 class CompressedSound {
 public:
 
-	CompressedSound() : _compressedSoundType(-1) {}
+	CompressedSound() : _compressedSoundType(-1), _fxCache(kFxCacheSize) {}
 
 	void openFile();
 	void closeFile();
@@ -240,9 +241,16 @@ public:
 
 private:
 
+	enum {
+		kFxCacheSize = 4 * 1024 * 1024
+	};
+
 	int _compressedSoundType;
 	int _compressedSoundFlags;
 	Common::File _fCompressedSound;
+
+	/** Sound effects are played over and over again, so keep them decoded */
+	Audio::PCMCache _fxCache;
 };
 
 inline int scaleMixerVolume(int volume, int max = 100) {
@@ -48,6 +48,7 @@ endif
 
 ifdef USE_HQ_SCALERS
 MODULE_OBJS += \
+	scaler/hq.o \
 	scaler/hq2x.o \
 	scaler/hq3x.o
 
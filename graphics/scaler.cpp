@@ -20,6 +20,7 @@
  *
  */
 
+#include "graphics/scaler.h"
 #include "graphics/scaler/intern.h"
 #include "graphics/scaler/scalebit.h"
 #include "common/util.h"
@@ -28,6 +29,14 @@
 
 int gBitFormat = 565;
 
+/**
+ * Return the size of the pixels the scalers work on, which are 32 bit for
+ * the 8888 format and 16 bit for all the others.
+ */
+static inline uint32 getBytesPerPixel() {
+	return gBitFormat == 8888 ? 4 : 2;
+}
+
 #ifdef USE_HQ_SCALERS
 // RGB-to-YUV lookup table
 extern "C" {
@@ -121,7 +130,7 @@ void InitLUT(Graphics::PixelFormat format) {
 
 
 /** Lookup table for the DotMatrix scaler. */
-uint16 g_dotmatrix[16] = {0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0};
+uint32 g_dotmatrix[16] = {0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0};
 
 /** Init the scaler subsystem. */
 void InitScalers(uint32 BitFormat) {
@@ -135,21 +144,26 @@ void InitScalers(uint32 BitFormat) {
 		format = Graphics::createPixelFormat<555>();
 	} else if (gBitFormat == 565) {
 		format = Graphics::createPixelFormat<565>();
+	} else if (gBitFormat == 8888) {
+		format = Graphics::createPixelFormat<8888>();
 	} else {
 		assert(g_system);
 		format = g_system->getOverlayFormat();
 	}
 
 #ifdef USE_HQ_SCALERS
-	InitLUT(format);
+	// The hq scalers convert 32 bit pixels to YUV on the fly
+	if (format.bytesPerPixel == 2)
+		InitLUT(format);
 #endif
 
-	// Build dotmatrix lookup table for the DotMatrix scaler.
-	g_dotmatrix[0] = g_dotmatrix[10] = format.RGBToColor(0, 63, 0);
-	g_dotmatrix[1] = g_dotmatrix[11] = format.RGBToColor(0, 0, 63);
-	g_dotmatrix[2] = g_dotmatrix[8] = format.RGBToColor(63, 0, 0);
+	// Build dotmatrix lookup table for the DotMatrix scaler. The alpha
+	// channel, if any, is left alone.
+	g_dotmatrix[0] = g_dotmatrix[10] = format.ARGBToColor(0, 0, 63, 0);
+	g_dotmatrix[1] = g_dotmatrix[11] = format.ARGBToColor(0, 0, 0, 63);
+	g_dotmatrix[2] = g_dotmatrix[8] = format.ARGBToColor(0, 63, 0, 0);
 	g_dotmatrix[4] = g_dotmatrix[6] =
-		g_dotmatrix[12] = g_dotmatrix[14] = format.RGBToColor(63, 63, 63);
+		g_dotmatrix[12] = g_dotmatrix[14] = format.ARGBToColor(0, 63, 63, 63);
 }
 
 void DestroyScalers(){
@@ -159,6 +173,35 @@ void DestroyScalers(){
 #endif
 }
 
+int splitScalerBands(const uint8 *srcPtr, uint32 srcPitch, uint8 *dstPtr, uint32 dstPitch,
+							int width, int height, int scaleFactor, int numThreads, ScalerBand *bands) {
+	const int minBandHeight = 16;
+
+	int numBands = MIN(numThreads, height / minBandHeight);
+	if (numBands <= 1) {
+		bands[0].src = srcPtr;
+		bands[0].dst = dstPtr;
+		bands[0].width = width;
+		bands[0].height = height;
+		return 1;
+	}
+
+	numBands = MIN(numBands * 2, height / minBandHeight);
+	int bandHeight = (height + numBands - 1) / numBands;
+	bandHeight = (bandHeight + 1) & ~1;
+
+	// Rounding the band height up may leave fewer bands than planned
+	numBands = 0;
+	for (int y = 0; y < height; y += bandHeight) {
+		ScalerBand &band = bands[numBands++];
+		band.src = srcPtr + y * srcPitch;
+		band.dst = dstPtr + y * scaleFactor * dstPitch;
+		band.width = width;
+		band.height = MIN(bandHeight, height - y);
+	}
+
+	return numBands;
+}
 
 /**
  * Trivial 'scaler' - in fact it doesn't do any scaling but just copies the
@@ -166,13 +209,15 @@ void DestroyScalers(){
  */
 void Normal1x(const uint8 *srcPtr, uint32 srcPitch, uint8 *dstPtr, uint32 dstPitch,
 							int width, int height) {
+	const uint32 lineSize = getBytesPerPixel() * width;
+
 	// Spot the case when it can all be done in 1 hit
-	if ((srcPitch == sizeof(uint16) * (uint)width) && (dstPitch == sizeof(uint16) * (uint)width)) {
-		memcpy(dstPtr, srcPtr, sizeof(uint16) * width * height);
+	if ((srcPitch == lineSize) && (dstPitch == lineSize)) {
+		memcpy(dstPtr, srcPtr, lineSize * height);
 		return;
 	}
 	while (height--) {
-		memcpy(dstPtr, srcPtr, sizeof(uint16) * width);
+		memcpy(dstPtr, srcPtr, lineSize);
 		srcPtr += srcPitch;
 		dstPtr += dstPitch;
 	}
@@ -189,20 +234,11 @@ extern "C" void Normal2xARM(const uint8  *srcPtr,
                                   int     width,
                                   int     height);
 
-void Normal2x(const uint8  *srcPtr,
-                    uint32  srcPitch,
-                    uint8  *dstPtr,
-                    uint32  dstPitch,
-                    int     width,
-                    int     height) {
-	Normal2xARM(srcPtr, srcPitch, dstPtr, dstPitch, width, height);
-}
-
 #else
 /**
- * Trivial nearest-neighbor 2x scaler.
+ * Trivial nearest-neighbor 2x scaler, for 16 bit pixels.
  */
-void Normal2x(const uint8 *srcPtr, uint32 srcPitch, uint8 *dstPtr, uint32 dstPitch,
+static void Normal2x16(const uint8 *srcPtr, uint32 srcPitch, uint8 *dstPtr, uint32 dstPitch,
 							int width, int height) {
 	uint8 *r;
 
@@ -224,35 +260,80 @@ void Normal2x(const uint8 *srcPtr, uint32 srcPitch, uint8 *dstPtr, uint32 dstPit
 #endif
 
 /**
- * Trivial nearest-neighbor 3x scaler.
+ * Trivial nearest-neighbor 2x scaler, for 32 bit pixels.
  */
-void Normal3x(const uint8 *srcPtr, uint32 srcPitch, uint8 *dstPtr, uint32 dstPitch,
+static void Normal2x32(const uint8 *srcPtr, uint32 srcPitch, uint8 *dstPtr, uint32 dstPitch,
+							int width, int height) {
+	assert(IS_ALIGNED(dstPtr, 4));
+	while (height--) {
+		const uint32 *s = (const uint32 *)srcPtr;
+		uint32 *d0 = (uint32 *)dstPtr;
+		uint32 *d1 = (uint32 *)(dstPtr + dstPitch);
+		for (int i = 0; i < width; ++i) {
+			const uint32 color = s[i];
+
+			d0[2 * i] = d0[2 * i + 1] = color;
+			d1[2 * i] = d1[2 * i + 1] = color;
+		}
+		srcPtr += srcPitch;
+		dstPtr += dstPitch << 1;
+	}
+}
+
+/**
+ * Trivial nearest-neighbor 2x scaler.
+ */
+void Normal2x(const uint8 *srcPtr, uint32 srcPitch, uint8 *dstPtr, uint32 dstPitch,
+							int width, int height) {
+	if (gBitFormat == 8888)
+		Normal2x32(srcPtr, srcPitch, dstPtr, dstPitch, width, height);
+	else
+#ifdef USE_ARM_SCALER_ASM
+		Normal2xARM(srcPtr, srcPitch, dstPtr, dstPitch, width, height);
+#else
+		Normal2x16(srcPtr, srcPitch, dstPtr, dstPitch, width, height);
+#endif
+}
+
+template<typename Pixel>
+void Normal3xTemplate(const uint8 *srcPtr, uint32 srcPitch, uint8 *dstPtr, uint32 dstPitch,
 							int width, int height) {
 	uint8 *r;
 	const uint32 dstPitch2 = dstPitch * 2;
 	const uint32 dstPitch3 = dstPitch * 3;
 
-	assert(IS_ALIGNED(dstPtr, 2));
+	assert(IS_ALIGNED(dstPtr, sizeof(Pixel)));
 	while (height--) {
 		r = dstPtr;
-		for (int i = 0; i < width; ++i, r += 6) {
-			uint16 color = *(((const uint16 *)srcPtr) + i);
-
-			*(uint16 *)(r + 0) = color;
-			*(uint16 *)(r + 2) = color;
-			*(uint16 *)(r + 4) = color;
-			*(uint16 *)(r + 0 + dstPitch) = color;
-			*(uint16 *)(r + 2 + dstPitch) = color;
-			*(uint16 *)(r + 4 + dstPitch) = color;
-			*(uint16 *)(r + 0 + dstPitch2) = color;
-			*(uint16 *)(r + 2 + dstPitch2) = color;
-			*(uint16 *)(r + 4 + dstPitch2) = color;
+		for (int i = 0; i < width; ++i, r += 3 * sizeof(Pixel)) {
+			Pixel color = *(((const Pixel *)srcPtr) + i);
+
+			*(Pixel *)(r + 0 * sizeof(Pixel)) = color;
+			*(Pixel *)(r + 1 * sizeof(Pixel)) = color;
+			*(Pixel *)(r + 2 * sizeof(Pixel)) = color;
+			*(Pixel *)(r + 0 * sizeof(Pixel) + dstPitch) = color;
+			*(Pixel *)(r + 1 * sizeof(Pixel) + dstPitch) = color;
+			*(Pixel *)(r + 2 * sizeof(Pixel) + dstPitch) = color;
+			*(Pixel *)(r + 0 * sizeof(Pixel) + dstPitch2) = color;
+			*(Pixel *)(r + 1 * sizeof(Pixel) + dstPitch2) = color;
+			*(Pixel *)(r + 2 * sizeof(Pixel) + dstPitch2) = color;
 		}
 		srcPtr += srcPitch;
 		dstPtr += dstPitch3;
 	}
 }
 
+/**
+ * Trivial nearest-neighbor 3x scaler.
+ */
+void Normal3x(const uint8 *srcPtr, uint32 srcPitch, uint8 *dstPtr, uint32 dstPitch,
+							int width, int height) {
+	if (gBitFormat == 8888)
+		Normal3xTemplate<uint32>(srcPtr, srcPitch, dstPtr, dstPitch, width, height);
+	else
+		Normal3xTemplate<uint16>(srcPtr, srcPitch, dstPtr, dstPitch, width, height);
+}
+
 #define interpolate_1_1		interpolate16_1_1<ColorMask>
 #define interpolate_1_1_1_1	interpolate16_1_1_1_1<ColorMask>
 
@@ -305,7 +386,7 @@ void Normal1o5x(const uint8 *srcPtr, uint32 srcPitch, uint8 *dstPtr, uint32 dstP
  */
 void AdvMame2x(const uint8 *srcPtr, uint32 srcPitch, uint8 *dstPtr, uint32 dstPitch,
 							 int width, int height) {
-	scale(2, dstPtr, dstPitch, srcPtr - srcPitch, srcPitch, 2, width, height);
+	scale(2, dstPtr, dstPitch, srcPtr - srcPitch, srcPitch, getBytesPerPixel(), width, height);
 }
 
 /**
@@ -314,30 +395,33 @@ void AdvMame2x(const uint8 *srcPtr, uint32 srcPitch, uint8 *dstPtr, uint32 dstPi
  */
 void AdvMame3x(const uint8 *srcPtr, uint32 srcPitch, uint8 *dstPtr, uint32 dstPitch,
 							 int width, int height) {
-	scale(3, dstPtr, dstPitch, srcPtr - srcPitch, srcPitch, 2, width, height);
+	scale(3, dstPtr, dstPitch, srcPtr - srcPitch, srcPitch, getBytesPerPixel(), width, height);
 }
 
 template<typename ColorMask>
 void TV2xTemplate(const uint8 *srcPtr, uint32 srcPitch, uint8 *dstPtr, uint32 dstPitch,
 					int width, int height) {
-	const uint32 nextlineSrc = srcPitch / sizeof(uint16);
-	const uint16 *p = (const uint16 *)srcPtr;
+	typedef typename ColorMask::PixelType Pixel;
+
+	const uint32 nextlineSrc = srcPitch / sizeof(Pixel);
+	const Pixel *p = (const Pixel *)srcPtr;
 
-	const uint32 nextlineDst = dstPitch / sizeof(uint16);
-	uint16 *q = (uint16 *)dstPtr;
+	const uint32 nextlineDst = dstPitch / sizeof(Pixel);
+	Pixel *q = (Pixel *)dstPtr;
 
 	while (height--) {
 		for (int i = 0, j = 0; i < width; ++i, j += 2) {
-			uint16 p1 = *(p + i);
+			Pixel p1 = *(p + i);
 			uint32 pi;
 
 			pi = (((p1 & ColorMask::kRedBlueMask) * 7) >> 3) & ColorMask::kRedBlueMask;
 			pi |= (((p1 & ColorMask::kGreenMask) * 7) >> 3) & ColorMask::kGreenMask;
+			pi |= p1 & ColorMask::kAlphaMask;
 
 			*(q + j) = p1;
 			*(q + j + 1) = p1;
-			*(q + j + nextlineDst) = (uint16)pi;
-			*(q + j + nextlineDst + 1) = (uint16)pi;
+			*(q + j + nextlineDst) = (Pixel)pi;
+			*(q + j + nextlineDst + 1) = (Pixel)pi;
 		}
 		p += nextlineSrc;
 		q += nextlineDst << 1;
@@ -345,13 +429,16 @@ void TV2xTemplate(const uint8 *srcPtr, uint32 srcPitch, uint8 *dstPtr, uint32 ds
 }
 
 void TV2x(const uint8 *srcPtr, uint32 srcPitch, uint8 *dstPtr, uint32 dstPitch, int width, int height) {
-	if (gBitFormat == 565)
+	if (gBitFormat == 8888)
+		TV2xTemplate<Graphics::ColorMasks<8888> >(srcPtr, srcPitch, dstPtr, dstPitch, width, height);
+	else if (gBitFormat == 565)
 		TV2xTemplate<Graphics::ColorMasks<565> >(srcPtr, srcPitch, dstPtr, dstPitch, width, height);
 	else
 		TV2xTemplate<Graphics::ColorMasks<555> >(srcPtr, srcPitch, dstPtr, dstPitch, width, height);
 }
 
-static inline uint16 DOT_16(const uint16 *dotmatrix, uint16 c, int j, int i) {
+template<typename Pixel>
+static inline Pixel DOT(const uint32 *dotmatrix, Pixel c, int j, int i) {
 	return c - ((c >> 2) & dotmatrix[((j & 3) << 2) + (i & 3)]);
 }
 
@@ -362,28 +449,37 @@ static inline uint16 DOT_16(const uint16 *dotmatrix, uint16 c, int j, int i) {
 // a way that also works together with aspect-ratio correction is left as an
 // exercise for the reader.)
 
-void DotMatrix(const uint8 *srcPtr, uint32 srcPitch, uint8 *dstPtr, uint32 dstPitch,
+template<typename Pixel>
+void DotMatrixTemplate(const uint8 *srcPtr, uint32 srcPitch, uint8 *dstPtr, uint32 dstPitch,
 					int width, int height) {
 
-	const uint16 *dotmatrix = g_dotmatrix;
+	const uint32 *dotmatrix = g_dotmatrix;
 
-	const uint32 nextlineSrc = srcPitch / sizeof(uint16);
-	const uint16 *p = (const uint16 *)srcPtr;
+	const uint32 nextlineSrc = srcPitch / sizeof(Pixel);
+	const Pixel *p = (const Pixel *)srcPtr;
 
-	const uint32 nextlineDst = dstPitch / sizeof(uint16);
-	uint16 *q = (uint16 *)dstPtr;
+	const uint32 nextlineDst = dstPitch / sizeof(Pixel);
+	Pixel *q = (Pixel *)dstPtr;
 
 	for (int j = 0, jj = 0; j < height; ++j, jj += 2) {
 		for (int i = 0, ii = 0; i < width; ++i, ii += 2) {
-			uint16 c = *(p + i);
-			*(q + ii) = DOT_16(dotmatrix, c, jj, ii);
-			*(q + ii + 1) = DOT_16(dotmatrix, c, jj, ii + 1);
-			*(q + ii + nextlineDst) = DOT_16(dotmatrix, c, jj + 1, ii);
-			*(q + ii + nextlineDst + 1) = DOT_16(dotmatrix, c, jj + 1, ii + 1);
+			Pixel c = *(p + i);
+			*(q + ii) = DOT(dotmatrix, c, jj, ii);
+			*(q + ii + 1) = DOT(dotmatrix, c, jj, ii + 1);
+			*(q + ii + nextlineDst) = DOT(dotmatrix, c, jj + 1, ii);
+			*(q + ii + nextlineDst + 1) = DOT(dotmatrix, c, jj + 1, ii + 1);
 		}
 		p += nextlineSrc;
 		q += nextlineDst << 1;
 	}
 }
 
+void DotMatrix(const uint8 *srcPtr, uint32 srcPitch, uint8 *dstPtr, uint32 dstPitch,
+					int width, int height) {
+	if (gBitFormat == 8888)
+		DotMatrixTemplate<uint32>(srcPtr, srcPitch, dstPtr, dstPitch, width, height);
+	else
+		DotMatrixTemplate<uint16>(srcPtr, srcPitch, dstPtr, dstPitch, width, height);
+}
+
 #endif // #ifdef USE_SCALERS
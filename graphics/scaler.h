@@ -25,6 +25,11 @@
 #include "common/scummsys.h"
 #include "graphics/surface.h"
 
+/**
+ * Init the scaler subsystem for the given bit format, e.g. 555 or 565.
+ * All the scalers handle 16 bit pixels; those not marked as 16 bit only
+ * below handle the 32 bit 8888 format as well.
+ */
 extern void InitScalers(uint32 BitFormat);
 extern void DestroyScalers();
 
@@ -42,8 +47,10 @@ DECLARE_SCALER(Normal1x);
 
 DECLARE_SCALER(Normal2x);
 DECLARE_SCALER(Normal3x);
+// 16 bit only
 DECLARE_SCALER(Normal1o5x);
 
+// 16 bit only
 DECLARE_SCALER(_2xSaI);
 DECLARE_SCALER(Super2xSaI);
 DECLARE_SCALER(SuperEagle);
@@ -61,6 +68,34 @@ DECLARE_SCALER(HQ3x);
 
 #endif // #ifdef USE_SCALERS
 
+/**
+ * A horizontal band of a rect, see splitScalerBands().
+ */
+struct ScalerBand {
+	const uint8 *src;
+	uint8 *dst;
+	int width, height;
+};
+
+/**
+ * Split a rect into horizontal bands, so that several threads can scale it
+ * together. There are twice as many bands as threads, so that the threads
+ * done first can take over some of the work of the others, but each band is
+ * at least 16 rows high, so that waking up a thread doesn't take longer
+ * than scaling its band.
+ *
+ * The scalers only read from the source, so the rows around a band are the
+ * same ones they see when scaling the whole rect. Each band starts at an
+ * even row, so scalers depending on the parity of the row give the same
+ * result as well.
+ *
+ * @param numThreads	the number of threads scaling the bands
+ * @param bands			receives the bands, at least 2 * numThreads of them
+ * @return				the number of bands, 1 if the rect is not worth splitting
+ */
+extern int splitScalerBands(const uint8 *srcPtr, uint32 srcPitch, uint8 *dstPtr, uint32 dstPitch,
+							int width, int height, int scaleFactor, int numThreads, ScalerBand *bands);
+
 // creates a 160x100 thumbnail for 320x200 games
 // and 160x120 thumbnail for 320x240 and 640x480 games
 // only 565 mode
@@ -0,0 +1,113 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ */
+
+// The SSE2 header has to come before the ScummVM ones, which forbid some of
+// the symbols in the system headers it includes
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+#include "graphics/scaler/hq.h"
+
+HQRowBuffer::HQRowBuffer(int width) : _width(width), _onStack(width <= kMaxStackWidth) {
+	const int rowSize = width + 2;
+	if (_onStack) {
+		_buffer = _stackBuffer;
+#ifdef __SSE2__
+		_patterns = _stackPatterns;
+#endif
+	} else {
+		_buffer = new uint32[rowSize * 6];
+#ifdef __SSE2__
+		_patterns = new uint8[width];
+#endif
+	}
+
+	for (int i = 0; i < 3; i++) {
+		_pixels[i] = _buffer + rowSize * i;
+		_yuv[i] = _buffer + rowSize * (i + 3);
+	}
+}
+
+HQRowBuffer::~HQRowBuffer() {
+	if (!_onStack) {
+		delete[] _buffer;
+#ifdef __SSE2__
+		delete[] _patterns;
+#endif
+	}
+}
+
+#ifdef __SSE2__
+
+/**
+ * Return the given bit for each of the four pixels which differs from the
+ * one in the middle of its neighbourhood, and whose YUV value differs from
+ * it by more than the thresholds of diffYUV().
+ */
+static inline __m128i diffNeighboursSSE2(__m128i w5, __m128i yuv5, const uint32 *pixels, const uint32 *yuv, int bit) {
+	// The YUV values are compared byte by byte, with the threshold of the
+	// unused top byte making sure it never counts
+	const __m128i threshold = _mm_set1_epi32((int)0xFF300706);
+
+	const __m128i w = _mm_loadu_si128((const __m128i *)pixels);
+	const __m128i y = _mm_loadu_si128((const __m128i *)yuv);
+	const __m128i diff = _mm_or_si128(_mm_subs_epu8(yuv5, y), _mm_subs_epu8(y, yuv5));
+
+	const __m128i same = _mm_or_si128(_mm_cmpeq_epi32(w5, w),
+		_mm_cmpeq_epi32(_mm_subs_epu8(diff, threshold), _mm_setzero_si128()));
+	return _mm_andnot_si128(same, _mm_set1_epi32(bit));
+}
+
+/**
+ * Compute the patterns of four pixels, from the first of their top left
+ * neighbours.
+ */
+static inline __m128i computePatternsSSE2(const uint32 *const *pixels, const uint32 *const *yuv, int x) {
+	const __m128i w5 = _mm_loadu_si128((const __m128i *)(pixels[1] + x + 1));
+	const __m128i yuv5 = _mm_loadu_si128((const __m128i *)(yuv[1] + x + 1));
+
+	__m128i pattern = diffNeighboursSSE2(w5, yuv5, pixels[0] + x, yuv[0] + x, 0x0001);
+	pattern = _mm_or_si128(pattern, diffNeighboursSSE2(w5, yuv5, pixels[0] + x + 1, yuv[0] + x + 1, 0x0002));
+	pattern = _mm_or_si128(pattern, diffNeighboursSSE2(w5, yuv5, pixels[0] + x + 2, yuv[0] + x + 2, 0x0004));
+	pattern = _mm_or_si128(pattern, diffNeighboursSSE2(w5, yuv5, pixels[1] + x, yuv[1] + x, 0x0008));
+	pattern = _mm_or_si128(pattern, diffNeighboursSSE2(w5, yuv5, pixels[1] + x + 2, yuv[1] + x + 2, 0x0010));
+	pattern = _mm_or_si128(pattern, diffNeighboursSSE2(w5, yuv5, pixels[2] + x, yuv[2] + x, 0x0020));
+	pattern = _mm_or_si128(pattern, diffNeighboursSSE2(w5, yuv5, pixels[2] + x + 1, yuv[2] + x + 1, 0x0040));
+	pattern = _mm_or_si128(pattern, diffNeighboursSSE2(w5, yuv5, pixels[2] + x + 2, yuv[2] + x + 2, 0x0080));
+	return pattern;
+}
+
+void HQRowBuffer::computePatterns() {
+	int x = 0;
+	for (; x + 8 <= _width; x += 8) {
+		const __m128i lo = computePatternsSSE2(_pixels, _yuv, x);
+		const __m128i hi = computePatternsSSE2(_pixels, _yuv, x + 4);
+		const __m128i patterns = _mm_packs_epi32(lo, hi);
+		_mm_storel_epi64((__m128i *)(_patterns + x), _mm_packus_epi16(patterns, patterns));
+	}
+
+	for (; x < _width; x++)
+		_patterns[x] = computePattern(_pixels[0] + x, _pixels[1] + x, _pixels[2] + x, _yuv[0] + x, _yuv[1] + x, _yuv[2] + x);
+}
+
+#endif // __SSE2__
@@ -0,0 +1,163 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ */
+
+#ifndef GRAPHICS_SCALER_HQ_H
+#define GRAPHICS_SCALER_HQ_H
+
+#include "graphics/scaler/intern.h"
+
+extern "C" uint32 *RGBtoYUV;
+
+/**
+ * Convert a 16 bit pixel to YUV (encoded 8-8-8), using the table set up
+ * by InitLUT().
+ */
+template<typename ColorMask>
+static inline uint32 convertToYUV(uint16 color) {
+	return RGBtoYUV[color];
+}
+
+/**
+ * Convert a 32 bit pixel to YUV (encoded 8-8-8), the same way InitLUT()
+ * fills the table for 16 bit pixels.
+ */
+template<typename ColorMask>
+static inline uint32 convertToYUV(uint32 color) {
+	const int r = (color & ColorMask::kRedMask) >> ColorMask::kRedShift;
+	const int g = (color & ColorMask::kGreenMask) >> ColorMask::kGreenShift;
+	const int b = (color & ColorMask::kBlueMask) >> ColorMask::kBlueShift;
+
+	const int Y = (r + g + b) >> 2;
+	const int u = 128 + ((r - b) >> 2);
+	const int v = 128 + ((-r + 2 * g - b) >> 3);
+	return (Y << 16) | (u << 8) | v;
+}
+
+/**
+ * Compute the pattern of a pixel, which has a bit set for each of its eight
+ * neighbours differing from it. The rows of pixels and of their YUV values
+ * start at the top left neighbour.
+ */
+static inline int computePattern(const uint32 *above, const uint32 *middle, const uint32 *below,
+		const uint32 *yuvAbove, const uint32 *yuvMiddle, const uint32 *yuvBelow) {
+	const uint32 w5 = middle[1];
+	const uint32 yuv5 = yuvMiddle[1];
+
+	int pattern = 0;
+	if (w5 != above[0] && diffYUV(yuv5, yuvAbove[0])) pattern |= 0x0001;
+	if (w5 != above[1] && diffYUV(yuv5, yuvAbove[1])) pattern |= 0x0002;
+	if (w5 != above[2] && diffYUV(yuv5, yuvAbove[2])) pattern |= 0x0004;
+	if (w5 != middle[0] && diffYUV(yuv5, yuvMiddle[0])) pattern |= 0x0008;
+	if (w5 != middle[2] && diffYUV(yuv5, yuvMiddle[2])) pattern |= 0x0010;
+	if (w5 != below[0] && diffYUV(yuv5, yuvBelow[0])) pattern |= 0x0020;
+	if (w5 != below[1] && diffYUV(yuv5, yuvBelow[1])) pattern |= 0x0040;
+	if (w5 != below[2] && diffYUV(yuv5, yuvBelow[2])) pattern |= 0x0080;
+	return pattern;
+}
+
+/**
+ * The source rows the hq scalers look at when scaling a row: the ones
+ * above, at and below it, including the pixels left and right of them.
+ * The pixels are widened to 32 bits and converted to YUV once, for all the
+ * rows they are looked at for.
+ *
+ * With SSE2, it also computes the patterns of the middle row eight pixels
+ * at a time. Without it, they are faster computed while scaling each pixel.
+ *
+ * Rows of up to kMaxStackWidth pixels are kept in the object itself, which
+ * the scalers create on the stack. This avoids allocating memory on every
+ * call, and the scaler threads of the SDL backend never share a buffer.
+ */
+class HQRowBuffer {
+public:
+	enum {
+		kMaxStackWidth = 1024
+	};
+
+	HQRowBuffer(int width);
+	~HQRowBuffer();
+
+	/**
+	 * Move the rows up by one, and fill the bottom row from the source.
+	 *
+	 * @param src	the first pixel of the source row; the pixels left and
+	 *				right of the row are read as well
+	 */
+	template<typename ColorMask>
+	void push(const typename ColorMask::PixelType *src) {
+		uint32 *pixels = _pixels[0];
+		uint32 *yuv = _yuv[0];
+		_pixels[0] = _pixels[1];
+		_pixels[1] = _pixels[2];
+		_pixels[2] = pixels;
+		_yuv[0] = _yuv[1];
+		_yuv[1] = _yuv[2];
+		_yuv[2] = yuv;
+
+		src--;
+		for (int i = 0; i < _width + 2; i++) {
+			pixels[i] = src[i];
+			yuv[i] = convertToYUV<ColorMask>(src[i]);
+		}
+	}
+
+#ifdef __SSE2__
+	/**
+	 * Compute the patterns of the middle row.
+	 */
+	void computePatterns();
+
+	/**
+	 * Return the pattern of a pixel of the middle row.
+	 */
+	int getPattern(int x) const { return _patterns[x]; }
+#endif
+
+	/**
+	 * Return the pixels of the row above (0), at (1) or below (2) the one
+	 * being scaled. The first one is left of the row.
+	 */
+	const uint32 *getPixels(int row) const { return _pixels[row]; }
+
+	/**
+	 * Return the YUV values of the pixels of a row, see getPixels().
+	 */
+	const uint32 *getYUV(int row) const { return _yuv[row]; }
+
+private:
+	int _width;
+	uint32 *_buffer;
+	uint32 *_pixels[3];
+	uint32 *_yuv[3];
+#ifdef __SSE2__
+	uint8 *_patterns;
+#endif
+
+	/** Whether the rows are kept in the object, or were allocated */
+	bool _onStack;
+	uint32 _stackBuffer[(kMaxStackWidth + 2) * 6];
+#ifdef __SSE2__
+	uint8 _stackPatterns[kMaxStackWidth];
+#endif
+};
+
+#endif
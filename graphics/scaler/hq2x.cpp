@@ -20,10 +20,10 @@
  *
  */
 
-#include "graphics/scaler/intern.h"
+#include "graphics/scaler/hq.h"
 
 #ifdef USE_NASM
-// Assembly version of HQ2x
+// Assembly version of HQ2x, for 16 bit pixels
 
 extern "C" {
 
@@ -35,81 +35,89 @@ void hq2x_16(const byte *, byte *, uint32, uint32, uint32, uint32);
 
 }
 
-void HQ2x(const uint8 *srcPtr, uint32 srcPitch, uint8 *dstPtr, uint32 dstPitch, int width, int height) {
-	hq2x_16(srcPtr, dstPtr, width, height, srcPitch, dstPitch);
-}
-
-#else
+#endif
 
 #define PIXEL00_0	*(q) = w5;
-#define PIXEL00_10	*(q) = interpolate16_3_1<ColorMask >(w5, w1);
-#define PIXEL00_11	*(q) = interpolate16_3_1<ColorMask >(w5, w4);
-#define PIXEL00_12	*(q) = interpolate16_3_1<ColorMask >(w5, w2);
-#define PIXEL00_20	*(q) = interpolate16_2_1_1<ColorMask >(w5, w4, w2);
-#define PIXEL00_21	*(q) = interpolate16_2_1_1<ColorMask >(w5, w1, w2);
-#define PIXEL00_22	*(q) = interpolate16_2_1_1<ColorMask >(w5, w1, w4);
-#define PIXEL00_60	*(q) = interpolate16_5_2_1<ColorMask >(w5, w2, w4);
-#define PIXEL00_61	*(q) = interpolate16_5_2_1<ColorMask >(w5, w4, w2);
-#define PIXEL00_70	*(q) = interpolate16_6_1_1<ColorMask >(w5, w4, w2);
-#define PIXEL00_90	*(q) = interpolate16_2_3_3<ColorMask >(w5, w4, w2);
-#define PIXEL00_100	*(q) = interpolate16_14_1_1<ColorMask >(w5, w4, w2);
+#define PIXEL00_10	*(q) = Interpolator<ColorMask>::mix_3_1(w5, w1);
+#define PIXEL00_11	*(q) = Interpolator<ColorMask>::mix_3_1(w5, w4);
+#define PIXEL00_12	*(q) = Interpolator<ColorMask>::mix_3_1(w5, w2);
+#define PIXEL00_20	*(q) = Interpolator<ColorMask>::mix_2_1_1(w5, w4, w2);
+#define PIXEL00_21	*(q) = Interpolator<ColorMask>::mix_2_1_1(w5, w1, w2);
+#define PIXEL00_22	*(q) = Interpolator<ColorMask>::mix_2_1_1(w5, w1, w4);
+#define PIXEL00_60	*(q) = Interpolator<ColorMask>::mix_5_2_1(w5, w2, w4);
+#define PIXEL00_61	*(q) = Interpolator<ColorMask>::mix_5_2_1(w5, w4, w2);
+#define PIXEL00_70	*(q) = Interpolator<ColorMask>::mix_6_1_1(w5, w4, w2);
+#define PIXEL00_90	*(q) = Interpolator<ColorMask>::mix_2_3_3(w5, w4, w2);
+#define PIXEL00_100	*(q) = Interpolator<ColorMask>::mix_14_1_1(w5, w4, w2);
 
 #define PIXEL01_0	*(q+1) = w5;
-#define PIXEL01_10	*(q+1) = interpolate16_3_1<ColorMask >(w5, w3);
-#define PIXEL01_11	*(q+1) = interpolate16_3_1<ColorMask >(w5, w2);
-#define PIXEL01_12	*(q+1) = interpolate16_3_1<ColorMask >(w5, w6);
-#define PIXEL01_20	*(q+1) = interpolate16_2_1_1<ColorMask >(w5, w2, w6);
-#define PIXEL01_21	*(q+1) = interpolate16_2_1_1<ColorMask >(w5, w3, w6);
-#define PIXEL01_22	*(q+1) = interpolate16_2_1_1<ColorMask >(w5, w3, w2);
-#define PIXEL01_60	*(q+1) = interpolate16_5_2_1<ColorMask >(w5, w6, w2);
-#define PIXEL01_61	*(q+1) = interpolate16_5_2_1<ColorMask >(w5, w2, w6);
-#define PIXEL01_70	*(q+1) = interpolate16_6_1_1<ColorMask >(w5, w2, w6);
-#define PIXEL01_90	*(q+1) = interpolate16_2_3_3<ColorMask >(w5, w2, w6);
-#define PIXEL01_100	*(q+1) = interpolate16_14_1_1<ColorMask >(w5, w2, w6);
+#define PIXEL01_10	*(q+1) = Interpolator<ColorMask>::mix_3_1(w5, w3);
+#define PIXEL01_11	*(q+1) = Interpolator<ColorMask>::mix_3_1(w5, w2);
+#define PIXEL01_12	*(q+1) = Interpolator<ColorMask>::mix_3_1(w5, w6);
+#define PIXEL01_20	*(q+1) = Interpolator<ColorMask>::mix_2_1_1(w5, w2, w6);
+#define PIXEL01_21	*(q+1) = Interpolator<ColorMask>::mix_2_1_1(w5, w3, w6);
+#define PIXEL01_22	*(q+1) = Interpolator<ColorMask>::mix_2_1_1(w5, w3, w2);
+#define PIXEL01_60	*(q+1) = Interpolator<ColorMask>::mix_5_2_1(w5, w6, w2);
+#define PIXEL01_61	*(q+1) = Interpolator<ColorMask>::mix_5_2_1(w5, w2, w6);
+#define PIXEL01_70	*(q+1) = Interpolator<ColorMask>::mix_6_1_1(w5, w2, w6);
+#define PIXEL01_90	*(q+1) = Interpolator<ColorMask>::mix_2_3_3(w5, w2, w6);
+#define PIXEL01_100	*(q+1) = Interpolator<ColorMask>::mix_14_1_1(w5, w2, w6);
 
 #define PIXEL10_0	*(q+nextlineDst) = w5;
-#define PIXEL10_10	*(q+nextlineDst) = interpolate16_3_1<ColorMask >(w5, w7);
-#define PIXEL10_11	*(q+nextlineDst) = interpolate16_3_1<ColorMask >(w5, w8);
-#define PIXEL10_12	*(q+nextlineDst) = interpolate16_3_1<ColorMask >(w5, w4);
-#define PIXEL10_20	*(q+nextlineDst) = interpolate16_2_1_1<ColorMask >(w5, w8, w4);
-#define PIXEL10_21	*(q+nextlineDst) = interpolate16_2_1_1<ColorMask >(w5, w7, w4);
-#define PIXEL10_22	*(q+nextlineDst) = interpolate16_2_1_1<ColorMask >(w5, w7, w8);
-#define PIXEL10_60	*(q+nextlineDst) = interpolate16_5_2_1<ColorMask >(w5, w4, w8);
-#define PIXEL10_61	*(q+nextlineDst) = interpolate16_5_2_1<ColorMask >(w5, w8, w4);
-#define PIXEL10_70	*(q+nextlineDst) = interpolate16_6_1_1<ColorMask >(w5, w8, w4);
-#define PIXEL10_90	*(q+nextlineDst) = interpolate16_2_3_3<ColorMask >(w5, w8, w4);
-#define PIXEL10_100	*(q+nextlineDst) = interpolate16_14_1_1<ColorMask >(w5, w8, w4);
+#define PIXEL10_10	*(q+nextlineDst) = Interpolator<ColorMask>::mix_3_1(w5, w7);
+#define PIXEL10_11	*(q+nextlineDst) = Interpolator<ColorMask>::mix_3_1(w5, w8);
+#define PIXEL10_12	*(q+nextlineDst) = Interpolator<ColorMask>::mix_3_1(w5, w4);
+#define PIXEL10_20	*(q+nextlineDst) = Interpolator<ColorMask>::mix_2_1_1(w5, w8, w4);
+#define PIXEL10_21	*(q+nextlineDst) = Interpolator<ColorMask>::mix_2_1_1(w5, w7, w4);
+#define PIXEL10_22	*(q+nextlineDst) = Interpolator<ColorMask>::mix_2_1_1(w5, w7, w8);
+#define PIXEL10_60	*(q+nextlineDst) = Interpolator<ColorMask>::mix_5_2_1(w5, w4, w8);
+#define PIXEL10_61	*(q+nextlineDst) = Interpolator<ColorMask>::mix_5_2_1(w5, w8, w4);
+#define PIXEL10_70	*(q+nextlineDst) = Interpolator<ColorMask>::mix_6_1_1(w5, w8, w4);
+#define PIXEL10_90	*(q+nextlineDst) = Interpolator<ColorMask>::mix_2_3_3(w5, w8, w4);
+#define PIXEL10_100	*(q+nextlineDst) = Interpolator<ColorMask>::mix_14_1_1(w5, w8, w4);
 
 #define PIXEL11_0	*(q+1+nextlineDst) = w5;
-#define PIXEL11_10	*(q+1+nextlineDst) = interpolate16_3_1<ColorMask >(w5, w9);
-#define PIXEL11_11	*(q+1+nextlineDst) = interpolate16_3_1<ColorMask >(w5, w6);
-#define PIXEL11_12	*(q+1+nextlineDst) = interpolate16_3_1<ColorMask >(w5, w8);
-#define PIXEL11_20	*(q+1+nextlineDst) = interpolate16_2_1_1<ColorMask >(w5, w6, w8);
-#define PIXEL11_21	*(q+1+nextlineDst) = interpolate16_2_1_1<ColorMask >(w5, w9, w8);
-#define PIXEL11_22	*(q+1+nextlineDst) = interpolate16_2_1_1<ColorMask >(w5, w9, w6);
-#define PIXEL11_60	*(q+1+nextlineDst) = interpolate16_5_2_1<ColorMask >(w5, w8, w6);
-#define PIXEL11_61	*(q+1+nextlineDst) = interpolate16_5_2_1<ColorMask >(w5, w6, w8);
-#define PIXEL11_70	*(q+1+nextlineDst) = interpolate16_6_1_1<ColorMask >(w5, w6, w8);
-#define PIXEL11_90	*(q+1+nextlineDst) = interpolate16_2_3_3<ColorMask >(w5, w6, w8);
-#define PIXEL11_100	*(q+1+nextlineDst) = interpolate16_14_1_1<ColorMask >(w5, w6, w8);
+#define PIXEL11_10	*(q+1+nextlineDst) = Interpolator<ColorMask>::mix_3_1(w5, w9);
+#define PIXEL11_11	*(q+1+nextlineDst) = Interpolator<ColorMask>::mix_3_1(w5, w6);
+#define PIXEL11_12	*(q+1+nextlineDst) = Interpolator<ColorMask>::mix_3_1(w5, w8);
+#define PIXEL11_20	*(q+1+nextlineDst) = Interpolator<ColorMask>::mix_2_1_1(w5, w6, w8);
+#define PIXEL11_21	*(q+1+nextlineDst) = Interpolator<ColorMask>::mix_2_1_1(w5, w9, w8);
+#define PIXEL11_22	*(q+1+nextlineDst) = Interpolator<ColorMask>::mix_2_1_1(w5, w9, w6);
+#define PIXEL11_60	*(q+1+nextlineDst) = Interpolator<ColorMask>::mix_5_2_1(w5, w8, w6);
+#define PIXEL11_61	*(q+1+nextlineDst) = Interpolator<ColorMask>::mix_5_2_1(w5, w6, w8);
+#define PIXEL11_70	*(q+1+nextlineDst) = Interpolator<ColorMask>::mix_6_1_1(w5, w6, w8);
+#define PIXEL11_90	*(q+1+nextlineDst) = Interpolator<ColorMask>::mix_2_3_3(w5, w6, w8);
+#define PIXEL11_100	*(q+1+nextlineDst) = Interpolator<ColorMask>::mix_14_1_1(w5, w6, w8);
 
-extern "C" uint32   *RGBtoYUV;
-#define YUV(x)	RGBtoYUV[w ## x]
+// Without a row buffer, the YUV values are only looked up when needed
+#define YUV(x)	(useRowBuffer ? yuv ## x : convertToYUV<ColorMask>((Pixel)w ## x))
 
 /*
  * The HQ2x high quality 2x graphics filter.
  * Original author Maxim Stepin (see http://www.hiend3d.com/hq2x.html).
  * Adapted for ScummVM to 16 bit output and optimized by Max Horn.
+ * Extended to 32 bit pixels, finding the patterns with SSE2 where available.
  */
 template<typename ColorMask>
 static void HQ2x_implementation(const uint8 *srcPtr, uint32 srcPitch, uint8 *dstPtr, uint32 dstPitch, int width, int height) {
-	register int w1, w2, w3, w4, w5, w6, w7, w8, w9;
+	typedef typename ColorMask::PixelType Pixel;
+
+#ifdef __SSE2__
+	const bool useRowBuffer = true;
+#else
+	// Without SSE2, 16 bit pixels are faster scaled straight from the
+	// source, since their YUV values come from a table anyway
+	const bool useRowBuffer = (sizeof(Pixel) == 4);
+#endif
+
+	uint32 w1, w2, w3, w4, w5, w6, w7, w8, w9;
+	uint32 yuv2 = 0, yuv4 = 0, yuv6 = 0, yuv8 = 0;
 
-	const uint32 nextlineSrc = srcPitch / sizeof(uint16);
-	const uint16 *p = (const uint16 *)srcPtr;
+	const uint32 nextlineSrc = srcPitch / sizeof(Pixel);
+	const Pixel *p = (const Pixel *)srcPtr;
 
-	const uint32 nextlineDst = dstPitch / sizeof(uint16);
-	uint16 *q = (uint16 *)dstPtr;
+	const uint32 nextlineDst = dstPitch / sizeof(Pixel);
+	Pixel *q = (Pixel *)dstPtr;
 
 	//	 +----+----+----+
 	//	 |    |    |    |
@@ -122,33 +130,82 @@ static void HQ2x_implementation(const uint8 *srcPtr, uint32 srcPitch, uint8 *dst
 	//	 | w7 | w8 | w9 |
 	//	 +----+----+----+
 
+	HQRowBuffer rows(useRowBuffer ? width : 0);
+	if (useRowBuffer) {
+		rows.push<ColorMask>(p - nextlineSrc);
+		rows.push<ColorMask>(p);
+	}
+
 	while (height--) {
-		w1 = *(p - 1 - nextlineSrc);
-		w4 = *(p - 1);
-		w7 = *(p - 1 + nextlineSrc);
+		const uint32 *above = 0, *middle = 0, *below = 0;
+		const uint32 *yuvAbove = 0, *yuvMiddle = 0, *yuvBelow = 0;
 
-		w2 = *(p - nextlineSrc);
-		w5 = *(p);
-		w8 = *(p + nextlineSrc);
+		if (useRowBuffer) {
+			rows.push<ColorMask>(p + nextlineSrc);
+#ifdef __SSE2__
+			rows.computePatterns();
+#endif
+
+			above = rows.getPixels(0);
+			middle = rows.getPixels(1);
+			below = rows.getPixels(2);
+			yuvAbove = rows.getYUV(0);
+			yuvMiddle = rows.getYUV(1);
+			yuvBelow = rows.getYUV(2);
+		} else {
+			w1 = *(p - 1 - nextlineSrc);
+			w4 = *(p - 1);
+			w7 = *(p - 1 + nextlineSrc);
 
-		int tmpWidth = width;
-		while (tmpWidth--) {
-			p++;
+			w2 = *(p - nextlineSrc);
+			w5 = *(p);
+			w8 = *(p + nextlineSrc);
+		}
 
-			w3 = *(p - nextlineSrc);
-			w6 = *(p);
-			w9 = *(p + nextlineSrc);
+		for (int x = 0; x < width; x++) {
+			int pattern;
 
-			int pattern = 0;
-			const int yuv5 = YUV(5);
-			if (w5 != w1 && diffYUV(yuv5, YUV(1))) pattern |= 0x0001;
-			if (w5 != w2 && diffYUV(yuv5, YUV(2))) pattern |= 0x0002;
-			if (w5 != w3 && diffYUV(yuv5, YUV(3))) pattern |= 0x0004;
-			if (w5 != w4 && diffYUV(yuv5, YUV(4))) pattern |= 0x0008;
-			if (w5 != w6 && diffYUV(yuv5, YUV(6))) pattern |= 0x0010;
-			if (w5 != w7 && diffYUV(yuv5, YUV(7))) pattern |= 0x0020;
-			if (w5 != w8 && diffYUV(yuv5, YUV(8))) pattern |= 0x0040;
-			if (w5 != w9 && diffYUV(yuv5, YUV(9))) pattern |= 0x0080;
+			if (useRowBuffer) {
+				w1 = above[x];
+				w2 = above[x + 1];
+				w3 = above[x + 2];
+				w4 = middle[x];
+				w5 = middle[x + 1];
+				w6 = middle[x + 2];
+				w7 = below[x];
+				w8 = below[x + 1];
+				w9 = below[x + 2];
+
+				// Besides the patterns, only the direct neighbours of the
+				// middle pixel are compared with each other
+				yuv2 = yuvAbove[x + 1];
+				yuv4 = yuvMiddle[x];
+				yuv6 = yuvMiddle[x + 2];
+				yuv8 = yuvBelow[x + 1];
+
+#ifdef __SSE2__
+				pattern = rows.getPattern(x);
+#else
+				pattern = computePattern(above + x, middle + x, below + x, yuvAbove + x, yuvMiddle + x, yuvBelow + x);
+#endif
+			} else {
+				p++;
+
+				w3 = *(p - nextlineSrc);
+				w6 = *(p);
+				w9 = *(p + nextlineSrc);
+
+				pattern = 0;
+				const uint32 yuv5 = convertToYUV<ColorMask>((Pixel)w5);
+				if (w5 != w1 && diffYUV(yuv5, convertToYUV<ColorMask>((Pixel)w1))) pattern |= 0x0001;
+				if (w5 != w2 && diffYUV(yuv5, convertToYUV<ColorMask>((Pixel)w2))) pattern |= 0x0002;
+				if (w5 != w3 && diffYUV(yuv5, convertToYUV<ColorMask>((Pixel)w3))) pattern |= 0x0004;
+				if (w5 != w4 && diffYUV(yuv5, convertToYUV<ColorMask>((Pixel)w4))) pattern |= 0x0008;
+				if (w5 != w6 && diffYUV(yuv5, convertToYUV<ColorMask>((Pixel)w6))) pattern |= 0x0010;
+				if (w5 != w7 && diffYUV(yuv5, convertToYUV<ColorMask>((Pixel)w7))) pattern |= 0x0020;
+				if (w5 != w8 && diffYUV(yuv5, convertToYUV<ColorMask>((Pixel)w8))) pattern |= 0x0040;
+				if (w5 != w9 && diffYUV(yuv5, convertToYUV<ColorMask>((Pixel)w9))) pattern |= 0x0080;
+			}
 
 			switch (pattern) {
 			case 0:
@@ -1942,27 +1999,34 @@ static void HQ2x_implementation(const uint8 *srcPtr, uint32 srcPitch, uint8 *dst
 				break;
 			}
 
-			w1 = w2;
-			w4 = w5;
-			w7 = w8;
+			if (!useRowBuffer) {
+				w1 = w2;
+				w4 = w5;
+				w7 = w8;
 
-			w2 = w3;
-			w5 = w6;
-			w8 = w9;
+				w2 = w3;
+				w5 = w6;
+				w8 = w9;
+			}
 
 			q += 2;
 		}
-		p += nextlineSrc - width;
+		p += useRowBuffer ? nextlineSrc : nextlineSrc - width;
 		q += (nextlineDst - width) * 2;
 	}
 }
 
 void HQ2x(const uint8 *srcPtr, uint32 srcPitch, uint8 *dstPtr, uint32 dstPitch, int width, int height) {
 	extern int gBitFormat;
-	if (gBitFormat == 565)
+	if (gBitFormat == 8888)
+		HQ2x_implementation<Graphics::ColorMasks<8888> >(srcPtr, srcPitch, dstPtr, dstPitch, width, height);
+#ifdef USE_NASM
+	else
+		hq2x_16(srcPtr, dstPtr, width, height, srcPitch, dstPitch);
+#else
+	else if (gBitFormat == 565)
 		HQ2x_implementation<Graphics::ColorMasks<565> >(srcPtr, srcPitch, dstPtr, dstPitch, width, height);
 	else
 		HQ2x_implementation<Graphics::ColorMasks<555> >(srcPtr, srcPitch, dstPtr, dstPitch, width, height);
+#endif
 }
-
-#endif // Assembly version
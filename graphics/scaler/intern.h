@@ -179,6 +179,67 @@ static inline unsigned interpolate16_1_1_1_1(unsigned p1, unsigned p2, unsigned
 	return ((p1+p2+p3+p4) - lowbits) >> 2;
 }
 
+/**
+ * The interpolation functions of the hq scaler family, for the pixels of
+ * the given color format.
+ */
+template<typename ColorMask, int bytesPerPixel = ColorMask::kBytesPerPixel>
+struct Interpolator {
+};
+
+/**
+ * For 16 bit pixels, these are the interpolate16_* functions.
+ */
+template<typename ColorMask>
+struct Interpolator<ColorMask, 2> {
+	static inline unsigned mix_1_1(unsigned p1, unsigned p2) { return interpolate16_1_1<ColorMask>(p1, p2); }
+	static inline unsigned mix_3_1(unsigned p1, unsigned p2) { return interpolate16_3_1<ColorMask>(p1, p2); }
+	static inline unsigned mix_5_3(unsigned p1, unsigned p2) { return interpolate16_5_3<ColorMask>(p1, p2); }
+	static inline unsigned mix_7_1(unsigned p1, unsigned p2) { return interpolate16_7_1<ColorMask>(p1, p2); }
+	static inline unsigned mix_2_1_1(unsigned p1, unsigned p2, unsigned p3) { return interpolate16_2_1_1<ColorMask>(p1, p2, p3); }
+	static inline unsigned mix_5_2_1(unsigned p1, unsigned p2, unsigned p3) { return interpolate16_5_2_1<ColorMask>(p1, p2, p3); }
+	static inline unsigned mix_6_1_1(unsigned p1, unsigned p2, unsigned p3) { return interpolate16_6_1_1<ColorMask>(p1, p2, p3); }
+	static inline unsigned mix_2_3_3(unsigned p1, unsigned p2, unsigned p3) { return interpolate16_2_3_3<ColorMask>(p1, p2, p3); }
+	static inline unsigned mix_2_7_7(unsigned p1, unsigned p2, unsigned p3) { return interpolate16_2_7_7<ColorMask>(p1, p2, p3); }
+	static inline unsigned mix_14_1_1(unsigned p1, unsigned p2, unsigned p3) { return interpolate16_14_1_1<ColorMask>(p1, p2, p3); }
+	static inline unsigned mix_1_1_1_1(unsigned p1, unsigned p2, unsigned p3, unsigned p4) { return interpolate16_1_1_1_1<ColorMask>(p1, p2, p3, p4); }
+};
+
+/**
+ * For 32 bit pixels, the channels are interpolated in two pairs, those
+ * in 0x00FF00FF and those in 0xFF00FF00, with 16 bits of room for each
+ * channel. This works for any order of the four 8 bit channels, and keeps
+ * the alpha channel of the pixels.
+ */
+template<typename ColorMask>
+struct Interpolator<ColorMask, 4> {
+	static inline uint32 mix_1_1(uint32 p1, uint32 p2) { return (((p1 ^ p2) & 0xFEFEFEFE) >> 1) + (p1 & p2); }
+	static inline uint32 mix_3_1(uint32 p1, uint32 p2) { return mix<3, 1, 0, 0, 2>(p1, p2, 0, 0); }
+	static inline uint32 mix_5_3(uint32 p1, uint32 p2) { return mix<5, 3, 0, 0, 3>(p1, p2, 0, 0); }
+	static inline uint32 mix_7_1(uint32 p1, uint32 p2) { return mix<7, 1, 0, 0, 3>(p1, p2, 0, 0); }
+	static inline uint32 mix_2_1_1(uint32 p1, uint32 p2, uint32 p3) { return mix<2, 1, 1, 0, 2>(p1, p2, p3, 0); }
+	static inline uint32 mix_5_2_1(uint32 p1, uint32 p2, uint32 p3) { return mix<5, 2, 1, 0, 3>(p1, p2, p3, 0); }
+	static inline uint32 mix_6_1_1(uint32 p1, uint32 p2, uint32 p3) { return mix<6, 1, 1, 0, 3>(p1, p2, p3, 0); }
+	static inline uint32 mix_2_3_3(uint32 p1, uint32 p2, uint32 p3) { return mix<2, 3, 3, 0, 3>(p1, p2, p3, 0); }
+	static inline uint32 mix_2_7_7(uint32 p1, uint32 p2, uint32 p3) { return mix<2, 7, 7, 0, 4>(p1, p2, p3, 0); }
+	static inline uint32 mix_14_1_1(uint32 p1, uint32 p2, uint32 p3) { return mix<14, 1, 1, 0, 4>(p1, p2, p3, 0); }
+	static inline uint32 mix_1_1_1_1(uint32 p1, uint32 p2, uint32 p3, uint32 p4) { return mix<1, 1, 1, 1, 2>(p1, p2, p3, p4); }
+
+private:
+	/**
+	 * Interpolate four pixels with the given weights, which have to add up
+	 * to 1 << shift, and at most 256.
+	 */
+	template<int w1, int w2, int w3, int w4, int shift>
+	static inline uint32 mix(uint32 p1, uint32 p2, uint32 p3, uint32 p4) {
+		const uint32 rb = ((p1 & 0x00FF00FF) * w1 + (p2 & 0x00FF00FF) * w2
+		                +  (p3 & 0x00FF00FF) * w3 + (p4 & 0x00FF00FF) * w4) >> shift;
+		const uint32 ag = (((p1 >> 8) & 0x00FF00FF) * w1 + ((p2 >> 8) & 0x00FF00FF) * w2
+		                +  ((p3 >> 8) & 0x00FF00FF) * w3 + ((p4 >> 8) & 0x00FF00FF) * w4) >> shift;
+		return (rb & 0x00FF00FF) | ((ag & 0x00FF00FF) << 8);
+	}
+};
+
 /**
  * Compare two YUV values (encoded 8-8-8) and check if they differ by more than
  * a certain hard coded threshold. Used by the hq scaler family.
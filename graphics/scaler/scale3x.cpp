@@ -19,7 +19,7 @@
  */
 
 /*
- * This file contains a C and MMX implementation of the Scale2x effect.
+ * This file contains a C and SSE2 implementation of the Scale3x effect.
  *
  * You can find an high level description of the effect at :
  *
@@ -32,6 +32,12 @@
  * - derivative works of the program are allowed.
  */
 
+// The SSE2 header has to come before the ScummVM ones, which forbid some of
+// the symbols in the system headers it includes
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
 #include "common/scummsys.h"
 
 #include "graphics/scaler/scale3x.h"
@@ -220,3 +226,98 @@ void scale3x_32_def(scale3x_uint32* dst0, scale3x_uint32* dst1, scale3x_uint32*
 	scale3x_32_def_center(dst1, src0, src1, src2, count);
 	scale3x_32_def_border(dst2, src2, src1, src0, count);
 }
+
+/***************************************************************************/
+/* Scale3x SSE2 implementation */
+
+#ifdef __SSE2__
+
+/**
+ * Select the pixels of a where the mask is set, and those of b elsewhere.
+ */
+static inline __m128i scale3x_select_sse2(__m128i mask, __m128i a, __m128i b) {
+	return _mm_or_si128(_mm_and_si128(mask, a), _mm_andnot_si128(mask, b));
+}
+
+/**
+ * Store three groups of four pixels interleaved, as a0 b0 c0 a1 b1 c1...
+ */
+static inline void scale3x_32_store_sse2(scale3x_uint32* dst, __m128i a, __m128i b, __m128i c) {
+	const __m128 ab_lo = _mm_castsi128_ps(_mm_unpacklo_epi32(a, b)); /* a0 b0 a1 b1 */
+	const __m128 ab_hi = _mm_castsi128_ps(_mm_unpackhi_epi32(a, b)); /* a2 b2 a3 b3 */
+	const __m128 bc_lo = _mm_castsi128_ps(_mm_unpacklo_epi32(b, c)); /* b0 c0 b1 c1 */
+	const __m128 bc_hi = _mm_castsi128_ps(_mm_unpackhi_epi32(b, c)); /* b2 c2 b3 c3 */
+	const __m128 ca_lo = _mm_castsi128_ps(_mm_unpacklo_epi32(c, a)); /* c0 a0 c1 a1 */
+	const __m128 ca_hi = _mm_castsi128_ps(_mm_unpackhi_epi32(c, a)); /* c2 a2 c3 a3 */
+
+	_mm_storeu_si128((__m128i *)dst, _mm_castps_si128(_mm_shuffle_ps(ab_lo, ca_lo, _MM_SHUFFLE(3, 0, 1, 0))));
+	_mm_storeu_si128((__m128i *)(dst + 4), _mm_castps_si128(_mm_shuffle_ps(bc_lo, ab_hi, _MM_SHUFFLE(1, 0, 3, 2))));
+	_mm_storeu_si128((__m128i *)(dst + 8), _mm_castps_si128(_mm_shuffle_ps(ca_hi, bc_hi, _MM_SHUFFLE(3, 2, 3, 0))));
+}
+
+/**
+ * Scale by a factor of 3 a row of pixels of 32 bits.
+ * This function operates like scale3x_32_def(), but does four pixels at
+ * once with SSE2, replacing the tests of the C version with masks.
+ * @param src0 Pointer at the first pixel of the previous row.
+ * @param src1 Pointer at the first pixel of the current row.
+ * @param src2 Pointer at the first pixel of the next row.
+ * @param count Length in pixels of the src0, src1 and src2 rows.
+ * It must be at least 2.
+ * @param dst0 First destination row, triple length in pixels.
+ * @param dst1 Second destination row, triple length in pixels.
+ * @param dst2 Third destination row, triple length in pixels.
+ */
+void scale3x_32_sse2(scale3x_uint32* dst0, scale3x_uint32* dst1, scale3x_uint32* dst2, const scale3x_uint32* src0, const scale3x_uint32* src1, const scale3x_uint32* src2, unsigned count) {
+	unsigned i = 0;
+
+	for (; i + 4 <= count; i += 4) {
+		/* A B C */
+		/* D E F */
+		/* G H I */
+		const __m128i A = _mm_loadu_si128((const __m128i *)(src0 + i - 1));
+		const __m128i B = _mm_loadu_si128((const __m128i *)(src0 + i));
+		const __m128i C = _mm_loadu_si128((const __m128i *)(src0 + i + 1));
+		const __m128i D = _mm_loadu_si128((const __m128i *)(src1 + i - 1));
+		const __m128i E = _mm_loadu_si128((const __m128i *)(src1 + i));
+		const __m128i F = _mm_loadu_si128((const __m128i *)(src1 + i + 1));
+		const __m128i G = _mm_loadu_si128((const __m128i *)(src2 + i - 1));
+		const __m128i H = _mm_loadu_si128((const __m128i *)(src2 + i));
+		const __m128i I = _mm_loadu_si128((const __m128i *)(src2 + i + 1));
+
+		/* the pixels with B == H or D == F are just copied */
+		const __m128i copy = _mm_or_si128(_mm_cmpeq_epi32(B, H), _mm_cmpeq_epi32(D, F));
+
+		const __m128i DB = _mm_andnot_si128(copy, _mm_cmpeq_epi32(D, B));
+		const __m128i FB = _mm_andnot_si128(copy, _mm_cmpeq_epi32(F, B));
+		const __m128i DH = _mm_andnot_si128(copy, _mm_cmpeq_epi32(D, H));
+		const __m128i FH = _mm_andnot_si128(copy, _mm_cmpeq_epi32(F, H));
+
+		const __m128i EA = _mm_cmpeq_epi32(E, A);
+		const __m128i EC = _mm_cmpeq_epi32(E, C);
+		const __m128i EG = _mm_cmpeq_epi32(E, G);
+		const __m128i EI = _mm_cmpeq_epi32(E, I);
+
+		scale3x_32_store_sse2(dst0 + 3 * i,
+			scale3x_select_sse2(DB, D, E),
+			scale3x_select_sse2(_mm_or_si128(_mm_andnot_si128(EC, DB), _mm_andnot_si128(EA, FB)), B, E),
+			scale3x_select_sse2(FB, F, E));
+		scale3x_32_store_sse2(dst1 + 3 * i,
+			scale3x_select_sse2(_mm_or_si128(_mm_andnot_si128(EG, DB), _mm_andnot_si128(EA, DH)), D, E),
+			E,
+			scale3x_select_sse2(_mm_or_si128(_mm_andnot_si128(EI, FB), _mm_andnot_si128(EC, FH)), F, E));
+		scale3x_32_store_sse2(dst2 + 3 * i,
+			scale3x_select_sse2(DH, D, E),
+			scale3x_select_sse2(_mm_or_si128(_mm_andnot_si128(EI, DH), _mm_andnot_si128(EG, FH)), H, E),
+			scale3x_select_sse2(FH, F, E));
+	}
+
+	/* remaining pixels */
+	if (i < count) {
+		scale3x_32_def_border(dst0 + 3 * i, src0 + i, src1 + i, src2 + i, count - i);
+		scale3x_32_def_center(dst1 + 3 * i, src0 + i, src1 + i, src2 + i, count - i);
+		scale3x_32_def_border(dst2 + 3 * i, src2 + i, src1 + i, src0 + i, count - i);
+	}
+}
+
+#endif
@@ -83,6 +83,12 @@
 // BASIS, AND BROWN UNIVERSITY HAS NO OBLIGATION TO PROVIDE MAINTENANCE,
 // SUPPORT, UPDATES, ENHANCEMENTS, OR MODIFICATIONS.
 
+// The SSE2 header has to come before the ScummVM ones, which forbid some of
+// the symbols in the system headers it includes
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
 #include "graphics/surface.h"
 #include "graphics/yuv_to_rgb.h"
 
@@ -192,6 +198,142 @@ const YUVToRGBLookup *YUVToRGBManager::getLookup(Graphics::PixelFormat format, Y
 	return _lookup;
 }
 
+#ifdef __SSE2__
+
+/**
+ * Converts eight pixels at once, giving the same results as the lookup
+ * tables. The chroma terms of the tables are truncated products, which are
+ * computed here with fixed point multiplications of the absolute values.
+ * The sums are then clamped and scaled like the tables do.
+ */
+class YUVToRGBSSE2 {
+public:
+	YUVToRGBSSE2(const Graphics::PixelFormat &format, YUVToRGBManager::LuminanceScale scale) {
+		_itu = (scale == YUVToRGBManager::kScaleITU);
+		_rLoss = _mm_cvtsi32_si128(format.rLoss);
+		_gLoss = _mm_cvtsi32_si128(format.gLoss);
+		_bLoss = _mm_cvtsi32_si128(format.bLoss);
+		_rShift = _mm_cvtsi32_si128(format.rShift);
+		_gShift = _mm_cvtsi32_si128(format.gShift);
+		_bShift = _mm_cvtsi32_si128(format.bShift);
+		_rShiftHi = _mm_cvtsi32_si128(format.rShift >= 16 ? format.rShift - 16 : 16);
+		_gShiftHi = _mm_cvtsi32_si128(format.gShift >= 16 ? format.gShift - 16 : 16);
+		_bShiftHi = _mm_cvtsi32_si128(format.bShift >= 16 ? format.bShift - 16 : 16);
+		_rShiftDown = _mm_cvtsi32_si128(format.rShift < 16 ? 16 - format.rShift : 16);
+		_gShiftDown = _mm_cvtsi32_si128(format.gShift < 16 ? 16 - format.gShift : 16);
+		_bShiftDown = _mm_cvtsi32_si128(format.bShift < 16 ? 16 - format.bShift : 16);
+		_crossesHalves = (format.rShift < 16 && format.rShift + 8 - format.rLoss > 16) ||
+		                 (format.gShift < 16 && format.gShift + 8 - format.gLoss > 16) ||
+		                 (format.bShift < 16 && format.bShift + 8 - format.bLoss > 16);
+		_alpha = (0xFF >> format.aLoss) << format.aShift;
+	}
+
+	/** Load 8 bytes as 16 bit values. */
+	static __m128i load8(const byte *src) {
+		return _mm_unpacklo_epi8(_mm_loadl_epi64((const __m128i *)src), _mm_setzero_si128());
+	}
+
+	/**
+	 * Compute the chroma terms added to the luminance of the red, green and
+	 * blue components, for 8 chroma values. The factors are those of the
+	 * tables set up in the YUVToRGBManager constructor. The ones above 1 use
+	 * the doubled absolute value.
+	 */
+	static void getChroma(__m128i u, __m128i v, __m128i &r, __m128i &g, __m128i &b) {
+		const __m128i cr = _mm_sub_epi16(v, _mm_set1_epi16(128));
+		const __m128i cb = _mm_sub_epi16(u, _mm_set1_epi16(128));
+		const __m128i crSign = _mm_srai_epi16(cr, 15);
+		const __m128i cbSign = _mm_srai_epi16(cb, 15);
+		const __m128i crAbs = _mm_sub_epi16(_mm_xor_si128(cr, crSign), crSign);
+		const __m128i cbAbs = _mm_sub_epi16(_mm_xor_si128(cb, cbSign), cbSign);
+
+		r = mulChroma(crSign, _mm_add_epi16(crAbs, crAbs), 45876);
+		g = _mm_add_epi16(mulChroma(crSign, crAbs, 46735), mulChroma(cbSign, cbAbs, 22562));
+		g = _mm_sub_epi16(_mm_setzero_si128(), g);
+		b = mulChroma(cbSign, _mm_add_epi16(cbAbs, cbAbs), 58109);
+	}
+
+	/** Convert 8 pixels, from the luminance and the chroma terms. */
+	void putPixels(uint16 *dst, __m128i y, __m128i rChroma, __m128i gChroma, __m128i bChroma) const {
+		__m128i pixels = _mm_set1_epi16(_alpha);
+		pixels = _mm_or_si128(pixels, _mm_sll_epi16(getComponent(y, rChroma, _rLoss), _rShift));
+		pixels = _mm_or_si128(pixels, _mm_sll_epi16(getComponent(y, gChroma, _gLoss), _gShift));
+		pixels = _mm_or_si128(pixels, _mm_sll_epi16(getComponent(y, bChroma, _bLoss), _bShift));
+
+		_mm_storeu_si128((__m128i *)dst, pixels);
+	}
+
+	void putPixels(uint32 *dst, __m128i y, __m128i rChroma, __m128i gChroma, __m128i bChroma) const {
+		const __m128i r = getComponent(y, rChroma, _rLoss);
+		const __m128i g = getComponent(y, gChroma, _gLoss);
+		const __m128i b = getComponent(y, bChroma, _bLoss);
+
+		// Build the lower and upper 16 bits of the pixels separately. Shifts
+		// by 16 or more clear the value, so each component only ends up in
+		// the half it belongs to.
+		__m128i lo = _mm_set1_epi16(_alpha & 0xFFFF);
+		__m128i hi = _mm_set1_epi16(_alpha >> 16);
+		lo = _mm_or_si128(lo, _mm_sll_epi16(r, _rShift));
+		hi = _mm_or_si128(hi, _mm_sll_epi16(r, _rShiftHi));
+		lo = _mm_or_si128(lo, _mm_sll_epi16(g, _gShift));
+		hi = _mm_or_si128(hi, _mm_sll_epi16(g, _gShiftHi));
+		lo = _mm_or_si128(lo, _mm_sll_epi16(b, _bShift));
+		hi = _mm_or_si128(hi, _mm_sll_epi16(b, _bShiftHi));
+
+		// Components crossing into the upper half, which the usual formats
+		// do not have
+		if (_crossesHalves) {
+			hi = _mm_or_si128(hi, _mm_srl_epi16(r, _rShiftDown));
+			hi = _mm_or_si128(hi, _mm_srl_epi16(g, _gShiftDown));
+			hi = _mm_or_si128(hi, _mm_srl_epi16(b, _bShiftDown));
+		}
+
+		_mm_storeu_si128((__m128i *)dst, _mm_unpacklo_epi16(lo, hi));
+		_mm_storeu_si128((__m128i *)(dst + 4), _mm_unpackhi_epi16(lo, hi));
+	}
+
+	/** Convert 8 pixels, from the luminance and chroma values. */
+	template<typename PixelInt>
+	void putPixels(PixelInt *dst, __m128i y, __m128i u, __m128i v) const {
+		__m128i r, g, b;
+		getChroma(u, v, r, g, b);
+		putPixels(dst, y, r, g, b);
+	}
+
+private:
+	bool _itu;
+	__m128i _rLoss, _gLoss, _bLoss;
+	__m128i _rShift, _gShift, _bShift;
+	__m128i _rShiftHi, _gShiftHi, _bShiftHi;	///< Shifts of the components within the upper 16 bits of 32 bit pixels
+	__m128i _rShiftDown, _gShiftDown, _bShiftDown;	///< Shifts of the parts crossing into the upper 16 bits
+	bool _crossesHalves;
+	uint32 _alpha;
+
+	/** The truncated product of the signed value with factor / 65536. */
+	static __m128i mulChroma(__m128i sign, __m128i abs, uint16 factor) {
+		const __m128i product = _mm_mulhi_epu16(abs, _mm_set1_epi16(factor));
+		return _mm_sub_epi16(_mm_xor_si128(product, sign), sign);
+	}
+
+	/** Clamp and scale a color component, like the tables do. */
+	__m128i getComponent(__m128i y, __m128i chroma, __m128i loss) const {
+		__m128i x = _mm_add_epi16(y, chroma);
+
+		if (!_itu) {
+			x = _mm_max_epi16(_mm_min_epi16(x, _mm_set1_epi16(255)), _mm_setzero_si128());
+		} else {
+			// (x - 16) * 255 / 219 of the value clamped to [16, 235]
+			x = _mm_max_epi16(_mm_min_epi16(x, _mm_set1_epi16(235)), _mm_set1_epi16(16));
+			x = _mm_sub_epi16(x, _mm_set1_epi16(16));
+			x = _mm_mulhi_epu16(_mm_add_epi16(x, x), _mm_set1_epi16((short)38155));
+		}
+
+		return _mm_srl_epi16(x, loss);
+	}
+};
+
+#endif // __SSE2__
+
 #define PUT_PIXEL(s, d) \
 	L = &rgbToPix[(s)]; \
 	*((PixelInt *)(d)) = (L[cr_r] | L[crb_g] | L[cb_b])
@@ -205,8 +347,24 @@ void convertYUV444ToRGB(byte *dstPtr, int dstPitch, const YUVToRGBLookup *lookup
 	const int16 *Cb_b_tab = Cb_g_tab + 256;
 	const uint32 *rgbToPix = lookup->getRGBToPix();
 
+#ifdef __SSE2__
+	const YUVToRGBSSE2 sse2(lookup->getFormat(), lookup->getScale());
+#endif
+
 	for (int h = 0; h < yHeight; h++) {
-		for (int w = 0; w < yWidth; w++) {
+		int w = 0;
+
+#ifdef __SSE2__
+		for (; w + 8 <= yWidth; w += 8) {
+			sse2.putPixels((PixelInt *)dstPtr, YUVToRGBSSE2::load8(ySrc), YUVToRGBSSE2::load8(uSrc), YUVToRGBSSE2::load8(vSrc));
+			ySrc += 8;
+			uSrc += 8;
+			vSrc += 8;
+			dstPtr += 8 * sizeof(PixelInt);
+		}
+#endif
+
+		for (; w < yWidth; w++) {
 			register const uint32 *L;
 
 			int16 cr_r  = Cr_r_tab[*vSrc];
@@ -254,8 +412,36 @@ void convertYUV420ToRGB(byte *dstPtr, int dstPitch, const YUVToRGBLookup *lookup
 	const int16 *Cb_b_tab = Cb_g_tab + 256;
 	const uint32 *rgbToPix = lookup->getRGBToPix();
 
+#ifdef __SSE2__
+	const YUVToRGBSSE2 sse2(lookup->getFormat(), lookup->getScale());
+#endif
+
 	for (int h = 0; h < halfHeight; h++) {
-		for (int w = 0; w < halfWidth; w++) {
+		int w = 0;
+
+#ifdef __SSE2__
+		// 16 pixels of two lines, sharing 8 chroma values
+		for (; w + 8 <= halfWidth; w += 8) {
+			__m128i r, g, b;
+			YUVToRGBSSE2::getChroma(YUVToRGBSSE2::load8(uSrc), YUVToRGBSSE2::load8(vSrc), r, g, b);
+
+			const __m128i rLo = _mm_unpacklo_epi16(r, r), rHi = _mm_unpackhi_epi16(r, r);
+			const __m128i gLo = _mm_unpacklo_epi16(g, g), gHi = _mm_unpackhi_epi16(g, g);
+			const __m128i bLo = _mm_unpacklo_epi16(b, b), bHi = _mm_unpackhi_epi16(b, b);
+
+			sse2.putPixels((PixelInt *)dstPtr, YUVToRGBSSE2::load8(ySrc), rLo, gLo, bLo);
+			sse2.putPixels((PixelInt *)dstPtr + 8, YUVToRGBSSE2::load8(ySrc + 8), rHi, gHi, bHi);
+			sse2.putPixels((PixelInt *)(dstPtr + dstPitch), YUVToRGBSSE2::load8(ySrc + yPitch), rLo, gLo, bLo);
+			sse2.putPixels((PixelInt *)(dstPtr + dstPitch) + 8, YUVToRGBSSE2::load8(ySrc + yPitch + 8), rHi, gHi, bHi);
+
+			uSrc += 8;
+			vSrc += 8;
+			ySrc += 16;
+			dstPtr += 16 * sizeof(PixelInt);
+		}
+#endif
+
+		for (; w < halfWidth; w++) {
 			register const uint32 *L;
 
 			int16 cr_r  = Cr_r_tab[*vSrc];
@@ -322,6 +508,37 @@ void YUVToRGBManager::convert420(Graphics::Surface *dst, YUVToRGBManager::Lumina
 	ySrc++; \
 	xDiff++
 
+#ifdef __SSE2__
+
+/**
+ * Interpolate the chroma values for eight pixels, from the three values
+ * at src and the three below them, like DO_INTERPOLATION does.
+ */
+static inline __m128i interpolate410SSE2(const byte *src, int uvPitch, __m128i weightA, __m128i weightB, __m128i weightC, __m128i weightD) {
+	const __m128i zero = _mm_setzero_si128();
+	const __m128i top = _mm_unpacklo_epi8(_mm_cvtsi32_si128(src[0] | (src[1] << 8) | (src[2] << 16)), zero);
+	const __m128i bottom = _mm_unpacklo_epi8(_mm_cvtsi32_si128(src[uvPitch] | (src[uvPitch + 1] << 8) | (src[uvPitch + 2] << 16)), zero);
+
+	// Repeat the first value four times, then the second one
+	__m128i a = _mm_unpacklo_epi16(top, top);
+	__m128i b = _mm_srli_si128(a, 4);
+	__m128i c = _mm_unpacklo_epi16(bottom, bottom);
+	__m128i d = _mm_srli_si128(c, 4);
+	a = _mm_unpacklo_epi32(a, a);
+	b = _mm_unpacklo_epi32(b, b);
+	c = _mm_unpacklo_epi32(c, c);
+	d = _mm_unpacklo_epi32(d, d);
+
+	__m128i sum = _mm_mullo_epi16(a, weightA);
+	sum = _mm_add_epi16(sum, _mm_mullo_epi16(b, weightB));
+	sum = _mm_add_epi16(sum, _mm_mullo_epi16(c, weightC));
+	sum = _mm_add_epi16(sum, _mm_mullo_epi16(d, weightD));
+
+	return _mm_srli_epi16(sum, 4);
+}
+
+#endif // __SSE2__
+
 template<typename PixelInt>
 void convertYUV410ToRGB(byte *dstPtr, int dstPitch, const YUVToRGBLookup *lookup, int16 *colorTab, const byte *ySrc, const byte *uSrc, const byte *vSrc, int yWidth, int yHeight, int yPitch, int uvPitch) {
 	// Keep the tables in pointers here to avoid a dereference on each pixel
@@ -333,8 +550,37 @@ void convertYUV410ToRGB(byte *dstPtr, int dstPitch, const YUVToRGBLookup *lookup
 
 	int quarterWidth = yWidth >> 2;
 
+#ifdef __SSE2__
+	const YUVToRGBSSE2 sse2(lookup->getFormat(), lookup->getScale());
+	const __m128i xDiffs = _mm_setr_epi16(0, 1, 2, 3, 0, 1, 2, 3);
+	const __m128i four = _mm_set1_epi16(4);
+#endif
+
 	for (int y = 0; y < yHeight; y++) {
-		for (int x = 0; x < quarterWidth; x++) {
+		int x = 0;
+
+#ifdef __SSE2__
+		// The interpolation weights of the four chroma values for two
+		// groups of four pixels
+		const __m128i yDiffs = _mm_set1_epi16(y & 3);
+		const __m128i weightA = _mm_mullo_epi16(_mm_sub_epi16(four, xDiffs), _mm_sub_epi16(four, yDiffs));
+		const __m128i weightB = _mm_mullo_epi16(xDiffs, _mm_sub_epi16(four, yDiffs));
+		const __m128i weightC = _mm_mullo_epi16(yDiffs, _mm_sub_epi16(four, xDiffs));
+		const __m128i weightD = _mm_mullo_epi16(xDiffs, yDiffs);
+
+		for (; x + 2 <= quarterWidth; x += 2) {
+			int index = (y >> 2) * uvPitch + x;
+
+			const __m128i u = interpolate410SSE2(uSrc + index, uvPitch, weightA, weightB, weightC, weightD);
+			const __m128i v = interpolate410SSE2(vSrc + index, uvPitch, weightA, weightB, weightC, weightD);
+
+			sse2.putPixels((PixelInt *)dstPtr, YUVToRGBSSE2::load8(ySrc), u, v);
+			ySrc += 8;
+			dstPtr += 8 * sizeof(PixelInt);
+		}
+#endif
+
+		for (; x < quarterWidth; x++) {
 			// Perform bilinear interpolation on the the chroma values
 			// Based on the algorithm found here: http://tech-algorithm.com/articles/bilinear-image-scaling/
 			// Feel free to optimize further
@@ -24,6 +24,7 @@
 #define FORBIDDEN_SYMBOL_ALLOW_ALL
 
 #include "common/debug-channels.h"
+#include "common/profiler.h"
 #include "common/system.h"
 
 #include "engines/engine.h"
@@ -64,6 +65,10 @@ Debugger::Debugger() {
 	DCmd_Register("debugflag_list",		WRAP_METHOD(Debugger, Cmd_DebugFlagsList));
 	DCmd_Register("debugflag_enable",	WRAP_METHOD(Debugger, Cmd_DebugFlagEnable));
 	DCmd_Register("debugflag_disable",	WRAP_METHOD(Debugger, Cmd_DebugFlagDisable));
+
+#ifdef USE_PROFILER
+	DCmd_Register("profile_dump",		WRAP_METHOD(Debugger, Cmd_ProfileDump));
+#endif
 }
 
 Debugger::~Debugger() {
@@ -537,6 +542,18 @@ bool Debugger::Cmd_DebugFlagDisable(int argc, const char **argv) {
 	return true;
 }
 
+#ifdef USE_PROFILER
+bool Debugger::Cmd_ProfileDump(int argc, const char **argv) {
+	const char *filename = (argc < 2) ? "scummvm-profile.json" : argv[1];
+
+	if (ProfilerMan.dump(filename))
+		DebugPrintf("Wrote profile to '%s'\n", filename);
+	else
+		DebugPrintf("Failed to write profile to '%s'\n", filename);
+	return true;
+}
+#endif
+
 // Console handler
 #ifndef USE_TEXT_CONSOLE_FOR_DEBUGGER
 bool Debugger::debuggerInputCallback(GUI::ConsoleDialog *console, const char *input, void *refCon) {
@@ -29,6 +29,8 @@
 #include "common/system.h"
 #include "common/translation.h"
 
+#include "engines/detectionCache.h"
+
 #include "gui/about.h"
 #include "gui/browser.h"
 #include "gui/chooser.h"
@@ -842,6 +844,7 @@ void LauncherDialog::addGame() {
 			// ...so let's determine a list of candidates, games that
 			// could be contained in the specified directory.
 			GameList candidates(EngineMan.detectGames(files));
+			DetectionCacheMan.flush();
 
 			int idx;
 			if (candidates.empty()) {
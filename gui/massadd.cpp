@@ -19,12 +19,14 @@
  * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
  */
 
+#include "engines/detectionCache.h"
 #include "engines/metaengine.h"
 #include "common/algorithm.h"
 #include "common/config-manager.h"
 #include "common/debug.h"
 #include "common/system.h"
 #include "common/taskbar.h"
+#include "common/timer.h"
 #include "common/translation.h"
 
 #include "gui/launcher.h"	// For addGameToConf()
@@ -44,9 +46,8 @@ TODO:
 */
 
 enum {
-	// Upper bound (im milliseconds) we want to spend in handleTickle.
-	// Setting this low makes the GUI more responsive but also slows
-	// down the scanning.
+	// Upper bound (in milliseconds) we want to spend in one scan step on
+	// the timer thread. Other timer callbacks have to wait meanwhile.
 	kMaxScanTime = 50
 };
 
@@ -59,9 +60,13 @@ enum {
 
 MassAddDialog::MassAddDialog(const Common::FSNode &startDir)
 	: Dialog("MassAdd"),
+	_dirInProgress(false),
+	_currentPlugin(0),
 	_dirsScanned(0),
-	_oldGamesCount(0),
 	_dirTotal(0),
+	_scanComplete(false),
+	_scanRunning(false),
+	_oldGamesCount(0),
 	_okButton(0),
 	_dirProgressText(0),
 	_gameProgressText(0) {
@@ -118,6 +123,29 @@ MassAddDialog::MassAddDialog(const Common::FSNode &startDir)
 	}
 }
 
+void MassAddDialog::open() {
+	Dialog::open();
+
+	// The scan runs on the timer thread, while handleTickle() picks up its
+	// results. Detectors are not safe to run concurrently, as they share
+	// SearchMan, the detection cache and the state of some engine specific
+	// fallback detectors, so there is a single scan step at a time.
+	if (!_scanComplete && !_scanRunning)
+		_scanRunning = g_system->getTimerManager()->installTimerProc(&scanTimerProc, 10000, this, "MassAddDialog");
+}
+
+void MassAddDialog::close() {
+	stopScan();
+	Dialog::close();
+}
+
+void MassAddDialog::stopScan() {
+	if (_scanRunning) {
+		g_system->getTimerManager()->removeTimerProc(&scanTimerProc);
+		_scanRunning = false;
+	}
+}
+
 struct GameTargetLess {
 	bool operator()(const GameDescriptor &x, const GameDescriptor &y) const {
 		return x.preferredtarget().compareToIgnoreCase(y.preferredtarget()) < 0;
@@ -170,88 +198,170 @@ void MassAddDialog::handleCommand(CommandSender *sender, uint32 cmd, uint32 data
 	}
 }
 
-void MassAddDialog::handleTickle() {
-	if (_scanStack.empty())
+bool MassAddDialog::detectNextEngine() {
+#if defined(UNCACHED_PLUGINS) && defined(DYNAMIC_MODULES)
+	// Only one engine plugin is in memory at a time, and loading them is
+	// expensive. So run all detectors on the dir in one go.
+	_currentCandidates = EngineMan.detectGames(_currentFiles);
+	return true;
+#else
+	const EnginePlugin::List &plugins = EngineMan.getPlugins();
+
+	if (_currentPlugin < plugins.size()) {
+		_currentCandidates.push_back((*plugins[_currentPlugin])->detectGames(_currentFiles));
+		_currentPlugin++;
+	}
+
+	return _currentPlugin >= plugins.size();
+#endif
+}
+
+void MassAddDialog::addCandidates(const ScanResult &scanResult) {
+	const Common::String &path = scanResult.path;
+
+	// Just add all detected games / game variants. If we get more than one,
+	// that either means the directory contains multiple games, or the detector
+	// could not fully determine which game variant it was seeing. In either
+	// case, let the user choose which entries he wants to keep.
+	//
+	// However, we only add games which are not already in the config file.
+	for (GameList::const_iterator cand = scanResult.candidates.begin(); cand != scanResult.candidates.end(); ++cand) {
+		GameDescriptor result = *cand;
+
+		// Check for existing config entries for this path/gameid/lang/platform combination
+		if (_pathToTargets.contains(path)) {
+			bool duplicate = false;
+			const StringArray &targets = _pathToTargets[path];
+			for (StringArray::const_iterator iter = targets.begin(); iter != targets.end(); ++iter) {
+				// If the gameid, platform and language match -> skip it
+				Common::ConfigManager::Domain *dom = ConfMan.getDomain(*iter);
+				assert(dom);
+
+				if ((*dom)["gameid"] == result["gameid"] &&
+				    (*dom)["platform"] == result["platform"] &&
+				    (*dom)["language"] == result["language"]) {
+					duplicate = true;
+					break;
+				}
+			}
+			if (duplicate) {
+				_oldGamesCount++;
+				break;	// Skip duplicates
+			}
+		}
+		result["path"] = path;
+		_games.push_back(result);
+
+		_list->append(result.description());
+	}
+}
+
+void MassAddDialog::scanTimerProc(void *refCon) {
+	((MassAddDialog *)refCon)->scanStep();
+}
+
+void MassAddDialog::scanStep() {
+	if (_scanStack.empty() && !_dirInProgress)
 		return;	// We have finished scanning
 
 	uint32 t = g_system->getMillis();
 
-	// Perform a breadth-first scan of the filesystem.
-	while (!_scanStack.empty() && (g_system->getMillis() - t) < kMaxScanTime) {
-		Common::FSNode dir = _scanStack.pop();
+	// Perform a depth-first scan of the filesystem. Detection in a
+	// directory is split into one step per engine, so that a directory
+	// with many (or large) files does not hold up other timer callbacks.
+	while ((!_scanStack.empty() || _dirInProgress) && (g_system->getMillis() - t) < kMaxScanTime) {
+		if (!_dirInProgress) {
+			_currentDir = _scanStack.pop();
 
-		Common::FSList files;
-		if (!dir.getChildren(files, Common::FSNode::kListAll)) {
-			continue;
-		}
+			_currentFiles.clear();
+			if (!_currentDir.getChildren(_currentFiles, Common::FSNode::kListAll)) {
+				continue;
+			}
 
-		// Run the detector on the dir
-		GameList candidates(EngineMan.detectGames(files));
-
-		// Just add all detected games / game variants. If we get more than one,
-		// that either means the directory contains multiple games, or the detector
-		// could not fully determine which game variant it was seeing. In either
-		// case, let the user choose which entries he wants to keep.
-		//
-		// However, we only add games which are not already in the config file.
-		for (GameList::const_iterator cand = candidates.begin(); cand != candidates.end(); ++cand) {
-			GameDescriptor result = *cand;
-			Common::String path = dir.getPath();
-
-			// Remove trailing slashes
-			while (path != "/" && path.lastChar() == '/')
-				path.deleteLastChar();
-
-			// Check for existing config entries for this path/gameid/lang/platform combination
-			if (_pathToTargets.contains(path)) {
-				bool duplicate = false;
-				const StringArray &targets = _pathToTargets[path];
-				for (StringArray::const_iterator iter = targets.begin(); iter != targets.end(); ++iter) {
-					// If the gameid, platform and language match -> skip it
-					Common::ConfigManager::Domain *dom = ConfMan.getDomain(*iter);
-					assert(dom);
-
-					if ((*dom)["gameid"] == result["gameid"] &&
-					    (*dom)["platform"] == result["platform"] &&
-					    (*dom)["language"] == result["language"]) {
-						duplicate = true;
-						break;
-					}
-				}
-				if (duplicate) {
-					_oldGamesCount++;
-					break;	// Skip duplicates
+			// Recurse into all subdirs
+			int subdirs = 0;
+			for (Common::FSList::const_iterator file = _currentFiles.begin(); file != _currentFiles.end(); ++file) {
+				if (file->isDirectory()) {
+					_scanStack.push(*file);
+
+					subdirs++;
 				}
 			}
-			result["path"] = path;
-			_games.push_back(result);
 
-			_list->append(result.description());
+			{
+				Common::StackLock lock(_mutex);
+				_dirTotal += subdirs;
+			}
+
+			_currentCandidates.clear();
+			_currentPlugin = 0;
+			_dirInProgress = true;
 		}
 
+		// Run the next detector on the dir
+		if (!detectNextEngine())
+			continue;
 
-		// Recurse into all subdirs
-		for (Common::FSList::const_iterator file = files.begin(); file != files.end(); ++file) {
-			if (file->isDirectory()) {
-				_scanStack.push(*file);
+		ScanResult result;
+		result.path = _currentDir.getPath();
 
-				_dirTotal++;
-			}
-		}
+		// Remove trailing slashes
+		while (result.path != "/" && result.path.lastChar() == '/')
+			result.path.deleteLastChar();
 
+		result.candidates = _currentCandidates;
+		_dirInProgress = false;
+
+		Common::StackLock lock(_mutex);
+		if (!result.candidates.empty())
+			_results.push(result);
 		_dirsScanned++;
+	}
+
+	if (_scanStack.empty() && !_dirInProgress) {
+		Common::StackLock lock(_mutex);
+		_scanComplete = true;
+	}
+}
+
+void MassAddDialog::handleTickle() {
+	if (!_scanRunning)
+		return;	// We have finished scanning
+
+	Common::Array<ScanResult> results;
+	int dirsScanned;
+	bool scanComplete;
+
+	{
+		Common::StackLock lock(_mutex);
+		while (!_results.empty())
+			results.push_back(_results.pop());
+		dirsScanned = _dirsScanned;
+		scanComplete = _scanComplete;
 
 #if defined(USE_TASKBAR)
 		g_system->getTaskbarManager()->setProgressValue(_dirsScanned, _dirTotal);
-		g_system->getTaskbarManager()->setCount(_games.size());
 #endif
 	}
 
+	// Add the results on the GUI thread, since this accesses ConfMan and
+	// the game list widget
+	for (uint i = 0; i < results.size(); i++)
+		addCandidates(results[i]);
+
+#if defined(USE_TASKBAR)
+	g_system->getTaskbarManager()->setCount(_games.size());
+#endif
 
 	// Update the dialog
 	Common::String buf;
 
-	if (_scanStack.empty()) {
+	if (scanComplete) {
+		stopScan();
+
+		// Keep the detection results for the next scan
+		DetectionCacheMan.flush();
+
 		// Enable the OK button
 		_okButton->setEnabled(true);
 
@@ -262,7 +372,7 @@ void MassAddDialog::handleTickle() {
 		_gameProgressText->setLabel(buf);
 
 	} else {
-		buf = Common::String::format(_("Scanned %d directories ..."), _dirsScanned);
+		buf = Common::String::format(_("Scanned %d directories ..."), dirsScanned);
 		_dirProgressText->setLabel(buf);
 
 		buf = Common::String::format(_("Discovered %d new games, ignored %d previously added games ..."), _games.size(), _oldGamesCount);
@@ -25,6 +25,8 @@
 #include "gui/dialog.h"
 #include "common/fs.h"
 #include "common/hashmap.h"
+#include "common/mutex.h"
+#include "common/queue.h"
 #include "common/stack.h"
 #include "common/str.h"
 
@@ -37,7 +39,8 @@ class MassAddDialog : public Dialog {
 public:
 	MassAddDialog(const Common::FSNode &startDir);
 
-	//void open();
+	void open();
+	void close();
 	void handleCommand(CommandSender *sender, uint32 cmd, uint32 data);
 	void handleTickle();
 
@@ -48,7 +51,52 @@ public:
 	}
 
 private:
+	/** The games detected in a directory, passed from the scan to the dialog. */
+	struct ScanResult {
+		Common::String path;
+		GameList candidates;
+	};
+
+	static void scanTimerProc(void *refCon);
+
+	/**
+	 * Scan directories for a limited amount of time. This runs on the
+	 * timer thread, so the GUI stays responsive while detectors are busy.
+	 */
+	void scanStep();
+
+	/**
+	 * Run the next engine's detector on the directory currently being scanned.
+	 * @return true if all detectors have been run on it
+	 */
+	bool detectNextEngine();
+
+	/** Remove the scan timer, waiting for a running scan step to return. */
+	void stopScan();
+
+	/** Add the games detected in a directory to the list. */
+	void addCandidates(const ScanResult &result);
+
+	/** Only accessed by scanStep(), or before and after the scan. */
 	Common::Stack<Common::FSNode>  _scanStack;
+
+	/** The directory being scanned, its contents and the games detected so far. */
+	Common::FSNode _currentDir;
+	Common::FSList _currentFiles;
+	GameList _currentCandidates;
+	bool _dirInProgress;
+	uint _currentPlugin;
+
+	/** Protects the results and progress below, shared with scanStep(). */
+	Common::Mutex _mutex;
+	Common::Queue<ScanResult> _results;
+	int _dirsScanned;
+	int _dirTotal;
+	bool _scanComplete;
+
+	/** Whether the scan timer is installed, only accessed by the GUI thread. */
+	bool _scanRunning;
+
 	GameList _games;
 
 	/**
@@ -58,9 +106,7 @@ private:
 	 */
 	Common::HashMap<Common::String, StringArray>	_pathToTargets;
 
-	int _dirsScanned;
 	int _oldGamesCount;
-	int _dirTotal;
 
 	Widget *_okButton;
 	StaticTextWidget *_dirProgressText;
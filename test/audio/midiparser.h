@@ -0,0 +1,148 @@
+#include <cxxtest/TestSuite.h>
+
+#include "audio/mididrv.h"
+#include "audio/midiparser.h"
+
+#include "common/array.h"
+
+/**
+ * A MIDI driver remembering all messages sent to it.
+ */
+class MidiParserTestDriver : public MidiDriver_BASE {
+public:
+	void send(uint32 b) { messages.push_back(b); }
+
+	Common::Array<uint32> messages;
+};
+
+class MidiParserTestSuite : public CxxTest::TestSuite
+{
+	enum {
+		kNoteCount = 1000,
+		kTimerRate = 10000
+	};
+
+	Common::Array<byte> _data;
+
+	void addVLQ(Common::Array<byte> &track, uint32 value) {
+		if (value >= 0x80)
+			track.push_back(0x80 | (value >> 7));
+		track.push_back(value & 0x7F);
+	}
+
+	void addTempo(Common::Array<byte> &track, uint32 tempo) {
+		addVLQ(track, 0);
+		track.push_back(0xFF);
+		track.push_back(0x51);
+		track.push_back(3);
+		track.push_back(tempo >> 16);
+		track.push_back(tempo >> 8);
+		track.push_back(tempo);
+	}
+
+	/**
+	 * Create a type 0 SMF with notes of varying lengths on all channels,
+	 * and a few tempo changes.
+	 */
+	void createSong() {
+		Common::Array<byte> track;
+		uint32 seed = 1;
+
+		for (uint32 i = 0; i < kNoteCount; i++) {
+			if (i == 100 || i == 500)
+				addTempo(track, 300000 + i * 1000);
+
+			seed = seed * 1103515245 + 12345;
+			const byte channel = (seed >> 16) & 0x0F;
+			const byte note = 36 + (seed >> 20) % 48;
+
+			addVLQ(track, (seed >> 8) % 50);
+			track.push_back(0x90 | channel);
+			track.push_back(note);
+			track.push_back(100);
+
+			addVLQ(track, (seed >> 12) % 200);
+			track.push_back(0x80 | channel);
+			track.push_back(note);
+			track.push_back(0);
+		}
+
+		// End of track
+		addVLQ(track, 0);
+		track.push_back(0xFF);
+		track.push_back(0x2F);
+		track.push_back(0);
+
+		static const byte header[] = { 'M', 'T', 'h', 'd', 0, 0, 0, 6, 0, 0, 0, 1, 0, 96, 'M', 'T', 'r', 'k' };
+		_data.clear();
+		for (uint32 i = 0; i < ARRAYSIZE(header); i++)
+			_data.push_back(header[i]);
+		_data.push_back(track.size() >> 24);
+		_data.push_back(track.size() >> 16);
+		_data.push_back(track.size() >> 8);
+		_data.push_back(track.size());
+		for (uint32 i = 0; i < track.size(); i++)
+			_data.push_back(track[i]);
+	}
+
+	MidiParser *createParser(MidiParserTestDriver &driver) {
+		MidiParser *parser = MidiParser::createParser_SMF();
+		parser->setMidiDriver(&driver);
+		parser->setTimerRate(kTimerRate);
+		parser->loadMusic(_data.begin(), _data.size());
+		return parser;
+	}
+
+	/**
+	 * Jump to the tick and play on for a while, then compare with a parser
+	 * which jumps there without any seek points.
+	 */
+	void checkJump(MidiParser *parser, MidiParserTestDriver &driver, uint32 tick) {
+		MidiParserTestDriver referenceDriver;
+		MidiParser *reference = createParser(referenceDriver);
+
+		// The times after the jump are based on the tempo at the time of the
+		// jump, until the song sets one. Make it differ from the tempo at
+		// which the seek points were made.
+		parser->setTempo(400000);
+		reference->setTempo(400000);
+
+		TS_ASSERT(parser->jumpToTick(tick));
+		TS_ASSERT(reference->jumpToTick(tick));
+		TS_ASSERT_EQUALS(parser->getTick(), tick);
+		TS_ASSERT_EQUALS(reference->getTick(), tick);
+
+		// Only compare what is played after the jump
+		driver.messages.clear();
+		referenceDriver.messages.clear();
+
+		for (int i = 0; i < 200; i++) {
+			parser->onTimer();
+			reference->onTimer();
+			TS_ASSERT_EQUALS(parser->getTick(), reference->getTick());
+		}
+
+		TS_ASSERT_EQUALS(driver.messages.size(), referenceDriver.messages.size());
+		for (uint32 i = 0; i < driver.messages.size() && i < referenceDriver.messages.size(); i++)
+			TS_ASSERT_EQUALS(driver.messages[i], referenceDriver.messages[i]);
+
+		delete reference;
+	}
+
+	public:
+	void test_jump_to_tick() {
+		createSong();
+
+		MidiParserTestDriver driver;
+		MidiParser *parser = createParser(driver);
+
+		// Jumping past the end fails, but walks the whole track
+		TS_ASSERT(!parser->jumpToTick(0x7FFFFFFF));
+
+		static const uint32 ticks[] = { 1, 5000, 60000, 20000, 120000, 3000, 95000 };
+		for (uint32 i = 0; i < ARRAYSIZE(ticks); i++)
+			checkJump(parser, driver, ticks[i]);
+
+		delete parser;
+	}
+};
@@ -0,0 +1,218 @@
+#include <cxxtest/TestSuite.h>
+
+#include "common/scummsys.h"
+
+#ifdef USE_MT32EMU
+#include "audio/softsynth/mt32/mt32emu.h"
+
+#include "common/file.h"
+#include "common/memstream.h"
+#endif
+
+/**
+ * Renders a fixed MIDI sequence through the MT-32 emulator and compares the
+ * output with a checksum of a reference rendering, so that changes to the
+ * emulator can be checked to keep its output bit identical.
+ *
+ * The real ROMs can't be used here, so the test builds a control ROM with a
+ * single timbre, which is used for all timbres of bank A, and a PCM ROM of
+ * random samples. The reference was rendered on x86-64 with SSE2 floating
+ * point math; other floating point implementations may round differently.
+ */
+class MT32TestSuite : public CxxTest::TestSuite
+{
+#ifdef USE_MT32EMU
+	enum {
+		kSampleRate = 32000,
+		kChunkSize = 400,
+		kChunkCount = 200,
+
+		// Layout of the "ver1.07" MT-32 control ROM, see ControlROMMaps
+		kIdPos = 0x4010,
+		kMaxTables = 0x51F4,
+		kMaxTablesEnd = 0x5270,
+		kReserveSettings = 0x57B1,
+
+		kPCMROMSize = 512 * 1024
+	};
+
+	byte *_controlROM;
+	byte *_pcmROM;
+
+	static void printDebug(void *userData, const char *fmt, va_list list) {
+	}
+
+	static Common::File *openFile(void *userData, const char *filename) {
+		MT32TestSuite *suite = (MT32TestSuite *)userData;
+		byte *data;
+		uint32 size;
+
+		if (!strcmp(filename, "MT32_CONTROL.ROM")) {
+			data = suite->_controlROM;
+			size = MT32Emu::CONTROL_ROM_SIZE;
+		} else if (!strcmp(filename, "MT32_PCM.ROM")) {
+			data = suite->_pcmROM;
+			size = kPCMROMSize;
+		} else {
+			return 0;
+		}
+
+		Common::File *file = new Common::File();
+		file->open(new Common::MemoryReadStream(data, size), filename);
+		return file;
+	}
+
+	uint32 _seed;
+
+	uint32 getRandom() {
+		_seed = _seed * 1103515245 + 12345;
+		return _seed >> 8;
+	}
+
+	void createROMs() {
+		_controlROM = new byte[MT32Emu::CONTROL_ROM_SIZE];
+		memset(_controlROM, 0, MT32Emu::CONTROL_ROM_SIZE);
+
+		// All entries of the timbre maps are zero, so every timbre of bank
+		// A and the rhythm bank is read from the start of the ROM.
+		MT32Emu::TimbreParam *timbre = (MT32Emu::TimbreParam *)_controlROM;
+		memcpy(timbre->common.name, "TEST      ", 10);
+		timbre->common.partialStructure12 = 0;
+		timbre->common.partialStructure34 = 0;
+		timbre->common.partialMute = 0x0F;
+		timbre->common.noSustain = 0;
+
+		for (int i = 0; i < 4; i++) {
+			MT32Emu::TimbreParam::PartialParam &partial = timbre->partial[i];
+
+			partial.wg.pitchCoarse = 36 + 12 * (i / 2);
+			partial.wg.pitchFine = 45 + 3 * i;
+			partial.wg.pitchKeyfollow = 11;
+			partial.wg.pitchBenderEnabled = 1;
+			partial.wg.waveform = i & 1;
+			partial.wg.pulseWidth = 30 + 10 * i;
+			partial.wg.pulseWidthVeloSensitivity = 7;
+
+			partial.pitchEnv.depth = 2;
+			partial.pitchEnv.veloSensitivity = 20;
+			partial.pitchEnv.timeKeyfollow = 1;
+			for (int j = 0; j < 4; j++)
+				partial.pitchEnv.time[j] = 10 + 20 * j;
+			for (int j = 0; j < 5; j++)
+				partial.pitchEnv.level[j] = 40 + 5 * j;
+
+			partial.pitchLFO.rate = 60;
+			partial.pitchLFO.depth = 10;
+			partial.pitchLFO.modSensitivity = 50;
+
+			partial.tvf.cutoff = 60 + 10 * i;
+			partial.tvf.resonance = 5 + 5 * i;
+			partial.tvf.keyfollow = 11;
+			partial.tvf.biasPoint = 64;
+			partial.tvf.biasLevel = 7;
+			partial.tvf.envDepth = 50;
+			partial.tvf.envVeloSensitivity = 50;
+			partial.tvf.envDepthKeyfollow = 1;
+			partial.tvf.envTimeKeyfollow = 1;
+			for (int j = 0; j < 5; j++)
+				partial.tvf.envTime[j] = 10 + 15 * j;
+			for (int j = 0; j < 4; j++)
+				partial.tvf.envLevel[j] = 100 - 10 * j;
+
+			partial.tva.level = 80;
+			partial.tva.veloSensitivity = 50;
+			partial.tva.biasPoint1 = 64;
+			partial.tva.biasLevel1 = 10;
+			partial.tva.biasPoint2 = 80;
+			partial.tva.biasLevel2 = 10;
+			partial.tva.envTimeKeyfollow = 1;
+			partial.tva.envTimeVeloSensitivity = 1;
+			for (int j = 0; j < 5; j++)
+				partial.tva.envTime[j] = 5 + 15 * j;
+			for (int j = 0; j < 4; j++)
+				partial.tva.envLevel[j] = 100 - 8 * j;
+		}
+
+		memcpy(_controlROM + kIdPos, "\000 ver1.07 10 Oct, 87 ", 22);
+
+		// No parameter limits, the timbre above only uses valid values
+		memset(_controlROM + kMaxTables, 0x7F, kMaxTablesEnd - kMaxTables);
+
+		// Four partials for each part, none for the rhythm part
+		memset(_controlROM + kReserveSettings, 4, 8);
+
+		_pcmROM = new byte[kPCMROMSize];
+		for (uint32 i = 0; i < kPCMROMSize; i++)
+			_pcmROM[i] = getRandom();
+	}
+
+	void deleteROMs() {
+		delete[] _controlROM;
+		delete[] _pcmROM;
+	}
+
+	/**
+	 * Play chords on the first three parts, with pitch bends and
+	 * overlapping notes, so that partials have to be stolen.
+	 */
+	void playEvents(MT32Emu::Synth &synth, int chunk) {
+		for (int channel = 1; channel <= 3; channel++) {
+			if ((chunk + channel * 3) % 8 == 0) {
+				for (int i = 0; i < 3; i++) {
+					const byte note = 36 + getRandom() % 48;
+					const byte velocity = 40 + getRandom() % 88;
+					synth.playMsg(0x90 | channel | (note << 8) | (velocity << 16));
+				}
+			}
+
+			if ((chunk + channel) % 11 == 0) {
+				const uint32 bend = getRandom() % 0x4000;
+				synth.playMsg(0xE0 | channel | ((bend & 0x7F) << 8) | ((bend >> 7) << 16));
+			}
+
+			if ((chunk + channel * 5) % 24 == 0)
+				synth.playMsg(0xB0 | channel | (0x7B << 8));	// All notes off
+		}
+	}
+#endif
+
+public:
+	void test_render_reference() {
+#ifdef USE_MT32EMU
+		_seed = 1;
+		createROMs();
+
+		MT32Emu::SynthProperties prop;
+		memset(&prop, 0, sizeof(prop));
+		prop.sampleRate = kSampleRate;
+		prop.userData = this;
+		prop.printDebug = printDebug;
+		prop.openFile = openFile;
+
+		MT32Emu::Synth *synth = new MT32Emu::Synth();
+		TS_ASSERT(synth->open(prop));
+
+		int16 buffer[kChunkSize * 2];
+		uint32 checksum = 0;
+		int16 peak = 0;
+
+		for (int chunk = 0; chunk < kChunkCount; chunk++) {
+			playEvents(*synth, chunk);
+			synth->render(buffer, kChunkSize);
+
+			for (int i = 0; i < kChunkSize * 2; i++) {
+				checksum = checksum * 31 + (uint16)buffer[i];
+				peak = MAX<int16>(peak, ABS(buffer[i]));
+			}
+		}
+
+		synth->close();
+		delete synth;
+		deleteROMs();
+
+		// Make sure the sequence is not just silence
+		TS_ASSERT_LESS_THAN(1000, peak);
+		TS_ASSERT_EQUALS(checksum, 453071443U);
+#endif
+	}
+};
@@ -0,0 +1,112 @@
+#include <cxxtest/TestSuite.h>
+
+#include "audio/audiostream.h"
+#include "audio/mixer.h"
+#include "audio/rate.h"
+
+#include "common/math.h"
+
+/**
+ * An endless mono sine tone.
+ */
+class RateTestSineStream : public Audio::AudioStream {
+public:
+	RateTestSineStream(int rate, int frequency) : _rate(rate), _frequency(frequency), _pos(0) {}
+
+	int readBuffer(int16 *buffer, const int numSamples) {
+		for (int i = 0; i < numSamples; i++, _pos++)
+			buffer[i] = (int16)(sin(2 * M_PI * _frequency * _pos / _rate) * 16384);
+		return numSamples;
+	}
+
+	bool isStereo() const { return false; }
+	int getRate() const { return _rate; }
+	bool endOfData() const { return false; }
+
+private:
+	int _rate;
+	int _frequency;
+	int _pos;
+};
+
+class RateConverterTestSuite : public CxxTest::TestSuite
+{
+	enum {
+		kInputRate = 11025,
+		kOutputRate = 48000,
+		kLength = 8192
+	};
+
+	/**
+	 * Determine the level of a frequency in the left channel of a mixing bus,
+	 * in dB relative to the level of RateTestSineStream.
+	 */
+	static double measureLevel(const Audio::st_bus_t *buffer, int frequency) {
+		double re = 0.0, im = 0.0, windowSum = 0.0;
+
+		for (int i = 0; i < kLength; i++) {
+			const double window = 0.5 - 0.5 * cos(2 * M_PI * i / kLength);
+			const double phase = 2 * M_PI * frequency * i / kOutputRate;
+			re += window * buffer[2 * i] * cos(phase);
+			im += window * buffer[2 * i] * sin(phase);
+			windowSum += window;
+		}
+
+		const double amplitude = 2 * sqrt(re * re + im * im) / windowSum;
+		return 20 * log10(amplitude / (16384.0 * Audio::Mixer::kMaxMixerVolume) + 1e-12);
+	}
+
+	/**
+	 * Convert sine tones throughout the input's frequency range, and
+	 * determine the lowest level of the tones, as well as the highest
+	 * level of their images (i.e. aliasing) in the output.
+	 */
+	static void sweep(bool highQuality, double &minTone, double &maxImage) {
+		minTone = 0.0;
+		maxImage = -1000.0;
+
+		Audio::st_bus_t *buffer = new Audio::st_bus_t[2 * (kLength + 64)];
+
+		for (int frequency = 250; frequency <= 4000; frequency += 250) {
+			RateTestSineStream stream(kInputRate, frequency);
+			Audio::RateConverter *converter = Audio::makeRateConverter(kInputRate, kOutputRate, false, false, highQuality);
+
+			// Skip the start, where the filter is still filling up
+			memset(buffer, 0, 2 * (kLength + 64) * sizeof(Audio::st_bus_t));
+			converter->flow(stream, buffer, 64, Audio::Mixer::kMaxMixerVolume, Audio::Mixer::kMaxMixerVolume);
+			memset(buffer, 0, 2 * kLength * sizeof(Audio::st_bus_t));
+			converter->flow(stream, buffer, kLength, Audio::Mixer::kMaxMixerVolume, Audio::Mixer::kMaxMixerVolume);
+
+			minTone = MIN(minTone, measureLevel(buffer, frequency));
+
+			// The images are mirrored around multiples of the input rate
+			for (int image = kInputRate; image - frequency < kOutputRate / 2; image += kInputRate) {
+				maxImage = MAX(maxImage, measureLevel(buffer, image - frequency));
+				if (image + frequency < kOutputRate / 2)
+					maxImage = MAX(maxImage, measureLevel(buffer, image + frequency));
+			}
+
+			delete converter;
+		}
+
+		delete[] buffer;
+	}
+
+public:
+	void test_sinc_sweep() {
+		double minTone, maxImage;
+		sweep(true, minTone, maxImage);
+
+		// The tones must pass (almost) unchanged, while the images must
+		// be at least 60 dB below them.
+		TS_ASSERT_LESS_THAN(-0.5, minTone);
+		TS_ASSERT_LESS_THAN(maxImage, -60.0);
+
+		// For comparison, linear interpolation keeps the images at about
+		// -14 dB, and attenuates the higher tones by about 4 dB.
+		double minToneLinear, maxImageLinear;
+		sweep(false, minToneLinear, maxImageLinear);
+
+		TS_ASSERT_LESS_THAN(maxImage, maxImageLinear - 40.0);
+	}
+};
@@ -149,4 +149,37 @@ class BitStreamTestSuite : public CxxTest::TestSuite
 		TS_ASSERT_EQUALS(bs.peekBits(5), 12u);
 		TS_ASSERT(!bs.eos());
 	}
+
+	/**
+	 * Peek at any number of bits at all positions, which may span several
+	 * values of the stream, and compare with reading them.
+	 */
+	template<class BS>
+	void checkPeekAcrossValues() {
+		byte contents[16];
+		for (int i = 0; i < 16; i++)
+			contents[i] = i * 37 + 11;
+
+		Common::MemoryReadStream ms(contents, sizeof(contents));
+		BS bs(ms);
+
+		for (uint32 start = 0; start < 64; start++) {
+			for (uint8 n = 1; n <= 32; n++) {
+				bs.rewind();
+				bs.skip(start);
+				const uint32 peeked = bs.peekBits(n);
+				TS_ASSERT_EQUALS(bs.pos(), start);
+				TS_ASSERT_EQUALS(bs.getBits(n), peeked);
+			}
+		}
+	}
+
+	void test_peek_bits_across_values() {
+		checkPeekAcrossValues<Common::BitStream8MSB>();
+		checkPeekAcrossValues<Common::BitStream8LSB>();
+		checkPeekAcrossValues<Common::BitStream16LEMSB>();
+		checkPeekAcrossValues<Common::BitStream16BELSB>();
+		checkPeekAcrossValues<Common::BitStream32LEMSB>();
+		checkPeekAcrossValues<Common::BitStream32LELSB>();
+	}
 };
@@ -0,0 +1,122 @@
+#include <cxxtest/TestSuite.h>
+
+#include "common/fft.h"
+#include "common/rdft.h"
+#include "common/util.h"
+
+class FFTTestSuite : public CxxTest::TestSuite
+{
+	/** Fill the buffer with some arbitrary signal. */
+	void fill(float *data, int count) {
+		for (int i = 0; i < count; i++)
+			data[i] = (float)(sin(i * 0.37) + 0.5 * cos(i * 2.11) + (i % 7) * 0.1);
+	}
+
+	/**
+	 * Compare with a naive DFT of the input, in double precision, using
+	 * exp(sign * 2 * pi * i * j * k / n).
+	 */
+	void checkDFT(const Common::Complex *input, const Common::Complex *output, int n, int sign) {
+		double maxError = 0.0;
+		double maxValue = 0.0;
+
+		for (int k = 0; k < n; k++) {
+			double re = 0.0, im = 0.0;
+			for (int j = 0; j < n; j++) {
+				const double angle = sign * 2.0 * M_PI * (((double)j * k) - n * floor((double)j * k / n)) / n;
+				re += input[j].re * cos(angle) - input[j].im * sin(angle);
+				im += input[j].re * sin(angle) + input[j].im * cos(angle);
+			}
+
+			maxError = MAX(maxError, MAX(fabs(re - output[k].re), fabs(im - output[k].im)));
+			maxValue = MAX(maxValue, MAX(fabs(re), fabs(im)));
+		}
+
+		TS_ASSERT_LESS_THAN(maxError, maxValue * 1e-5);
+	}
+
+	void checkFFT(int bits, int inverse) {
+		const int n = 1 << bits;
+		Common::Complex *input = new Common::Complex[n];
+		Common::Complex *output = new Common::Complex[n];
+
+		fill(&input[0].re, 2 * n);
+		memcpy(output, input, n * sizeof(Common::Complex));
+
+		Common::FFT fft(bits, inverse);
+		fft.permute(output);
+		fft.calc(output);
+
+		checkDFT(input, output, n, inverse ? 1 : -1);
+
+		delete[] input;
+		delete[] output;
+	}
+
+	public:
+	void test_fft() {
+		for (int bits = 2; bits <= 10; bits++) {
+			checkFFT(bits, 0);
+			checkFFT(bits, 1);
+		}
+	}
+
+	void test_rdft() {
+		// The real to complex transform gives the first half of the spectrum,
+		// with the real value of the last bin in place of the imaginary part
+		// of the first one.
+		for (int bits = 4; bits <= 10; bits++) {
+			const int n = 1 << bits;
+			float *data = new float[n];
+			Common::Complex *input = new Common::Complex[n];
+			Common::Complex *output = new Common::Complex[n];
+
+			fill(data, n);
+			for (int i = 0; i < n; i++) {
+				input[i].re = data[i];
+				input[i].im = 0.0f;
+			}
+
+			Common::RDFT rdft(bits, Common::RDFT::IDFT_R2C);
+			rdft.calc(data);
+
+			output[0].re = data[0];
+			output[0].im = 0.0f;
+			output[n / 2].re = data[1];
+			output[n / 2].im = 0.0f;
+			for (int i = 1; i < n / 2; i++) {
+				output[i].re = output[n - i].re = data[2 * i];
+				output[i].im = data[2 * i + 1];
+				output[n - i].im = -data[2 * i + 1];
+			}
+
+			checkDFT(input, output, n, 1);
+
+			delete[] data;
+			delete[] input;
+			delete[] output;
+		}
+	}
+
+	void test_shared_tables() {
+		// The twiddle factor tables are shared between transforms of the
+		// same size, and must outlive the transform creating them.
+		const int bits = 8;
+		const int n = 1 << bits;
+		float expected[n], data[n];
+
+		fill(expected, n);
+		Common::RDFT *first = new Common::RDFT(bits, Common::RDFT::IDFT_R2C);
+		first->calc(expected);
+
+		Common::RDFT *second = new Common::RDFT(bits, Common::RDFT::IDFT_R2C);
+		delete first;
+
+		fill(data, n);
+		second->calc(data);
+		delete second;
+
+		for (int i = 0; i < n; i++)
+			TS_ASSERT_EQUALS(data[i], expected[i]);
+	}
+};
@@ -0,0 +1,193 @@
+#include <cxxtest/TestSuite.h>
+
+#include "common/flathashmap.h"
+#include "common/hashmap.h"
+#include "common/hash-str.h"
+
+class FlatHashMapTestSuite : public CxxTest::TestSuite
+{
+	typedef Common::FlatHashMap<Common::String, Common::String, Common::IgnoreCase_Hash, Common::IgnoreCase_EqualTo> StringMap;
+
+	public:
+	void test_empty_clear() {
+		Common::FlatHashMap<int, int> container;
+		TS_ASSERT(container.empty());
+		container[0] = 17;
+		container[1] = 33;
+		TS_ASSERT(!container.empty());
+		container.clear();
+		TS_ASSERT(container.empty());
+
+		StringMap container2;
+		TS_ASSERT(container2.empty());
+		container2["foo"] = "bar";
+		container2["quux"] = "blub";
+		TS_ASSERT(!container2.empty());
+		container2.clear();
+		TS_ASSERT(container2.empty());
+	}
+
+	void test_contains() {
+		Common::FlatHashMap<int, int> container;
+		container[0] = 17;
+		container[1] = 33;
+		TS_ASSERT(container.contains(0));
+		TS_ASSERT(container.contains(1));
+		TS_ASSERT(!container.contains(17));
+		TS_ASSERT(!container.contains(-1));
+
+		StringMap container2;
+		container2["foo"] = "bar";
+		container2["quux"] = "blub";
+		TS_ASSERT(container2.contains("foo"));
+		TS_ASSERT(container2.contains("FOO"));
+		TS_ASSERT(container2.contains("quux"));
+		TS_ASSERT(!container2.contains("bar"));
+		TS_ASSERT(!container2.contains("asdf"));
+	}
+
+	void test_add_remove() {
+		Common::FlatHashMap<int, int> container;
+		container[0] = 17;
+		container[1] = 33;
+		container[2] = 45;
+		container[3] = 12;
+		container[4] = 96;
+		TS_ASSERT(container.contains(1));
+		container.erase(1);
+		TS_ASSERT(!container.contains(1));
+		container[1] = 42;
+		TS_ASSERT(container.contains(1));
+		container.erase(0);
+		container.erase(1);
+		container.erase(2);
+		container.erase(3);
+		TS_ASSERT(!container.empty());
+		TS_ASSERT_EQUALS(container.size(), 1u);
+		container.erase(container.find(4));
+		TS_ASSERT(container.empty());
+	}
+
+	void test_lookup_with_default() {
+		Common::FlatHashMap<int, int> container;
+		container[0] = 17;
+		container[1] = -1;
+		container[2] = 45;
+
+		// We take a const ref now to ensure that the map
+		// is not modified by getVal.
+		const Common::FlatHashMap<int, int> &containerRef = container;
+
+		TS_ASSERT_EQUALS(containerRef.getVal(0), 17);
+		TS_ASSERT_EQUALS(containerRef.getVal(1), -1);
+		TS_ASSERT_EQUALS(containerRef.getVal(17), 0);
+		TS_ASSERT_EQUALS(containerRef.getVal(0, -10), 17);
+		TS_ASSERT_EQUALS(containerRef.getVal(17, -10), -10);
+		TS_ASSERT_EQUALS(containerRef.size(), 3u);
+	}
+
+	void test_iterator() {
+		Common::FlatHashMap<int, int> container;
+
+		// The container is initially empty ...
+		TS_ASSERT_EQUALS(container.begin(), container.end());
+
+		container[0] = 17;
+		container[1] = 33;
+		container[2] = 45;
+		container[3] = 12;
+		container[4] = 96;
+		container.erase(0);
+		container.erase(1);
+
+		int found = 0;
+		Common::FlatHashMap<int, int>::iterator i;
+		for (i = container.begin(); i != container.end(); ++i) {
+			int key = i->_key;
+			TS_ASSERT(key >= 0 && key <= 4);
+			TS_ASSERT(!(found & (1 << key)));
+			found |= 1 << key;
+			i->_value = key;
+		}
+		TS_ASSERT(found == 16+8+4);
+
+		found = 0;
+		Common::FlatHashMap<int, int>::const_iterator j;
+		for (j = container.begin(); j != container.end(); ++j) {
+			TS_ASSERT_EQUALS(j->_key, j->_value);
+			found |= 1 << j->_key;
+		}
+		TS_ASSERT(found == 16+8+4);
+
+		// ... and again empty.
+		container.clear(true);
+		TS_ASSERT_EQUALS(container.begin(), container.end());
+	}
+
+	void test_copy() {
+		Common::FlatHashMap<int, int> map1, container2;
+		for (int i = 0; i < 100; i++)
+			map1[i * 7] = i;
+		map1.erase(14);
+
+		container2 = map1;
+		Common::FlatHashMap<int, int> container3(map1);
+		map1.clear();
+
+		TS_ASSERT_EQUALS(container2.size(), 99u);
+		TS_ASSERT_EQUALS(container3.size(), 99u);
+		TS_ASSERT(!container2.contains(14));
+		TS_ASSERT(!container3.contains(14));
+		TS_ASSERT_EQUALS(container2[693], 99);
+		TS_ASSERT_EQUALS(container3[693], 99);
+	}
+
+	void test_against_hashmap() {
+		// Perform a long pseudo random sequence of insertions and
+		// deletions, which causes the table to be rehashed and to fill
+		// with deleted slots, and compare the result with HashMap.
+		Common::FlatHashMap<uint, uint> flat;
+		Common::HashMap<uint, uint> reference;
+		uint seed = 12345;
+
+		for (uint i = 0; i < 20000; i++) {
+			seed = seed * 1103515245 + 12345;
+			const uint key = (seed >> 16) % 3000;
+
+			if (seed & 0x100) {
+				flat[key] = i;
+				reference[key] = i;
+			} else {
+				flat.erase(key);
+				reference.erase(key);
+			}
+		}
+
+		TS_ASSERT_EQUALS(flat.size(), reference.size());
+
+		for (Common::HashMap<uint, uint>::const_iterator i = reference.begin(); i != reference.end(); ++i)
+			TS_ASSERT_EQUALS(flat.getVal(i->_key, (uint)-1), i->_value);
+
+		uint count = 0;
+		for (Common::FlatHashMap<uint, uint>::const_iterator i = flat.begin(); i != flat.end(); ++i) {
+			TS_ASSERT(reference.contains(i->_key));
+			count++;
+		}
+		TS_ASSERT_EQUALS(count, reference.size());
+	}
+
+	void test_string_values() {
+		// Make sure keys and values survive being moved on rehashing
+		StringMap container;
+		for (int i = 0; i < 500; i++)
+			container[Common::String::format("key%d", i)] = Common::String::format("value%d", i);
+
+		for (int i = 0; i < 500; i += 2)
+			container.erase(Common::String::format("KEY%d", i));
+
+		TS_ASSERT_EQUALS(container.size(), 250u);
+		TS_ASSERT_EQUALS(container["key1"], "value1");
+		TS_ASSERT_EQUALS(container["key499"], "value499");
+		TS_ASSERT(!container.contains("key498"));
+	}
+};
@@ -0,0 +1,110 @@
+#include <cxxtest/TestSuite.h>
+
+#include "common/bitstream.h"
+#include "common/huffman.h"
+#include "common/memstream.h"
+
+/*
+ * A codebook with the code lengths 1 to 20: 0, 10, 110, ..., 1111...10,
+ * with the last two codes of length 20 both. This gives us codes resolved
+ * by the first-level table, by a subtable and by the bitwise fallback.
+ */
+static const uint32 kHuffmanTestCodeCount = 21;
+
+class HuffmanTestSuite : public CxxTest::TestSuite {
+	uint32 _codes[kHuffmanTestCodeCount];
+	uint8  _lengths[kHuffmanTestCodeCount];
+	uint32 _symbols[kHuffmanTestCodeCount];
+
+	byte  _data[64];
+	uint32 _bitPos;
+
+	void buildCodes(bool msbFirst) {
+		for (uint32 i = 0; i < kHuffmanTestCodeCount; i++) {
+			uint32 length = MIN<uint32>(i + 1, 20);
+
+			// Code in MSB-first notation: (length - 1) ones and a zero, or all ones for the last one
+			uint32 code = (i == kHuffmanTestCodeCount - 1) ? ((1 << length) - 1) : ((1 << length) - 2);
+
+			if (!msbFirst) {
+				// Reverse the code, since the first bit read ends up as the LSB
+				uint32 reversed = 0;
+				for (uint32 j = 0; j < length; j++)
+					reversed |= ((code >> j) & 1) << (length - 1 - j);
+				code = reversed;
+			}
+
+			_codes[i]   = code;
+			_lengths[i] = length;
+			_symbols[i] = 1000 + i;
+		}
+	}
+
+	void putCode(uint32 i, bool msbFirst) {
+		for (uint32 j = 0; j < _lengths[i]; j++) {
+			uint32 bit = msbFirst ? ((_codes[i] >> (_lengths[i] - 1 - j)) & 1) : ((_codes[i] >> j) & 1);
+
+			if (bit)
+				_data[_bitPos / 8] |= msbFirst ? (0x80 >> (_bitPos % 8)) : (1 << (_bitPos % 8));
+
+			_bitPos++;
+		}
+	}
+
+	void checkDecode(bool msbFirst) {
+		static const uint32 sequence[] = { 0, 3, 20, 8, 9, 10, 1, 15, 19, 2, 0, 0, 1 };
+		const uint32 sequenceLength = ARRAYSIZE(sequence);
+
+		buildCodes(msbFirst);
+
+		memset(_data, 0, sizeof(_data));
+		_bitPos = 0;
+
+		for (uint32 i = 0; i < sequenceLength; i++)
+			putCode(sequence[i], msbFirst);
+
+		Common::Huffman huffman(0, kHuffmanTestCodeCount, _codes, _lengths, _symbols);
+		Common::MemoryReadStream ms(_data, (_bitPos + 7) / 8);
+
+		Common::BitStream *bits;
+		if (msbFirst)
+			bits = new Common::BitStream8MSB(ms);
+		else
+			bits = new Common::BitStream8LSB(ms);
+
+		for (uint32 i = 0; i < sequenceLength; i++)
+			TS_ASSERT_EQUALS(huffman.getSymbol(*bits), 1000 + sequence[i]);
+
+		TS_ASSERT_EQUALS(bits->pos(), _bitPos);
+
+		delete bits;
+	}
+
+	public:
+	void test_get_symbol_msb() {
+		checkDecode(true);
+	}
+
+	void test_get_symbol_lsb() {
+		checkDecode(false);
+	}
+
+	void test_set_symbols() {
+		buildCodes(true);
+
+		memset(_data, 0, sizeof(_data));
+		_bitPos = 0;
+
+		putCode(2, true);
+		putCode(12, true);
+
+		Common::Huffman huffman(0, kHuffmanTestCodeCount, _codes, _lengths, _symbols);
+		huffman.setSymbols();
+
+		Common::MemoryReadStream ms(_data, (_bitPos + 7) / 8);
+		Common::BitStream8MSB bits(ms);
+
+		TS_ASSERT_EQUALS(huffman.getSymbol(bits), 2u);
+		TS_ASSERT_EQUALS(huffman.getSymbol(bits), 12u);
+	}
+};
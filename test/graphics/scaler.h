@@ -0,0 +1,129 @@
+#include <cxxtest/TestSuite.h>
+
+#include "graphics/scaler.h"
+
+class ScalerBandsTestSuite : public CxxTest::TestSuite
+{
+	enum {
+		kWidth = 67,
+		kHeight = 201,
+		// The scalers look at the pixels around the rect
+		kBorder = 2,
+		kMaxScale = 3,
+		kMaxBands = 2 * 17
+	};
+
+	struct Scaler {
+		ScalerProc *proc;
+		int scaleFactor;
+		bool only16Bit;
+	};
+
+	uint8 *_src;
+	uint8 *_whole;
+	uint8 *_banded;
+	uint32 _seed;
+
+	uint32 getRandom() {
+		_seed = _seed * 1103515245 + 12345;
+		return _seed >> 8;
+	}
+
+	/**
+	 * Scale a rect as a whole and band by band, and check both give the same
+	 * result.
+	 */
+	void checkScaler(const Scaler &scaler, int bytesPerPixel, int width, int height, int numThreads) {
+		const uint32 srcPitch = (kWidth + 2 * kBorder) * bytesPerPixel;
+		const uint32 dstPitch = kWidth * kMaxScale * bytesPerPixel;
+		const uint8 *src = _src + kBorder * srcPitch + kBorder * bytesPerPixel;
+		const uint32 dstSize = dstPitch * kHeight * kMaxScale;
+
+		memset(_whole, 0, dstSize);
+		memset(_banded, 0, dstSize);
+
+		scaler.proc(src, srcPitch, _whole, dstPitch, width, height);
+
+		ScalerBand bands[kMaxBands];
+		const int numBands = splitScalerBands(src, srcPitch, _banded, dstPitch, width, height, scaler.scaleFactor, numThreads, bands);
+		TS_ASSERT(numBands >= 1 && numBands <= 2 * numThreads);
+
+		// Scale the bands back to front, like threads finishing in any order
+		int rows = 0;
+		for (int i = numBands - 1; i >= 0; i--) {
+			TS_ASSERT_EQUALS(bands[i].width, width);
+			scaler.proc(bands[i].src, srcPitch, bands[i].dst, dstPitch, bands[i].width, bands[i].height);
+			rows += bands[i].height;
+		}
+		TS_ASSERT_EQUALS(rows, height);
+
+		TS_ASSERT_EQUALS(memcmp(_whole, _banded, dstSize), 0);
+	}
+
+	void checkScalers(uint32 bitFormat, int bytesPerPixel) {
+		static const Scaler scalers[] = {
+			{ Normal1x,   1, false },
+#ifdef USE_SCALERS
+			{ Normal2x,   2, false },
+			{ Normal3x,   3, false },
+			{ _2xSaI,     2, true },
+			{ Super2xSaI, 2, true },
+			{ SuperEagle, 2, true },
+			{ AdvMame2x,  2, false },
+			{ AdvMame3x,  3, false },
+			{ TV2x,       2, false },
+			{ DotMatrix,  2, false },
+#ifdef USE_HQ_SCALERS
+			{ HQ2x,       2, false },
+			{ HQ3x,       3, false },
+#endif
+#endif
+		};
+
+		InitScalers(bitFormat);
+
+		for (uint i = 0; i < ARRAYSIZE(scalers); i++) {
+			if (scalers[i].only16Bit && bytesPerPixel != 2)
+				continue;
+
+			for (int numThreads = 1; numThreads <= 17; numThreads++) {
+				checkScaler(scalers[i], bytesPerPixel, kWidth, kHeight, numThreads);
+				checkScaler(scalers[i], bytesPerPixel, 32, 47, numThreads);
+				checkScaler(scalers[i], bytesPerPixel, 1, 15, numThreads);
+			}
+		}
+
+		DestroyScalers();
+	}
+
+	void fillSource(int bytesPerPixel) {
+		// Few colors, so that the scalers find edges and equal neighbours
+		const uint32 srcSize = (kWidth + 2 * kBorder) * (kHeight + 2 * kBorder) * bytesPerPixel;
+		for (uint32 i = 0; i < srcSize; i++)
+			_src[i] = (getRandom() & 1) ? 0xFF : 0x18;
+	}
+
+public:
+	void setUp() {
+		_src = new uint8[(kWidth + 2 * kBorder) * (kHeight + 2 * kBorder) * 4];
+		_whole = new uint8[kWidth * kHeight * kMaxScale * kMaxScale * 4];
+		_banded = new uint8[kWidth * kHeight * kMaxScale * kMaxScale * 4];
+		_seed = 1;
+	}
+
+	void tearDown() {
+		delete[] _src;
+		delete[] _whole;
+		delete[] _banded;
+	}
+
+	void test_bands_16bit() {
+		fillSource(2);
+		checkScalers(565, 2);
+	}
+
+	void test_bands_32bit() {
+		fillSource(4);
+		checkScalers(8888, 4);
+	}
+};
@@ -0,0 +1,143 @@
+#include <cxxtest/TestSuite.h>
+
+#include "video/bink_idct.h"
+
+class BinkIDCTTestSuite : public CxxTest::TestSuite
+{
+	enum {
+		kBlockCount = 20000,
+		kPitch = 13
+	};
+
+	uint32 _seed;
+
+	uint32 getRandom() {
+		_seed = _seed * 1103515245 + 12345;
+		return _seed >> 8;
+	}
+
+	/**
+	 * Fill a block with random coefficients. Dense blocks use the whole
+	 * int16 range for all coefficients, sparse ones have a DC coefficient
+	 * and a few small AC coefficients, like most blocks of a video.
+	 */
+	void fillBlock(int16 *block, bool sparse) {
+		if (!sparse) {
+			for (int i = 0; i < 64; i++)
+				block[i] = (int16)getRandom();
+			return;
+		}
+
+		memset(block, 0, 64 * sizeof(int16));
+		block[0] = (int16)(getRandom() % 4096) - 2048;
+
+		const int count = getRandom() % 4;
+		for (int i = 0; i < count; i++)
+			block[getRandom() % 64] = (int16)(getRandom() % 512) - 256;
+	}
+
+	void fillPixels(byte *pixels) {
+		for (int i = 0; i < 8 * kPitch; i++)
+			pixels[i] = getRandom();
+	}
+
+public:
+	void setUp() {
+		_seed = 1;
+	}
+
+	void test_put() {
+		int16 block[64], transformed[64];
+		byte dest[8 * kPitch];
+
+		for (int n = 0; n < kBlockCount; n++) {
+			fillBlock(block, n & 1);
+			memcpy(transformed, block, sizeof(block));
+			Video::binkIDCT(transformed);
+
+			fillPixels(dest);
+			Video::binkIDCTPut(dest, kPitch, block);
+
+			// Only the lower 8 bits of the transformed block are stored
+			bool match = true;
+			for (int y = 0; y < 8; y++)
+				for (int x = 0; x < 8; x++)
+					match &= (dest[y * kPitch + x] == (byte)transformed[y * 8 + x]);
+			TS_ASSERT(match);
+		}
+	}
+
+	void test_add() {
+		int16 block[64], transformed[64];
+		byte dest[8 * kPitch], expected[8 * kPitch];
+
+		for (int n = 0; n < kBlockCount; n++) {
+			fillBlock(block, n & 1);
+			memcpy(transformed, block, sizeof(block));
+			Video::binkIDCT(transformed);
+
+			fillPixels(dest);
+			memcpy(expected, dest, sizeof(dest));
+			for (int y = 0; y < 8; y++)
+				for (int x = 0; x < 8; x++)
+					expected[y * kPitch + x] += transformed[y * 8 + x];
+
+			Video::binkIDCTAdd(dest, kPitch, block);
+
+			// The pixels between the rows are left alone
+			TS_ASSERT_EQUALS(memcmp(dest, expected, sizeof(dest)), 0);
+		}
+	}
+
+#ifdef __SSE2__
+	void test_sse2_idct() {
+		int16 block[64], expected[64];
+
+		for (int n = 0; n < kBlockCount; n++) {
+			fillBlock(block, n & 1);
+			memcpy(expected, block, sizeof(block));
+
+			Video::binkIDCT(expected);
+			Video::binkIDCTSSE2(block);
+
+			TS_ASSERT_EQUALS(memcmp(block, expected, sizeof(block)), 0);
+		}
+	}
+
+	void test_sse2_put() {
+		int16 block[64], original[64];
+		byte dest[8 * kPitch], expected[8 * kPitch];
+
+		for (int n = 0; n < kBlockCount; n++) {
+			fillBlock(block, n & 1);
+			memcpy(original, block, sizeof(block));
+
+			fillPixels(dest);
+			memcpy(expected, dest, sizeof(dest));
+
+			Video::binkIDCTPut(expected, kPitch, original);
+			Video::binkIDCTPutSSE2(dest, kPitch, block);
+
+			TS_ASSERT_EQUALS(memcmp(dest, expected, sizeof(dest)), 0);
+		}
+	}
+
+	void test_sse2_add() {
+		int16 block[64], original[64];
+		byte dest[8 * kPitch], expected[8 * kPitch];
+
+		for (int n = 0; n < kBlockCount; n++) {
+			fillBlock(block, n & 1);
+			memcpy(original, block, sizeof(block));
+
+			fillPixels(dest);
+			memcpy(expected, dest, sizeof(dest));
+
+			Video::binkIDCTAdd(expected, kPitch, original);
+			Video::binkIDCTAddSSE2(dest, kPitch, block);
+
+			TS_ASSERT_EQUALS(memcmp(dest, expected, sizeof(dest)), 0);
+		}
+	}
+#endif
+};
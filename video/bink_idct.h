@@ -0,0 +1,315 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ */
+
+// The Bink video IDCT, used by the Bink decoder. The C version is always
+// available, so that the test suite can check the SSE2 version against it.
+
+#ifndef VIDEO_BINK_IDCT_H
+#define VIDEO_BINK_IDCT_H
+
+// The SSE2 header is best included before the ScummVM ones, which forbid
+// some of the symbols in the system headers it includes
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+#include "common/scummsys.h"
+
+namespace Video {
+
+#define A1  2896 /* (1/sqrt(2))<<12 */
+#define A2  2217
+#define A3  3784
+#define A4 -5352
+
+#define IDCT_TRANSFORM(dest,s0,s1,s2,s3,s4,s5,s6,s7,d0,d1,d2,d3,d4,d5,d6,d7,munge,src) {\
+    const int a0 = (src)[s0] + (src)[s4]; \
+    const int a1 = (src)[s0] - (src)[s4]; \
+    const int a2 = (src)[s2] + (src)[s6]; \
+    const int a3 = (A1*((src)[s2] - (src)[s6])) >> 11; \
+    const int a4 = (src)[s5] + (src)[s3]; \
+    const int a5 = (src)[s5] - (src)[s3]; \
+    const int a6 = (src)[s1] + (src)[s7]; \
+    const int a7 = (src)[s1] - (src)[s7]; \
+    const int b0 = a4 + a6; \
+    const int b1 = (A3*(a5 + a7)) >> 11; \
+    const int b2 = ((A4*a5) >> 11) - b0 + b1; \
+    const int b3 = (A1*(a6 - a4) >> 11) - b2; \
+    const int b4 = ((A2*a7) >> 11) + b3 - b1; \
+    (dest)[d0] = munge(a0+a2   +b0); \
+    (dest)[d1] = munge(a1+a3-a2+b2); \
+    (dest)[d2] = munge(a1-a3+a2+b3); \
+    (dest)[d3] = munge(a0-a2   -b4); \
+    (dest)[d4] = munge(a0-a2   +b4); \
+    (dest)[d5] = munge(a1-a3+a2-b3); \
+    (dest)[d6] = munge(a1+a3-a2-b2); \
+    (dest)[d7] = munge(a0+a2   -b0); \
+}
+/* end IDCT_TRANSFORM macro */
+
+#define MUNGE_NONE(x) (x)
+#define IDCT_COL(dest,src) IDCT_TRANSFORM(dest,0,8,16,24,32,40,48,56,0,8,16,24,32,40,48,56,MUNGE_NONE,src)
+
+#define MUNGE_ROW(x) (((x) + 0x7F)>>8)
+#define IDCT_ROW(dest,src) IDCT_TRANSFORM(dest,0,1,2,3,4,5,6,7,0,1,2,3,4,5,6,7,MUNGE_ROW,src)
+
+static inline void IDCTCol(int16 *dest, const int16 *src) {
+	if ((src[8] | src[16] | src[24] | src[32] | src[40] | src[48] | src[56]) == 0) {
+		dest[ 0] =
+		dest[ 8] =
+		dest[16] =
+		dest[24] =
+		dest[32] =
+		dest[40] =
+		dest[48] =
+		dest[56] = src[0];
+	} else {
+		IDCT_COL(dest, src);
+	}
+}
+
+/** The IDCT of a block, in place. */
+static inline void binkIDCT(int16 *block) {
+	int i;
+	int16 temp[64];
+
+	for (i = 0; i < 8; i++)
+		IDCTCol(&temp[i], &block[i]);
+	for (i = 0; i < 8; i++) {
+		IDCT_ROW( (&block[8*i]), (&temp[8*i]) );
+	}
+}
+
+/** The IDCT of a block, added to the 8x8 pixels at dest. The block is transformed in place. */
+static inline void binkIDCTAdd(byte *dest, uint32 pitch, int16 *block) {
+	int i, j;
+
+	binkIDCT(block);
+	for (i = 0; i < 8; i++, dest += pitch, block += 8)
+		for (j = 0; j < 8; j++)
+			 dest[j] += block[j];
+}
+
+/** The IDCT of a block, stored to the 8x8 pixels at dest. */
+static inline void binkIDCTPut(byte *dest, uint32 pitch, int16 *block) {
+	int i;
+	int16 temp[64];
+	for (i = 0; i < 8; i++)
+		IDCTCol(&temp[i], &block[i]);
+	for (i = 0; i < 8; i++) {
+		IDCT_ROW( (&dest[i*pitch]), (&temp[8*i]) );
+	}
+}
+
+#ifdef __SSE2__
+
+
+/** Multiply 32 bit values with a constant, keeping the lower 32 bits of the products. */
+static inline __m128i mulSSE2(__m128i x, int c) {
+	const __m128i cv   = _mm_set1_epi32(c);
+	const __m128i even = _mm_mul_epu32(x, cv);
+	const __m128i odd  = _mm_mul_epu32(_mm_srli_si128(x, 4), cv);
+
+	return _mm_unpacklo_epi32(_mm_shuffle_epi32(even, _MM_SHUFFLE(0, 0, 2, 0)),
+	                          _mm_shuffle_epi32(odd , _MM_SHUFFLE(0, 0, 2, 0)));
+}
+
+/**
+ * IDCT_TRANSFORM on four columns of 32 bit values at once, in place.
+ * The multiplications are done in 32 bits, like in the C version, so the
+ * results are identical.
+ */
+static inline void idctTransformSSE2(__m128i *s) {
+	const __m128i a0 = _mm_add_epi32(s[0], s[4]);
+	const __m128i a1 = _mm_sub_epi32(s[0], s[4]);
+	const __m128i a2 = _mm_add_epi32(s[2], s[6]);
+	const __m128i a3 = _mm_srai_epi32(mulSSE2(_mm_sub_epi32(s[2], s[6]), A1), 11);
+	const __m128i a4 = _mm_add_epi32(s[5], s[3]);
+	const __m128i a5 = _mm_sub_epi32(s[5], s[3]);
+	const __m128i a6 = _mm_add_epi32(s[1], s[7]);
+	const __m128i a7 = _mm_sub_epi32(s[1], s[7]);
+	const __m128i b0 = _mm_add_epi32(a4, a6);
+	const __m128i b1 = _mm_srai_epi32(mulSSE2(_mm_add_epi32(a5, a7), A3), 11);
+	const __m128i b2 = _mm_add_epi32(_mm_sub_epi32(_mm_srai_epi32(mulSSE2(a5, A4), 11), b0), b1);
+	const __m128i b3 = _mm_sub_epi32(_mm_srai_epi32(mulSSE2(_mm_sub_epi32(a6, a4), A1), 11), b2);
+	const __m128i b4 = _mm_sub_epi32(_mm_add_epi32(_mm_srai_epi32(mulSSE2(a7, A2), 11), b3), b1);
+
+	const __m128i c0 = _mm_add_epi32(a0, a2);
+	const __m128i c1 = _mm_sub_epi32(_mm_add_epi32(a1, a3), a2);
+	const __m128i c2 = _mm_add_epi32(_mm_sub_epi32(a1, a3), a2);
+	const __m128i c3 = _mm_sub_epi32(a0, a2);
+
+	s[0] = _mm_add_epi32(c0, b0);
+	s[1] = _mm_add_epi32(c1, b2);
+	s[2] = _mm_add_epi32(c2, b3);
+	s[3] = _mm_sub_epi32(c3, b4);
+	s[4] = _mm_add_epi32(c3, b4);
+	s[5] = _mm_sub_epi32(c2, b3);
+	s[6] = _mm_sub_epi32(c1, b2);
+	s[7] = _mm_sub_epi32(c0, b0);
+}
+
+/** Sign extend the lower or upper four 16 bit values to 32 bits. */
+static inline __m128i unpackLoSSE2(__m128i x) {
+	return _mm_srai_epi32(_mm_unpacklo_epi16(x, x), 16);
+}
+
+static inline __m128i unpackHiSSE2(__m128i x) {
+	return _mm_srai_epi32(_mm_unpackhi_epi16(x, x), 16);
+}
+
+/** Truncate 32 bit values to 16 bits, like storing an int into an int16. */
+static inline __m128i packSSE2(__m128i lo, __m128i hi) {
+	lo = _mm_srai_epi32(_mm_slli_epi32(lo, 16), 16);
+	hi = _mm_srai_epi32(_mm_slli_epi32(hi, 16), 16);
+
+	return _mm_packs_epi32(lo, hi);
+}
+
+static inline void transposeSSE2(__m128i *r) {
+	const __m128i t0 = _mm_unpacklo_epi16(r[0], r[1]);
+	const __m128i t1 = _mm_unpackhi_epi16(r[0], r[1]);
+	const __m128i t2 = _mm_unpacklo_epi16(r[2], r[3]);
+	const __m128i t3 = _mm_unpackhi_epi16(r[2], r[3]);
+	const __m128i t4 = _mm_unpacklo_epi16(r[4], r[5]);
+	const __m128i t5 = _mm_unpackhi_epi16(r[4], r[5]);
+	const __m128i t6 = _mm_unpacklo_epi16(r[6], r[7]);
+	const __m128i t7 = _mm_unpackhi_epi16(r[6], r[7]);
+
+	const __m128i u0 = _mm_unpacklo_epi32(t0, t2);
+	const __m128i u1 = _mm_unpackhi_epi32(t0, t2);
+	const __m128i u2 = _mm_unpacklo_epi32(t1, t3);
+	const __m128i u3 = _mm_unpackhi_epi32(t1, t3);
+	const __m128i u4 = _mm_unpacklo_epi32(t4, t6);
+	const __m128i u5 = _mm_unpackhi_epi32(t4, t6);
+	const __m128i u6 = _mm_unpacklo_epi32(t5, t7);
+	const __m128i u7 = _mm_unpackhi_epi32(t5, t7);
+
+	r[0] = _mm_unpacklo_epi64(u0, u4);
+	r[1] = _mm_unpackhi_epi64(u0, u4);
+	r[2] = _mm_unpacklo_epi64(u1, u5);
+	r[3] = _mm_unpackhi_epi64(u1, u5);
+	r[4] = _mm_unpacklo_epi64(u2, u6);
+	r[5] = _mm_unpackhi_epi64(u2, u6);
+	r[6] = _mm_unpacklo_epi64(u3, u7);
+	r[7] = _mm_unpackhi_epi64(u3, u7);
+}
+
+/**
+ * The IDCT of a block, leaving the rows of the result as 16 bit values in
+ * rows. Both passes work on four columns at once, with the block transposed
+ * in between and afterwards.
+ */
+static inline void idctSSE2(const int16 *block, __m128i *rows) {
+	__m128i lo[8], hi[8];
+
+	for (int i = 0; i < 8; i++) {
+		const __m128i r = _mm_loadu_si128((const __m128i *)(block + 8 * i));
+
+		lo[i] = unpackLoSSE2(r);
+		hi[i] = unpackHiSSE2(r);
+	}
+
+	idctTransformSSE2(lo);
+	idctTransformSSE2(hi);
+
+	for (int i = 0; i < 8; i++)
+		rows[i] = packSSE2(lo[i], hi[i]);
+
+	transposeSSE2(rows);
+
+	for (int i = 0; i < 8; i++) {
+		lo[i] = unpackLoSSE2(rows[i]);
+		hi[i] = unpackHiSSE2(rows[i]);
+	}
+
+	idctTransformSSE2(lo);
+	idctTransformSSE2(hi);
+
+	const __m128i round = _mm_set1_epi32(0x7F);
+	for (int i = 0; i < 8; i++)
+		rows[i] = packSSE2(_mm_srai_epi32(_mm_add_epi32(lo[i], round), 8),
+		                   _mm_srai_epi32(_mm_add_epi32(hi[i], round), 8));
+
+	transposeSSE2(rows);
+}
+
+/** Same as binkIDCT(), with identical results. */
+static inline void binkIDCTSSE2(int16 *block) {
+	__m128i rows[8];
+
+	idctSSE2(block, rows);
+
+	for (int i = 0; i < 8; i++)
+		_mm_storeu_si128((__m128i *)(block + 8 * i), rows[i]);
+}
+
+/**
+ * Same as binkIDCTAdd(), with identical results, except that the block is
+ * left untouched.
+ */
+static inline void binkIDCTAddSSE2(byte *dest, uint32 pitch, const int16 *block) {
+	__m128i rows[8];
+
+	idctSSE2(block, rows);
+
+	// The sums wrap around, like adding to a byte does
+	const __m128i zero = _mm_setzero_si128();
+	const __m128i mask = _mm_set1_epi16(0xFF);
+
+	for (int i = 0; i < 8; i++, dest += pitch) {
+		const __m128i d = _mm_unpacklo_epi8(_mm_loadl_epi64((const __m128i *)dest), zero);
+		const __m128i sum = _mm_and_si128(_mm_add_epi16(d, rows[i]), mask);
+
+		_mm_storel_epi64((__m128i *)dest, _mm_packus_epi16(sum, zero));
+	}
+}
+
+/** Same as binkIDCTPut(), with identical results. */
+static inline void binkIDCTPutSSE2(byte *dest, uint32 pitch, const int16 *block) {
+	__m128i rows[8];
+
+	idctSSE2(block, rows);
+
+	// Only the lower 8 bits are stored, like with the C version
+	const __m128i zero = _mm_setzero_si128();
+	const __m128i mask = _mm_set1_epi16(0xFF);
+
+	for (int i = 0; i < 8; i++, dest += pitch)
+		_mm_storel_epi64((__m128i *)dest, _mm_packus_epi16(_mm_and_si128(rows[i], mask), zero));
+}
+
+#endif // __SSE2__
+
+#undef A1
+#undef A2
+#undef A3
+#undef A4
+#undef IDCT_TRANSFORM
+#undef MUNGE_NONE
+#undef IDCT_COL
+#undef MUNGE_ROW
+#undef IDCT_ROW
+
+} // End of namespace Video
+
+#endif
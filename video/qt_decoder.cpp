@@ -92,10 +92,6 @@ void QuickTimeDecoder::close() {
 const Graphics::Surface *QuickTimeDecoder::decodeNextFrame() {
 	const Graphics::Surface *frame = VideoDecoder::decodeNextFrame();
 
-	// Update audio buffers too
-	// (needs to be done after we find the next track)
-	updateAudioBuffer();
-
 	// We have to initialize the scaled surface
 	if (frame && (_scaleFactorX != 1 || _scaleFactorY != 1)) {
 		if (!_scaledSurface) {
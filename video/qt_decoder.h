@@ -70,6 +70,10 @@ public:
 	Audio::Timestamp getDuration() const { return Audio::Timestamp(0, _duration, _timeScale); }
 
 protected:
+	// Update audio buffers too
+	// (needs to be done after we find the next track)
+	void nextFrameDecoded() { updateAudioBuffer(); }
+
 	Common::QuickTimeParser::SampleDesc *readSampleDesc(Common::QuickTimeParser::Track *track, uint32 format, uint32 descSize);
 
 private:
@@ -67,8 +67,12 @@ private:
 	uint16 _treeSize;
 	uint16 _tree[511];
 
-	uint16 _prefixtree[256];
-	byte _prefixlength[256];
+	/**
+	 * For all combinations of the next 8 bits, either the value and the
+	 * length of the code they start with, as (length << 8) | value, or
+	 * SMK_NODE and the tree node reached after 8 bits for longer codes.
+	 */
+	uint16 _lookup[256];
 
 	Common::BitStream &_bs;
 };
@@ -79,7 +83,7 @@ SmallHuffmanTree::SmallHuffmanTree(Common::BitStream &bs)
 	assert(bit);
 
 	for (uint16 i = 0; i < 256; ++i)
-		_prefixtree[i] = _prefixlength[i] = 0;
+		_lookup[i] = 0;
 
 	decodeTree(0, 0);
 
@@ -92,10 +96,8 @@ uint16 SmallHuffmanTree::decodeTree(uint32 prefix, int length) {
 		_tree[_treeSize] = _bs.getBits(8);
 
 		if (length <= 8) {
-			for (int i = 0; i < 256; i += (1 << length)) {
-				_prefixtree[prefix | i] = _treeSize;
-				_prefixlength[prefix | i] = length;
-			}
+			for (int i = 0; i < 256; i += (1 << length))
+				_lookup[prefix | i] = (length << 8) | _tree[_treeSize];
 		}
 		++_treeSize;
 
@@ -104,10 +106,8 @@ uint16 SmallHuffmanTree::decodeTree(uint32 prefix, int length) {
 
 	uint16 t = _treeSize++;
 
-	if (length == 8) {
-		_prefixtree[prefix] = t;
-		_prefixlength[prefix] = 8;
-	}
+	if (length == 8)
+		_lookup[prefix] = SMK_NODE | t;
 
 	uint16 r1 = decodeTree(prefix, length + 1);
 
@@ -119,9 +119,15 @@ uint16 SmallHuffmanTree::decodeTree(uint32 prefix, int length) {
 }
 
 uint16 SmallHuffmanTree::getCode(Common::BitStream &bs) {
-	byte peek = bs.peekBits(8);
-	uint16 *p = &_tree[_prefixtree[peek]];
-	bs.skip(_prefixlength[peek]);
+	uint16 entry = _lookup[bs.peekBits(8)];
+
+	if (!(entry & SMK_NODE)) {
+		bs.skip(entry >> 8);
+		return entry & 0xff;
+	}
+
+	uint16 *p = &_tree[entry & ~SMK_NODE];
+	bs.skip(8);
 
 	while (*p & SMK_NODE) {
 		if (bs.getBit())
@@ -149,14 +155,30 @@ private:
 		SMK_NODE = 0x80000000
 	};
 
+	enum {
+		/** Number of bits looked up at once */
+		kLookupBits = 12,
+		/** Flag for lookup entries referring to the tree */
+		kLookupIndirect = 0x10
+	};
+
 	uint32 decodeTree(uint32 prefix, int length);
 
 	uint32  _treeSize;
 	uint32 *_tree;
 	uint32  _last[3];
 
-	uint32 _prefixtree[256];
-	byte _prefixlength[256];
+	/**
+	 * For all combinations of the next kLookupBits bits, the length of the
+	 * code they start with in the lower four bits, and the value of the code
+	 * in the bits above kLookupIndirect.
+	 *
+	 * Leaves holding one of the last used values, and codes longer than
+	 * kLookupBits, are marked with kLookupIndirect. Instead of the value,
+	 * these hold the index of the leaf, or of the node reached after
+	 * kLookupBits bits.
+	 */
+	uint32 _lookup[1 << kLookupBits];
 
 	/* Used during construction */
 	Common::BitStream &_bs;
@@ -172,12 +194,13 @@ BigHuffmanTree::BigHuffmanTree(Common::BitStream &bs, int allocSize)
 		_tree = new uint32[1];
 		_tree[0] = 0;
 		_last[0] = _last[1] = _last[2] = 0;
+
+		// Every code is the value of the single leaf, taking no bits
+		for (uint32 i = 0; i < (1 << kLookupBits); ++i)
+			_lookup[i] = kLookupIndirect;
 		return;
 	}
 
-	for (uint32 i = 0; i < 256; ++i)
-		_prefixtree[i] = _prefixlength[i] = 0;
-
 	_loBytes = new SmallHuffmanTree(_bs);
 	_hiBytes = new SmallHuffmanTree(_bs);
 
@@ -220,22 +243,22 @@ uint32 BigHuffmanTree::decodeTree(uint32 prefix, int length) {
 		uint32 hi = _hiBytes->getCode(_bs);
 
 		uint32 v = (hi << 8) | lo;
+		uint32 entry = (v << 5) | length;
 
 		_tree[_treeSize] = v;
 
-		if (length <= 8) {
-			for (int i = 0; i < 256; i += (1 << length)) {
-				_prefixtree[prefix | i] = _treeSize;
-				_prefixlength[prefix | i] = length;
-			}
-		}
-
 		for (int i = 0; i < 3; ++i) {
 			if (_markers[i] == v) {
 				_last[i] = _treeSize;
 				_tree[_treeSize] = 0;
+				entry = (_treeSize << 5) | kLookupIndirect | length;
 			}
 		}
+
+		if (length <= kLookupBits) {
+			for (uint32 i = 0; i < (1 << kLookupBits); i += (1 << length))
+				_lookup[prefix | i] = entry;
+		}
 		++_treeSize;
 
 		return 1;
@@ -243,10 +266,8 @@ uint32 BigHuffmanTree::decodeTree(uint32 prefix, int length) {
 
 	uint32 t = _treeSize++;
 
-	if (length == 8) {
-		_prefixtree[prefix] = t;
-		_prefixlength[prefix] = 8;
-	}
+	if (length == kLookupBits)
+		_lookup[prefix] = (t << 5) | kLookupIndirect | length;
 
 	uint32 r1 = decodeTree(prefix, length + 1);
 
@@ -257,17 +278,25 @@ uint32 BigHuffmanTree::decodeTree(uint32 prefix, int length) {
 }
 
 uint32 BigHuffmanTree::getCode(Common::BitStream &bs) {
-	byte peek = bs.peekBits(8);
-	uint32 *p = &_tree[_prefixtree[peek]];
-	bs.skip(_prefixlength[peek]);
+	uint32 entry = _lookup[bs.peekBits(kLookupBits)];
+	bs.skip(entry & 0xf);
 
-	while (*p & SMK_NODE) {
-		if (bs.getBit())
-			p += (*p) & ~SMK_NODE;
-		p++;
+	uint32 v;
+
+	if (entry & kLookupIndirect) {
+		uint32 *p = &_tree[entry >> 5];
+
+		while (*p & SMK_NODE) {
+			if (bs.getBit())
+				p += (*p) & ~SMK_NODE;
+			p++;
+		}
+
+		v = *p;
+	} else {
+		v = entry >> 5;
 	}
 
-	uint32 v = *p;
 	if (v != _tree[_last[0]]) {
 		_tree[_last[2]] = _tree[_last[1]];
 		_tree[_last[1]] = _tree[_last[0]];
@@ -409,6 +438,9 @@ void SmackerDecoder::close() {
 }
 
 bool SmackerDecoder::rewind() {
+	// Keep frames from being decoded ahead until the file is rewound, too
+	Common::StackLock decodeLock(_decodeMutex);
+
 	// Call the parent method to rewind the tracks first
 	if (!VideoDecoder::rewind())
 		return false;
@@ -464,13 +496,16 @@ void SmackerDecoder::readNextPacket() {
 
 	uint32 frameDataSize = frameSize - (_fileStream->pos() - startPos);
 
-	byte *frameData = (byte *)malloc(frameDataSize + 1);
-	// Padding to keep the BigHuffmanTrees from reading past the data end
-	frameData[frameDataSize] = 0x00;
+	// The data is read in 32-bit units, which take the bits in the same order
+	// as bytes do. Padding keeps the BigHuffmanTrees from reading past the
+	// data end when peeking at the last code.
+	const uint32 paddedSize = (frameDataSize + 4 + 3) & ~3;
+	byte *frameData = (byte *)malloc(paddedSize);
+	memset(frameData + frameDataSize, 0, paddedSize - frameDataSize);
 
 	_fileStream->read(frameData, frameDataSize);
 
-	Common::BitStream8LSB bs(new Common::MemoryReadStream(frameData, frameDataSize + 1, DisposeAfterUse::YES), true);
+	Common::BitStream32LELSB bs(new Common::MemoryReadStream(frameData, paddedSize, DisposeAfterUse::YES), true);
 	videoTrack->decodeFrame(bs);
 
 	_fileStream->seek(startPos + frameSize);
@@ -27,12 +27,162 @@
 
 #include "common/rational.h"
 #include "common/file.h"
+#include "common/algorithm.h"
+#include "common/array.h"
+#include "common/list.h"
+#include "common/profiler.h"
+#include "common/singleton.h"
 #include "common/system.h"
+#include "common/timer.h"
 
 #include "graphics/palette.h"
+#include "graphics/surface.h"
 
 namespace Video {
 
+/**
+ * Calls VideoDecoder::decodeAhead() on all videos decoding ahead from a
+ * timer callback. The timer stays installed as long as the manager exists,
+ * the callback returns right away while no video decodes ahead.
+ */
+class DecodeAheadManager : public Common::Singleton<DecodeAheadManager> {
+public:
+	void addDecoder(VideoDecoder *decoder);
+	void removeDecoder(VideoDecoder *decoder);
+
+private:
+	friend class Common::Singleton<SingletonBaseType>;
+	DecodeAheadManager();
+	~DecodeAheadManager();
+
+	static void timerProc(void *refCon);
+
+	/**
+	 * The timer callback is shared with music players and other decoders,
+	 * so it stops decoding further videos once this many milliseconds have
+	 * passed. The remaining videos are decoded first in the next callback.
+	 */
+	enum {
+		kMaxDecodeTime = 5
+	};
+
+	/**
+	 * Protects the decoder list and _decodingDecoder. Only held for short
+	 * periods of time, not while decoding.
+	 */
+	Common::Mutex _mutex;
+	Common::List<VideoDecoder *> _decoders;
+
+	/**
+	 * Held by the timer callback while decoding a video, which is
+	 * _decodingDecoder. This keeps removeDecoder() from returning while the
+	 * decoder being removed is still decoding.
+	 */
+	Common::Mutex _decodeMutex;
+	VideoDecoder *_decodingDecoder;
+
+	/** The index of the decoder to start with in the next callback */
+	uint _firstDecoder;
+};
+
+} // End of namespace Video
+
+namespace Common {
+DECLARE_SINGLETON(Video::DecodeAheadManager);
+}
+
+namespace Video {
+
+DecodeAheadManager::DecodeAheadManager() : _decodingDecoder(0), _firstDecoder(0) {
+	g_system->getTimerManager()->installTimerProc(&timerProc, 10000, this, "VideoDecodeAheadManager");
+}
+
+DecodeAheadManager::~DecodeAheadManager() {
+	g_system->getTimerManager()->removeTimerProc(&timerProc);
+}
+
+void DecodeAheadManager::addDecoder(VideoDecoder *decoder) {
+	Common::StackLock lock(_mutex);
+	_decoders.push_back(decoder);
+}
+
+void DecodeAheadManager::removeDecoder(VideoDecoder *decoder) {
+	Common::StackLock lock(_mutex);
+	_decoders.remove(decoder);
+
+	if (decoder == _decodingDecoder) {
+		// The video is being decoded right now. Since it is no longer in
+		// the list, the timer callback won't pick it up again, so we only
+		// have to wait for the current frame. The callback needs _mutex for
+		// that, so release it meanwhile.
+		_mutex.unlock();
+		_decodeMutex.lock();
+		_decodeMutex.unlock();
+		_mutex.lock();
+	}
+}
+
+void DecodeAheadManager::timerProc(void *refCon) {
+	DecodeAheadManager *manager = (DecodeAheadManager *)refCon;
+	Common::Array<VideoDecoder *> decoders;
+
+	{
+		Common::StackLock lock(manager->_mutex);
+		if (manager->_decoders.empty())
+			return;
+
+		for (Common::List<VideoDecoder *>::iterator i = manager->_decoders.begin(); i != manager->_decoders.end(); ++i)
+			decoders.push_back(*i);
+	}
+
+	const uint32 startTime = g_system->getMillis();
+
+	// Only hold the list mutex while picking the next video, so that
+	// videos can be added and removed while others are decoding.
+	for (uint i = 0; i < decoders.size(); i++) {
+		const uint index = (manager->_firstDecoder + i) % decoders.size();
+
+		// Each video decodes at most one frame per callback, but with
+		// several videos, leave the rest for the next callback if this
+		// one took long already.
+		if (i > 0 && g_system->getMillis() - startTime >= kMaxDecodeTime) {
+			manager->_firstDecoder = index;
+			return;
+		}
+
+		Common::StackLock decodeLock(manager->_decodeMutex);
+
+		{
+			Common::StackLock lock(manager->_mutex);
+			// Skip videos which have stopped decoding ahead in the meantime
+			if (Common::find(manager->_decoders.begin(), manager->_decoders.end(), decoders[index]) == manager->_decoders.end())
+				continue;
+			manager->_decodingDecoder = decoders[index];
+		}
+
+		decoders[index]->decodeAhead();
+
+		Common::StackLock lock(manager->_mutex);
+		manager->_decodingDecoder = 0;
+	}
+
+	manager->_firstDecoder = 0;
+}
+
+/**
+ * A frame decoded ahead of playback, along with the palette and the state of
+ * the tracks after decoding it.
+ */
+struct VideoDecoder::QueuedFrame {
+	Graphics::Surface surface;
+	bool hasSurface;
+	byte palette[256 * 3];
+	bool dirtyPalette;
+	FrameState state;
+};
+
+#pragma mark -
+
 VideoDecoder::VideoDecoder() {
 	_startTime = 0;
 	_dirtyPalette = false;
@@ -46,6 +196,10 @@ VideoDecoder::VideoDecoder() {
 	_endTime = 0;
 	_endTimeSet = false;
 	_nextVideoTrack = 0;
+	_queuedFrames = 0;
+	_decodeAheadFrames = 0;
+	_queueReadPos = 0;
+	_queuedFrameCount = 0;
 
 	// Find the best format for output
 	_defaultHighColorFormat = g_system->getScreenFormat();
@@ -55,6 +209,8 @@ VideoDecoder::VideoDecoder() {
 }
 
 void VideoDecoder::close() {
+	stopDecodingAhead();
+
 	if (isPlaying())
 		stop();
 
@@ -67,12 +223,14 @@ void VideoDecoder::close() {
 	_startTime = 0;
 	_audioVolume = Audio::Mixer::kMaxChannelVolume;
 	_audioBalance = 0;
-	_pauseLevel = 0;
 	_needsUpdate = false;
 	_lastTimeChange = 0;
 	_endTime = 0;
 	_endTimeSet = false;
 	_nextVideoTrack = 0;
+
+	Common::StackLock lock(_stateMutex);
+	_pauseLevel = 0;
 }
 
 bool VideoDecoder::loadFile(const Common::String &filename) {
@@ -91,24 +249,35 @@ bool VideoDecoder::needsUpdate() const {
 }
 
 void VideoDecoder::pauseVideo(bool pause) {
-	if (pause) {
-		_pauseLevel++;
+	uint32 pauseLevel;
 
-	// We can't go negative
-	} else if (_pauseLevel) {
-		_pauseLevel--;
+	{
+		Common::StackLock lock(_stateMutex);
 
-	// Do nothing
-	} else {
-		return;
+		if (pause) {
+			_pauseLevel++;
+
+		// We can't go negative
+		} else if (_pauseLevel) {
+			_pauseLevel--;
+
+		// Do nothing
+		} else {
+			return;
+		}
+
+		pauseLevel = _pauseLevel;
 	}
 
-	if (_pauseLevel == 1 && pause) {
+	// The tracks may be decoding ahead in the timer callback
+	Common::StackLock decodeLock(_decodeMutex);
+
+	if (pauseLevel == 1 && pause) {
 		_pauseStartTime = g_system->getMillis(); // Store the starting time from pausing to keep it for later
 
 		for (TrackList::iterator it = _tracks.begin(); it != _tracks.end(); it++)
 			(*it)->pause(true);
-	} else if (_pauseLevel == 0) {
+	} else if (pauseLevel == 0) {
 		for (TrackList::iterator it = _tracks.begin(); it != _tracks.end(); it++)
 			(*it)->pause(false);
 
@@ -166,14 +335,21 @@ Graphics::PixelFormat VideoDecoder::getPixelFormat() const {
 }
 
 const Graphics::Surface *VideoDecoder::decodeNextFrame() {
+	PROFILE_ZONE("VideoDecoder::decodeNextFrame");
+
 	_needsUpdate = false;
 
+	if (_queuedFrames)
+		return decodeQueuedFrame();
+
 	readNextPacket();
 
 	// If we have no next video track at this point, there shouldn't be
 	// any frame available for us to display.
-	if (!_nextVideoTrack)
+	if (!_nextVideoTrack) {
+		nextFrameDecoded();
 		return 0;
+	}
 
 	const Graphics::Surface *frame = _nextVideoTrack->decodeNextFrame();
 
@@ -184,6 +360,7 @@ const Graphics::Surface *VideoDecoder::decodeNextFrame() {
 
 	// Look for the next video track here for the next decode.
 	findNextVideoTrack();
+	nextFrameDecoded();
 
 	return frame;
 }
@@ -193,6 +370,10 @@ bool VideoDecoder::setReverse(bool reverse) {
 	if (reverse && hasAudio())
 		return false;
 
+	// The queued frames are decoded forward
+	if (reverse && _queuedFrames)
+		return false;
+
 	// Attempt to make sure all the tracks are in the requested direction
 	for (TrackList::iterator it = _tracks.begin(); it != _tracks.end(); it++) {
 		if ((*it)->getTrackType() == Track::kTrackTypeVideo && ((VideoTrack *)*it)->isReversed() != reverse) {
@@ -213,6 +394,15 @@ const byte *VideoDecoder::getPalette() {
 }
 
 int VideoDecoder::getCurFrame() const {
+	// When decoding ahead, the tracks are further along than the frames
+	// returned so far.
+	if (_queuedFrames)
+		return _shownState.curFrame;
+
+	return getDecodedFrame();
+}
+
+int VideoDecoder::getDecodedFrame() const {
 	int32 frame = -1;
 
 	for (TrackList::const_iterator it = _tracks.begin(); it != _tracks.end(); it++)
@@ -254,13 +444,25 @@ uint32 VideoDecoder::getTime() const {
 }
 
 uint32 VideoDecoder::getTimeToNextFrame() const {
-	if (endOfVideo() || _needsUpdate || !_nextVideoTrack)
+	if (endOfVideo() || _needsUpdate)
 		return 0;
 
 	uint32 currentTime = getTime();
-	uint32 nextFrameStartTime = _nextVideoTrack->getNextFrameStartTime();
+	uint32 nextFrameStartTime;
+
+	if (_queuedFrames) {
+		if (!_shownState.hasNextFrame)
+			return 0;
+
+		nextFrameStartTime = _shownState.nextFrameStartTime;
+	} else {
+		if (!_nextVideoTrack)
+			return 0;
 
-	if (_nextVideoTrack->isReversed()) {
+		nextFrameStartTime = _nextVideoTrack->getNextFrameStartTime();
+	}
+
+	if (!_queuedFrames && _nextVideoTrack->isReversed()) {
 		// For reversed videos, we need to handle the time difference the opposite way.
 		if (nextFrameStartTime >= currentTime)
 			return 0;
@@ -276,9 +478,16 @@ uint32 VideoDecoder::getTimeToNextFrame() const {
 }
 
 bool VideoDecoder::endOfVideo() const {
-	for (TrackList::const_iterator it = _tracks.begin(); it != _tracks.end(); it++)
-		if (!(*it)->endOfTrack() && (!isPlaying() || (*it)->getTrackType() != Track::kTrackTypeVideo || !_endTimeSet || ((VideoTrack *)*it)->getNextFrameStartTime() < (uint)_endTime.msecs()))
+	for (TrackList::const_iterator it = _tracks.begin(); it != _tracks.end(); it++) {
+		if ((*it)->getTrackType() == Track::kTrackTypeVideo) {
+			const VideoTrack *track = (const VideoTrack *)*it;
+
+			if (!isVideoTrackEnded(track) && (!isPlaying() || !_endTimeSet || getVideoTrackNextFrameStartTime(track) < (uint)_endTime.msecs()))
+				return false;
+		} else if (!(*it)->endOfTrack()) {
 			return false;
+		}
+	}
 
 	return true;
 }
@@ -298,6 +507,8 @@ bool VideoDecoder::rewind() {
 	if (!isRewindable())
 		return false;
 
+	Common::StackLock decodeLock(_decodeMutex);
+
 	// Stop all tracks so they can be rewound
 	if (isPlaying())
 		stopAudio();
@@ -314,6 +525,7 @@ bool VideoDecoder::rewind() {
 	_startTime = g_system->getMillis();
 	resetPauseStartTime();
 	findNextVideoTrack();
+	flushQueuedFrames();
 	return true;
 }
 
@@ -332,6 +544,8 @@ bool VideoDecoder::seek(const Audio::Timestamp &time) {
 	if (!isSeekable())
 		return false;
 
+	Common::StackLock decodeLock(_decodeMutex);
+
 	// Stop all tracks so they can be seeked
 	if (isPlaying())
 		stopAudio();
@@ -351,6 +565,7 @@ bool VideoDecoder::seek(const Audio::Timestamp &time) {
 
 	resetPauseStartTime();
 	findNextVideoTrack();
+	flushQueuedFrames();
 	_needsUpdate = true;
 	return true;
 }
@@ -402,14 +617,18 @@ void VideoDecoder::stop() {
 	// reset.
 	_lastTimeChange = getTime();
 
-	_playbackRate = 0;
 	_startTime = 0;
 	_palette = 0;
 	_dirtyPalette = false;
 	_needsUpdate = false;
 
-	// Also reset the pause state.
-	_pauseLevel = 0;
+	{
+		Common::StackLock lock(_stateMutex);
+		_playbackRate = 0;
+
+		// Also reset the pause state.
+		_pauseLevel = 0;
+	}
 
 	// Reset the pause state of the tracks too
 	for (TrackList::iterator it = _tracks.begin(); it != _tracks.end(); it++)
@@ -444,7 +663,11 @@ void VideoDecoder::setRate(const Common::Rational &rate) {
 	if (_playbackRate != 0)
 		_lastTimeChange = getTime();
 
-	_playbackRate = targetRate;
+	{
+		Common::StackLock lock(_stateMutex);
+		_playbackRate = targetRate;
+	}
+
 	_startTime = g_system->getMillis();
 
 	// Adjust start time if we've seeked to something besides zero time
@@ -455,9 +678,15 @@ void VideoDecoder::setRate(const Common::Rational &rate) {
 }
 
 bool VideoDecoder::isPlaying() const {
+	Common::StackLock lock(_stateMutex);
 	return _playbackRate != 0;
 }
 
+bool VideoDecoder::isPaused() const {
+	Common::StackLock lock(_stateMutex);
+	return _pauseLevel != 0;
+}
+
 Audio::Timestamp VideoDecoder::getDuration() const {
 	Audio::Timestamp maxDuration(0, 1000);
 
@@ -672,8 +901,11 @@ bool VideoDecoder::addStreamFileTrack(const Common::String &baseName) {
 
 	bool result = track->loadFromFile(baseName);
 
-	if (result)
+	if (result) {
+		// Don't change the track list while decoding ahead
+		Common::StackLock decodeLock(_decodeMutex);
 		addTrack(track);
+	}
 
 	return result;
 }
@@ -771,9 +1003,14 @@ bool VideoDecoder::hasFramesLeft() const {
 	// This is similar to endOfVideo(), except it doesn't take Audio into account (and returns true if not the end of the video)
 	// This is only used for needsUpdate() atm so that setEndTime() works properly
 	// And unlike endOfVideoTracks(), this takes into account _endTime
-	for (TrackList::const_iterator it = _tracks.begin(); it != _tracks.end(); it++)
-		if ((*it)->getTrackType() == Track::kTrackTypeVideo && !(*it)->endOfTrack() && (!isPlaying() || !_endTimeSet || ((VideoTrack *)*it)->getNextFrameStartTime() < (uint)_endTime.msecs()))
-			return true;
+	for (TrackList::const_iterator it = _tracks.begin(); it != _tracks.end(); it++) {
+		if ((*it)->getTrackType() == Track::kTrackTypeVideo) {
+			const VideoTrack *track = (const VideoTrack *)*it;
+
+			if (!isVideoTrackEnded(track) && (!isPlaying() || !_endTimeSet || getVideoTrackNextFrameStartTime(track) < (uint)_endTime.msecs()))
+				return true;
+		}
+	}
 
 	return false;
 }
@@ -786,4 +1023,216 @@ bool VideoDecoder::hasAudio() const {
 	return false;
 }
 
+bool VideoDecoder::setDecodeAhead(uint frames) {
+	stopDecodingAhead();
+
+	if (frames == 0)
+		return true;
+
+	// The state of the tracks is only kept for a single video track
+	const VideoTrack *videoTrack = 0;
+
+	for (TrackList::const_iterator it = _tracks.begin(); it != _tracks.end(); it++) {
+		if ((*it)->getTrackType() == Track::kTrackTypeVideo) {
+			if (videoTrack)
+				return false;
+
+			videoTrack = (const VideoTrack *)*it;
+		}
+	}
+
+	if (!videoTrack || videoTrack->isReversed())
+		return false;
+
+	// One more frame than queued is needed, to keep the frame last returned
+	// by decodeNextFrame() intact while the next one is decoded.
+	_queuedFrames = new QueuedFrame[frames + 1];
+	_decodeAheadFrames = frames;
+	_queueReadPos = 0;
+	_queuedFrameCount = 0;
+
+	for (uint i = 0; i <= frames; i++) {
+		_queuedFrames[i].surface.create(getWidth(), getHeight(), getPixelFormat());
+		_queuedFrames[i].hasSurface = false;
+		_queuedFrames[i].dirtyPalette = false;
+	}
+
+	memset(&_decodeAheadStats, 0, sizeof(_decodeAheadStats));
+	saveFrameState(_shownState);
+
+	DecodeAheadManager::instance().addDecoder(this);
+	return true;
+}
+
+uint VideoDecoder::getDecodeAheadDepth() const {
+	Common::StackLock lock(_queueMutex);
+	return _queuedFrameCount;
+}
+
+void VideoDecoder::stopDecodingAhead() {
+	if (!_queuedFrames)
+		return;
+
+	// This waits for the timer callback, in case it is decoding right now
+	DecodeAheadManager::instance().removeDecoder(this);
+
+	for (uint i = 0; i <= _decodeAheadFrames; i++)
+		_queuedFrames[i].surface.free();
+
+	delete[] _queuedFrames;
+	_queuedFrames = 0;
+	_decodeAheadFrames = 0;
+	_queueReadPos = 0;
+	_queuedFrameCount = 0;
+}
+
+void VideoDecoder::decodeAhead() {
+	PROFILE_ZONE_TRACK("VideoDecoder::decodeAhead", kTrackTimer);
+
+	Common::StackLock decodeLock(_decodeMutex);
+
+	if (!isPlaying() || isPaused() || !_nextVideoTrack)
+		return;
+
+	{
+		Common::StackLock lock(_queueMutex);
+		if (_queuedFrameCount == _decodeAheadFrames)
+			return;
+	}
+
+	// Only decode a single frame per callback, so that other timer
+	// callbacks (like music players) aren't held up for too long.
+	queueNextFrame();
+}
+
+bool VideoDecoder::queueNextFrame() {
+	readNextPacket();
+
+	if (!_nextVideoTrack) {
+		nextFrameDecoded();
+		return false;
+	}
+
+	const Graphics::Surface *surface = _nextVideoTrack->decodeNextFrame();
+
+	QueuedFrame *frame;
+
+	{
+		Common::StackLock lock(_queueMutex);
+		frame = &_queuedFrames[(_queueReadPos + _queuedFrameCount) % (_decodeAheadFrames + 1)];
+	}
+
+	// Only the free part of the queue is written to, so the frame can be
+	// copied without holding the queue mutex.
+	frame->hasSurface = surface != 0;
+
+	if (surface) {
+		if (frame->surface.w != surface->w || frame->surface.h != surface->h || frame->surface.format != surface->format) {
+			frame->surface.free();
+			frame->surface.create(surface->w, surface->h, surface->format);
+		}
+
+		for (int y = 0; y < surface->h; y++)
+			memcpy(frame->surface.getBasePtr(0, y), surface->getBasePtr(0, y), surface->w * surface->format.bytesPerPixel);
+	}
+
+	frame->dirtyPalette = _nextVideoTrack->hasDirtyPalette();
+	if (frame->dirtyPalette)
+		memcpy(frame->palette, _nextVideoTrack->getPalette(), sizeof(frame->palette));
+
+	findNextVideoTrack();
+	nextFrameDecoded();
+	saveFrameState(frame->state);
+
+	Common::StackLock lock(_queueMutex);
+	_queuedFrameCount++;
+	return true;
+}
+
+VideoDecoder::QueuedFrame *VideoDecoder::takeQueuedFrame(uint &depth) {
+	Common::StackLock lock(_queueMutex);
+
+	depth = _queuedFrameCount;
+	if (_queuedFrameCount == 0)
+		return 0;
+
+	QueuedFrame *frame = &_queuedFrames[_queueReadPos];
+	_queueReadPos = (_queueReadPos + 1) % (_decodeAheadFrames + 1);
+	_queuedFrameCount--;
+	return frame;
+}
+
+const Graphics::Surface *VideoDecoder::decodeQueuedFrame() {
+	uint depth;
+	QueuedFrame *frame = takeQueuedFrame(depth);
+
+	if (!frame) {
+		// The queue ran empty. Wait for the timer callback in case it is
+		// decoding right now, and decode the frame ourselves if necessary.
+		Common::StackLock decodeLock(_decodeMutex);
+
+		frame = takeQueuedFrame(depth);
+
+		if (!frame) {
+			if (!queueNextFrame())
+				return 0;
+
+			frame = takeQueuedFrame(depth);
+			depth = 0;
+			_decodeAheadStats.underruns++;
+		}
+	}
+
+	PROFILE_COUNTER("VideoDecoder queued frames", depth);
+
+	_decodeAheadStats.minDepth = _decodeAheadStats.frames ? MIN<uint32>(_decodeAheadStats.minDepth, depth) : depth;
+	_decodeAheadStats.totalDepth += depth;
+	_decodeAheadStats.frames++;
+
+	_shownState = frame->state;
+
+	if (frame->dirtyPalette) {
+		memcpy(_shownPalette, frame->palette, sizeof(_shownPalette));
+		_palette = _shownPalette;
+		_dirtyPalette = true;
+	}
+
+	return frame->hasSurface ? &frame->surface : 0;
+}
+
+void VideoDecoder::flushQueuedFrames() {
+	if (!_queuedFrames)
+		return;
+
+	// Keep the read position, so that the frame last returned by
+	// decodeNextFrame() isn't overwritten.
+	{
+		Common::StackLock lock(_queueMutex);
+		_queuedFrameCount = 0;
+	}
+
+	saveFrameState(_shownState);
+}
+
+void VideoDecoder::saveFrameState(FrameState &state) const {
+	state.curFrame = getDecodedFrame();
+	state.hasNextFrame = _nextVideoTrack != 0;
+	state.nextFrameStartTime = _nextVideoTrack ? _nextVideoTrack->getNextFrameStartTime() : 0;
+}
+
+bool VideoDecoder::isVideoTrackEnded(const VideoTrack *track) const {
+	// There is only a single video track when decoding ahead
+	if (_queuedFrames)
+		return !_shownState.hasNextFrame;
+
+	return track->endOfTrack();
+}
+
+uint32 VideoDecoder::getVideoTrackNextFrameStartTime(const VideoTrack *track) const {
+	if (_queuedFrames)
+		return _shownState.nextFrameStartTime;
+
+	return track->getNextFrameStartTime();
+}
+
 } // End of namespace Video
@@ -26,6 +26,7 @@
 #include "audio/mixer.h"
 #include "audio/timestamp.h"	// TODO: Move this to common/ ?
 #include "common/array.h"
+#include "common/mutex.h"
 #include "common/rational.h"
 #include "common/str.h"
 #include "graphics/pixelformat.h"
@@ -201,7 +202,7 @@ public:
 	/**
 	 * Return whether the video is currently paused or not.
 	 */
-	bool isPaused() const { return _pauseLevel != 0; }
+	bool isPaused() const;
 
 	/**
 	 * Set the time for this video to end at. At this time in the video,
@@ -365,6 +366,53 @@ public:
 	 */
 	bool setReverse(bool reverse);
 
+	/**
+	 * Decode frames ahead of playback.
+	 *
+	 * The frames are decoded from a timer callback into a queue, from which
+	 * decodeNextFrame() takes them, so that a frame which takes long to
+	 * decode doesn't hold up playback. The queue is only filled while the
+	 * video is playing and not paused. Should it run empty, decodeNextFrame()
+	 * decodes the frame right away.
+	 *
+	 * The timer callback is shared with other users, like music players.
+	 * It decodes at most one frame of each video, and with several videos
+	 * leaves the rest for later once it took 5ms, but a single frame is
+	 * always decoded completely. Videos whose frames take much longer than
+	 * 10ms to decode may thus delay the music.
+	 *
+	 * This is only supported for videos with a single video track, and
+	 * reverse playback isn't possible while decoding ahead.
+	 *
+	 * @note This must be called after loading the video, and is reset by
+	 *       close(). Disabling it drops the queued frames, so it should be
+	 *       followed by a seek unless the queue is empty.
+	 * @param frames the number of frames to queue, or 0 to disable
+	 * @return true on success, false otherwise
+	 */
+	bool setDecodeAhead(uint frames);
+
+	/**
+	 * Statistics about decoding ahead, see getDecodeAheadStats().
+	 */
+	struct DecodeAheadStats {
+		uint32 frames;		///< Number of frames returned by decodeNextFrame()
+		uint32 underruns;	///< Number of frames which had to be decoded right away
+		uint32 minDepth;	///< Lowest number of queued frames when a frame was requested
+		uint32 totalDepth;	///< Sum of the number of queued frames when a frame was requested
+	};
+
+	/**
+	 * Get the statistics about decoding ahead since setDecodeAhead() was
+	 * called. The average queue depth is totalDepth / frames.
+	 */
+	const DecodeAheadStats &getDecodeAheadStats() const { return _decodeAheadStats; }
+
+	/**
+	 * Get the number of frames currently queued when decoding ahead.
+	 */
+	uint getDecodeAheadDepth() const;
+
 	/////////////////////////////////////////
 	// Audio Control
 	/////////////////////////////////////////
@@ -756,6 +804,16 @@ protected:
 	 */
 	virtual void readNextPacket() {}
 
+	/**
+	 * Called after a frame has been decoded and the next video track has
+	 * been found, or when there was no frame left to decode.
+	 *
+	 * A subclass may use this to keep other tracks in step with the video.
+	 * Like readNextPacket(), this is called from a timer callback when
+	 * decoding ahead.
+	 */
+	virtual void nextFrameDecoded() {}
+
 	/**
 	 * Define a track to be used by this class.
 	 *
@@ -820,6 +878,15 @@ protected:
 	 */
 	TrackListIterator getTrackListEnd() { return _tracks.end(); }
 
+	/**
+	 * Held while decoding, and while changing the position of the tracks.
+	 * Since frames are added to the queue while holding it, too, this keeps
+	 * them in order when decodeNextFrame() has to decode a frame itself.
+	 * Subclasses which change the position of their own streams must hold
+	 * it as well, since frames may be decoded from a timer callback.
+	 */
+	Common::Mutex _decodeMutex;
+
 private:
 	// Tracks owned by this VideoDecoder
 	TrackList _tracks;
@@ -850,6 +917,50 @@ private:
 	uint32 _pauseStartTime;
 	byte _audioVolume;
 	int8 _audioBalance;
+
+	// Decoding ahead
+	friend class DecodeAheadManager;
+
+	/** The state of the video tracks after decoding a frame */
+	struct FrameState {
+		int curFrame;
+		bool hasNextFrame;
+		uint32 nextFrameStartTime;
+	};
+
+	struct QueuedFrame;
+
+	/**
+	 * Protects _playbackRate and _pauseLevel, which the timer callback
+	 * checks through isPlaying() and isPaused()
+	 */
+	mutable Common::Mutex _stateMutex;
+
+	/** Protects the queue positions */
+	mutable Common::Mutex _queueMutex;
+
+	/** Ring buffer of decoded frames, 0 unless decoding ahead */
+	QueuedFrame *_queuedFrames;
+	uint _decodeAheadFrames;
+	uint _queueReadPos;
+	uint _queuedFrameCount;
+
+	/** The state after the frame last returned by decodeNextFrame() */
+	FrameState _shownState;
+	byte _shownPalette[256 * 3];
+
+	DecodeAheadStats _decodeAheadStats;
+
+	void decodeAhead();
+	void stopDecodingAhead();
+	bool queueNextFrame();
+	QueuedFrame *takeQueuedFrame(uint &depth);
+	const Graphics::Surface *decodeQueuedFrame();
+	void flushQueuedFrames();
+	void saveFrameState(FrameState &state) const;
+	int getDecodedFrame() const;
+	bool isVideoTrackEnded(const VideoTrack *track) const;
+	uint32 getVideoTrackNextFrameStartTime(const VideoTrack *track) const;
 };
 
 } // End of namespace Video